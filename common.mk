@@ -296,6 +296,42 @@ $(VV)mkdir -p $(dir $(LDTIMEOBJ))
 $(call test_output_2,Adding timestamp ,echo 'const int _PROS_COMPILE_TIMESTAMP_INT = $(shell echo $$(($$(date +%s)+($$(date +%-z)/100*3600)))); char const * const _PROS_COMPILE_TIMESTAMP = __DATE__ " " __TIME__; char const * const _PROS_COMPILE_DIRECTORY = "$(wildcard $(shell pwd | tail -c 23))";' | $(CC) -c -x c $(CFLAGS) $(EXTRA_CFLAGS) -o $(LDTIMEOBJ) -,$(OK_STRING))
 endef
 
+# Host simulator: builds the project against sim/ instead of libpros so autons can run on a PC.
+# EZ-Template only ships as a prebuilt ARM archive, so point EZ_TEMPLATE_SRC at a checkout of its src/.
+# squiggles is the same, sim/src/squiggles.cpp stands in for it unless SQUIGGLES_SRC points at its src/.
+HOSTCXX?=g++
+SIMDIR=$(ROOT)/sim
+SIM_BIN:=$(BINDIR)/sim/sim
+SIM_SRC=$(call CXXSRC) $(wildcard $(SIMDIR)/src/*.cpp) $(if $(EZ_TEMPLATE_SRC),$(call rwildcard,$(EZ_TEMPLATE_SRC)/,*.cpp)) $(if $(SQUIGGLES_SRC),$(call rwildcard,$(SQUIGGLES_SRC)/,*.cpp))
+SIM_OBJ=$(patsubst %,$(BINDIR)/sim/obj/%.o,$(abspath $(SIM_SRC)))
+SIM_CXXFLAGS=-std=$(CXX_STANDARD) -O2 -g -pthread $(filter -D_PROS_INCLUDE_LIBLVGL%,$(CPPFLAGS)) -Wno-deprecated-declarations $(if $(SQUIGGLES_SRC),-DSIM_SQUIGGLES_SRC) $(EXTRA_CXXFLAGS)
+SIM_INCLUDE=$(INCLUDE) -iquote"$(INCDIR)/okapi/squiggles" -iquote"$(SIMDIR)/include"
+
+.PHONY: sim
+sim: $(SIM_BIN)
+
+$(SIM_BIN): $(SIM_OBJ)
+ifeq ($(EZ_TEMPLATE_SRC),)
+	$(error make sim needs EZ_TEMPLATE_SRC=<path to EZ-Template/src>)
+endif
+	$(call test_output_2,Linking simulator ,$(HOSTCXX) -pthread $^ -o $@,$(OK_STRING))
+
+$(BINDIR)/sim/obj/%.o: %
+	$(VV)mkdir -p $(dir $@)
+	$(call test_output_2,Compiled $< for host ,$(HOSTCXX) -c $(SIM_INCLUDE) $(SIM_CXXFLAGS) -MMD -MP -o $@ $<,$(OK_STRING))
+
+-include $(SIM_OBJ:.o=.d)
+
+# Host tools (tuner, log decoder, benchmarks), one file each in sim/tools
+SIM_TOOLS=$(patsubst $(SIMDIR)/tools/%.cpp,$(BINDIR)/sim/%,$(wildcard $(SIMDIR)/tools/*.cpp))
+
+.PHONY: sim-tools
+sim-tools: $(SIM_TOOLS)
+
+$(BINDIR)/sim/%: $(SIMDIR)/tools/%.cpp
+	$(VV)mkdir -p $(dir $@)
+	$(call test_output_2,Compiled $< for host ,$(HOSTCXX) $(SIM_INCLUDE) $(SIM_CXXFLAGS) -o $@ $<,$(OK_STRING))
+
 # these rules are for build-compile-commands, which just print out sysroot information
 cc-sysroot:
 	@echo | $(CC) -c -x c $(CFLAGS) $(EXTRA_CFLAGS) --verbose -o /dev/null -
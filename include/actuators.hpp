@@ -0,0 +1,155 @@
+/*
+This Source Code Form is subject to the terms of the Mozilla Public
+License, v. 2.0. If a copy of the MPL was not distributed with this
+file, You can obtain one at http://mozilla.org/MPL/2.0/.
+*/
+
+#pragma once
+
+#include <array>
+#include <cstdint>
+
+#include "api.h"
+
+namespace robot {
+/**
+ * Pistons the sequencer drives.
+ */
+enum piston_id { PISTON_MATCHLOAD = 0,
+                 PISTON_RIGHT_DESCORE = 1,
+                 PISTON_MIDDLE_GOAL = 2,
+                 PISTON_HOOD = 3,
+                 PISTON_ALIGNER = 4,
+                 PISTON_COUNT = 5 };
+
+/**
+ * Motors the sequencer drives.
+ */
+enum roller_id { ROLLER_INTAKE = 0,
+                 ROLLER_HOOD = 1,
+                 ROLLER_COUNT = 2 };
+
+/**
+ * Two pistons that can't be extended together.  Extending one retracts the other, and it
+ * only extends once the other has been retracted for gap ms.
+ */
+struct piston_interlock {
+  piston_id a;
+  piston_id b;
+  std::uint32_t gap;
+};
+
+/**
+ * Non-blocking sequencer for the pistons and rollers.
+ *
+ * Button handlers and autons only change targets and return immediately.  update() runs every
+ * control_loop tick, applies the interlocks, and writes an output once its timed transition is
+ * allowed to happen.  Outputs are only written when they change, so anything else writing the
+ * same devices isn't fought every tick.
+ */
+class actuators {
+ public:
+  /**
+   * Every pair of pistons that must never be extended together.
+   */
+  static constexpr piston_interlock INTERLOCKS[] = {
+      {PISTON_MATCHLOAD, PISTON_ALIGNER, 250},  // they hit each other, give one time to clear
+      {PISTON_HOOD, PISTON_MIDDLE_GOAL, 0},
+      {PISTON_HOOD, PISTON_RIGHT_DESCORE, 0},
+  };
+
+  /**
+   * Creates the sequencer.  Every output starts retracted and stopped.
+   *
+   * \param pistons
+   *        one piston per piston_id, in order
+   * \param intake
+   *        intake motor
+   * \param hood
+   *        hood motor
+   */
+  actuators(std::array<pros::adi::DigitalOut*, PISTON_COUNT> pistons, pros::Motor& intake, pros::Motor& hood);
+
+  /**
+   * Sets a piston target.  Extending it retracts anything it's interlocked with.
+   *
+   * \param piston
+   *        piston to set
+   * \param extended
+   *        true to extend
+   */
+  void piston_set(piston_id piston, bool extended);
+
+  /**
+   * Returns a piston target.
+   *
+   * \param piston
+   *        piston to check
+   */
+  bool piston_get(piston_id piston);
+
+  /**
+   * Returns true if the piston is extended right now.  Lags piston_get() while an interlock
+   * gap runs.
+   *
+   * \param piston
+   *        piston to check
+   */
+  bool piston_output_get(piston_id piston);
+
+  /**
+   * Sets a roller target.
+   *
+   * \param roller
+   *        roller to set
+   * \param speed
+   *        -127 to 127
+   */
+  void roller_set(roller_id roller, int speed);
+
+  /**
+   * Returns a roller target.
+   *
+   * \param roller
+   *        roller to check
+   */
+  int roller_get(roller_id roller);
+
+  /**
+   * Returns true while any target hasn't reached its output yet.
+   */
+  bool busy();
+
+  /**
+   * Applies interlocks and writes outputs.  Scheduler stage, runs every tick.
+   */
+  void update();
+
+  // Driver controls.  Each toggles one function, the same as the old handlers in main.cpp
+  void matchload_toggle();
+  void aligner_toggle();
+  void right_descore_toggle();
+  void middle_goal_toggle();
+  void bottom_intake_toggle();
+  void top_score_toggle();
+  void rollers_stop();
+
+  /**
+   * Returns true while the bottom intake toggle is on.
+   */
+  bool bottom_intake_get();
+
+ private:
+  std::array<pros::adi::DigitalOut*, PISTON_COUNT> devices;
+  std::array<pros::Motor*, ROLLER_COUNT> motors;
+  std::array<bool, PISTON_COUNT> target{};
+  std::array<bool, PISTON_COUNT> output{};
+  std::array<bool, PISTON_COUNT> retracted{};  // has retracted since boot, retracted_at is set
+  std::array<std::uint32_t, PISTON_COUNT> retracted_at{};
+  std::array<int, ROLLER_COUNT> roller_target{};
+  std::array<int, ROLLER_COUNT> roller_output{};
+  bool bottom_intake = false;
+  pros::Mutex mutex;
+  void piston_target_set(piston_id piston, bool extended);
+};
+}  // namespace robot
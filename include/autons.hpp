@@ -23,4 +23,5 @@ void LEFT_SIDE_NO_AWP();
 void auton_button_5();
 void auton_button_6();
 void auton_button_8();
+void drive_characterize();
 
@@ -0,0 +1,104 @@
+/*
+This Source Code Form is subject to the terms of the Mozilla Public
+License, v. 2.0. If a copy of the MPL was not distributed with this
+file, You can obtain one at http://mozilla.org/MPL/2.0/.
+*/
+
+#pragma once
+
+#include "api.h"
+#include "feedforward.hpp"
+
+namespace robot {
+/**
+ * Drives the chassis at velocities instead of raw outputs.
+ *
+ * Motions that know the velocity and acceleration they want ask for them here and add their own
+ * feedback on top, so the feedback only corrects what the feedforward misses and can run much
+ * lower gains.  EZ's own motions drive the motors from inside ez::Drive and keep using only
+ * their PIDs.
+ *
+ * Until gains are set or characterize() measures them, kV is full output over the drive's free
+ * speed and kS and kA are 0, which is the plain fraction of top speed motions used before.
+ */
+class drive_velocity {
+ public:
+  /**
+   * Sets both sides' gains, eg. from what characterize() printed.
+   *
+   * \param left
+   *        left side
+   * \param right
+   *        right side
+   */
+  void gains_set(feedforward_gains left, feedforward_gains right);
+
+  /**
+   * Returns the left side's gains, the free speed fallback if none were set.
+   */
+  feedforward_gains left_gains_get();
+
+  /**
+   * Returns the right side's gains, the free speed fallback if none were set.
+   */
+  feedforward_gains right_gains_get();
+
+  /**
+   * Returns the drive's free speed in in/s, from the wheel size and ratio EZ was built with.
+   * Motor encoders count 3000 ticks a second at full speed on every cartridge, so it's
+   * 3000 / chassis.drive_tick_per_inch().  Needs the integrated encoder constructor, with
+   * tracking wheels in it EZ's ticks per inch are theirs.
+   */
+  double top_speed_get();
+
+  /**
+   * Returns a side's velocity in in/s from its motors' rpm.
+   *
+   * \param rpm
+   *        average motor rpm, eg. robot::motor_telemetry::left_velocity()
+   */
+  double wheel_velocity_get(double rpm);
+
+  /**
+   * Drives both sides at a velocity and acceleration, plus feedback.
+   *
+   * \param left_velocity
+   *        in/s
+   * \param right_velocity
+   *        in/s
+   * \param left_accel
+   *        in/s^2
+   * \param right_accel
+   *        in/s^2
+   * \param left_feedback
+   *        output added to the left side's feedforward
+   * \param right_feedback
+   *        output added to the right side's feedforward
+   */
+  void set(double left_velocity, double right_velocity, double left_accel = 0.0, double right_accel = 0.0, double left_feedback = 0.0,
+           double right_feedback = 0.0);
+
+  /**
+   * Runs the characterization: a slow ramp forward and back, then a fast step forward and back,
+   * each at most settings.max_distance.  Blocks until it's done, about 20 seconds, then sets the
+   * gains it measured and prints them.  Returns false, keeping the old gains, if either side
+   * fit poorly.
+   *
+   * \param settings
+   *        how hard and how far to drive
+   */
+  bool characterize(characterize_settings settings = {});
+
+ private:
+  pros::Mutex mutex;
+  feedforward_gains left;
+  feedforward_gains right;
+  bool measured = false;
+  feedforward_gains fallback_get();
+};
+
+/**
+ * Velocity control for the chassis.
+ */
+extern drive_velocity chassis_velocity;
+}  // namespace robot
@@ -0,0 +1,204 @@
+/*
+This Source Code Form is subject to the terms of the Mozilla Public
+License, v. 2.0. If a copy of the MPL was not distributed with this
+file, You can obtain one at http://mozilla.org/MPL/2.0/.
+*/
+
+#pragma once
+
+#include <cstdint>
+#include <span>
+
+#include "EZ-Template/PID.hpp"
+#include "api.h"
+#include "settle_predictor.hpp"
+#include "telemetry.hpp"
+
+namespace robot {
+/**
+ * How pid_exit decides a motion is over.
+ */
+enum exit_mode {
+  EXIT_TIMERS = 0,     // EZ-Template's small, big and velocity timers only
+  EXIT_PREDICTED = 1,  // also exits as soon as robot::settle_predictor sees the error settle
+};
+
+/**
+ * Exits taken and time saved by predicted exits, across every robot::pid_wait() and profiled
+ * motion since the last exit_stats_reset().
+ */
+struct exit_stats {
+  int motions = 0;
+  int predicted = 0;             // motions a prediction ended
+  std::uint32_t saved = 0;       // ms, at least, the timers would have taken longer
+  std::uint32_t last_saved = 0;  // ms, the last motion
+};
+
+/**
+ * Sets how every pid_exit made or reset from now on exits.
+ *
+ * \param mode
+ *        EXIT_TIMERS or EXIT_PREDICTED
+ */
+void exit_mode_set(exit_mode mode);
+
+/**
+ * Returns how pid_exits exit.
+ */
+exit_mode exit_mode_get();
+
+/**
+ * Records how a motion ended, for exit_stats_get().
+ *
+ * \param saved
+ *        ms the prediction saved, 0 if the timers ended it
+ */
+void exit_stats_add(std::uint32_t saved);
+
+/**
+ * Returns the exits since the last reset.
+ */
+exit_stats exit_stats_get();
+
+/**
+ * Clears the exit stats.
+ */
+void exit_stats_reset();
+
+/**
+ * Prints the exit stats.
+ */
+void exit_stats_print();
+
+/**
+ * Exit conditions for an ez::PID that never copy motors or allocate.
+ *
+ * ez::PID::exit_condition(std::vector<pros::Motor>) takes the motors by value every loop.
+ * These overloads take a view of the motors, the shared telemetry, or a current draw the
+ * caller already has, and keep the mA timeout here instead.
+ *
+ * In EXIT_PREDICTED mode the PID's error also feeds a robot::settle_predictor, and the motion
+ * exits SMALL_EXIT the tick the error is predicted to stay in small_error, or BIG_EXIT once it
+ * has stopped for good inside big_error (only for PIDs without ki, whose integral would keep
+ * pushing).  EZ's timers still run underneath and end anything the prediction doesn't.
+ */
+class pid_exit {
+ public:
+  /**
+   * Watches a PID.  The PID has to outlive this.
+   *
+   * \param pid
+   *        the PID to check exit conditions on
+   */
+  pid_exit(ez::PID& pid);
+
+  /**
+   * Iterative exit condition using an over current flag the caller already read.
+   *
+   * \param over_current
+   *        true while the motor is over current, eg. pros::Motor::is_over_current()
+   * \param print = false
+   *        if true, prints when complete
+   */
+  ez::exit_output exit_condition(bool over_current, bool print = false);
+
+  /**
+   * Iterative exit condition.  Reads the motors' over current flags without copying them.
+   *
+   * \param motors
+   *        motors on the mechanism
+   * \param print = false
+   *        if true, prints when complete
+   */
+  ez::exit_output exit_condition(std::span<const pros::Motor> motors, bool print = false);
+
+  /**
+   * Iterative exit condition using the chassis telemetry published this tick.  Like
+   * ez::Drive::pid_wait(), the mA timeout only reads the first motor of a side.  A sample
+   * already seen, when the caller runs on its own clock and got ahead of control_loop, doesn't
+   * move the mA timeout.
+   *
+   * \param telemetry
+   *        chassis telemetry
+   * \param left
+   *        true to check the left side's first motor
+   * \param right
+   *        true to check the right side's first motor
+   * \param print = false
+   *        if true, prints when complete
+   */
+  ez::exit_output exit_condition(const motor_telemetry& telemetry, bool left, bool right, bool print = false);
+
+  /**
+   * Resets the mA timeout and the prediction, and picks up the current exit_mode_get().
+   */
+  void reset();
+
+  /**
+   * Returns how many ms, at least, the last predicted exit beat the timers by, 0 if the timers
+   * ended it.
+   */
+  int saved_get();
+
+ private:
+  ez::PID* pid;
+  int mA_time = 0;
+  std::uint32_t sample_time = 0;  // ms, telemetry the mA timeout last counted
+  bool sampled = false;
+  exit_mode mode = EXIT_TIMERS;
+  settle_predictor predictor;
+  int small_time = 0;  // ms, how long EZ's own timers have been running
+  int big_time = 0;
+  int velocity_time = 0;
+  int saved = 0;
+  ez::exit_output mA_check(bool over_current, bool count, bool print);
+  ez::exit_output predict(bool print);
+};
+
+/**
+ * How a wait on chassis exits ended.
+ */
+struct exit_wait_result {
+  ez::exit_output exit = ez::RUNNING;  // mA_EXIT if any PID timed out on current, else the last to exit
+  bool interfered = false;             // a PID ended on mA_EXIT or VELOCITY_EXIT, like ez::Drive::interfered
+  int saved = 0;                       // ms the last PID to exit beat its timers by
+  bool aborted = false;                // the robot was disabled or the competition mode changed, exit is RUNNING
+};
+
+/**
+ * The loop behind pid_wait().  Checks exits against drive_telemetry every DELAY_TIME until
+ * they end: left and right for DRIVE, angular for TURN and SWING.  The mA timeout reads the
+ * same motors ez::Drive::pid_wait() does, the first motor of each side for drives and turns
+ * and of the swinging side for swings.  Returns early, aborted, once the robot is disabled or
+ * the competition mode changes.  Doesn't allocate.
+ *
+ * \param mode
+ *        DRIVE, TURN or SWING
+ * \param swing
+ *        which side a SWING drives
+ * \param left
+ *        exits of the left side
+ * \param right
+ *        exits of the right side
+ * \param angular
+ *        exits of the turn or swing
+ * \param print
+ *        if true, prints when each exits
+ */
+exit_wait_result exits_wait(ez::e_mode mode, ez::e_swing swing, pid_exit& left, pid_exit& right, pid_exit& angular, bool print);
+
+/**
+ * Waits for the chassis to settle, a drop in for chassis.pid_wait() that doesn't allocate.
+ *
+ * Lets the PID run for one DELAY_TIME first and sets chassis.interfered on mA and velocity
+ * exits, the same as EZ.  Drive, turn and swing motions check exits with exits_wait().  Odom
+ * motions depend on EZ-Template internals, so they fall back to chassis.pid_wait().  Every
+ * motion is counted in exit_stats_get(), and ends its robot::chassis_events.
+ */
+void pid_wait();
+
+/**
+ * chassis.pid_wait_quick_chain() that also ends the motion's robot::chassis_events.
+ */
+void pid_wait_quick_chain();
+}  // namespace robot
@@ -0,0 +1,225 @@
+/*
+This Source Code Form is subject to the terms of the Mozilla Public
+License, v. 2.0. If a copy of the MPL was not distributed with this
+file, You can obtain one at http://mozilla.org/MPL/2.0/.
+*/
+
+#pragma once
+
+#include <cmath>
+#include <vector>
+
+// Drive feedforward, output = kS * sign(v) + kV * v + kA * a, and the routine that measures it.
+// No PROS dependencies so the host bench characterizes a simulated drive with the same code.
+// Outputs are chassis.drive_set() units, -127 to 127.
+
+namespace robot {
+/**
+ * Feedforward for one side of the drive.
+ */
+struct feedforward_gains {
+  double kS = 0.0;  // output to break static friction
+  double kV = 0.0;  // output per in/s
+  double kA = 0.0;  // output per in/s^2
+};
+
+/**
+ * Returns the output that holds a side at a velocity and acceleration.
+ *
+ * \param gains
+ *        the side's gains
+ * \param velocity
+ *        in/s
+ * \param acceleration
+ *        in/s^2
+ */
+inline double feedforward_output(const feedforward_gains& gains, double velocity, double acceleration) {
+  // Friction opposes motion, or the motion about to start when standing still
+  double direction = std::fabs(velocity) > 1e-3 ? velocity : acceleration;
+  double sign = direction > 0.0 ? 1.0 : (direction < 0.0 ? -1.0 : 0.0);
+  return gains.kS * sign + gains.kV * velocity + gains.kA * acceleration;
+}
+
+/**
+ * Output and velocity of one side on one tick of characterization.
+ */
+struct feedforward_sample {
+  int test = 0;  // samples from different tests aren't differentiated across
+  double output = 0.0;
+  double velocity = 0.0;  // in/s
+};
+
+/**
+ * Gains fit to samples, with how well they explain them.
+ */
+struct feedforward_fit {
+  feedforward_gains gains;
+  double r2 = 0.0;  // 1 is a perfect fit
+  int samples = 0;  // samples used
+};
+
+/**
+ * Least squares fit of output = kS * sign(v) + kV * v + kA * a.  Acceleration is the central
+ * difference of velocity within each test, samples slower than min_velocity are left out since
+ * static friction isn't linear.
+ *
+ * \param samples
+ *        one side's samples, in tick order
+ * \param dt
+ *        seconds between samples
+ * \param min_velocity
+ *        in/s
+ */
+inline feedforward_fit feedforward_fit_get(const std::vector<feedforward_sample>& samples, double dt, double min_velocity = 1.0) {
+  double A[3][3] = {}, b[3] = {}, sum = 0.0, sum2 = 0.0;
+  int n = 0;
+  for (std::size_t i = 1; i + 1 < samples.size(); i++) {
+    const auto& s = samples[i];
+    if (samples[i - 1].test != s.test || samples[i + 1].test != s.test || std::fabs(s.velocity) < min_velocity) continue;
+    double x[3] = {s.velocity > 0.0 ? 1.0 : -1.0, s.velocity, (samples[i + 1].velocity - samples[i - 1].velocity) / (2.0 * dt)};
+    for (int r = 0; r < 3; r++) {
+      for (int c = 0; c < 3; c++) A[r][c] += x[r] * x[c];
+      b[r] += x[r] * s.output;
+    }
+    sum += s.output;
+    sum2 += s.output * s.output;
+    n++;
+  }
+
+  // Normal equations by Gaussian elimination with partial pivoting
+  feedforward_fit out;
+  out.samples = n;
+  double k[3] = {};
+  for (int c = 0; c < 3; c++) {
+    int pivot = c;
+    for (int r = c + 1; r < 3; r++)
+      if (std::fabs(A[r][c]) > std::fabs(A[pivot][c])) pivot = r;
+    if (std::fabs(A[pivot][c]) < 1e-9) return out;
+    for (int j = 0; j < 3; j++) std::swap(A[c][j], A[pivot][j]);
+    std::swap(b[c], b[pivot]);
+    for (int r = c + 1; r < 3; r++) {
+      double f = A[r][c] / A[c][c];
+      for (int j = c; j < 3; j++) A[r][j] -= f * A[c][j];
+      b[r] -= f * b[c];
+    }
+  }
+  for (int r = 2; r >= 0; r--) {
+    double v = b[r];
+    for (int j = r + 1; j < 3; j++) v -= A[r][j] * k[j];
+    k[r] = v / A[r][r];
+  }
+  out.gains = {k[0], k[1], k[2]};
+
+  // r^2 from a second pass, residuals against the fitted gains
+  double residual = 0.0, mean = sum / n;
+  for (std::size_t i = 1; i + 1 < samples.size(); i++) {
+    const auto& s = samples[i];
+    if (samples[i - 1].test != s.test || samples[i + 1].test != s.test || std::fabs(s.velocity) < min_velocity) continue;
+    double a = (samples[i + 1].velocity - samples[i - 1].velocity) / (2.0 * dt);
+    double e = s.output - feedforward_output(out.gains, s.velocity, a);
+    residual += e * e;
+  }
+  double total = sum2 - n * mean * mean;
+  out.r2 = total > 0.0 ? 1.0 - residual / total : 0.0;
+  return out;
+}
+
+/**
+ * How hard and how far the characterization drives.
+ */
+struct characterize_settings {
+  double ramp_rate = 8.0;     // output per second in the slow ramps
+  double ramp_max = 80.0;     // output the ramps stop at
+  double step_output = 60.0;  // output of the fast steps
+  double step_time = 1.5;     // seconds each step lasts at most
+  double rest_time = 1.0;     // seconds stopped between tests
+  double max_distance = 48.0;  // inches any test may drive, keep this much room in front and behind
+};
+
+/**
+ * The characterization routine, one tick at a time so the robot and the host can both drive it.
+ *
+ * A slow ramp forward and back, where acceleration is small and kS and kV show, then a fast step
+ * forward and back, where kA shows.  Every tick give it the measured side velocities and send
+ * the output it returns to both sides.
+ */
+class feedforward_characterizer {
+ public:
+  explicit feedforward_characterizer(characterize_settings input = {}) : settings(input) {}
+
+  /**
+   * Records this tick and returns the output to send to both sides.
+   *
+   * \param dt
+   *        seconds since the last tick
+   * \param left_velocity
+   *        in/s
+   * \param right_velocity
+   *        in/s
+   */
+  double update(double dt, double left_velocity, double right_velocity) {
+    if (done()) return 0.0;
+    distance += (left_velocity + right_velocity) / 2.0 * dt;
+    time += dt;
+
+    // A test ends at its time or output limit, or when it's driven as far as it may
+    double travelled = std::fabs(distance - test_start);
+    bool over = travelled >= settings.max_distance;
+    switch (test) {
+      case RAMP_FORWARD:
+      case RAMP_REVERSE:
+        output = (test == RAMP_FORWARD ? 1.0 : -1.0) * settings.ramp_rate * time;
+        over = over || std::fabs(output) >= settings.ramp_max;
+        break;
+      case STEP_FORWARD:
+      case STEP_REVERSE:
+        output = (test == STEP_FORWARD ? 1.0 : -1.0) * settings.step_output;
+        over = over || time >= settings.step_time;
+        break;
+      default:
+        output = 0.0;
+        over = time >= settings.rest_time;
+        break;
+    }
+    if (over) {
+      test++;
+      time = 0.0;
+      test_start = distance;
+      output = 0.0;
+    } else if (output != 0.0) {
+      left.push_back({test, output, left_velocity});
+      right.push_back({test, output, right_velocity});
+    }
+    return output;
+  }
+
+  /**
+   * Returns true once every test has run.
+   */
+  bool done() const { return test == DONE; }
+
+  /**
+   * Returns the samples recorded for one side.
+   */
+  const std::vector<feedforward_sample>& left_samples() const { return left; }
+  const std::vector<feedforward_sample>& right_samples() const { return right; }
+
+ private:
+  enum { RAMP_FORWARD,
+         REST_1,
+         RAMP_REVERSE,
+         REST_2,
+         STEP_FORWARD,
+         REST_3,
+         STEP_REVERSE,
+         REST_4,
+         DONE };
+  characterize_settings settings;
+  int test = RAMP_FORWARD;
+  double time = 0.0;
+  double distance = 0.0;
+  double test_start = 0.0;
+  double output = 0.0;
+  std::vector<feedforward_sample> left, right;
+};
+}  // namespace robot
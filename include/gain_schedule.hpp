@@ -0,0 +1,174 @@
+/*
+This Source Code Form is subject to the terms of the Mozilla Public
+License, v. 2.0. If a copy of the MPL was not distributed with this
+file, You can obtain one at http://mozilla.org/MPL/2.0/.
+*/
+
+#pragma once
+
+// PID gain tables indexed by commanded speed, battery voltage and payload.  The points on each
+// axis are evenly spaced, so finding where a speed and voltage fall is a division, not a search,
+// and a lookup costs the same however big the table is.  No PROS dependencies so host tools
+// tune and check the same tables the robot runs.
+
+namespace robot {
+/**
+ * One set of PID constants, the same four as ez::PID::Constants.
+ */
+struct pid_gains {
+  double kp = 0.0;
+  double ki = 0.0;
+  double kd = 0.0;
+  double start_i = 0.0;
+};
+
+/**
+ * Evenly spaced points from first to last.
+ */
+struct schedule_axis {
+  double first = 0.0;
+  double last = 0.0;
+  int points = 1;  // at most gain_schedule::MAX_POINTS
+};
+
+/**
+ * Gains at every speed and voltage point, for an empty robot and one carrying a payload.
+ *
+ * get() blends the four points around a speed and voltage, clamped to the ends of each axis.
+ * The payload layer is the empty one until a payload point is set, so only the points that
+ * really change with a payload need tuning.
+ *
+ *   robot::gain_schedule turn({0, 127, 3}, {11.8, 12.6, 2});
+ *   turn.fill({3, 0.05, 20, 15});
+ *   turn.set(2, 0, {3.6, 0.05, 20, 15});  // full speed at 11.8 V
+ */
+class gain_schedule {
+ public:
+  static constexpr int MAX_POINTS = 6;
+
+  gain_schedule() = default;
+
+  /**
+   * Sets up the axes with every point 0.
+   *
+   * \param speed
+   *        commanded speed points, 0 to 127
+   * \param voltage
+   *        battery voltage points, in volts
+   */
+  gain_schedule(schedule_axis speed, schedule_axis voltage) { axes_set(speed, voltage); }
+
+  /**
+   * Sets up the axes.  Clears every point to 0.
+   *
+   * \param speed
+   *        commanded speed points, 0 to 127
+   * \param voltage
+   *        battery voltage points, in volts
+   */
+  void axes_set(schedule_axis speed, schedule_axis voltage) {
+    speeds = clamp_points(speed);
+    voltages = clamp_points(voltage);
+    fill({});
+  }
+
+  /**
+   * Sets every point, empty and with a payload, eg. to the constants from default_constants().
+   *
+   * \param gains
+   *        gains everywhere
+   */
+  void fill(pid_gains gains) {
+    for (auto& layer : table)
+      for (auto& row : layer)
+        for (pid_gains& point : row) point = gains;
+    loaded_set = false;
+  }
+
+  /**
+   * Sets one point.
+   *
+   * \param speed_point
+   *        index on the speed axis
+   * \param voltage_point
+   *        index on the voltage axis
+   * \param gains
+   *        gains there
+   * \param loaded
+   *        true for the payload layer
+   */
+  void set(int speed_point, int voltage_point, pid_gains gains, bool loaded = false) {
+    if (speed_point < 0 || speed_point >= speeds.points || voltage_point < 0 || voltage_point >= voltages.points) return;
+    if (loaded && !loaded_set) {
+      for (int v = 0; v < MAX_POINTS; v++)
+        for (int s = 0; s < MAX_POINTS; s++) table[1][v][s] = table[0][v][s];
+      loaded_set = true;
+    }
+    table[loaded ? 1 : 0][voltage_point][speed_point] = gains;
+  }
+
+  /**
+   * Returns the gains for a speed and voltage, blended from the points around them.
+   *
+   * \param speed
+   *        commanded speed, 0 to 127
+   * \param voltage
+   *        battery voltage, in volts
+   * \param loaded
+   *        true when carrying a payload
+   */
+  pid_gains get(double speed, double voltage, bool loaded = false) const {
+    int s, v;
+    double ts, tv;
+    locate(speeds, speed, s, ts);
+    locate(voltages, voltage, v, tv);
+    const auto& layer = table[loaded && loaded_set ? 1 : 0];
+    int s1 = speeds.points > 1 ? s + 1 : s, v1 = voltages.points > 1 ? v + 1 : v;
+    pid_gains low = blend(layer[v][s], layer[v][s1], ts);
+    pid_gains high = blend(layer[v1][s], layer[v1][s1], ts);
+    return blend(low, high, tv);
+  }
+
+  /**
+   * Returns the speed axis.
+   */
+  schedule_axis speed_axis_get() const { return speeds; }
+
+  /**
+   * Returns the voltage axis.
+   */
+  schedule_axis voltage_axis_get() const { return voltages; }
+
+ private:
+  pid_gains table[2][MAX_POINTS][MAX_POINTS] = {};  // [payload][voltage][speed]
+  schedule_axis speeds;
+  schedule_axis voltages;
+  bool loaded_set = false;
+
+  static schedule_axis clamp_points(schedule_axis axis) {
+    if (axis.points < 1) axis.points = 1;
+    if (axis.points > MAX_POINTS) axis.points = MAX_POINTS;
+    return axis;
+  }
+
+  // Point at or before x and how far x is toward the next one, clamped to the axis
+  static void locate(const schedule_axis& axis, double x, int& point, double& t) {
+    point = 0;
+    t = 0.0;
+    if (axis.points < 2 || axis.last == axis.first) return;
+    double f = (x - axis.first) / (axis.last - axis.first) * (axis.points - 1);
+    if (!(f > 0.0)) return;  // also catches nan
+    if (f >= axis.points - 1) {
+      point = axis.points - 2;
+      t = 1.0;
+      return;
+    }
+    point = (int)f;
+    t = f - point;
+  }
+
+  static pid_gains blend(const pid_gains& a, const pid_gains& b, double t) {
+    return {a.kp + (b.kp - a.kp) * t, a.ki + (b.ki - a.ki) * t, a.kd + (b.kd - a.kd) * t, a.start_i + (b.start_i - a.start_i) * t};
+  }
+};
+}  // namespace robot
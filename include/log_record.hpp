@@ -0,0 +1,69 @@
+/*
+This Source Code Form is subject to the terms of the Mozilla Public
+License, v. 2.0. If a copy of the MPL was not distributed with this
+file, You can obtain one at http://mozilla.org/MPL/2.0/.
+*/
+
+#pragma once
+
+#include <cstdint>
+
+// Layout of the binary logs the recorder writes to /usd.  This header has no PROS
+// dependencies so the host decoder can read logs with the exact same structs.
+
+namespace robot {
+constexpr std::uint32_t LOG_MAGIC = 0x474c5a45;  // "EZLG" in a little endian file
+constexpr std::uint16_t LOG_VERSION = 2;
+
+/**
+ * Written once at the start of every log file.
+ */
+struct log_header {
+  std::uint32_t magic = LOG_MAGIC;
+  std::uint16_t version = LOG_VERSION;
+  std::uint16_t record_size = 0;
+  std::uint32_t start_time = 0;  // ms since the brain started
+  std::uint32_t period = 0;      // ms between records
+};
+
+/**
+ * Terms of one ez::PID on one tick.
+ */
+struct pid_terms {
+  float target = 0.0f;
+  float current = 0.0f;
+  float error = 0.0f;
+  float output = 0.0f;
+  float integral = 0.0f;
+  float derivative = 0.0f;
+};
+
+/**
+ * One control tick.  Fixed size, written to the file exactly as it is in memory.
+ */
+struct log_record {
+  std::uint32_t time = 0;  // ms
+  std::uint32_t tick = 0;  // control_loop tick
+  float x = 0.0f;          // pose from robot::chassis_pose
+  float y = 0.0f;
+  float theta = 0.0f;
+  float velocity = 0.0f;
+  pid_terms primary;    // drive: left, turn/swing: the angle PID, odom: xy
+  pid_terms secondary;  // drive: right, odom: angular
+  std::int16_t current[6] = {};  // mA, chassis motors in robot::motor_telemetry order
+  std::uint8_t mode = 0;         // ez::e_mode
+  std::uint8_t exit = 0;         // ez::exit_output of the last robot::pid_wait(), 1 while running, 0 unknown
+  std::uint16_t dropped = 0;     // records lost to a full ring just before this one
+  float odom_forward = 0.0f;     // robot::fusion_input this tick, zero while fusion isn't running
+  float odom_right = 0.0f;
+  float odom_turn = 0.0f;
+  float distance = -1.0f;        // inches, negative without a reading
+  float gps_x = 0.0f;            // inches from the field center
+  float gps_y = 0.0f;
+  float gps_theta = 0.0f;
+  float gps_error = -1.0f;       // inches, negative without a fix
+};
+
+static_assert(sizeof(log_header) == 16, "log_header layout changed, bump LOG_VERSION");
+static_assert(sizeof(log_record) == 120, "log_record layout changed, bump LOG_VERSION");
+}  // namespace robot
@@ -44,7 +44,21 @@
 #include "EZ-Template/api.hpp"
 
 // More includes here...
+#include "actuators.hpp"
 #include "autons.hpp"
+#include "drive_velocity.hpp"
+#include "exit_condition.hpp"
+#include "motion_events.hpp"
+#include "path_cache.hpp"
+#include "pid_schedule.hpp"
+#include "pose_fusion.hpp"
+#include "pose_snapshot.hpp"
+#include "profiled_motion.hpp"
+#include "recorder.hpp"
+#include "scheduler.hpp"
+#include "telemetry.hpp"
+#include "trajectory.hpp"
+#include "trajectory_library.hpp"
 #include "subsystems.hpp"
 
 
@@ -0,0 +1,334 @@
+/*
+This Source Code Form is subject to the terms of the Mozilla Public
+License, v. 2.0. If a copy of the MPL was not distributed with this
+file, You can obtain one at http://mozilla.org/MPL/2.0/.
+*/
+
+#pragma once
+
+#include <cmath>
+
+// Plans a queue of drives and turns as one motion, rounding drive, turn, drive corners into arcs
+// so the robot carries its speed through them.  No PROS dependencies so host tools time the same
+// plans the robot follows.
+
+namespace robot {
+/**
+ * One queued motion.
+ */
+struct chain_motion {
+  bool turn = false;      // true for a turn
+  bool relative = false;  // the turn is by target from the heading the last motion ended at
+  double target = 0.0;    // in to drive, negative is backwards, or degrees to turn to or by
+  double velocity = 0.0;  // in/s the fastest wheel may go
+};
+
+/**
+ * Limits for a chain.  Accelerations are at the wheels.
+ */
+struct chain_settings {
+  double accel = 170.0;         // in/s^2
+  double radius = 12.0;         // in, corners are rounded with this unless the drives are too short for it
+  double lateral_accel = 120.0; // in/s^2 the robot can corner with before it slides wide
+  double half_width = 5.75;     // in, half the track width
+};
+
+/**
+ * Where a chain is at one time, wheel distances from where it started.
+ */
+struct chain_state {
+  double left = 0.0;     // in
+  double right = 0.0;
+  double heading = 0.0;  // degrees
+  double left_velocity = 0.0;
+  double right_velocity = 0.0;
+  double left_accel = 0.0;
+  double right_accel = 0.0;
+  bool turning = false;  // in a turn in place
+};
+
+/**
+ * A queue of drives and turns planned as one motion.
+ *
+ * A turn between two drives the same way becomes a curve tangent to both, cutting the corner but
+ * ending where the three motions would have, and the robot carries its speed from one to the
+ * next.  The curve's curvature ramps up to 1 / settings.radius and back down, so the wheels
+ * change speed smoothly going into and out of it instead of stepping.  Each piece is a trapezoid that starts and ends at whatever
+ * speed the neighbouring pieces allow: the slower of their caps, 0 wherever a wheel would have to
+ * reverse, like a turn in place or a drive that backs up, and never more than the accel can reach
+ * or stop from.  Curves are capped so the outer wheel stays under the turn's speed and the corner
+ * under lateral_accel.
+ */
+class motion_chain {
+ public:
+  static constexpr int MAX_MOTIONS = 16;
+
+  /**
+   * Plans the motions.  Returns false, and plans nothing, if there are more than MAX_MOTIONS.
+   *
+   * \param motions
+   *        queued motions in order
+   * \param count
+   *        how many
+   * \param heading
+   *        heading the chain starts at, the first turn turns from here
+   * \param settings
+   *        limits
+   */
+  bool plan(const chain_motion* motions, int count, double heading, const chain_settings& settings) {
+    size = 0;
+    blends = 0;
+    stops = 0;
+    heading_start = heading_end = heading;
+    if (count > MAX_MOTIONS) return false;
+
+    // Straight line and turn in place legs, motions that go nowhere dropped
+    double distance[MAX_MOTIONS], turn[MAX_MOTIONS], velocity[MAX_MOTIONS];
+    int legs = 0;
+    for (int i = 0; i < count; i++) {
+      double d = motions[i].turn ? 0.0 : motions[i].target;
+      double a = !motions[i].turn ? 0.0 : motions[i].relative ? motions[i].target : motions[i].target - heading_end;
+      if (std::fabs(d) < 1e-6 && std::fabs(a) < 1e-6) continue;
+      heading_end += a;
+      distance[legs] = d;
+      turn[legs] = a;
+      velocity[legs] = motions[i].velocity;
+      legs++;
+    }
+
+    // Round drive, turn, drive corners.  The curvature ramps up and back down over the corner so
+    // neither wheel's speed steps going in or out of it, at its sharpest the corner turns at
+    // settings.radius.  A drive between two turns gives at most half its length to the first
+    // corner, so the corners at either end of it can't overlap
+    double corner[MAX_MOTIONS] = {};
+    for (int i = 1; i + 1 < legs; i++) {
+      double before = distance[i - 1], after = distance[i + 1];
+      if (turn[i] == 0.0 || turn[i - 1] != 0.0 || turn[i + 1] != 0.0 || before == 0.0 || after == 0.0 || (before > 0.0) != (after > 0.0)) continue;
+      double angle = std::fabs(turn[i]) * M_PI / 180.0;
+      if (angle >= M_PI - 1e-3) continue;
+      double tangent = corner_tangent(angle);
+      double room = std::fmin(std::fabs(before), i + 2 == legs ? std::fabs(after) : 0.5 * std::fabs(after));
+      double length = std::fmin(2.0 * angle * settings.radius, room / tangent);
+      // Keeps the inner wheel going forward at a fifth of the outer's speed or more
+      if (length / (2.0 * angle) < 1.5 * settings.half_width) continue;
+      double sign = before > 0.0 ? 1.0 : -1.0;
+      distance[i - 1] -= sign * length * tangent;
+      distance[i + 1] -= sign * length * tangent;
+      distance[i] = sign;
+      corner[i] = length;
+      blends++;
+    }
+
+    // Pieces, each parametrised by u, the center distance or for a turn in place the wheel distance
+    double left = 0.0, right = 0.0, angle = heading;
+    for (int i = 0; i < legs; i++) {
+      double d = distance[i], a = turn[i] * M_PI / 180.0, h = settings.half_width;
+      if (corner[i] > 0.0) {
+        // Curvature up to its peak over the first half, back down over the second
+        double peak = 2.0 * a / corner[i];
+        piece_add(corner[i] / 2.0, d, 0.0, peak, h, velocity[i], settings, left, right, angle);
+        piece_add(corner[i] / 2.0, d, peak, 0.0, h, velocity[i], settings, left, right, angle);
+      } else if (std::fabs(d) > 1e-6) {
+        piece_add(std::fabs(d), d > 0.0 ? 1.0 : -1.0, 0.0, 0.0, h, velocity[i], settings, left, right, angle);
+      } else if (std::fabs(a) > 1e-9) {
+        piece_add(std::fabs(a) * h, 0.0, 1.0 / std::copysign(h, a), 1.0 / std::copysign(h, a), h, velocity[i], settings, left, right, angle);
+      }
+    }
+    left_end = left;
+    right_end = right;
+
+    // Speeds where pieces meet, then forward and backward passes so every piece can reach them
+    double junction[MAX_PIECES + 1];
+    junction[0] = junction[size] = 0.0;
+    for (int i = 1; i < size; i++) {
+      const piece& a = pieces[i - 1];
+      const piece& b = pieces[i];
+      bool reverses = a.left_ratio_end * b.left_ratio < 0.0 || a.right_ratio_end * b.right_ratio < 0.0;
+      junction[i] = reverses ? 0.0 : std::fmin(a.velocity, b.velocity);
+    }
+    for (int i = 1; i < size; i++) junction[i] = std::fmin(junction[i], std::sqrt(junction[i - 1] * junction[i - 1] + 2.0 * pieces[i - 1].accel * pieces[i - 1].length));
+    for (int i = size - 1; i > 0; i--) junction[i] = std::fmin(junction[i], std::sqrt(junction[i + 1] * junction[i + 1] + 2.0 * pieces[i].accel * pieces[i].length));
+    for (int i = 1; i < size; i++)
+      if (junction[i] == 0.0) stops++;
+
+    // Trapezoid through each piece
+    double time = 0.0;
+    for (int i = 0; i < size; i++) {
+      piece& p = pieces[i];
+      double in = junction[i], out = junction[i + 1];
+      p.start = time;
+      p.entry = in;
+      p.peak = std::fmin(p.velocity, std::sqrt((2.0 * p.accel * p.length + in * in + out * out) / 2.0));
+      p.peak = std::fmax(p.peak, std::fmax(in, out));
+      p.speed_up = (p.peak - in) / p.accel;
+      p.slow_down = (p.peak - out) / p.accel;
+      double ramps = (p.peak * p.peak - in * in + p.peak * p.peak - out * out) / (2.0 * p.accel);
+      p.cruise = p.peak > 0.0 ? std::fmax(0.0, p.length - ramps) / p.peak : 0.0;
+      time += p.speed_up + p.cruise + p.slow_down;
+    }
+    duration = time;
+    return true;
+  }
+
+  /**
+   * Returns the setpoint at a time since the start, holding the end once it's over.
+   *
+   * \param t
+   *        seconds
+   */
+  chain_state sample(double t) const {
+    chain_state out;
+    out.heading = heading_start;
+    if (size == 0) return out;
+    if (t >= duration) {
+      out.left = left_end;
+      out.right = right_end;
+      out.heading = heading_end;
+      out.turning = ends_turning();
+      return out;
+    }
+    int i = 0;
+    while (i + 1 < size && t >= pieces[i + 1].start) i++;
+    const piece& p = pieces[i];
+    double local = std::fmax(0.0, t - p.start), u, v, a;
+    if (local < p.speed_up) {
+      u = p.entry * local + p.accel * local * local / 2.0;
+      v = p.entry + p.accel * local;
+      a = p.accel;
+    } else if (local < p.speed_up + p.cruise) {
+      double c = local - p.speed_up;
+      u = (p.peak * p.peak - p.entry * p.entry) / (2.0 * p.accel) + p.peak * c;
+      v = p.peak;
+      a = 0.0;
+    } else {
+      // Slowing down is speeding up backwards from the end of the piece
+      double left_time = std::fmax(0.0, p.speed_up + p.cruise + p.slow_down - local);
+      double exit = p.peak - p.accel * p.slow_down;
+      u = p.length - (exit * left_time + p.accel * left_time * left_time / 2.0);
+      v = exit + p.accel * left_time;
+      a = -p.accel;
+    }
+    // Ratios change linearly through a corner piece, so a wheel's acceleration also has the
+    // ratio's change at this speed in it
+    double bend_left = (p.left_ratio_end - p.left_ratio) / p.length, bend_right = (p.right_ratio_end - p.right_ratio) / p.length;
+    double bend_heading = (p.heading_ratio_end - p.heading_ratio) / p.length;
+    double left_ratio = p.left_ratio + bend_left * u, right_ratio = p.right_ratio + bend_right * u;
+    out.left = p.left + p.left_ratio * u + bend_left * u * u / 2.0;
+    out.right = p.right + p.right_ratio * u + bend_right * u * u / 2.0;
+    out.heading = p.heading + p.heading_ratio * u + bend_heading * u * u / 2.0;
+    out.left_velocity = left_ratio * v;
+    out.right_velocity = right_ratio * v;
+    out.left_accel = left_ratio * a + bend_left * v * v;
+    out.right_accel = right_ratio * a + bend_right * v * v;
+    out.turning = in_place(p);
+    return out;
+  }
+
+  /**
+   * Returns how long the chain takes, in seconds.
+   */
+  double duration_get() const { return duration; }
+
+  /**
+   * Returns the heading the chain ends at.
+   */
+  double heading_get() const { return heading_end; }
+
+  /**
+   * Returns how many corners were rounded into arcs.
+   */
+  int blends_get() const { return blends; }
+
+  /**
+   * Returns how many times the chain stops before its end.
+   */
+  int stops_get() const { return stops; }
+
+  /**
+   * Returns true if the last piece turns in place, so the chain should exit on its heading.
+   */
+  bool ends_turning() const { return size > 0 && in_place(pieces[size - 1]); }
+
+ private:
+  static constexpr int MAX_PIECES = 2 * MAX_MOTIONS;  // a rounded corner is two
+
+  struct piece {
+    double length = 0.0;         // u, always positive
+    double left_ratio = 0.0;     // wheel in per u where the piece starts
+    double right_ratio = 0.0;
+    double heading_ratio = 0.0;  // degrees per u
+    double left_ratio_end = 0.0;  // the same where it ends
+    double right_ratio_end = 0.0;
+    double heading_ratio_end = 0.0;
+    double velocity = 0.0;       // u/s cap
+    double accel = 0.0;          // u/s^2
+    double left = 0.0;           // where the piece starts
+    double right = 0.0;
+    double heading = 0.0;
+    double start = 0.0;          // s
+    double entry = 0.0;          // u/s
+    double peak = 0.0;
+    double speed_up = 0.0;       // s
+    double cruise = 0.0;
+    double slow_down = 0.0;
+  };
+  piece pieces[MAX_PIECES];
+  int size = 0;
+  int blends = 0;
+  int stops = 0;
+  double duration = 0.0;
+  double heading_start = 0.0;
+  double heading_end = 0.0;
+  double left_end = 0.0;
+  double right_end = 0.0;
+
+  // True for a turn in place, the wheels going opposite ways at the same speed
+  static bool in_place(const piece& p) { return p.left_ratio_end != 0.0 && std::fabs(p.left_ratio_end + p.right_ratio_end) < 1e-9; }
+
+  // Tangent length of a corner of length 1 turning by angle radians, the curvature ramping up
+  // over the first half and back down over the second.  The corner starts heading along y, the
+  // tangents meet at x 0, y tangent, so the tangent is where it ends in x over sin(angle)
+  static double corner_tangent(double angle) {
+    constexpr int STEPS = 64;
+    double x = 0.0;
+    for (int i = 0; i < STEPS; i++) {
+      double s = (i + 0.5) / STEPS;
+      double theta = s < 0.5 ? 2.0 * angle * s * s : angle - 2.0 * angle * (1.0 - s) * (1.0 - s);
+      x += std::sin(theta) / STEPS;
+    }
+    return x / std::sin(angle);
+  }
+
+  // Adds a piece moving the center sign per u and turning from rate to rate_end radians per u,
+  // capped so the outer wheel stays under velocity and accel and the robot under lateral_accel
+  void piece_add(double length, double sign, double rate, double rate_end, double half_width, double velocity, const chain_settings& settings, double& left,
+                 double& right, double& heading) {
+    if (length < 1e-6) return;
+    piece& p = pieces[size++];
+    p.length = length;
+    p.left_ratio = sign + rate * half_width;
+    p.right_ratio = sign - rate * half_width;
+    p.heading_ratio = rate * 180.0 / M_PI;
+    p.left_ratio_end = sign + rate_end * half_width;
+    p.right_ratio_end = sign - rate_end * half_width;
+    p.heading_ratio_end = rate_end * 180.0 / M_PI;
+    double outer = std::fmax(std::fmax(std::fabs(p.left_ratio), std::fabs(p.right_ratio)), std::fmax(std::fabs(p.left_ratio_end), std::fabs(p.right_ratio_end)));
+    p.velocity = velocity / outer;
+    p.accel = settings.accel / outer;
+    double bend = std::fabs(rate_end - rate) * half_width / length;
+    if (bend > 0.0) {
+      // Half the wheels' accel goes to speeding up, half to bending
+      p.accel /= 2.0;
+      p.velocity = std::fmin(p.velocity, std::sqrt(settings.accel / (2.0 * bend)));
+    }
+    double sharpest = std::fmax(std::fabs(rate), std::fabs(rate_end));
+    if (sign != 0.0 && sharpest > 0.0 && settings.lateral_accel > 0.0) p.velocity = std::fmin(p.velocity, std::sqrt(settings.lateral_accel / sharpest));
+    p.left = left;
+    p.right = right;
+    p.heading = heading;
+    left += (p.left_ratio + p.left_ratio_end) / 2.0 * length;
+    right += (p.right_ratio + p.right_ratio_end) / 2.0 * length;
+    heading += (p.heading_ratio + p.heading_ratio_end) / 2.0 * length;
+  }
+};
+}  // namespace robot
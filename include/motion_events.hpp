@@ -0,0 +1,193 @@
+/*
+This Source Code Form is subject to the terms of the Mozilla Public
+License, v. 2.0. If a copy of the MPL was not distributed with this
+file, You can obtain one at http://mozilla.org/MPL/2.0/.
+*/
+
+#pragma once
+
+#include <array>
+#include <cstdint>
+#include <vector>
+
+#include "EZ-Template/util.hpp"
+#include "api.h"
+
+namespace robot {
+/**
+ * Callbacks that fire partway through a motion.
+ *
+ * check() runs in the control_loop right after the pose stage, so a callback fires on the same
+ * tick the pose that crosses its threshold is published.  The route thread registers events and
+ * carries on, nothing waits on the motion.
+ *
+ * Events belong to the motion they were added for.  robot::pid_wait() and
+ * robot::pid_wait_quick_chain() end it, and pid_odom_set() or path_set() start the next one, so
+ * an event that didn't fire is dropped instead of firing partway through a later motion.
+ */
+class motion_events {
+ public:
+  /**
+   * Function an event runs.  It runs in the control_loop task, so it should only set targets
+   * and never block.
+   */
+  using callback = void (*)();
+
+  /**
+   * Events that can wait at once.
+   */
+  static constexpr int MAX_EVENTS = 16;
+
+  /**
+   * Points kept from the last path passed to pid_odom_set().
+   */
+  static constexpr int MAX_PATH_POINTS = 32;
+
+  /**
+   * Fires once the robot is within radius of a point.  Returns an event id, or -1 if the
+   * queue is full.
+   *
+   * \param x
+   *        x of the point in inches, odom frame
+   * \param y
+   *        y of the point in inches, odom frame
+   * \param radius
+   *        distance from the point that fires the event, in inches
+   * \param fn
+   *        callback to run
+   */
+  int at_pose(double x, double y, double radius, callback fn);
+
+  /**
+   * Fires once the robot has passed a point, like chassis.pid_wait_until() on a point: past the
+   * line through it square to the way the robot approaches it from where it is now.  Unlike
+   * at_pose() it fires even if the path misses the point.  Returns an event id, or -1 if the
+   * queue is full.
+   *
+   * \param x
+   *        x of the point in inches, odom frame
+   * \param y
+   *        y of the point in inches, odom frame
+   * \param fn
+   *        callback to run
+   */
+  int past_point(double x, double y, callback fn);
+
+  /**
+   * Fires once the robot has travelled a distance from now, in any direction.  Returns an
+   * event id, or -1 if the queue is full.
+   *
+   * \param distance
+   *        inches of travel
+   * \param fn
+   *        callback to run
+   */
+  int at_distance(double distance, callback fn);
+
+  /**
+   * Fires once the robot has passed a point of the path last given to pid_odom_set().
+   * Returns an event id, or -1 if the queue is full or there is no such point.
+   *
+   * \param index
+   *        index of the input point, 0 is the first point
+   * \param fn
+   *        callback to run
+   */
+  int at_index(int index, callback fn);
+
+  /**
+   * Starts an odom motion through chassis.pid_odom_set() and keeps its points for at_index().
+   * Events from an earlier motion are dropped.
+   *
+   * \param path
+   *        points to drive through
+   */
+  void pid_odom_set(std::vector<ez::united_odom> path);
+
+  /**
+   * Starts an odom motion to one point, see pid_odom_set(std::vector<ez::united_odom>).
+   *
+   * \param target
+   *        point to drive to
+   */
+  void pid_odom_set(ez::united_odom target);
+
+  /**
+   * Keeps a path's points for at_index() without starting a motion.  For motions started some
+   * other way, like robot::path_cache.  Events from an earlier motion are dropped.
+   *
+   * \param start
+   *        pose the path starts from
+   * \param path
+   *        input points
+   */
+  void path_set(ez::pose start, const std::vector<ez::odom>& path);
+
+  /**
+   * Returns true if an event hasn't fired yet.
+   *
+   * \param id
+   *        id returned when the event was added
+   */
+  bool pending(int id);
+
+  /**
+   * Ends the current motion, dropping its events that haven't fired and its path.  Prints how
+   * many were dropped.
+   */
+  void motion_end();
+
+  /**
+   * Drops every event without running it.
+   */
+  void clear();
+
+  /**
+   * Returns inches travelled since the brain started.
+   */
+  double travelled_get();
+
+  /**
+   * Fires every event whose threshold the latest pose crossed.  Scheduler stage, runs every
+   * tick after the pose stage.
+   */
+  void check();
+
+ private:
+  enum trigger { POSE,
+                 PAST,
+                 DISTANCE,
+                 INDEX };
+  struct event {
+    int id = -1;  // -1 when the slot is free
+    trigger type = POSE;
+    double x = 0.0;  // POSE and PAST point, DISTANCE odometer reading to fire at
+    double y = 0.0;
+    double radius = 0.0;
+    double dx = 0.0;  // PAST approach direction
+    double dy = 0.0;
+    int index = 0;
+    callback fn = nullptr;
+  };
+  std::array<event, MAX_EVENTS> events;
+  std::array<ez::pose, MAX_PATH_POINTS + 1> path;  // start pose, then every input point
+  int path_size = 0;
+  int path_passed = 0;  // input points passed so far
+  double travelled = 0.0;
+  ez::pose last = {0.0, 0.0, 0.0};
+  bool have_last = false;
+  int next_id = 0;
+  pros::Mutex mutex;
+  int add(event e);
+};
+
+/**
+ * Events for the chassis, checked every control_loop tick.
+ */
+extern motion_events chassis_events;
+
+/**
+ * Scheduler stage that checks chassis_events.
+ */
+void chassis_events_check();
+}  // namespace robot
@@ -0,0 +1,185 @@
+/*
+This Source Code Form is subject to the terms of the Mozilla Public
+License, v. 2.0. If a copy of the MPL was not distributed with this
+file, You can obtain one at http://mozilla.org/MPL/2.0/.
+*/
+
+#pragma once
+
+#include <cmath>
+
+// One dimensional motion profiles from rest to rest, trapezoidal or jerk limited S-curve.  No
+// PROS dependencies so host tools time the same setpoints the robot follows.
+
+namespace robot {
+/**
+ * Shape of a profile's speed changes.
+ */
+enum profile_shape {
+  PROFILE_TRAPEZOID = 0,  // acceleration steps between 0 and the limit
+  PROFILE_S_CURVE = 1,    // acceleration ramps at the jerk limit, gentler on the wheels
+};
+
+/**
+ * Limits a profile stays inside, in the caller's units, eg. in/s or deg/s.
+ */
+struct motion_limits {
+  double velocity = 0.0;
+  double accel = 0.0;
+  double jerk = 0.0;  // only used by PROFILE_S_CURVE
+};
+
+/**
+ * Where a profile is at one time.
+ */
+struct motion_state {
+  double position = 0.0;
+  double velocity = 0.0;
+  double acceleration = 0.0;
+};
+
+/**
+ * A move of some distance from rest to rest in the least time the limits allow.
+ *
+ * Speeding up and slowing down are mirror images, each a jerk ramp, a constant acceleration and
+ * a jerk ramp back to 0 (the ramps are empty for a trapezoid), with a cruise at the top speed
+ * between them.  Moves too short to reach the top speed peak lower instead.
+ */
+class motion_profile {
+ public:
+  /**
+   * Plans a move.
+   *
+   * \param distance
+   *        signed distance to move
+   * \param limits
+   *        velocity, acceleration and jerk, all positive
+   * \param shape
+   *        trapezoid or S-curve
+   */
+  void generate(double distance, motion_limits limits, profile_shape shape) {
+    sign = distance < 0.0 ? -1.0 : 1.0;
+    length = std::fabs(distance);
+    jerk = limits.jerk;
+    s_curve = shape == PROFILE_S_CURVE && limits.jerk > 0.0;
+    if (length <= 0.0 || limits.velocity <= 0.0 || limits.accel <= 0.0) {
+      ramp = hold = cruise = peak_accel = peak = 0.0;
+      return;
+    }
+
+    // Distance spent speeding up grows with the peak, so a short move bisects for the peak that fits
+    double top = limits.velocity;
+    if (2.0 * speed_up_set(top, limits.accel) > length) {
+      double low = 0.0;
+      for (int i = 0; i < 60; i++) {
+        double mid = 0.5 * (low + top);
+        if (2.0 * speed_up_set(mid, limits.accel) > length) top = mid;
+        else low = mid;
+      }
+      top = low;
+    }
+    double speed_up = speed_up_set(top, limits.accel);
+    peak = top;
+    cruise = top > 0.0 ? (length - 2.0 * speed_up) / top : 0.0;
+  }
+
+  /**
+   * Returns the setpoint at a time since the start, holding the end once it's over.
+   *
+   * \param t
+   *        seconds
+   */
+  motion_state sample(double t) const {
+    double accelerating = 2.0 * ramp + hold;
+    motion_state out;
+    if (t <= 0.0) {
+      return out;
+    } else if (t < accelerating) {
+      out = speed_up_get(t);
+    } else if (t < accelerating + cruise) {
+      out = speed_up_get(accelerating);
+      out.position += peak * (t - accelerating);
+      out.acceleration = 0.0;
+    } else if (t < duration_get()) {
+      // Slowing down is speeding up backwards from the end
+      out = speed_up_get(duration_get() - t);
+      out.position = length - out.position;
+      out.acceleration = -out.acceleration;
+    } else {
+      out.position = length;
+    }
+    out.position *= sign;
+    out.velocity *= sign;
+    out.acceleration *= sign;
+    return out;
+  }
+
+  /**
+   * Returns how long the move takes, in seconds.
+   */
+  double duration_get() const { return 2.0 * (2.0 * ramp + hold) + cruise; }
+
+  /**
+   * Returns the highest speed the move reaches.
+   */
+  double peak_get() const { return peak; }
+
+  /**
+   * Returns the signed distance the move covers.
+   */
+  double distance_get() const { return sign * length; }
+
+ private:
+  double sign = 1.0;
+  double length = 0.0;
+  double jerk = 0.0;
+  bool s_curve = false;
+  double ramp = 0.0;        // s of jerk at each end of speeding up, 0 for a trapezoid
+  double hold = 0.0;        // s at peak_accel in between
+  double peak_accel = 0.0;  // highest acceleration reached
+  double peak = 0.0;        // top speed reached
+  double cruise = 0.0;      // s at the top speed
+
+  // Times speeding up from rest to top and returns the distance it takes
+  double speed_up_set(double top, double accel) {
+    if (!s_curve) {
+      ramp = 0.0;
+      peak_accel = accel;
+      hold = top / accel;
+    } else if (top * jerk >= accel * accel) {
+      ramp = accel / jerk;
+      peak_accel = accel;
+      hold = top / accel - ramp;
+    } else {
+      // Never reaches the acceleration limit before the ramps meet
+      ramp = std::sqrt(top / jerk);
+      peak_accel = jerk * ramp;
+      hold = 0.0;
+    }
+    return top * (2.0 * ramp + hold) / 2.0;  // symmetric about the midpoint of speeding up
+  }
+
+  // State t seconds into speeding up, unsigned
+  motion_state speed_up_get(double t) const {
+    motion_state out;
+    double j = s_curve ? jerk : 0.0;
+    double t1 = std::fmin(t, ramp);
+    out.acceleration = j * t1;
+    out.velocity = j * t1 * t1 / 2.0;
+    out.position = j * t1 * t1 * t1 / 6.0;
+    if (t <= ramp) return out;
+
+    double t2 = std::fmin(t - ramp, hold);
+    out.position += out.velocity * t2 + peak_accel * t2 * t2 / 2.0;
+    out.velocity += peak_accel * t2;
+    out.acceleration = peak_accel;
+    if (t <= ramp + hold) return out;
+
+    double t3 = std::fmin(t - ramp - hold, ramp);
+    out.position += out.velocity * t3 + peak_accel * t3 * t3 / 2.0 - j * t3 * t3 * t3 / 6.0;
+    out.velocity += peak_accel * t3 - j * t3 * t3 / 2.0;
+    out.acceleration = peak_accel - j * t3;
+    return out;
+  }
+};
+}  // namespace robot
@@ -0,0 +1,188 @@
+/*
+This Source Code Form is subject to the terms of the Mozilla Public
+License, v. 2.0. If a copy of the MPL was not distributed with this
+file, You can obtain one at http://mozilla.org/MPL/2.0/.
+*/
+
+#pragma once
+
+#include <cstdint>
+#include <unordered_map>
+#include <vector>
+
+#include "EZ-Template/util.hpp"
+#include "route.hpp"
+#include "velocity_profile.hpp"
+
+namespace robot {
+/**
+ * A pure pursuit path with points already injected and smoothed.  Never changes once compiled.
+ */
+struct compiled_path {
+  std::uint64_t key = 0;
+  std::vector<ez::odom> points;  // ready for chassis.pid_odom_pp_set()
+  std::vector<int> input_index;  // index in points of every input point
+};
+
+/**
+ * Settings a path is compiled with.  Part of the key, so changing any of them compiles a new path.
+ */
+struct path_settings {
+  double spacing = 0.5;  // inches between injected points
+  double weight_smooth = 0.75;
+  double weight_data = 0.03;
+  double tolerance = 0.0001;
+  profile_settings profile{};  // per point speed, see velocity_profile()
+};
+
+/**
+ * Returns the key a path is cached under, a hash of everything that changes the compiled path.
+ *
+ * \param start
+ *        pose the path starts from
+ * \param movements
+ *        input points
+ * \param settings
+ *        spacing and smoothing constants
+ */
+std::uint64_t path_key(ez::pose start, const std::vector<ez::odom>& movements, const path_settings& settings);
+
+/**
+ * Injects and smooths a path the same way pid_odom_smooth_pp_set() does, without touching
+ * the chassis, then gives every point a speed from velocity_profile().
+ *
+ * \param start
+ *        pose the path starts from
+ * \param movements
+ *        input points
+ * \param settings
+ *        spacing and smoothing constants
+ */
+compiled_path path_compile(ez::pose start, const std::vector<ez::odom>& movements, const path_settings& settings);
+
+/**
+ * Pure pursuit paths compiled ahead of time.
+ *
+ * pid_odom_smooth_pp_set() injects and smooths the path when the motion starts, and the robot
+ * sits still while it does.  Compile routes here in initialize() instead, then start them with
+ * pid_odom_smooth_pp_set() below, which only looks the path up and starts driving.
+ */
+class path_cache {
+ public:
+  /**
+   * Compiles a path with the chassis' current spacing and smoothing constants, or returns it
+   * if it's already compiled.
+   *
+   * \param start
+   *        pose the path starts from, the previous motion's target
+   * \param movements
+   *        input points
+   */
+  const compiled_path& compile(ez::pose start, const std::vector<ez::odom>& movements);
+
+  /**
+   * Compiles a path, see compile(ez::pose, const std::vector<ez::odom>&).
+   *
+   * \param start
+   *        pose the path starts from, the previous motion's target
+   * \param movements
+   *        input points, with okapi units
+   */
+  const compiled_path& compile(ez::pose start, const std::vector<ez::united_odom>& movements);
+
+  /**
+   * Starts a compiled path with chassis.pid_odom_pp_set().  A path that wasn't compiled yet is
+   * compiled first, and a warning is printed because that's the wait this class removes.
+   *
+   * \param start
+   *        pose the path starts from, the previous motion's target
+   * \param movements
+   *        input points
+   * \param slew_on
+   *        ramp up from a lower speed to your target speed
+   */
+  void pid_odom_smooth_pp_set(ez::pose start, const std::vector<ez::odom>& movements, bool slew_on = false);
+
+  /**
+   * Starts a compiled path, see pid_odom_smooth_pp_set(ez::pose, const std::vector<ez::odom>&, bool).
+   *
+   * \param start
+   *        pose the path starts from, the previous motion's target
+   * \param movements
+   *        input points, with okapi units
+   * \param slew_on
+   *        ramp up from a lower speed to your target speed
+   */
+  void pid_odom_smooth_pp_set(ez::pose start, const std::vector<ez::united_odom>& movements, bool slew_on = false);
+
+  /**
+   * Sets the velocity profile paths are compiled with.  Paths compiled before keep theirs, so
+   * set it in initialize() before compiling.
+   *
+   * \param profile
+   *        per point speed limits, see velocity_profile()
+   */
+  void profile_set(const profile_settings& profile);
+
+  /**
+   * Returns the velocity profile paths are compiled with.
+   */
+  profile_settings profile_get() const;
+
+  /**
+   * Returns a compiled path, or nullptr if nothing is cached under the key.
+   *
+   * \param key
+   *        key from path_key()
+   */
+  const compiled_path* find(std::uint64_t key) const;
+
+  /**
+   * Returns how many paths are cached.
+   */
+  int size() const;
+
+  /**
+   * Returns how many motions had to compile their path when they started.
+   */
+  int misses() const;
+
+ private:
+  std::unordered_map<std::uint64_t, compiled_path> paths;
+  profile_settings profile{};
+  int miss_count = 0;
+  path_settings settings_get();
+};
+
+/**
+ * Compiled pure pursuit paths for the chassis.
+ */
+extern path_cache pp_paths;
+
+/**
+ * Drives a table from route_compile() with chassis.pid_odom_pp_set().  The first point is where
+ * the route starts, so it's skipped.  The points are built in a buffer kept between calls, the
+ * only allocation left is the copy EZ-Template takes.  Call it from the route thread.
+ *
+ * \param route
+ *        first compiled point
+ * \param size
+ *        number of points
+ * \param slew_on
+ *        ramp up from a lower speed to your target speed
+ */
+void route_start(const route_sample* route, std::size_t size, bool slew_on = false);
+
+/**
+ * Drives a table from route_compile(), see route_start(const route_sample*, std::size_t, bool).
+ *
+ * \param route
+ *        compiled route
+ * \param slew_on
+ *        ramp up from a lower speed to your target speed
+ */
+template <std::size_t N>
+void route_start(const std::array<route_sample, N>& route, bool slew_on = false) {
+  route_start(route.data(), N, slew_on);
+}
+}  // namespace robot
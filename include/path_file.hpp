@@ -0,0 +1,218 @@
+/*
+This Source Code Form is subject to the terms of the Mozilla Public
+License, v. 2.0. If a copy of the MPL was not distributed with this
+file, You can obtain one at http://mozilla.org/MPL/2.0/.
+*/
+
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <cstdio>
+#include <cstring>
+#include <vector>
+
+#include "profile_point.hpp"
+
+// Binary trajectory files.  A header, then every column of the path one after another as
+// float32, so a path is read from /usd in one block and used where it lies.  No PROS
+// dependencies so the host converter writes files with the exact same code.
+
+namespace robot {
+constexpr std::uint32_t PATH_MAGIC = 0x48545045;  // "EPTH" in a little endian file
+constexpr std::uint16_t PATH_VERSION = 1;
+
+/**
+ * Columns of a path file, in file order.  Meters, radians and seconds, like squiggles.
+ */
+enum path_column { PATH_X,
+                   PATH_Y,
+                   PATH_YAW,
+                   PATH_VEL,
+                   PATH_ACCEL,
+                   PATH_JERK,
+                   PATH_CURVATURE,
+                   PATH_TIME,
+                   PATH_LEFT,   // left wheel velocity
+                   PATH_RIGHT,  // right wheel velocity
+                   PATH_COLUMNS };
+
+/**
+ * Written once at the start of every path file.
+ */
+struct path_header {
+  std::uint32_t magic = PATH_MAGIC;
+  std::uint16_t version = PATH_VERSION;
+  std::uint16_t columns = PATH_COLUMNS;
+  std::uint32_t count = 0;     // points, every column has this many floats
+  std::uint32_t checksum = 0;  // path_checksum() of everything after the header
+};
+
+static_assert(sizeof(path_header) == 16, "path_header layout changed, bump PATH_VERSION");
+
+/**
+ * FNV-1a over a block of bytes.
+ *
+ * \param data
+ *        first byte
+ * \param size
+ *        number of bytes
+ */
+inline std::uint32_t path_checksum(const void* data, std::size_t size) {
+  const auto* bytes = static_cast<const unsigned char*>(data);
+  std::uint32_t value = 2166136261u;
+  for (std::size_t i = 0; i < size; i++) {
+    value ^= bytes[i];
+    value *= 16777619u;
+  }
+  return value;
+}
+
+/**
+ * Returns the bytes of a path file holding a path.
+ *
+ * \param path
+ *        states from a generator or a csv, a std::vector<squiggles::ProfilePoint> or a
+ *        robot::profile_path
+ */
+template <typename Path>
+std::vector<std::uint8_t> path_encode(const Path& path) {
+  std::size_t count = path.size();
+  std::vector<std::uint8_t> out(sizeof(path_header) + PATH_COLUMNS * count * sizeof(float));
+  float* columns = reinterpret_cast<float*>(out.data() + sizeof(path_header));
+  for (std::size_t i = 0; i < count; i++) {
+    const auto& p = path[i];
+    const auto& wheels = p.wheel_velocities;
+    float values[PATH_COLUMNS] = {(float)p.vector.pose.x, (float)p.vector.pose.y, (float)p.vector.pose.yaw, (float)p.vector.vel,
+                                  (float)p.vector.accel, (float)p.vector.jerk, (float)p.curvature, (float)p.time,
+                                  wheels.size() > 0 ? (float)wheels[0] : 0.0f, wheels.size() > 1 ? (float)wheels[1] : 0.0f};
+    for (int c = 0; c < PATH_COLUMNS; c++) columns[c * count + i] = values[c];
+  }
+  path_header header;
+  header.count = count;
+  header.checksum = path_checksum(columns, out.size() - sizeof(path_header));
+  std::memcpy(out.data(), &header, sizeof(header));
+  return out;
+}
+
+/**
+ * A path file in memory, read where it lies.  Nothing is copied, so the bytes must outlive
+ * the view.
+ */
+class path_view {
+ public:
+  /**
+   * Checks a path file and points the view at it.  Returns false, leaving the view empty, if
+   * the magic, version, size or checksum don't match.
+   *
+   * \param data
+   *        first byte of the file, 4 byte aligned
+   * \param size
+   *        bytes in the file
+   */
+  bool open(const void* data, std::size_t size) {
+    close();
+    if (size < sizeof(path_header) || reinterpret_cast<std::uintptr_t>(data) % alignof(float) != 0) return false;
+    path_header header;
+    std::memcpy(&header, data, sizeof(header));
+    if (header.magic != PATH_MAGIC || header.version != PATH_VERSION || header.columns != PATH_COLUMNS) return false;
+    std::size_t payload = (std::size_t)header.count * PATH_COLUMNS * sizeof(float);
+    if (size != sizeof(path_header) + payload) return false;
+    const auto* body = static_cast<const std::uint8_t*>(data) + sizeof(path_header);
+    if (path_checksum(body, payload) != header.checksum) return false;
+    base = reinterpret_cast<const float*>(body);
+    count = header.count;
+    return true;
+  }
+
+  /**
+   * Empties the view.
+   */
+  void close() {
+    base = nullptr;
+    count = 0;
+  }
+
+  /**
+   * Returns the number of points.
+   */
+  std::size_t size() const { return count; }
+
+  /**
+   * Returns true if nothing is open.
+   */
+  bool empty() const { return count == 0; }
+
+  /**
+   * Returns one column, size() floats.
+   *
+   * \param c
+   *        column
+   */
+  const float* column(path_column c) const { return base + (std::size_t)c * count; }
+
+  /**
+   * Returns one value.
+   *
+   * \param c
+   *        column
+   * \param i
+   *        point
+   */
+  float get(path_column c, std::size_t i) const { return base[(std::size_t)c * count + i]; }
+
+  /**
+   * Returns one point.
+   *
+   * \param i
+   *        point
+   */
+  profile_point<2> point(std::size_t i) const {
+    return profile_point<2>(squiggles::ControlVector(squiggles::Pose(get(PATH_X, i), get(PATH_Y, i), get(PATH_YAW, i)), get(PATH_VEL, i), get(PATH_ACCEL, i), get(PATH_JERK, i)),
+                            {get(PATH_LEFT, i), get(PATH_RIGHT, i)}, get(PATH_CURVATURE, i), get(PATH_TIME, i));
+  }
+
+ private:
+  const float* base = nullptr;
+  std::size_t count = 0;
+};
+
+/**
+ * Reads a whole path file in one block.  Returns an empty vector if the file can't be read.
+ * The vector is float aligned, so it can be passed straight to path_view::open().
+ *
+ * \param file
+ *        path of the file, eg. "/usd/skills.path"
+ */
+inline std::vector<float> path_read(const char* file) {
+  std::vector<float> out;
+  FILE* f = std::fopen(file, "rb");
+  if (!f) return out;
+  std::fseek(f, 0, SEEK_END);
+  long size = std::ftell(f);
+  std::fseek(f, 0, SEEK_SET);
+  if (size > 0 && size % sizeof(float) == 0) {
+    out.resize(size / sizeof(float));
+    if (std::fread(out.data(), 1, size, f) != (std::size_t)size) out.clear();
+  }
+  std::fclose(f);
+  return out;
+}
+
+/**
+ * Writes a path file.  Returns false if it couldn't be written.
+ *
+ * \param file
+ *        path of the file, eg. "/usd/skills.path"
+ * \param path
+ *        states to write
+ */
+template <typename Path>
+bool path_write(const char* file, const Path& path) {
+  std::vector<std::uint8_t> bytes = path_encode(path);
+  FILE* f = std::fopen(file, "wb");
+  if (!f) return false;
+  bool ok = std::fwrite(bytes.data(), 1, bytes.size(), f) == bytes.size();
+  return std::fclose(f) == 0 && ok;
+}
+}  // namespace robot
@@ -0,0 +1,136 @@
+/*
+This Source Code Form is subject to the terms of the Mozilla Public
+License, v. 2.0. If a copy of the MPL was not distributed with this
+file, You can obtain one at http://mozilla.org/MPL/2.0/.
+*/
+
+#pragma once
+
+#include "EZ-Template/api.hpp"
+#include "api.h"
+#include "gain_schedule.hpp"
+
+namespace robot {
+/**
+ * Chassis PIDs a schedule can drive.
+ */
+enum schedule_pid {
+  SCHEDULE_DRIVE = 0,       // leftPID and rightPID during forward drives, and profiled drives
+  SCHEDULE_HEADING,         // headingPID during drives, and the heading hold of profiled drives
+  SCHEDULE_TURN,            // turnPID during turns, and profiled turns
+  SCHEDULE_SWING,           // swingPID during swings
+  SCHEDULE_DRIVE_BACKWARD,  // leftPID and rightPID during backward drives
+  SCHEDULE_COUNT,
+};
+
+/**
+ * Swaps EZ's PID constants for scheduled ones while the robot moves.
+ *
+ * default_constants() tunes one set of constants per motion, at whatever the battery was at and
+ * with whatever the robot was carrying.  A turn tuned at 12.6 V saturates sooner at 11.8 V, and
+ * a robot full of game objects turns slower than an empty one, so the same constants overshoot
+ * or stall.  Every tick update() reads the battery, filtered so the sag while accelerating
+ * doesn't shake the gains.  When EZ starts a motion, the scheduled gains for its speed
+ * (chassis.pid_speed_max_get()), the voltage and the payload flag are written once into the
+ * PID EZ computes with, and the constants they replaced are put back once EZ moves on to
+ * another.  robot::chassis_profile looks its gains up the same way, once per motion.  Writes
+ * only happen while EZ's task waits for its next tick, the scheduler task outranks it, so a
+ * compute() never sees half of them.  Each lookup is O(1), see robot::gain_schedule.
+ *
+ * PIDs without a table keep their constants from default_constants().  Drives keep EZ's split
+ * between the forward and backward constants: SCHEDULE_DRIVE only replaces forward ones and
+ * SCHEDULE_DRIVE_BACKWARD backward ones.
+ */
+class pid_scheduler {
+ public:
+  /**
+   * Schedules one PID.
+   *
+   * \param pid
+   *        which PID
+   * \param table
+   *        gains to schedule it with
+   */
+  void table_set(schedule_pid pid, const gain_schedule& table);
+
+  /**
+   * Stops scheduling one PID.  The constants from default_constants() are back in it from the
+   * next tick.
+   *
+   * \param pid
+   *        which PID
+   */
+  void table_clear(schedule_pid pid);
+
+  /**
+   * Sets whether the robot is carrying a payload, eg. from the intake once it's full.
+   *
+   * \param loaded
+   *        true with a payload
+   */
+  void payload_set(bool loaded);
+
+  /**
+   * Returns the payload flag.
+   */
+  bool payload_get();
+
+  /**
+   * Returns the filtered battery voltage, in volts.
+   */
+  double voltage_get();
+
+  /**
+   * Returns the scheduled gains for a PID at a speed, or fallback if it has no table.
+   *
+   * \param pid
+   *        which PID
+   * \param speed
+   *        commanded speed, 0 to 127
+   * \param fallback
+   *        gains without a table, eg. from chassis.pid_drive_constants_get()
+   */
+  pid_gains gains_get(schedule_pid pid, double speed, pid_gains fallback);
+
+  /**
+   * Reads the battery, and when EZ's motion has changed writes the scheduled gains into its PIDs.
+   * Scheduler stage, runs every tick before the profile stage computes.  Gains are written while
+   * EZ's task waits for its next tick, or after 5 ticks of it never waiting.
+   */
+  void update();
+
+ private:
+  // What EZ is running, a new one of these gets its gains written
+  struct motion {
+    ez::e_mode mode = ez::DISABLE;
+    double target = 0.0;
+    double speed = 0.0;
+    bool operator==(const motion& other) const { return mode == other.mode && target == other.target && speed == other.speed; }
+  };
+  pros::Mutex mutex;
+  gain_schedule tables[SCHEDULE_COUNT];
+  bool scheduled[SCHEDULE_COUNT] = {};
+  bool loaded = false;
+  double voltage = 0.0;  // V, 0 until the first reading
+  motion running;            // the motion the PIDs have gains for
+  bool stale = false;        // the PIDs don't, yet
+  int deferred = 0;          // ticks they have waited for EZ's task
+  int forced = 0;            // writes that stopped waiting
+  ez::PID* written[3] = {};  // PIDs given scheduled gains, at most a drive's three
+  ez::PID::Constants replaced[3];
+  pid_gains gains[3];
+  int writes = 0;
+  void write(ez::PID& pid, schedule_pid which, double speed);  // with the mutex held
+  void restore();                                              // with the mutex held
+};
+
+/**
+ * Gain schedules for the chassis.
+ */
+extern pid_scheduler chassis_gains;
+
+/**
+ * Scheduler stage, updates chassis_gains.
+ */
+void chassis_gains_update();
+}  // namespace robot
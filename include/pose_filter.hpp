@@ -0,0 +1,385 @@
+/*
+This Source Code Form is subject to the terms of the Mozilla Public
+License, v. 2.0. If a copy of the MPL was not distributed with this
+file, You can obtain one at http://mozilla.org/MPL/2.0/.
+*/
+
+#pragma once
+
+#include <cmath>
+
+// Extended Kalman filter for the robot's pose on the field.  Wheel odometry moves it every tick,
+// GPS fixes and distance sensor readings off the perimeter correct it whenever they arrive.  No
+// PROS dependencies so the host replay tool runs the exact same filter.
+//
+// Field coordinates are the GPS sensor's: inches from the center of the field, theta in degrees
+// clockwise from +y, like EZ.
+
+namespace robot {
+/**
+ * Where a distance sensor sits on the robot, same convention as the simulator.
+ */
+struct distance_mount {
+  double x_offset = 0.0;  // inches, right of the tracking center
+  double y_offset = 0.0;  // inches, in front of the tracking center
+  double facing = 0.0;    // degrees, clockwise from the front of the robot
+};
+
+/**
+ * Something on the field a distance sensor sees instead of the wall behind it, eg. a goal.  An
+ * axis aligned box in field coordinates, inches from the center.
+ */
+struct field_box {
+  double x_min = 0.0;
+  double y_min = 0.0;
+  double x_max = 0.0;
+  double y_max = 0.0;
+};
+
+/**
+ * Noise and gating for pose_filter.
+ */
+struct filter_settings {
+  static constexpr int MAX_OBSTACLES = 8;
+
+  double field_half = 72.0;       // inches from the center to each wall
+  double odom_noise = 0.03;       // 1 sigma, fraction of the distance driven
+  double slip_noise = 0.01;       // 1 sigma sideways, fraction of the distance driven
+  double turn_noise = 0.01;       // 1 sigma, fraction of the heading change
+  double heading_drift = 0.0005;  // degrees of 1 sigma heading drift every tick
+  double gps_min_sigma = 0.5;     // inches, floor on the GPS's own error estimate
+  double gps_heading_sigma = 2.0;       // degrees
+  double distance_min_sigma = 0.6;      // inches
+  double distance_fraction = 0.03;      // 1 sigma, fraction of the reading
+  double distance_max = 78.0;           // inches, anything further isn't trusted
+  double min_incidence = 0.5;           // cosine between the beam and the wall, lower is too glancing
+  double obstacle_margin = 3.0;         // inches around each obstacle the beam must clear, it spreads
+  double gate_gps = 11.34;              // chi-squared with 3 degrees of freedom, 99%
+  double gate_distance = 6.63;          // chi-squared with 1 degree of freedom, 99%
+  distance_mount distance{};
+  field_box obstacles[MAX_OBSTACLES] = {};  // readings are only fused when the beam clears all of these
+  int obstacle_count = 0;
+};
+
+/**
+ * One tick of inputs.  The robot builds these from its sensors, the replay tool from a log.
+ */
+struct fusion_input {
+  double forward = 0.0;  // inches driven along the heading since the last tick
+  double right = 0.0;    // inches driven sideways, positive to the right
+  double turn = 0.0;     // degrees turned, clockwise
+  double distance = -1.0;  // inches from the distance sensor, negative without a reading
+  double gps_error = -1.0;  // inches RMS from the GPS, negative without a fix
+  double gps_x = 0.0;
+  double gps_y = 0.0;
+  double gps_theta = 0.0;
+};
+
+/**
+ * How many measurements pose_filter has used and thrown away.
+ */
+struct filter_stats {
+  int gps_accepted = 0;
+  int gps_rejected = 0;
+  int distance_accepted = 0;
+  int distance_rejected = 0;
+};
+
+namespace filter_detail {
+constexpr double DEG = M_PI / 180.0;
+
+inline double wrap(double angle) { return std::atan2(std::sin(angle), std::cos(angle)); }
+
+// Distance along a ray from (x, y) in direction (dx, dy) to where it enters a box grown by
+// margin, -1 if it never does.  0 if it starts inside.
+inline double ray_box(double x, double y, double dx, double dy, const field_box& box, double margin) {
+  double enter = 0.0, leave = INFINITY;
+  const double origin[2] = {x, y}, direction[2] = {dx, dy};
+  const double low[2] = {box.x_min - margin, box.y_min - margin}, high[2] = {box.x_max + margin, box.y_max + margin};
+  for (int i = 0; i < 2; i++) {
+    if (std::fabs(direction[i]) < 1e-9) {
+      if (origin[i] < low[i] || origin[i] > high[i]) return -1.0;
+      continue;
+    }
+    double a = (low[i] - origin[i]) / direction[i], b = (high[i] - origin[i]) / direction[i];
+    enter = std::fmax(enter, std::fmin(a, b));
+    leave = std::fmin(leave, std::fmax(a, b));
+  }
+  return enter <= leave ? enter : -1.0;
+}
+
+// Inverts a symmetric positive definite matrix, n <= 3, by Gauss-Jordan.  False if singular.
+inline bool invert(int n, const double in[3][3], double out[3][3]) {
+  double a[3][6] = {};
+  for (int r = 0; r < n; r++) {
+    for (int c = 0; c < n; c++) a[r][c] = in[r][c];
+    a[r][n + r] = 1.0;
+  }
+  for (int c = 0; c < n; c++) {
+    int pivot = c;
+    for (int r = c + 1; r < n; r++)
+      if (std::fabs(a[r][c]) > std::fabs(a[pivot][c])) pivot = r;
+    if (std::fabs(a[pivot][c]) < 1e-12) return false;
+    for (int k = 0; k < 2 * n; k++) std::swap(a[c][k], a[pivot][k]);
+    double scale = 1.0 / a[c][c];
+    for (int k = 0; k < 2 * n; k++) a[c][k] *= scale;
+    for (int r = 0; r < n; r++) {
+      if (r == c) continue;
+      double f = a[r][c];
+      for (int k = 0; k < 2 * n; k++) a[r][k] -= f * a[c][k];
+    }
+  }
+  for (int r = 0; r < n; r++)
+    for (int c = 0; c < n; c++) out[r][c] = a[r][n + c];
+  return true;
+}
+}  // namespace filter_detail
+
+/**
+ * Pose estimate with its covariance.  State is x and y in inches and theta in radians.
+ */
+class pose_filter {
+ public:
+  /**
+   * Puts the estimate at a pose.
+   *
+   * \param x
+   *        inches from the field center
+   * \param y
+   *        inches from the field center
+   * \param theta
+   *        degrees, clockwise from +y
+   * \param sigma_xy
+   *        inches, how sure the pose is
+   * \param sigma_theta
+   *        degrees, how sure the heading is
+   */
+  void reset(double x, double y, double theta, double sigma_xy = 1.0, double sigma_theta = 1.0) {
+    state[0] = x;
+    state[1] = y;
+    state[2] = filter_detail::wrap(theta * filter_detail::DEG);
+    for (auto& row : P)
+      for (double& v : row) v = 0.0;
+    P[0][0] = P[1][1] = sigma_xy * sigma_xy;
+    P[2][2] = std::pow(sigma_theta * filter_detail::DEG, 2);
+  }
+
+  /**
+   * Moves the estimate by one tick of odometry, growing the covariance with the distance.
+   *
+   * \param forward
+   *        inches along the heading
+   * \param right
+   *        inches sideways, positive to the right
+   * \param turn
+   *        degrees, clockwise
+   */
+  void predict(double forward, double right, double turn) {
+    double dt = turn * filter_detail::DEG;
+    double mid = state[2] + dt / 2.0;
+    double s = std::sin(mid), c = std::cos(mid);
+    state[0] += forward * s + right * c;
+    state[1] += forward * c - right * s;
+    state[2] = filter_detail::wrap(state[2] + dt);
+
+    // P = F P F' + Q, F is the identity plus how x and y move with the heading
+    double fx = forward * c - right * s, fy = -forward * s - right * c;
+    double F[3][3] = {{1.0, 0.0, fx}, {0.0, 1.0, fy}, {0.0, 0.0, 1.0}};
+    double FP[3][3] = {};
+    for (int r = 0; r < 3; r++)
+      for (int k = 0; k < 3; k++)
+        for (int j = 0; j < 3; j++) FP[r][j] += F[r][k] * P[k][j];
+    for (int r = 0; r < 3; r++)
+      for (int j = 0; j < 3; j++) {
+        P[r][j] = 0.0;
+        for (int k = 0; k < 3; k++) P[r][j] += FP[r][k] * F[j][k];
+      }
+
+    // Wheel noise is along and across the robot, rotate it onto the field
+    double along = settings.odom_noise * std::fabs(forward) + settings.slip_noise * std::fabs(right);
+    double across = settings.odom_noise * std::fabs(right) + settings.slip_noise * std::fabs(forward);
+    double a2 = along * along, c2 = across * across;
+    P[0][0] += a2 * s * s + c2 * c * c;
+    P[1][1] += a2 * c * c + c2 * s * s;
+    P[0][1] += (a2 - c2) * s * c;
+    P[1][0] = P[0][1];
+    double heading = settings.turn_noise * std::fabs(dt) + settings.heading_drift * filter_detail::DEG;
+    P[2][2] += heading * heading;
+  }
+
+  /**
+   * Corrects the estimate with a GPS fix.  Returns false, leaving the estimate alone, if the fix
+   * is too far from the estimate to believe.
+   *
+   * \param x
+   *        inches from the field center
+   * \param y
+   *        inches from the field center
+   * \param theta
+   *        degrees, clockwise from +y
+   * \param error
+   *        inches, the GPS's own RMS error estimate
+   */
+  bool gps_update(double x, double y, double theta, double error) {
+    double sigma = std::fmax(error, settings.gps_min_sigma);
+    double heading = settings.gps_heading_sigma * filter_detail::DEG;
+    double innovation[3] = {x - state[0], y - state[1], filter_detail::wrap(theta * filter_detail::DEG - state[2])};
+    double H[3][3] = {{1.0, 0.0, 0.0}, {0.0, 1.0, 0.0}, {0.0, 0.0, 1.0}};
+    double R[3][3] = {{sigma * sigma, 0.0, 0.0}, {0.0, sigma * sigma, 0.0}, {0.0, 0.0, heading * heading}};
+    bool ok = correct(3, innovation, H, R, settings.gate_gps);
+    (ok ? stats.gps_accepted : stats.gps_rejected)++;
+    return ok;
+  }
+
+  /**
+   * Corrects the estimate with a distance sensor reading off the field perimeter.  Returns false,
+   * leaving the estimate alone, if the beam should miss the walls, hit one too glancingly or
+   * pass one of settings.obstacles first, or the reading is too far from what the walls
+   * predict, eg. another robot in the way.
+   *
+   * \param distance
+   *        inches the sensor read
+   */
+  bool distance_update(double distance) {
+    double incidence;
+    double expected = distance_expected(state, &incidence);
+    if (distance <= 0.0 || distance > settings.distance_max || expected < 0.0 || incidence < settings.min_incidence) {
+      stats.distance_rejected++;
+      return false;
+    }
+
+    // Jacobian of the expected reading by central differences, the nearest wall can change
+    double H[3][3] = {};
+    const double step[3] = {0.01, 0.01, 0.0001};
+    for (int i = 0; i < 3; i++) {
+      double plus[3] = {state[0], state[1], state[2]}, minus[3] = {state[0], state[1], state[2]};
+      plus[i] += step[i];
+      minus[i] -= step[i];
+      double a = distance_expected(plus, nullptr), b = distance_expected(minus, nullptr);
+      if (a < 0.0 || b < 0.0) {
+        stats.distance_rejected++;
+        return false;
+      }
+      H[0][i] = (a - b) / (2.0 * step[i]);
+    }
+    double sigma = std::fmax(settings.distance_min_sigma, settings.distance_fraction * distance);
+    double innovation[3] = {distance - expected};
+    double R[3][3] = {{sigma * sigma}};
+    bool ok = correct(1, innovation, H, R, settings.gate_distance);
+    (ok ? stats.distance_accepted : stats.distance_rejected)++;
+    return ok;
+  }
+
+  /**
+   * Runs one tick: odometry, then whichever measurements the input has.
+   *
+   * \param in
+   *        this tick's inputs
+   */
+  void update(const fusion_input& in) {
+    predict(in.forward, in.right, in.turn);
+    if (in.gps_error >= 0.0) gps_update(in.gps_x, in.gps_y, in.gps_theta, in.gps_error);
+    if (in.distance >= 0.0) distance_update(in.distance);
+  }
+
+  /**
+   * Returns the distance sensor reading the estimate predicts, or -1 if the beam misses every
+   * wall or an obstacle is in the way.
+   */
+  double distance_expected() const { return distance_expected(state, nullptr); }
+
+  double x_get() const { return state[0]; }
+  double y_get() const { return state[1]; }
+
+  /**
+   * Returns the heading in degrees, clockwise from +y, -180 to 180.
+   */
+  double theta_get() const { return state[2] / filter_detail::DEG; }
+
+  /**
+   * Returns the 1 sigma position uncertainty in inches, the larger axis.
+   */
+  double sigma_xy_get() const {
+    double mean = (P[0][0] + P[1][1]) / 2.0, diff = (P[0][0] - P[1][1]) / 2.0;
+    return std::sqrt(mean + std::sqrt(diff * diff + P[0][1] * P[0][1]));
+  }
+
+  void settings_set(const filter_settings& input) { settings = input; }
+  const filter_settings& settings_get() const { return settings; }
+  const filter_stats& stats_get() const { return stats; }
+  void stats_reset() { stats = {}; }
+
+ private:
+  double state[3] = {};
+  double P[3][3] = {};
+  filter_settings settings;
+  filter_stats stats;
+
+  // Distance from the sensor to the wall its beam hits first at a state, -1 if none or if it
+  // passes an obstacle on the way.  A goal can sit close enough to the wall behind it that the
+  // gate alone would take its face for the wall
+  double distance_expected(const double* at, double* incidence) const {
+    const distance_mount& m = settings.distance;
+    double s = std::sin(at[2]), c = std::cos(at[2]);
+    double ox = at[0] + m.y_offset * s + m.x_offset * c;
+    double oy = at[1] + m.y_offset * c - m.x_offset * s;
+    double beam = at[2] + m.facing * filter_detail::DEG;
+    double dx = std::sin(beam), dy = std::cos(beam);
+    double best = -1.0, cosine = 0.0;
+    auto consider = [&](double t, double normal) {
+      if (t > 0.0 && (best < 0.0 || t < best)) {
+        best = t;
+        cosine = std::fabs(normal);
+      }
+    };
+    double half = settings.field_half;
+    if (std::fabs(dx) > 1e-9) consider(((dx > 0.0 ? half : -half) - ox) / dx, dx);
+    if (std::fabs(dy) > 1e-9) consider(((dy > 0.0 ? half : -half) - oy) / dy, dy);
+    for (int i = 0; i < settings.obstacle_count && i < filter_settings::MAX_OBSTACLES && best >= 0.0; i++) {
+      double t = filter_detail::ray_box(ox, oy, dx, dy, settings.obstacles[i], settings.obstacle_margin);
+      if (t >= 0.0 && t < best) best = -1.0;
+    }
+    if (incidence) *incidence = cosine;
+    return best;
+  }
+
+  // Kalman update of an m dimensional measurement, skipped if its Mahalanobis distance is past gate
+  bool correct(int m, const double* innovation, const double H[3][3], const double R[3][3], double gate) {
+    double PH[3][3] = {};  // P H'
+    for (int r = 0; r < 3; r++)
+      for (int j = 0; j < m; j++)
+        for (int k = 0; k < 3; k++) PH[r][j] += P[r][k] * H[j][k];
+    double S[3][3] = {};
+    for (int i = 0; i < m; i++)
+      for (int j = 0; j < m; j++) {
+        S[i][j] = R[i][j];
+        for (int k = 0; k < 3; k++) S[i][j] += H[i][k] * PH[k][j];
+      }
+    double Si[3][3];
+    if (!filter_detail::invert(m, S, Si)) return false;
+    double d2 = 0.0;
+    for (int i = 0; i < m; i++)
+      for (int j = 0; j < m; j++) d2 += innovation[i] * Si[i][j] * innovation[j];
+    if (d2 > gate) return false;
+
+    double K[3][3] = {};  // P H' S^-1
+    for (int r = 0; r < 3; r++)
+      for (int j = 0; j < m; j++)
+        for (int k = 0; k < m; k++) K[r][j] += PH[r][k] * Si[k][j];
+    for (int r = 0; r < 3; r++)
+      for (int j = 0; j < m; j++) state[r] += K[r][j] * innovation[j];
+    state[2] = filter_detail::wrap(state[2]);
+
+    // P -= K H P, then keep it symmetric
+    double KHP[3][3] = {};
+    for (int r = 0; r < 3; r++)
+      for (int c = 0; c < 3; c++)
+        for (int j = 0; j < m; j++) KHP[r][c] += K[r][j] * PH[c][j];
+    for (int r = 0; r < 3; r++)
+      for (int c = 0; c < 3; c++) P[r][c] -= KHP[r][c];
+    for (int r = 0; r < 3; r++)
+      for (int c = r + 1; c < 3; c++) P[r][c] = P[c][r] = (P[r][c] + P[c][r]) / 2.0;
+    return true;
+  }
+};
+}  // namespace robot
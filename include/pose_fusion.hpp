@@ -0,0 +1,136 @@
+/*
+This Source Code Form is subject to the terms of the Mozilla Public
+License, v. 2.0. If a copy of the MPL was not distributed with this
+file, You can obtain one at http://mozilla.org/MPL/2.0/.
+*/
+
+#pragma once
+
+#include "EZ-Template/util.hpp"
+#include "api.h"
+#include "pose_filter.hpp"
+
+namespace robot {
+/**
+ * Fuses EZ's odometry with a GPS sensor and a distance sensor reading the field perimeter.
+ *
+ * EZ odometry only integrates the wheels and the IMU, so a long skills run drifts.  Once
+ * start_set() says where the robot is on the field, every tick runs pose_filter on the odometry
+ * moved since the last tick and whatever the sensors read, and the fused position is written
+ * back into EZ's odometry, so every odom motion uses it.  Heading is left to the IMU, EZ's turns
+ * read it directly.
+ */
+class pose_fusion {
+ public:
+  /**
+   * Sets the filter's noise and gating, see filter_settings.
+   *
+   * \param input
+   *        new settings, the distance sensor mount included
+   */
+  void settings_set(const filter_settings& input);
+
+  /**
+   * Returns the filter's settings.
+   */
+  filter_settings settings_get();
+
+  /**
+   * Reads a distance sensor off the field perimeter every tick.
+   *
+   * \param sensor
+   *        the sensor, nullptr stops using it
+   * \param mount
+   *        where it sits on the robot
+   */
+  void distance_set(pros::Distance* sensor, distance_mount mount);
+
+  /**
+   * Reads a GPS sensor every tick.  Set its offset from the tracking center on the sensor.
+   *
+   * \param sensor
+   *        the sensor, nullptr stops using it
+   */
+  void gps_set(pros::Gps* sensor);
+
+  /**
+   * Starts fusing.  Call it at the start of an auton, after chassis.odom_xyt_set().
+   *
+   * \param x
+   *        where the robot is now, inches from the field center
+   * \param y
+   *        where the robot is now, inches from the field center
+   * \param theta
+   *        where the robot faces now, degrees clockwise from the field's +y
+   */
+  void start_set(double x, double y, double theta);
+
+  /**
+   * Stops fusing, odometry is left wherever the filter last put it.
+   */
+  void stop();
+
+  /**
+   * Returns true while fusing.
+   */
+  bool running();
+
+  /**
+   * Sets whether the fused position is written back into EZ's odometry.  Off, the filter only
+   * runs alongside for field_pose_get() and the logs.
+   *
+   * \param input
+   *        true to correct odometry, the default
+   */
+  void correct_set(bool input);
+
+  /**
+   * Returns the fused pose in field coordinates.
+   */
+  ez::pose field_pose_get();
+
+  /**
+   * Returns the inputs the filter was given on the last tick, for the recorder.
+   */
+  fusion_input input_get();
+
+  /**
+   * Returns how many GPS fixes and distance readings were used and thrown away since start_set().
+   */
+  filter_stats stats_get();
+
+  /**
+   * Runs the filter for this tick.  Scheduler stage, runs before the pose stage.  Corrections
+   * are written while EZ's task waits for its next tick, the scheduler task must outrank it.
+   * One that waited 5 ticks is written anyway, with a message.
+   */
+  void update();
+
+ private:
+  pros::Mutex mutex;
+  pose_filter filter;
+  pros::Distance* distance = nullptr;
+  pros::Gps* gps = nullptr;
+  ez::pose origin = {0.0, 0.0, 0.0};  // field pose of EZ's odometry origin
+  ez::pose last = {0.0, 0.0, 0.0};    // odometry at the last tick
+  fusion_input input;
+  bool active = false;
+  bool correcting = true;
+  bool pending = false;  // a correction not written into odometry yet
+  int deferred = 0;      // ticks it has waited for EZ's task
+  int forced = 0;        // corrections written without waiting, since start()
+  ez::pose field_from_odom(ez::pose p);
+  bool odom_writable();
+  ez::pose odom_from_field(ez::pose p);
+};
+
+/**
+ * Pose fusion for the chassis.
+ */
+extern pose_fusion chassis_fusion;
+
+/**
+ * Scheduler stage, runs chassis_fusion.
+ */
+void chassis_pose_fuse();
+}  // namespace robot
@@ -0,0 +1,76 @@
+/*
+This Source Code Form is subject to the terms of the Mozilla Public
+License, v. 2.0. If a copy of the MPL was not distributed with this
+file, You can obtain one at http://mozilla.org/MPL/2.0/.
+*/
+
+#pragma once
+
+#include <cstdint>
+
+#include "EZ-Template/util.hpp"
+#include "snapshot.hpp"
+
+namespace robot {
+/**
+ * One consistent reading of the robot's pose.
+ */
+struct pose_sample {
+  double x = 0.0;
+  double y = 0.0;
+  double theta = 0.0;
+  double velocity = 0.0;   // in/s, positive is forward
+  std::uint32_t tick = 0;  // publish count, increases by 1 every publish
+  std::uint32_t time = 0;  // ms, when the pose was published
+};
+
+/**
+ * Lock free pose publication, see robot::snapshot.
+ */
+class pose_snapshot {
+ public:
+  /**
+   * Publishes a new pose.  Only one task may call this.
+   *
+   * \param x
+   *        x position in inches
+   * \param y
+   *        y position in inches
+   * \param theta
+   *        heading in degrees
+   * \param velocity
+   *        forward velocity in in/s
+   * \param time
+   *        time the pose was measured in ms
+   */
+  void publish(double x, double y, double theta, double velocity, std::uint32_t time);
+
+  /**
+   * Returns the latest pose.  x, y, theta and velocity always come from the same publish.
+   */
+  pose_sample get() const;
+
+  /**
+   * Returns the latest pose as an ez::pose.
+   */
+  ez::pose pose_get() const;
+
+  /**
+   * Returns how many times a pose has been published.
+   */
+  std::uint32_t tick_get() const;
+
+ private:
+  snapshot<pose_sample> buffer;
+};
+
+/**
+ * Pose of the chassis, published every control_loop tick.
+ */
+extern pose_snapshot chassis_pose;
+
+/**
+ * Scheduler stage that reads odometry from the chassis and publishes it to chassis_pose.
+ */
+void chassis_pose_publish();
+}  // namespace robot
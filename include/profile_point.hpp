@@ -0,0 +1,110 @@
+/*
+This Source Code Form is subject to the terms of the Mozilla Public
+License, v. 2.0. If a copy of the MPL was not distributed with this
+file, You can obtain one at http://mozilla.org/MPL/2.0/.
+*/
+
+#pragma once
+
+#include <array>
+#include <cstddef>
+#include <vector>
+
+#include "okapi/squiggles/geometry/profilepoint.hpp"
+
+// Trajectory states that never allocate on their own.  No PROS dependencies, the host tools use
+// these too.
+
+namespace robot {
+/**
+ * squiggles::ProfilePoint with its wheel velocities stored inline.  squiggles keeps them in a
+ * std::vector, so every point it makes is a heap allocation.
+ */
+template <std::size_t WHEELS = 2>
+struct profile_point {
+  squiggles::ControlVector vector;
+  std::array<double, WHEELS> wheel_velocities{};  // m/s, left then right for a TankModel
+  double curvature = 0.0;                         // 1/m, positive turning left
+  double time = 0.0;                              // s from the start of the path
+
+  profile_point() = default;
+
+  profile_point(squiggles::ControlVector ivector, std::array<double, WHEELS> iwheel_velocities, double icurvature, double itime)
+      : vector(ivector), wheel_velocities(iwheel_velocities), curvature(icurvature), time(itime) {}
+
+  /**
+   * Copies a squiggles point, keeping at most WHEELS wheel velocities.
+   */
+  explicit profile_point(const squiggles::ProfilePoint& p) : vector(p.vector), curvature(p.curvature), time(p.time) {
+    for (std::size_t i = 0; i < WHEELS && i < p.wheel_velocities.size(); i++) wheel_velocities[i] = p.wheel_velocities[i];
+  }
+
+  /**
+   * Returns the point as a squiggles::ProfilePoint, which allocates.
+   */
+  squiggles::ProfilePoint squiggles_get() const {
+    return squiggles::ProfilePoint(vector, std::vector<double>(wheel_velocities.begin(), wheel_velocities.end()), curvature, time);
+  }
+};
+
+/**
+ * A trajectory in one contiguous block.  assign() only allocates when the path grows past
+ * anything it held before, so regenerating into the same path allocates nothing.
+ */
+template <std::size_t WHEELS = 2>
+class profile_path {
+ public:
+  using point = profile_point<WHEELS>;
+
+  profile_path() = default;
+
+  /**
+   * Copies a squiggles path.
+   *
+   * \param path
+   *        states from squiggles
+   */
+  explicit profile_path(const std::vector<squiggles::ProfilePoint>& path) {
+    assign(path.size());
+    for (std::size_t i = 0; i < path.size(); i++) points[i] = point(path[i]);
+  }
+
+  /**
+   * Resizes to count default points, keeping the storage if it's big enough.
+   *
+   * \param count
+   *        number of points
+   */
+  void assign(std::size_t count) {
+    if (count > points.capacity()) {
+      points.clear();
+      points.shrink_to_fit();
+      points.reserve(count);
+    }
+    points.assign(count, point());
+  }
+
+  /**
+   * Empties the path, keeping the storage.
+   */
+  void clear() { points.clear(); }
+
+  std::size_t size() const { return points.size(); }
+  bool empty() const { return points.empty(); }
+  point* data() { return points.data(); }
+  const point* data() const { return points.data(); }
+  point& operator[](std::size_t i) { return points[i]; }
+  const point& operator[](std::size_t i) const { return points[i]; }
+  point& front() { return points.front(); }
+  const point& front() const { return points.front(); }
+  point& back() { return points.back(); }
+  const point& back() const { return points.back(); }
+  point* begin() { return points.data(); }
+  point* end() { return points.data() + points.size(); }
+  const point* begin() const { return points.data(); }
+  const point* end() const { return points.data() + points.size(); }
+
+ private:
+  std::vector<point> points;
+};
+}  // namespace robot
@@ -0,0 +1,233 @@
+/*
+This Source Code Form is subject to the terms of the Mozilla Public
+License, v. 2.0. If a copy of the MPL was not distributed with this
+file, You can obtain one at http://mozilla.org/MPL/2.0/.
+*/
+
+#pragma once
+
+#include <cstdint>
+
+#include "EZ-Template/api.hpp"
+#include "api.h"
+#include "exit_condition.hpp"
+#include "motion_chain.hpp"
+#include "motion_profile.hpp"
+#include "pid_schedule.hpp"
+
+namespace robot {
+/**
+ * Limits for profiled motions.  Accelerations are at the wheels, turns use the same ones through
+ * the track width.
+ */
+struct profiled_settings {
+  profile_shape shape = PROFILE_S_CURVE;
+  double accel = 170.0;       // in/s^2, keep it under what the tires grip
+  double jerk = 8000.0;       // in/s^3, S-curve only
+  double track_width = 11.5;  // used when chassis.drive_width_get() is 0
+  double blend_radius = 12.0;   // in, queued drive, turn, drive corners round off with this
+  double lateral_accel = 120.0; // in/s^2, caps the speed through a rounded corner
+};
+
+/**
+ * Drives and turns that follow a motion profile instead of chasing a step target.
+ *
+ * chassis.pid_drive_set() hands the PID the whole distance at once and only ez::slew limits how
+ * hard it starts, so the robot gets there as fast as the motors allow and slips when that's
+ * faster than the tires grip.  These plan a trapezoidal or S-curve move inside the acceleration
+ * limit and drive it through robot::chassis_velocity's feedforward, with EZ's drive, heading and
+ * turn PIDs correcting the error from the plan.  The PIDs use the constants and exit conditions
+ * from default_constants(), or robot::chassis_gains' schedule when it has one, looked up once as
+ * the motion starts like EZ's own motions.  Exits are only checked once the plan has finished.
+ *
+ * Drives and turns can also be queued with pid_drive_queue() and pid_turn_queue() and run as
+ * one motion by queue_start(), see robot::motion_chain.  Where chassis.pid_wait_quick_chain()
+ * still slows down at every drive to turn boundary, a queued drive, turn, drive becomes a curve
+ * the robot carries its speed through, eg.
+ *
+ *   robot::chassis_profile.pid_drive_queue(21_in, 110);
+ *   robot::chassis_profile.pid_turn_relative_queue(-75_deg, 90);
+ *   robot::chassis_profile.pid_drive_queue(26.25_in, 110);
+ *   robot::chassis_profile.queue_start();
+ *   robot::chassis_profile.wait();
+ *
+ * EZ's PID is put in DISABLE for the motion, update() writes the drive.
+ *
+ * Only built into the robot with make PROFILED_MOTION=1.  bin/sim/motion_profile_bench has them
+ * exiting later than chassis.pid_drive_set() with slew, and no auton uses them yet.
+ */
+class profiled_motion {
+ public:
+  /**
+   * Sets the limits.  Takes effect for the next motion.
+   *
+   * \param input
+   *        new settings
+   */
+  void settings_set(profiled_settings input);
+
+  /**
+   * Returns the limits.
+   */
+  profiled_settings settings_get();
+
+  /**
+   * Drives straight, holding the heading EZ's last motion left it at, like chassis.pid_drive_set().
+   *
+   * \param target
+   *        distance to drive, negative is backwards
+   * \param speed
+   *        0 to 127, the highest output the cruise may take
+   */
+  void pid_drive_set(okapi::QLength target, int speed);
+
+  /**
+   * Turns to an absolute heading, like chassis.pid_turn_set().
+   *
+   * \param target
+   *        heading to turn to
+   * \param speed
+   *        0 to 127, the highest output the cruise may take
+   */
+  void pid_turn_set(okapi::QAngle target, int speed);
+
+  /**
+   * Turns relative to the last heading target, like chassis.pid_turn_relative_set().
+   *
+   * \param target
+   *        angle to turn by
+   * \param speed
+   *        0 to 127, the highest output the cruise may take
+   */
+  void pid_turn_relative_set(okapi::QAngle target, int speed);
+
+  /**
+   * Adds a drive to the queue, see queue_start().  Call the queue functions from one task.
+   *
+   * \param target
+   *        distance to drive, negative is backwards
+   * \param speed
+   *        0 to 127, the highest output the cruise may take
+   */
+  void pid_drive_queue(okapi::QLength target, int speed);
+
+  /**
+   * Adds a turn to an absolute heading to the queue, see queue_start().
+   *
+   * \param target
+   *        heading to turn to
+   * \param speed
+   *        0 to 127, the highest output the outer wheel may take
+   */
+  void pid_turn_queue(okapi::QAngle target, int speed);
+
+  /**
+   * Adds a turn to the queue, relative to the heading the motion before it ends at.
+   *
+   * \param target
+   *        angle to turn by
+   * \param speed
+   *        0 to 127, the highest output the outer wheel may take
+   */
+  void pid_turn_relative_queue(okapi::QAngle target, int speed);
+
+  /**
+   * Plans the queued motions as one and starts it, then empties the queue.  The chain starts
+   * from the heading EZ's last motion left, and exits like a drive, or like a turn when the last
+   * motion is a turn that couldn't be rounded off.  The heading is held with the heading
+   * constants, and with the turn constants through turns in place.  Does nothing if the queue
+   * is empty.
+   */
+  void queue_start();
+
+  /**
+   * Empties the queue without running it.
+   */
+  void queue_clear();
+
+  /**
+   * Blocks until the motion has exited.
+   */
+  void wait();
+
+  /**
+   * Returns true until the motion has exited.
+   */
+  bool running();
+
+  /**
+   * Stops the motion and the drive.
+   */
+  void stop();
+
+  /**
+   * Returns how the last motion exited.
+   */
+  ez::exit_output exit_get();
+
+  /**
+   * Returns how long the last motion's plan lasted, in ms.
+   */
+  std::uint32_t plan_time_get();
+
+  /**
+   * Returns how long the last motion took from starting to exiting, in ms.
+   */
+  std::uint32_t exit_time_get();
+
+  /**
+   * Follows the plan for the current time and checks exits once it's over.  Scheduler stage,
+   * runs every tick after the pose stage.
+   */
+  void update();
+
+ private:
+  enum motion_type { MOTION_DRIVE,
+                     MOTION_TURN,
+                     MOTION_CHAIN };
+  pros::Mutex mutex;
+  profiled_settings settings;
+  motion_profile profile;
+  motion_chain chain;
+  chain_motion queue[motion_chain::MAX_MOTIONS];
+  int queued = 0;
+  int queue_speed = 0;  // fastest speed queued, what a chain's gains are scheduled at
+  bool chain_turning = false;  // angular_pid has the turn constants, the chain is turning in place
+  motion_type type = MOTION_DRIVE;
+  ez::PID left_pid;
+  ez::PID right_pid;
+  ez::PID angular_pid;  // heading hold while driving, the turn itself while turning
+  pid_exit left_exit{left_pid};
+  pid_exit right_exit{right_pid};
+  pid_exit angular_exit{angular_pid};
+  ez::exit_output left_done = ez::RUNNING;
+  ez::exit_output right_done = ez::RUNNING;
+  double left_start = 0.0;    // in, drive sensors when the motion started
+  double right_start = 0.0;
+  double angle_start = 0.0;   // degrees, IMU when a turn started
+  double half_width = 0.0;    // in
+  std::uint32_t start_time = 0;
+  std::uint32_t exit_time = 0;
+  int speed_max = 0;          // speed the motion was asked for, its gains are scheduled at this
+  ez::exit_output exit = ez::RUNNING;
+  bool active = false;
+  double top_speed_get(int speed);
+  double half_width_get(const profiled_settings& now);
+  void queue_add(chain_motion motion, int speed);
+  void begin(motion_type motion);                                          // with the mutex held, after planning
+  void angular_load();                                                     // with the mutex held, for chain_turning
+  void finish(ez::exit_output how, int saved);                             // with the mutex held
+  void drive_exit_check(const motor_telemetry& telemetry, bool print);     // with the mutex held
+  double duration_get() const;                                            // with the mutex held
+};
+
+/**
+ * Profiled motions for the chassis.
+ */
+extern profiled_motion chassis_profile;
+
+/**
+ * Scheduler stage, follows chassis_profile.
+ */
+void chassis_profile_update();
+}  // namespace robot
@@ -0,0 +1,120 @@
+/*
+This Source Code Form is subject to the terms of the Mozilla Public
+License, v. 2.0. If a copy of the MPL was not distributed with this
+file, You can obtain one at http://mozilla.org/MPL/2.0/.
+*/
+
+#pragma once
+
+#include <atomic>
+#include <cstdint>
+#include <cstdio>
+
+#include "EZ-Template/util.hpp"
+#include "api.h"
+#include "log_record.hpp"
+#include "spsc_ring.hpp"
+
+namespace robot {
+class recorder {
+ public:
+  /**
+   * Records in the ring, about 5 seconds at 100 Hz.
+   */
+  static constexpr int RING_RECORDS = 512;
+
+  /**
+   * Records written to the card in one fwrite.
+   */
+  static constexpr int BLOCK_RECORDS = 4096 / sizeof(log_record);
+
+  /**
+   * Starts the recorder's task, which opens the next free /usd/<prefix>_NNN.bin in the
+   * background so start() has nothing to wait on.  Call it once, from initialize().  Returns
+   * false if there is no SD card.
+   *
+   * \param prefix
+   *        start of the file name, has to outlive the recorder
+   */
+  bool open(const char* prefix = "/usd/log");
+
+  /**
+   * Starts recording into the file open() prepared.  Only sets a flag, the task writes the
+   * header and the records.  Returns false if no file is open yet, or every name is taken.
+   */
+  bool start();
+
+  /**
+   * Stops recording.  Whatever is left in the ring is written, the file is closed and the task
+   * opens the next one for the next start().
+   */
+  void stop();
+
+  /**
+   * Returns true while recording.
+   */
+  bool recording();
+
+  /**
+   * Adds a record.  Only one task may call this, the control_loop stage does.
+   *
+   * \param record
+   *        record to add, dropped if the ring is full
+   */
+  void push(const log_record& record);
+
+  /**
+   * Sets the exit state written into the following records.
+   *
+   * \param exit
+   *        ez::RUNNING while a motion runs, then its exit
+   */
+  void exit_set(ez::exit_output exit);
+
+  /**
+   * Returns the exit state written into records.
+   */
+  ez::exit_output exit_get();
+
+  /**
+   * Returns how many records were dropped because the ring was full.
+   */
+  std::uint32_t dropped_get();
+
+  /**
+   * Returns how many records have been written to the card.
+   */
+  std::uint32_t written_get();
+
+ private:
+  spsc_ring<log_record, RING_RECORDS> ring;
+  log_record block[BLOCK_RECORDS];
+  int block_count = 0;  // records in block, only the task touches it
+  FILE* file = nullptr;  // only the task touches it
+  const char* prefix = nullptr;
+  int next_name = 0;  // first NNN that might be free
+  bool header_written = false;
+  pros::Task* task = nullptr;
+  std::atomic<bool> ready{false};    // a file is open and waiting for start()
+  std::atomic<bool> enabled{false};
+  std::atomic<std::uint32_t> start_time{0};
+  std::atomic<bool> stopping{false};
+  std::atomic<std::uint32_t> dropped{0};
+  std::atomic<std::uint32_t> written{0};
+  std::atomic<int> exit{ez::RUNNING};
+  std::uint16_t dropped_since_push = 0;
+  void task_fn();
+  bool file_open();
+  void drain(bool everything);
+};
+
+/**
+ * Records the chassis every control_loop tick while started.
+ */
+extern recorder chassis_recorder;
+
+/**
+ * Scheduler stage that samples the chassis into chassis_recorder.
+ */
+void chassis_record();
+}  // namespace robot
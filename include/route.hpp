@@ -0,0 +1,202 @@
+/*
+This Source Code Form is subject to the terms of the Mozilla Public
+License, v. 2.0. If a copy of the MPL was not distributed with this
+file, You can obtain one at http://mozilla.org/MPL/2.0/.
+*/
+
+#pragma once
+
+#include <array>
+#include <cstddef>
+
+#include "velocity_profile.hpp"
+
+// Compile time route compiler.  A constexpr waypoint list becomes a constexpr table of injected,
+// smoothed points with curvature and a velocity profile, so the table is built by the compiler
+// and lives in flash.  No PROS dependencies, the host tools include this too.
+//
+//   constexpr std::array<robot::route_point, 3> SKILLS_START = {{{0, 0}, {0, 24}, {24, 48, 90}}};
+//   constexpr auto SKILLS_START_PATH = robot::route_compile<SKILLS_START>();
+//   static_assert(SKILLS_START_PATH.back().speed == 90);
+//
+// robot::route_start() in path_cache.hpp drives a compiled table with pure pursuit.
+
+namespace robot {
+/**
+ * One input waypoint, in inches.  speed is the EZ speed (0 to 127) for the segment into this point.
+ */
+struct route_point {
+  double x = 0.0;
+  double y = 0.0;
+  int speed = 110;
+  bool reverse = false;
+};
+
+/**
+ * How a route is compiled.
+ */
+struct route_settings {
+  double spacing = 1.0;         // inches between injected points
+  double weight_smooth = 0.75;  // same meaning as odom_path_smooth_constants_set()
+  double weight_data = 0.03;
+  double tolerance = 0.0001;
+  profile_settings profile{};  // per point speed, see velocity_profile()
+  bool mirror = false;         // negate x, for the other side of the field
+};
+
+/**
+ * One compiled point.
+ */
+struct route_sample {
+  double x = 0.0;
+  double y = 0.0;
+  double curvature = 0.0;  // 1 / turn radius in inches, 0 on straights
+  int speed = 0;           // EZ speed, 0 to 127
+  bool reverse = false;
+};
+
+/**
+ * Returns how many points are injected into a segment, one every spacing inches from its start.
+ * Shared with path_compile().
+ *
+ * \param length
+ *        segment length in inches
+ * \param spacing
+ *        inches between points, 0 injects none
+ */
+constexpr std::size_t path_inject_count(double length, double spacing) { return spacing > 0.0 ? (std::size_t)(length / spacing) : 0; }
+
+/**
+ * Gradient smoothing shared by route_compile() and path_compile().  Pulls each point toward its
+ * neighbours while keeping it near where it was injected, so corners round off.  The ends and
+ * fixed points stay where they are.
+ *
+ * \param points
+ *        first point, anything with x and y members, smoothed in place
+ * \param original
+ *        the points as injected
+ * \param count
+ *        number of points
+ * \param fixed
+ *        fixed(i) is true for a point that stays put
+ * \param weight_smooth
+ *        same meaning as odom_path_smooth_constants_set()
+ * \param weight_data
+ *        same meaning as odom_path_smooth_constants_set()
+ * \param tolerance
+ *        stops once a pass moves every point less than this in total
+ */
+template <typename T, typename F>
+constexpr void path_smooth(T* points, const T* original, std::size_t count, F fixed, double weight_smooth, double weight_data, double tolerance) {
+  double change = tolerance;
+  for (int iteration = 0; change >= tolerance && iteration < 1000; iteration++) {
+    change = 0.0;
+    for (std::size_t i = 1; i + 1 < count; i++) {
+      if (fixed(i)) continue;
+      double x = points[i].x, y = points[i].y;
+      points[i].x += weight_data * (original[i].x - x) + weight_smooth * (points[i - 1].x + points[i + 1].x - 2.0 * x);
+      points[i].y += weight_data * (original[i].y - y) + weight_smooth * (points[i - 1].y + points[i + 1].y - 2.0 * y);
+      change += profile_detail::abs(x - points[i].x) + profile_detail::abs(y - points[i].y);
+    }
+  }
+}
+
+namespace route_detail {
+// Not constexpr, so calling it while compiling a route stops the build
+inline void route_size_mismatch() {}
+
+// Points injected into the segment that ends at waypoint i
+template <std::size_t W>
+constexpr std::size_t segment_points(const std::array<route_point, W>& waypoints, std::size_t i, const route_settings& settings) {
+  return path_inject_count(profile_detail::distance(waypoints[i - 1].x, waypoints[i - 1].y, waypoints[i].x, waypoints[i].y), settings.spacing);
+}
+}  // namespace route_detail
+
+/**
+ * Returns how many points a route compiles to.
+ *
+ * \param waypoints
+ *        input points, the first is where the route starts
+ * \param settings
+ *        how the route is compiled
+ */
+template <std::size_t W>
+constexpr std::size_t route_size(const std::array<route_point, W>& waypoints, const route_settings& settings = {}) {
+  std::size_t size = 1;
+  for (std::size_t i = 1; i < W; i++) size += route_detail::segment_points(waypoints, i, settings);
+  return size;
+}
+
+/**
+ * Compiles waypoints into a table and returns how many points it used.  A route longer than the
+ * table keeps its first injected points and ends on the last waypoint, a shorter one repeats its
+ * last point to fill the table.  For tables sized at run time, compare the result against
+ * route_size().
+ *
+ * \param waypoints
+ *        input points, the first is where the route starts
+ * \param out
+ *        table to fill
+ * \param settings
+ *        how the route is compiled
+ */
+template <std::size_t N, std::size_t W>
+constexpr std::size_t route_compile(const std::array<route_point, W>& waypoints, std::array<route_sample, N>& out, const route_settings& settings = {}) {
+  static_assert(W >= 2, "a route needs a start and at least one more waypoint");
+  static_assert(N >= 2, "a route table needs room for its start and end");
+
+  // Inject, leaving the last slot for the last waypoint
+  std::size_t n = 0;
+  for (std::size_t i = 1; i < W && n + 1 < N; i++) {
+    const route_point& a = waypoints[i - 1];
+    const route_point& b = waypoints[i];
+    std::size_t fit = route_detail::segment_points(waypoints, i, settings);
+    double length = profile_detail::distance(a.x, a.y, b.x, b.y);
+    for (std::size_t j = 0; j < fit && n + 1 < N; j++) {
+      double t = (j * settings.spacing) / length;
+      out[n] = {a.x + (b.x - a.x) * t, a.y + (b.y - a.y) * t, 0.0, b.speed, b.reverse};
+      n++;
+    }
+  }
+  out[n++] = {waypoints[W - 1].x, waypoints[W - 1].y, 0.0, waypoints[W - 1].speed, waypoints[W - 1].reverse};
+
+  // Smooth, only the ends stay put
+  std::array<route_sample, N> original = out;
+  path_smooth(out.data(), original.data(), n, [](std::size_t) { return false; }, settings.weight_smooth, settings.weight_data, settings.tolerance);
+
+  velocity_profile(out.data(), n, settings.profile);
+
+  if (settings.mirror)
+    for (std::size_t i = 0; i < n; i++) out[i].x = -out[i].x;
+  for (std::size_t i = n; i < N; i++) out[i] = out[n - 1];
+  return n;
+}
+
+/**
+ * Compiles waypoints into a table of N points.  N must be route_size(waypoints, settings), a
+ * constexpr table of the wrong size doesn't build.  At run time it's compiled the same as
+ * route_compile(waypoints, out, settings).
+ *
+ * \param waypoints
+ *        input points, the first is where the route starts
+ * \param settings
+ *        how the route is compiled
+ */
+template <std::size_t N, std::size_t W>
+constexpr std::array<route_sample, N> route_compile(const std::array<route_point, W>& waypoints, const route_settings& settings = {}) {
+  if (route_size(waypoints, settings) != N) route_detail::route_size_mismatch();
+  std::array<route_sample, N> out{};
+  route_compile(waypoints, out, settings);
+  return out;
+}
+
+/**
+ * Compiles a constexpr waypoint array, working out the size itself.
+ *
+ *   constexpr auto PATH = robot::route_compile<WAYPOINTS>();
+ */
+template <const auto& WAYPOINTS, route_settings SETTINGS = route_settings{}>
+constexpr auto route_compile() {
+  return route_compile<route_size(WAYPOINTS, SETTINGS)>(WAYPOINTS, SETTINGS);
+}
+}  // namespace robot
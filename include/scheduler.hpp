@@ -0,0 +1,138 @@
+/*
+This Source Code Form is subject to the terms of the Mozilla Public
+License, v. 2.0. If a copy of the MPL was not distributed with this
+file, You can obtain one at http://mozilla.org/MPL/2.0/.
+*/
+
+#pragma once
+
+#include <cstdint>
+#include <functional>
+#include <vector>
+
+#include "EZ-Template/util.hpp"
+#include "api.h"
+
+namespace robot {
+class scheduler {
+ public:
+  /**
+   * Timing for one stage.  Times are in microseconds.
+   */
+  struct stage_stats {
+    const char* name = "";
+    std::uint32_t budget = 0;
+    std::uint32_t last = 0;
+    std::uint32_t max = 0;
+    std::uint64_t total = 0;
+    std::uint32_t runs = 0;
+    std::uint32_t overruns = 0;
+  };
+
+  /**
+   * Creates a fixed rate scheduler.  Nothing runs until start() is called.
+   *
+   * \param period
+   *        time between ticks in ms
+   */
+  scheduler(std::uint32_t period = ez::util::DELAY_TIME);
+
+  /**
+   * Adds a stage to the end of the tick.  Stages run in the order they're added, every tick.
+   *
+   * \param name
+   *        name shown in stats_print()
+   * \param stage
+   *        function to run every tick, must not block
+   * \param budget
+   *        time in microseconds this stage is allowed to take, 0 only counts the tick overrun
+   */
+  int stage_add(const char* name, std::function<void()> stage, std::uint32_t budget = 0);
+
+  /**
+   * Starts the scheduler task.
+   */
+  void start();
+
+  /**
+   * Stops running stages.  The task stays alive and start() resumes it.
+   */
+  void stop();
+
+  /**
+   * Returns true if the scheduler is running stages.
+   */
+  bool running();
+
+  /**
+   * Runs every stage once and records timing.  start() calls this every period.
+   */
+  void tick();
+
+  /**
+   * Sets the time between ticks.  5 ms and 10 ms are the useful values on a V5 brain.
+   *
+   * \param period
+   *        time between ticks in ms
+   */
+  void period_set(std::uint32_t period);
+
+  /**
+   * Returns the time between ticks in ms.
+   */
+  std::uint32_t period_get();
+
+  /**
+   * Returns how many ticks have run.
+   */
+  std::uint32_t tick_count();
+
+  /**
+   * Returns how many ticks took longer than the period, or started a full period late.
+   */
+  std::uint32_t overruns();
+
+  /**
+   * Returns the longest tick in microseconds.
+   */
+  std::uint32_t tick_max();
+
+  /**
+   * Returns timing for a stage.
+   *
+   * \param index
+   *        stage index returned by stage_add()
+   */
+  stage_stats stage_stats_get(int index);
+
+  /**
+   * Returns the number of stages.
+   */
+  int stage_count();
+
+  /**
+   * Zeroes every timing stat.
+   */
+  void stats_reset();
+
+  /**
+   * Prints timing for every stage to the terminal.
+   */
+  void stats_print();
+
+ private:
+  struct stage {
+    std::function<void()> run;
+    stage_stats stats;
+  };
+  std::vector<stage> stages;
+  std::uint32_t period;
+  std::uint32_t ticks = 0;
+  std::uint32_t tick_overruns = 0;
+  std::uint32_t longest_tick = 0;
+  bool enabled = false;
+  pros::Task* task = nullptr;
+  pros::Mutex stages_mutex;
+  void task_fn();
+};
+}  // namespace robot
@@ -0,0 +1,174 @@
+/*
+This Source Code Form is subject to the terms of the Mozilla Public
+License, v. 2.0. If a copy of the MPL was not distributed with this
+file, You can obtain one at http://mozilla.org/MPL/2.0/.
+*/
+
+#pragma once
+
+#include <cmath>
+
+// Predicts where a PID's error is going from the last few ticks of it, so a motion can exit as
+// soon as it's clearly settling instead of after a fixed dwell.  No PROS dependencies so the host
+// replay scores the same predictor against simulated steps and logs.
+
+namespace robot {
+/**
+ * Where the error is predicted to settle.
+ */
+enum settle_result {
+  SETTLE_RUNNING = 0,  // still moving, or the fit can't tell yet
+  SETTLE_SMALL = 1,    // inside the small tolerance for good
+  SETTLE_BIG = 2,      // stopped inside the big tolerance but outside the small one, eg. on friction
+};
+
+/**
+ * How much history the predictor fits and how far it looks ahead, in control ticks.
+ */
+struct settle_settings {
+  int window = 12;           // ticks fitted, at most settle_predictor::MAX_WINDOW
+  int horizon = 50;          // ticks the prediction has to stay inside the tolerance for
+  double fit_error = 0.1;    // rms misfit allowed, as a fraction of the tolerance
+  int confirm = 2;           // ticks in a row the prediction has to hold
+};
+
+/**
+ * Fits e[k] = a e[k-1] + b e[k-2] + c to the recent error, which is a sampled second order
+ * response (a and b) settling on some residual friction leaves (c).  Every tick the fit is
+ * rolled forward over the horizon, and once the error is inside a tolerance, the fit explains
+ * the data, and the roll out stays inside the tolerance and has stopped moving by its end, the
+ * error is predicted to have settled there.  An error that stops between the small and big
+ * tolerances is what EZ's big and velocity timers wait 250 to 500 ms to give up on.
+ */
+class settle_predictor {
+ public:
+  static constexpr int MAX_WINDOW = 32;
+
+  explicit settle_predictor(settle_settings input = {}) { settings_set(input); }
+
+  /**
+   * Sets the window and horizon.  Clears the history.
+   *
+   * \param input
+   *        new settings
+   */
+  void settings_set(settle_settings input) {
+    settings = input;
+    if (settings.window > MAX_WINDOW) settings.window = MAX_WINDOW;
+    if (settings.window < 4) settings.window = 4;
+    reset();
+  }
+
+  /**
+   * Clears the history, call it when a motion starts.
+   */
+  void reset() {
+    count = 0;
+    held = 0;
+    last = SETTLE_RUNNING;
+    residual = 0.0;
+  }
+
+  /**
+   * Adds this tick's error and returns where it's predicted to settle.
+   *
+   * \param error
+   *        the PID's error this tick
+   * \param small
+   *        band the error should settle in, eg. the PID's small_error
+   * \param big
+   *        band it may stop in, eg. the PID's big_error, 0 to only predict the small band.  Leave
+   *        it 0 for a PID with an integral, which keeps pushing a stopped error
+   */
+  settle_result update(double error, double small, double big = 0.0) {
+    history[count % (MAX_WINDOW + 2)] = error;
+    count++;
+    settle_result now = SETTLE_RUNNING;
+    if (small > 0.0 && std::fabs(error) < small && predict(small, small)) now = SETTLE_SMALL;
+    else if (small > 0.0 && big > small && std::fabs(error) < big && stopped(small) && predict(big, small)) now = SETTLE_BIG;
+    held = now != SETTLE_RUNNING && now == last ? held + 1 : (now != SETTLE_RUNNING ? 1 : 0);
+    last = now;
+    return held >= settings.confirm ? now : SETTLE_RUNNING;
+  }
+
+  /**
+   * Returns the error the last fit settles on.
+   */
+  double residual_get() const { return residual; }
+
+ private:
+  settle_settings settings;
+  double history[MAX_WINDOW + 2] = {};
+  int count = 0;
+  int held = 0;
+  settle_result last = SETTLE_RUNNING;
+  double residual = 0.0;
+
+  double at(int ago) const { return history[(count - 1 - ago) % (MAX_WINDOW + 2)]; }
+
+  // True if the whole window is within the noise the fit allows of one value
+  bool stopped(double small) const {
+    if (count < settings.window) return false;
+    double low = at(0), high = at(0);
+    for (int i = 1; i < settings.window; i++) {
+      low = std::fmin(low, at(i));
+      high = std::fmax(high, at(i));
+    }
+    return high - low < 2.0 * settings.fit_error * small;
+  }
+
+  // True if the error stays inside band and stops, judged against the small band's noise
+  bool predict(double band, double small) {
+    int n = settings.window;
+    if (count < n + 2) return false;
+
+    // Normal equations for a, b, c.  A little ridge on a and b keeps a stopped error, where the
+    // history is all one value and any a + b + c / e = 1 fits, solvable; the roll out stays put.
+    double A[3][3] = {}, v[3] = {};
+    for (int k = 0; k < n; k++) {
+      double x[3] = {at(k + 1), at(k + 2), 1.0};
+      for (int r = 0; r < 3; r++) {
+        for (int c = 0; c < 3; c++) A[r][c] += x[r] * x[c];
+        v[r] += x[r] * at(k);
+      }
+    }
+    double ridge = 1e-4 * small * small * n;
+    A[0][0] += ridge;
+    A[1][1] += ridge;
+    double det = A[0][0] * (A[1][1] * A[2][2] - A[1][2] * A[2][1]) - A[0][1] * (A[1][0] * A[2][2] - A[1][2] * A[2][0]) +
+                 A[0][2] * (A[1][0] * A[2][1] - A[1][1] * A[2][0]);
+    if (std::fabs(det) < 1e-12) return false;
+    double k[3];
+    for (int col = 0; col < 3; col++) {
+      // Cramer's rule, the system is only 3 by 3
+      double M[3][3];
+      for (int r = 0; r < 3; r++)
+        for (int c = 0; c < 3; c++) M[r][c] = c == col ? v[r] : A[r][c];
+      k[col] = (M[0][0] * (M[1][1] * M[2][2] - M[1][2] * M[2][1]) - M[0][1] * (M[1][0] * M[2][2] - M[1][2] * M[2][0]) +
+                M[0][2] * (M[1][0] * M[2][1] - M[1][1] * M[2][0])) /
+               det;
+    }
+
+    // The fit has to explain what happened before it's trusted with what happens next
+    double misfit = 0.0;
+    for (int i = 0; i < n; i++) {
+      double e = at(i) - (k[0] * at(i + 1) + k[1] * at(i + 2) + k[2]);
+      misfit += e * e;
+    }
+    if (std::sqrt(misfit / n) > settings.fit_error * small) return false;
+
+    // Noise the fit allows could carry an error that settles right on the edge back out, so the
+    // roll out has to stay that far inside
+    double limit = band - settings.fit_error * small;
+    double previous = at(1), current = at(0);
+    for (int i = 0; i < settings.horizon; i++) {
+      double next = k[0] * current + k[1] * previous + k[2];
+      previous = current;
+      current = next;
+      if (!(std::fabs(current) < limit)) return false;  // also catches a fit that blew up to nan
+    }
+    residual = current;
+    return std::fabs(current - previous) < 0.01 * small;
+  }
+};
+}  // namespace robot
@@ -0,0 +1,63 @@
+/*
+This Source Code Form is subject to the terms of the Mozilla Public
+License, v. 2.0. If a copy of the MPL was not distributed with this
+file, You can obtain one at http://mozilla.org/MPL/2.0/.
+*/
+
+#pragma once
+
+#include <atomic>
+#include <cstdint>
+
+namespace robot {
+/**
+ * Single writer, many reader publication of a small struct.
+ *
+ * The writer fills the buffer readers aren't using and then bumps a sequence counter.
+ * A reader copies the buffer the counter points at and retries only if a publish
+ * finished while it was copying, so readers never wait on the writer and the writer
+ * never takes a lock.
+ */
+template <typename T>
+class snapshot {
+ public:
+  /**
+   * Publishes a new value.  Only one task may call this.
+   *
+   * \param input
+   *        value to publish
+   */
+  void publish(const T& input) {
+    std::uint32_t next = sequence.load(std::memory_order_relaxed) + 1;
+    buffers[next & 1] = input;
+    sequence.store(next, std::memory_order_release);
+    // Keeps the next publish's buffer writes after this store, a release store alone lets later
+    // writes move above it
+    std::atomic_thread_fence(std::memory_order_release);
+  }
+
+  /**
+   * Returns the latest value.  Every field comes from the same publish.
+   */
+  T get() const {
+    while (true) {
+      std::uint32_t before = sequence.load(std::memory_order_acquire);
+      T out = buffers[before & 1];
+      std::atomic_thread_fence(std::memory_order_acquire);
+
+      // The writer only starts on this buffer again after finishing a publish into the other
+      // one, so the copy is clean as long as no publish finished while it was being made
+      if (sequence.load(std::memory_order_relaxed) == before) return out;
+    }
+  }
+
+  /**
+   * Returns how many times a value has been published.
+   */
+  std::uint32_t sequence_get() const { return sequence.load(std::memory_order_acquire); }
+
+ private:
+  T buffers[2] = {};
+  std::atomic<std::uint32_t> sequence{0};
+};
+}  // namespace robot
@@ -0,0 +1,499 @@
+/*
+This Source Code Form is subject to the terms of the Mozilla Public
+License, v. 2.0. If a copy of the MPL was not distributed with this
+file, You can obtain one at http://mozilla.org/MPL/2.0/.
+*/
+
+#pragma once
+
+#include <algorithm>
+#include <array>
+#include <cmath>
+#include <cstddef>
+#include <vector>
+
+#if !defined(__arm__)
+#include <thread>
+#endif
+
+#include "profile_point.hpp"
+
+// Spline trajectories fast enough to generate between motions.  Takes squiggles poses like
+// squiggles' SplineGenerator, and no PROS dependencies so the host benchmark includes this too.
+
+namespace robot {
+/**
+ * Limits a trajectory is generated with.  Meters and seconds, like squiggles.
+ */
+struct spline_settings {
+  double max_vel = 1.3;        // m/s of the faster wheel
+  double max_accel = 2.5;      // m/s^2
+  double track_width = 0.29;   // m
+  double spacing = 0.02;       // m between states
+  int max_iterations = 20;     // BFGS steps per segment
+  double tolerance = 0.001;    // step, as a fraction of the chord, that ends the search
+  bool warm_start = true;      // false seeds every segment from the grid alone, for comparison
+  bool analytic = true;        // false takes central differences of the cost, for comparison
+};
+
+namespace spline_detail {
+// Samples of each segment the cost is integrated over
+constexpr int COST_SAMPLES = 24;
+
+/**
+ * One quintic Hermite segment with zero acceleration at both ends.  Its only free parameters
+ * are the tangent lengths k0 and k1:
+ *
+ *   p(t) = h0(t) p0 + k0 h1(t) u0 + k1 h4(t) u1 + h5(t) p1,  t in [0, 1]
+ *
+ * so p' and p'' are linear in k0 and k1 and the cost's gradient comes straight from the basis.
+ */
+struct segment {
+  double x0 = 0.0, y0 = 0.0, ux0 = 1.0, uy0 = 0.0;  // start and unit heading
+  double x1 = 0.0, y1 = 0.0, ux1 = 1.0, uy1 = 0.0;  // end and unit heading
+  double k0 = 0.0, k1 = 0.0;
+  double length = 0.0;  // chord
+
+  segment() = default;
+  segment(const squiggles::Pose& a, const squiggles::Pose& b)
+      : x0(a.x), y0(a.y), ux0(std::cos(a.yaw)), uy0(std::sin(a.yaw)), x1(b.x), y1(b.y), ux1(std::cos(b.yaw)), uy1(std::sin(b.yaw)), length(a.dist(b)) {}
+};
+
+// Basis h0, h1, h4, h5 or one of their derivatives at t
+struct basis {
+  double h0, h1, h4, h5;
+};
+
+inline basis basis_at(double t, int derivative) {
+  double t2 = t * t, t3 = t2 * t, t4 = t3 * t, t5 = t4 * t;
+  switch (derivative) {
+    case 0:
+      return {1 - 10 * t3 + 15 * t4 - 6 * t5, t - 6 * t3 + 8 * t4 - 3 * t5, -4 * t3 + 7 * t4 - 3 * t5, 10 * t3 - 15 * t4 + 6 * t5};
+    case 1:
+      return {-30 * t2 + 60 * t3 - 30 * t4, 1 - 18 * t2 + 32 * t3 - 15 * t4, -12 * t2 + 28 * t3 - 15 * t4, 30 * t2 - 60 * t3 + 30 * t4};
+    default:
+      return {-60 * t + 180 * t2 - 120 * t3, -36 * t + 96 * t2 - 60 * t3, -24 * t + 84 * t2 - 60 * t3, 60 * t - 180 * t2 + 120 * t3};
+  }
+}
+
+inline void point_at(const segment& s, const basis& h, double& x, double& y) {
+  x = h.h0 * s.x0 + s.k0 * h.h1 * s.ux0 + s.k1 * h.h4 * s.ux1 + h.h5 * s.x1;
+  y = h.h0 * s.y0 + s.k0 * h.h1 * s.uy0 + s.k1 * h.h4 * s.uy1 + h.h5 * s.y1;
+}
+
+// Halvings of a sample's width the cost is refined to around a slow point
+constexpr int REFINE_LEVELS = 8;
+
+// Only samples slower than this fraction of the chord are refined, faster ones can't hide a spike
+constexpr double REFINE_SPEED = 1.0;
+
+// solve() also stops once a step along the gradient a whole chord long would change the cost by
+// less than this fraction of itself
+constexpr double GRADIENT_TOLERANCE = 0.01;
+
+inline double speed_at(const segment& s, double t) {
+  double vx, vy;
+  point_at(s, basis_at(t, 1), vx, vy);
+  return std::hypot(vx, vy);
+}
+
+// Slowest point between a and b, by golden section search
+inline double slowest_between(const segment& s, double a, double b) {
+  const double r = 0.6180339887498949;
+  double c = b - r * (b - a), d = a + r * (b - a), fc = speed_at(s, c), fd = speed_at(s, d);
+  for (int i = 0; i < 24; i++) {
+    if (fc < fd) {
+      b = d;
+      d = c;
+      fd = fc;
+      c = b - r * (b - a);
+      fc = speed_at(s, c);
+    } else {
+      a = c;
+      c = d;
+      fc = fd;
+      d = a + r * (b - a);
+      fd = speed_at(s, d);
+    }
+  }
+  return fc < fd ? c : d;
+}
+
+// Adds curvature squared times arc length at t, weighted by w, and its partials in k0 and k1
+inline void accumulate(const segment& s, double t, double w, double& total, double* gradient) {
+  basis d1 = basis_at(t, 1), d2 = basis_at(t, 2);
+  double vx, vy, ax, ay;
+  point_at(s, d1, vx, vy);
+  point_at(s, d2, ax, ay);
+  double speed = std::sqrt(vx * vx + vy * vy) + 1e-9;
+  double cross = vx * ay - vy * ax;
+  double s5 = speed * speed * speed * speed * speed;
+  total += cross * cross / s5 * w;
+  if (!gradient) return;
+
+  // d/dk of cross^2 / |v|^5, with dv/dk0 = h1' u0, da/dk0 = h1'' u0 and the same for k1
+  auto partial = [&](double dvx, double dvy, double dax, double day) {
+    double dcross = dvx * ay + vx * day - dvy * ax - vy * dax;
+    double dspeed = (vx * dvx + vy * dvy) / speed;
+    return (2.0 * cross * dcross / s5 - 5.0 * cross * cross * dspeed / (s5 * speed)) * w;
+  };
+  gradient[0] += partial(d1.h1 * s.ux0, d1.h1 * s.uy0, d2.h1 * s.ux0, d2.h1 * s.uy0);
+  gradient[1] += partial(d1.h4 * s.ux1, d1.h4 * s.uy1, d2.h4 * s.ux1, d2.h4 * s.uy1);
+}
+
+/**
+ * Integral of curvature squared over arc length, the bending energy of the segment.  Low means
+ * gentle, evenly spread turning the robot can take quickly.  With gradient set, also fills in
+ * the cost's partial derivatives in k0 and k1.
+ *
+ * Curvature spikes where the spline nearly stops, often narrower than one sample, and a search
+ * that can't see the spike will happily put a cusp there.  So around every sample slower than
+ * its neighbours and than REFINE_SPEED chords, the slowest point is found and the samples
+ * either side are integrated on a mesh that halves toward it.
+ */
+inline double cost(const segment& s, double* gradient = nullptr) {
+  double total = 0.0, g[2] = {0.0, 0.0};
+  double* gp = gradient ? g : nullptr;
+  const double dt = 1.0 / COST_SAMPLES;
+  std::array<double, COST_SAMPLES> speeds;
+  std::array<double, COST_SAMPLES> slowest;  // where each refined sample is refined toward, -1 if not
+  for (int j = 0; j < COST_SAMPLES; j++) {
+    speeds[j] = speed_at(s, (j + 0.5) * dt);
+    slowest[j] = -1.0;
+  }
+  for (int j = 0; j < COST_SAMPLES; j++) {
+    if (speeds[j] >= REFINE_SPEED * s.length) continue;
+    if ((j != 0 && speeds[j] > speeds[j - 1]) || (j + 1 != COST_SAMPLES && speeds[j] > speeds[j + 1])) continue;
+    double t0 = slowest_between(s, std::max(0.0, (j - 0.5) * dt), std::min(1.0, (j + 1.5) * dt));
+    for (int k = std::max(0, j - 1); k <= std::min(COST_SAMPLES - 1, j + 1); k++)
+      if (slowest[k] < 0.0) slowest[k] = t0;
+  }
+
+  for (int j = 0; j < COST_SAMPLES; j++) {
+    double a = j * dt, b = a + dt;
+    if (slowest[j] < 0.0) {
+      accumulate(s, a + 0.5 * dt, dt, total, gp);
+      continue;
+    }
+    // Breakpoints at t0 +- dt / 2^level, midpoint rule between them
+    double t0 = std::clamp(slowest[j], a, b);
+    double left = a;
+    for (int level = 0; level <= REFINE_LEVELS; level++) {
+      double right = level < REFINE_LEVELS ? t0 - dt / (2 << level) : t0;
+      if (right <= left) continue;
+      accumulate(s, 0.5 * (left + right), right - left, total, gp);
+      left = right;
+    }
+    for (int level = REFINE_LEVELS; level >= -1; level--) {
+      double right = level < 0 ? b : level < REFINE_LEVELS ? t0 + dt / (2 << level) : t0;
+      right = std::min(right, b);
+      if (right <= left) continue;
+      accumulate(s, 0.5 * (left + right), right - left, total, gp);
+      left = right;
+    }
+  }
+  if (gradient) {
+    gradient[0] = g[0];
+    gradient[1] = g[1];
+  }
+  return total;
+}
+
+// cost() with the gradient from central differences, four more evaluations, for comparison
+inline double cost_numeric(const segment& s, double* gradient) {
+  const double h = 1e-6 * s.length;
+  segment a = s, b = s;
+  a.k0 += h;
+  b.k0 -= h;
+  gradient[0] = (cost(a) - cost(b)) / (2.0 * h);
+  a = b = s;
+  a.k1 += h;
+  b.k1 -= h;
+  gradient[1] = (cost(a) - cost(b)) / (2.0 * h);
+  return cost(s);
+}
+
+// Tangent lengths, as a fraction of the chord, a cold segment tries before descending
+constexpr double SEEDS[] = {0.5, 1.2, 2.2};
+
+/**
+ * Picks the starting tangent lengths for solve(): the cheapest of a coarse grid and, if given,
+ * a guess like the previous segment's solution.  Only costs, no gradients.  Returns the number
+ * of cost evaluations.
+ */
+inline int seed(segment& s, const double* guess = nullptr) {
+  int evaluations = 0;
+  double best = -1.0;
+  segment trial = s;
+  auto consider = [&](double r0, double r1) {
+    trial.k0 = r0 * s.length;
+    trial.k1 = r1 * s.length;
+    double c = cost(trial);
+    evaluations++;
+    if (best < 0.0 || c < best) {
+      best = c;
+      s.k0 = trial.k0;
+      s.k1 = trial.k1;
+    }
+  };
+  for (double r0 : SEEDS)
+    for (double r1 : SEEDS) consider(r0, r1);
+  if (guess) consider(guess[0], guess[1]);
+  return evaluations;
+}
+
+/**
+ * Minimises cost() over k0 and k1 from their current values with BFGS: steps along the
+ * gradient scaled by an estimate of the inverse Hessian built up from past gradients, halving
+ * the step until the cost drops enough.  Stops once the gradient is flat or a step is shorter
+ * than settings.tolerance of the chord.  Returns the number of cost evaluations.
+ */
+inline int solve(segment& s, const spline_settings& settings) {
+  if (s.length <= 0.0) return 0;
+  const double low = 0.1 * s.length, high = 3.0 * s.length;
+  s.k0 = std::clamp(s.k0, low, high);
+  s.k1 = std::clamp(s.k1, low, high);
+  int evaluations = 0;
+  auto evaluate = [&](const segment& at, double* gradient) {
+    evaluations += settings.analytic ? 1 : 5;
+    return settings.analytic ? cost(at, gradient) : cost_numeric(at, gradient);
+  };
+
+  auto converged = [&](double cost, const double* gradient) { return std::hypot(gradient[0], gradient[1]) * s.length <= GRADIENT_TOLERANCE * cost; };
+  const double smallest = settings.tolerance * s.length;
+
+  double g[2];
+  double c = evaluate(s, g);
+  double norm = std::hypot(g[0], g[1]);
+  if (norm < 1e-12 || converged(c, g)) return evaluations;
+  double h[3] = {0.25 * s.length / norm, 0.0, 0.25 * s.length / norm};  // inverse Hessian, symmetric
+
+  for (int iteration = 0; iteration < settings.max_iterations; iteration++) {
+    double p0 = -(h[0] * g[0] + h[1] * g[1]), p1 = -(h[1] * g[0] + h[2] * g[1]);
+    double slope = p0 * g[0] + p1 * g[1];
+    if (slope >= 0.0) {  // lost a descent direction, start the estimate over
+      h[0] = h[2] = 0.25 * s.length / std::max(std::hypot(g[0], g[1]), 1e-12);
+      h[1] = 0.0;
+      p0 = -h[0] * g[0];
+      p1 = -h[2] * g[1];
+      slope = p0 * g[0] + p1 * g[1];
+    }
+
+    // Backtrack until the cost drops by a fraction of what the slope promised
+    segment trial = s;
+    double tg[2], tc = c;
+    bool moved = false;
+    for (double alpha = 1.0; alpha * std::hypot(p0, p1) > smallest; alpha *= 0.5) {
+      trial.k0 = std::clamp(s.k0 + alpha * p0, low, high);
+      trial.k1 = std::clamp(s.k1 + alpha * p1, low, high);
+      tc = evaluate(trial, tg);
+      if (tc <= c + 1e-4 * alpha * slope) {
+        moved = true;
+        break;
+      }
+    }
+    if (!moved) break;
+
+    double d0 = trial.k0 - s.k0, d1 = trial.k1 - s.k1;
+    double y0 = tg[0] - g[0], y1 = tg[1] - g[1];
+    s = trial;
+    c = tc;
+    g[0] = tg[0];
+    g[1] = tg[1];
+    if (converged(c, g) || std::hypot(d0, d1) < smallest) break;
+
+    // BFGS update of the inverse Hessian, skipped when the curvature condition fails
+    double sy = d0 * y0 + d1 * y1;
+    if (sy <= 1e-12) continue;
+    double hy0 = h[0] * y0 + h[1] * y1, hy1 = h[1] * y0 + h[2] * y1;
+    double yhy = y0 * hy0 + y1 * hy1;
+    double scale = (sy + yhy) / (sy * sy);
+    h[0] += scale * d0 * d0 - 2.0 * hy0 * d0 / sy;
+    h[1] += scale * d0 * d1 - (hy0 * d1 + hy1 * d0) / sy;
+    h[2] += scale * d1 * d1 - 2.0 * hy1 * d1 / sy;
+  }
+  return evaluations;
+}
+}  // namespace spline_detail
+
+/**
+ * Generates time parameterised trajectories through poses.
+ *
+ * squiggles searches every duration from T_MIN to T_MAX and runs numeric gradient descent for
+ * each one, which takes seconds on the brain.  Here the shape of each segment has two
+ * parameters, its tangent lengths, found by descending the analytic gradient of its bending
+ * energy, and timing is a separate forward/backward pass against the TankModel's wheel speed
+ * limit.  Each segment starts from the previous segment's solution, or from the same segment of
+ * the last path generated if it had as many waypoints, so regenerating a route from a slightly
+ * different pose only takes a few steps.
+ */
+class spline_generator {
+ public:
+  /**
+   * Generates a trajectory through poses, from rest to rest.  Allocates nothing once out and
+   * the generator have held a path this size.
+   *
+   * \param waypoints
+   *        poses to drive through, the first is where the robot starts
+   * \param settings
+   *        limits to respect
+   * \param out
+   *        path to fill
+   * \param threads
+   *        segments are split between this many threads, host builds only.  The brain has one
+   *        core, so it always generates on the calling task.
+   */
+  void generate(const std::vector<squiggles::Pose>& waypoints, const spline_settings& settings, profile_path<2>& out, int threads = 1) {
+    out.clear();
+    // A segment with no chord has nothing to scale its tangents by, so a waypoint on top of the
+    // one before is merged into it.  Its heading replaces the earlier one's unless that is the
+    // start, where the robot already is.  A spline can't turn in place, use a turn for that.
+    poses.clear();
+    for (const squiggles::Pose& w : waypoints) {
+      if (poses.empty() || poses.back().dist(w) > MIN_CHORD) {
+        poses.push_back(w);
+      } else if (poses.size() > 1) {
+        poses.back().yaw = w.yaw;
+      }
+    }
+    if (poses.size() < 2) return;
+    std::size_t count = poses.size() - 1;
+
+    // A path with as many segments as the last one starts from its solution, skipping the seed
+    // search.  Otherwise each segment seeds from a coarse grid and the previous segment in its
+    // chunk.
+    bool warm = settings.warm_start && solved.size() == count;
+    segments.resize(count);
+    offsets.resize(count + 1);
+    for (std::size_t i = 0; i < count; i++) {
+      segments[i] = spline_detail::segment(poses[i], poses[i + 1]);
+      if (warm) {
+        segments[i].k0 = solved[i][0] * segments[i].length;
+        segments[i].k1 = solved[i][1] * segments[i].length;
+      }
+    }
+
+    std::size_t chunks = std::clamp<std::size_t>(threads, 1, count);
+    std::array<int, MAX_THREADS> evaluations{};
+    chunks = std::min(chunks, MAX_THREADS);
+    parallel(chunks, count, [&](std::size_t chunk, std::size_t begin, std::size_t end) {
+      for (std::size_t i = begin; i < end; i++) {
+        if (!warm) {
+          const spline_detail::segment& previous = segments[i - (i != begin)];
+          double guess[2] = {previous.k0 / previous.length, previous.k1 / previous.length};
+          evaluations[chunk] += spline_detail::seed(segments[i], settings.warm_start && i != begin ? guess : nullptr);
+        }
+        evaluations[chunk] += spline_detail::solve(segments[i], settings);
+        offsets[i + 1] = states_in(segments[i], settings) + (i + 1 == count ? 1 : 0);
+      }
+    });
+
+    solved.resize(count);
+    evaluation_count = 0;
+    offsets[0] = 0;
+    for (std::size_t i = 0; i < count; i++) {
+      solved[i] = {segments[i].k0 / segments[i].length, segments[i].k1 / segments[i].length};
+      offsets[i + 1] += offsets[i];
+    }
+    for (int e : evaluations) evaluation_count += e;
+
+    // Every segment samples into its own slice of the one block
+    out.assign(offsets[count]);
+    parallel(chunks, count, [&](std::size_t, std::size_t begin, std::size_t end) {
+      for (std::size_t i = begin; i < end; i++) sample(segments[i], offsets[i + 1] - offsets[i], i + 1 == count, out.data() + offsets[i]);
+    });
+    profile(settings, out);
+  }
+
+  /**
+   * Drops the last path's solution, so the next generate() starts cold.
+   */
+  void forget() { solved.clear(); }
+
+  /**
+   * Returns how many times the last generate() evaluated a segment's cost, a gradient by
+   * central differences counting as five.
+   */
+  int evaluations() const { return evaluation_count; }
+
+ private:
+  static constexpr std::size_t MAX_THREADS = 16;
+  static constexpr double MIN_CHORD = 1e-4;  // m, waypoints closer than this are one
+  std::vector<squiggles::Pose> poses;         // waypoints with duplicates merged
+  std::vector<std::array<double, 2>> solved;  // k0 and k1 over chord length, per segment
+  std::vector<spline_detail::segment> segments;
+  std::vector<std::size_t> offsets;  // first state of each segment
+  int evaluation_count = 0;
+
+  // Runs fn(chunk, begin, end) over count items split into chunks, on threads on the host
+  template <typename F>
+  static void parallel(std::size_t chunks, std::size_t count, F&& fn) {
+    auto run = [&](std::size_t chunk) { fn(chunk, chunk * count / chunks, (chunk + 1) * count / chunks); };
+#if !defined(__arm__)
+    if (chunks > 1) {
+      std::vector<std::thread> workers;
+      for (std::size_t chunk = 1; chunk < chunks; chunk++) workers.emplace_back(run, chunk);
+      run(0);
+      for (auto& worker : workers) worker.join();
+      return;
+    }
+#endif
+    for (std::size_t chunk = 0; chunk < chunks; chunk++) run(chunk);
+  }
+
+  // States a segment is sampled into, about one every settings.spacing
+  static std::size_t states_in(const spline_detail::segment& s, const spline_settings& settings) {
+    double arc = 0.0;
+    for (int j = 0; j < spline_detail::COST_SAMPLES; j++) {
+      double vx, vy;
+      spline_detail::point_at(s, spline_detail::basis_at((j + 0.5) / spline_detail::COST_SAMPLES, 1), vx, vy);
+      arc += std::hypot(vx, vy) / spline_detail::COST_SAMPLES;
+    }
+    return std::max(2, (int)std::ceil(arc / settings.spacing));
+  }
+
+  // Pose and curvature of n evenly spaced states.  The end is left to the next segment unless
+  // this is the last one, which gets one more state.
+  static void sample(const spline_detail::segment& s, std::size_t n, bool last, profile_point<2>* out) {
+    std::size_t steps = last ? n - 1 : n;
+    for (std::size_t j = 0; j < n; j++) {
+      double t = (double)j / steps;
+      double x, y, vx, vy, ax, ay;
+      spline_detail::point_at(s, spline_detail::basis_at(t, 0), x, y);
+      spline_detail::point_at(s, spline_detail::basis_at(t, 1), vx, vy);
+      spline_detail::point_at(s, spline_detail::basis_at(t, 2), ax, ay);
+      double speed = std::hypot(vx, vy);
+      out[j].vector = squiggles::ControlVector(squiggles::Pose(x, y, std::atan2(vy, vx)), 0.0);
+      out[j].curvature = speed > 1e-9 ? (vx * ay - vy * ax) / (speed * speed * speed) : 0.0;
+    }
+  }
+
+  // Speed, acceleration, wheel speeds and time for every state, in place
+  static void profile(const spline_settings& settings, profile_path<2>& out) {
+    std::size_t n = out.size();
+    auto ds = [&](std::size_t i) { return out[i].vector.pose.dist(out[i - 1].vector.pose); };
+    for (std::size_t i = 0; i < n; i++) out[i].vector.vel = settings.max_vel / (1.0 + std::fabs(out[i].curvature) * settings.track_width / 2.0);  // faster wheel at max_vel
+    out.front().vector.vel = out.back().vector.vel = 0.0;
+    for (std::size_t i = n - 1; i-- > 0;) {
+      double next = out[i + 1].vector.vel;
+      out[i].vector.vel = std::min(out[i].vector.vel, std::sqrt(next * next + 2.0 * settings.max_accel * ds(i + 1)));
+    }
+    for (std::size_t i = 1; i < n; i++) {
+      double previous = out[i - 1].vector.vel;
+      out[i].vector.vel = std::min(out[i].vector.vel, std::sqrt(previous * previous + 2.0 * settings.max_accel * ds(i)));
+    }
+
+    double time = 0.0;
+    for (std::size_t i = 0; i < n; i++) {
+      double v = out[i].vector.vel;
+      if (i != 0 && v + out[i - 1].vector.vel > 0.0) time += 2.0 * ds(i) / (v + out[i - 1].vector.vel);
+      double next = i + 1 < n ? out[i + 1].vector.vel : v;
+      double step = i + 1 < n ? ds(i + 1) : 0.0;
+      double turn = out[i].curvature * settings.track_width / 2.0;
+      out[i].vector.accel = step > 0.0 ? (next * next - v * v) / (2.0 * step) : 0.0;
+      out[i].wheel_velocities = {v * (1.0 - turn), v * (1.0 + turn)};
+      out[i].time = time;
+    }
+  }
+};
+}  // namespace robot
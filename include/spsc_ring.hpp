@@ -0,0 +1,68 @@
+/*
+This Source Code Form is subject to the terms of the Mozilla Public
+License, v. 2.0. If a copy of the MPL was not distributed with this
+file, You can obtain one at http://mozilla.org/MPL/2.0/.
+*/
+
+#pragma once
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+
+namespace robot {
+/**
+ * Fixed size single producer, single consumer queue.
+ *
+ * One task pushes and one task pops.  Neither side locks or allocates, the producer only
+ * writes head and the consumer only writes tail.
+ */
+template <typename T, std::size_t N>
+class spsc_ring {
+  static_assert(N != 0 && (N & (N - 1)) == 0, "spsc_ring size must be a power of 2");
+
+ public:
+  /**
+   * Adds an item.  Returns false and drops the item if the ring is full.
+   *
+   * \param item
+   *        item to add
+   */
+  bool push(const T& item) {
+    std::uint32_t h = head.load(std::memory_order_relaxed);
+    if (h - tail.load(std::memory_order_acquire) == N) return false;
+    items[h & (N - 1)] = item;
+    head.store(h + 1, std::memory_order_release);
+    return true;
+  }
+
+  /**
+   * Removes the oldest item.  Returns false if the ring is empty.
+   *
+   * \param out
+   *        where the item is copied to
+   */
+  bool pop(T& out) {
+    std::uint32_t t = tail.load(std::memory_order_relaxed);
+    if (t == head.load(std::memory_order_acquire)) return false;
+    out = items[t & (N - 1)];
+    tail.store(t + 1, std::memory_order_release);
+    return true;
+  }
+
+  /**
+   * Returns how many items are waiting.
+   */
+  std::size_t size() const { return head.load(std::memory_order_acquire) - tail.load(std::memory_order_acquire); }
+
+  /**
+   * Returns how many items fit.
+   */
+  static constexpr std::size_t capacity() { return N; }
+
+ private:
+  T items[N];
+  std::atomic<std::uint32_t> head{0};
+  std::atomic<std::uint32_t> tail{0};
+};
+}  // namespace robot
@@ -5,6 +5,19 @@
 
 extern Drive chassis;
 
+// Fixed rate loop every periodic stage runs on
+extern robot::scheduler control_loop;
+
+// Pistons and rollers, see actuators.hpp
+extern robot::actuators mechanisms;
+
+// Distance sensor on the back, pose fusion reads the perimeter with it.  The mount is from the
+// drive's tracking center, the simulator puts its sensor here too.  Not measured yet, check it
+// before any auton starts fusion
+extern pros::Distance dist_sensor;
+inline constexpr int DIST_SENSOR_PORT = 14;
+inline constexpr robot::distance_mount DIST_SENSOR_MOUNT = {0.0, -6.0, 180.0};
+
 // Your motors, sensors, etc. should go here.  Below are examples
 
 // inline pros::Motor intake(1);
@@ -0,0 +1,73 @@
+/*
+This Source Code Form is subject to the terms of the Mozilla Public
+License, v. 2.0. If a copy of the MPL was not distributed with this
+file, You can obtain one at http://mozilla.org/MPL/2.0/.
+*/
+
+#pragma once
+
+#include <array>
+#include <cstdint>
+
+#include "snapshot.hpp"
+
+namespace robot {
+/**
+ * Most motors the chassis telemetry can hold.
+ */
+constexpr int TELEMETRY_MOTORS = 8;
+
+/**
+ * The chassis motor readings project code uses, read once in the same tick.  Struct of arrays
+ * so a consumer that only wants one quantity walks one contiguous array.  Left motors come
+ * first, then right motors, in the order they were given to ez::Drive.
+ *
+ * Only what something reads is sampled: velocity for drive_velocity's characterization,
+ * current for the recorder, and the over current flag of the motor EZ's exit conditions check
+ * on each side.  EZ-Template's own position reads happen inside its archive and can't be
+ * shared, so positions come from chassis.drive_sensor_left()/right() as they always did.
+ */
+struct motor_telemetry {
+  std::array<double, TELEMETRY_MOTORS> velocity{};       // rpm
+  std::array<std::int32_t, TELEMETRY_MOTORS> current{};  // mA
+  bool left_over_current = false;   // first motor of each side, the one ez::Drive::pid_wait() checks
+  bool right_over_current = false;
+  int left_count = 0;
+  int right_count = 0;
+  std::uint32_t tick = 0;  // publish count
+  std::uint32_t time = 0;  // ms, when the motors were read
+
+  /**
+   * Returns the number of motors.
+   */
+  int size() const { return left_count + right_count; }
+
+  /**
+   * Returns the index of the first left and right motor.
+   */
+  int left_begin() const { return 0; }
+  int right_begin() const { return left_count; }
+
+  /**
+   * Returns the average velocity of a side in rpm.
+   */
+  double left_velocity() const;
+  double right_velocity() const;
+
+  /**
+   * Returns the total current of a side in mA.
+   */
+  std::int32_t left_current() const;
+  std::int32_t right_current() const;
+};
+
+/**
+ * Chassis motor readings, published every control_loop tick.
+ */
+extern snapshot<motor_telemetry> drive_telemetry;
+
+/**
+ * Scheduler stage that reads the chassis motors once and publishes drive_telemetry.
+ */
+void drive_telemetry_sample();
+}  // namespace robot
@@ -0,0 +1,173 @@
+/*
+This Source Code Form is subject to the terms of the Mozilla Public
+License, v. 2.0. If a copy of the MPL was not distributed with this
+file, You can obtain one at http://mozilla.org/MPL/2.0/.
+*/
+
+#pragma once
+
+#include <cstdint>
+#include <memory>
+#include <vector>
+
+#include "EZ-Template/util.hpp"
+#include "api.h"
+#include "okapi/squiggles/squiggles.hpp"
+#include "path_file.hpp"
+#include "spline_generator.hpp"
+
+namespace robot {
+/**
+ * Limits and gains for trajectory motions.  Distances are inches, times are seconds.
+ */
+struct trajectory_settings {
+  double track_width = 11.5;  // used when chassis.drive_width_get() is 0
+  double max_accel = 100.0;   // in/s^2
+  double max_jerk = 1000.0;   // in/s^3, generate() only
+  double dt = 0.01;           // seconds between generate()'s states, one control_loop tick
+  double spacing = 0.75;      // in between generate_live()'s states
+  double b = 2.0;             // RAMSETE gains in their usual meter units, b > 0
+  double zeta = 0.7;          // 0 < zeta < 1
+};
+
+/**
+ * Time parameterised motions through squiggles' SplineGenerator.
+ *
+ * generate() fits quintic splines through a list of poses and times them against a TankModel
+ * built from the drive width and chassis_velocity.top_speed_get(), so every state is at the
+ * robot's velocity and acceleration limits instead of wherever a PID happens to put it.
+ * Generating takes a while, so do it in initialize() and keep the result.  start() then
+ * follows it: each tick the state for the current time is fed forward and RAMSETE corrects it
+ * from odometry.  EZ's PID is put in DISABLE for the motion, update() writes the drive.
+ */
+class trajectory_follower {
+ public:
+  /**
+   * Sets the limits and gains.  Takes effect for the next generate() and start().
+   *
+   * \param input
+   *        new settings
+   */
+  void settings_set(trajectory_settings input);
+
+  /**
+   * Returns the limits and gains.
+   */
+  trajectory_settings settings_get();
+
+  /**
+   * Generates a trajectory through poses, from rest to rest.  A pose without an angle faces
+   * the next one, the last one faces away from the one before.
+   *
+   * \param waypoints
+   *        poses to drive through, the first is where the robot starts
+   * \param fast
+   *        stop optimising as soon as the constraints are met instead of finding the smoothest
+   *        path
+   */
+  std::vector<squiggles::ProfilePoint> generate(const std::vector<ez::united_pose>& waypoints, bool fast = false);
+
+  /**
+   * Generates a trajectory with robot::spline_generator instead of squiggles, quick enough to
+   * call between motions.  A route with as many poses as the last one warm starts from it, so
+   * regenerating a route from where the robot actually ended up is quicker still.  Call it
+   * from one task at a time.
+   *
+   * \param waypoints
+   *        poses to drive through, the first is where the robot starts
+   * \param out
+   *        path to fill, reuse one so regenerating doesn't allocate
+   */
+  void generate_live(const std::vector<ez::united_pose>& waypoints, profile_path<2>& out);
+
+  /**
+   * Starts following a generated trajectory, or squiggles states read from a csv.
+   *
+   * \param path
+   *        states from generate()
+   */
+  void start(const std::vector<squiggles::ProfilePoint>& path);
+
+  /**
+   * Starts following a trajectory from generate_live().
+   *
+   * \param path
+   *        states to follow
+   */
+  void start(const profile_path<2>& path);
+
+  /**
+   * Starts following a path file already in memory, see robot::path_view.  Nothing is copied,
+   * so the file's bytes must outlive the motion, or be owned by owner, which is held until the
+   * motion ends.
+   *
+   * \param path
+   *        open path file
+   * \param owner
+   *        keeps the file's bytes alive, eg. from trajectory_library::find()
+   */
+  void start(const path_view& path, std::shared_ptr<const void> owner = nullptr);
+
+  /**
+   * Generates a trajectory and starts following it.  Only for routes that can wait for the
+   * generator, see generate().
+   *
+   * \param waypoints
+   *        poses to drive through, the first is where the robot starts
+   */
+  void pid_trajectory_set(const std::vector<ez::united_pose>& waypoints);
+
+  /**
+   * Blocks until the trajectory has been followed.
+   */
+  void wait();
+
+  /**
+   * Returns true while a trajectory is being followed.
+   */
+  bool running();
+
+  /**
+   * Stops following and stops the drive.
+   */
+  void stop();
+
+  /**
+   * Returns how far the robot ended from the last trajectory's final state, in inches.
+   */
+  double end_error_get();
+
+  /**
+   * Follows the trajectory for the current time.  Scheduler stage, runs every tick after the
+   * pose stage.
+   */
+  void update();
+
+ private:
+  pros::Mutex mutex;
+  trajectory_settings settings;
+  std::vector<std::uint8_t> owned;  // start(std::vector) encodes its path here
+  std::shared_ptr<const void> held;  // start(path_view)'s owner, until the motion ends
+  path_view states;
+  std::size_t state = 0;  // last state reached, only moves forward
+  std::uint32_t start_time = 0;
+  double width = 0.0;      // m
+  double end_error = 0.0;
+  bool active = false;
+  spline_generator live;
+  void start_encoded(std::vector<std::uint8_t> bytes);
+  void begin(const path_view& path, const trajectory_settings& now);  // with the mutex held
+  double width_get(const trajectory_settings& now);
+  spline_settings limits_get(const trajectory_settings& now);
+};
+
+/**
+ * Trajectory motions for the chassis.
+ */
+extern trajectory_follower chassis_trajectory;
+
+/**
+ * Scheduler stage, follows chassis_trajectory.
+ */
+void chassis_trajectory_update();
+}  // namespace robot
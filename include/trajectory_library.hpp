@@ -0,0 +1,173 @@
+/*
+This Source Code Form is subject to the terms of the Mozilla Public
+License, v. 2.0. If a copy of the MPL was not distributed with this
+file, You can obtain one at http://mozilla.org/MPL/2.0/.
+*/
+
+#pragma once
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <string>
+#include <string_view>
+#include <unordered_map>
+#include <vector>
+
+#include "api.h"
+#include "path_file.hpp"
+
+namespace robot {
+/**
+ * Id of a path in a trajectory_library, a hash of its file name without ".path".
+ */
+using path_id = std::uint32_t;
+
+/**
+ * Returns the id of a path name, at compile time when the name is a literal, eg.
+ * constexpr robot::path_id SKILLS_1 = robot::path_id_get("skills_1");
+ *
+ * \param name
+ *        file name without the directory or ".path"
+ */
+constexpr path_id path_id_get(std::string_view name) {
+  std::uint32_t value = 2166136261u;
+  for (char c : name) {
+    value ^= (unsigned char)c;
+    value *= 16777619u;
+  }
+  return value;
+}
+
+/**
+ * Path files from the SD card, read in the background and kept in memory.
+ *
+ * The card is slow, so load() only starts a low priority task that reads every path file in a
+ * directory while initialize() carries on.  Routes follow paths by id with start(), which waits
+ * for the one it needs if the task hasn't reached it yet.  Paths stay loaded until clear() or
+ * directory_set(), and a path being followed or held from find() outlives both.
+ */
+class trajectory_library {
+ public:
+  /**
+   * Starts reading every .path file in a directory in the background.  Paths already loaded
+   * are kept, a file with the same name as one of them is skipped.  If a load is running, the
+   * directory is read once it finishes, only the latest one asked for while it runs.  Returns
+   * false if there's no SD card.
+   *
+   * \param directory
+   *        directory on the card without "/usd", eg. "/paths/auton_2"
+   */
+  bool load(const char* directory);
+
+  /**
+   * Makes paths come from one directory only.  Unless it's the directory already selected,
+   * every loaded path is dropped, a load still reading another directory stops, and this one is
+   * loaded.  Call it whenever the auton selector's page may have changed.  A path still being
+   * followed is freed when the motion lets go of it.
+   *
+   * \param directory
+   *        directory on the card without "/usd", eg. "/paths/auton_2"
+   */
+  void directory_set(const char* directory);
+
+  /**
+   * Returns true while the background task is reading.
+   */
+  bool loading();
+
+  /**
+   * Returns a loaded path, or nullptr if it isn't loaded (yet).  Never blocks.  The path stays
+   * in memory while the pointer is held, even if it's dropped from the library.
+   *
+   * \param id
+   *        id from path_id_get()
+   */
+  std::shared_ptr<const path_view> find(path_id id);
+
+  /**
+   * Waits until a path is loaded or loading finished without it.  Returns the path, or nullptr.
+   *
+   * \param id
+   *        id from path_id_get()
+   * \param timeout
+   *        ms to give up after
+   */
+  std::shared_ptr<const path_view> wait(path_id id, int timeout = 3000);
+
+  /**
+   * Follows a loaded path with chassis_trajectory, waiting for it if it's still loading.
+   * Returns false, printing why, if the path never loaded.
+   *
+   * \param id
+   *        id from path_id_get()
+   */
+  bool start(path_id id);
+
+  /**
+   * Drops every path.  One still being followed is freed when the motion lets go of it.
+   */
+  void clear();
+
+  /**
+   * Sets the most memory paths may take.  A path that doesn't fit is skipped with a message.
+   *
+   * \param bytes
+   *        heap budget for every loaded path together
+   */
+  void budget_set(std::size_t bytes);
+
+  /**
+   * Returns how many paths are loaded.
+   */
+  int size();
+
+  /**
+   * Returns roughly how much heap the loaded paths take, files and bookkeeping.
+   */
+  std::size_t bytes_get();
+
+  /**
+   * Returns how long the last load() took to read its directory, in ms.
+   */
+  std::uint32_t load_time_get();
+
+  /**
+   * Prints every loaded path with its size and load time, and the totals against the budget.
+   */
+  void stats_print();
+
+ private:
+  struct entry {
+    std::string name;
+    std::vector<float> bytes;  // the whole file, path_read()
+    path_view view;
+    std::uint32_t load_time = 0;  // us
+  };
+  pros::Mutex mutex;
+  std::unordered_map<path_id, std::shared_ptr<entry>> paths;  // shared with motions following them
+  std::string pending;
+  std::string selected;                // from directory_set()
+  std::uint32_t requests = 0;          // load() calls, so the task sees ones made while it reads
+  std::uint32_t selections = 0;        // directory_set() changes, older reads are dropped
+  std::size_t budget = 4 * 1024 * 1024;
+  std::size_t footprint = 0;
+  std::atomic<std::uint32_t> load_time{0};  // ms
+  std::atomic<bool> busy{false};
+  pros::Task* task = nullptr;
+  void task_fn();
+  void directory_read(const std::string& directory, std::uint32_t selection);
+};
+
+/**
+ * Path files for the auton selector's page, see trajectories_select().
+ */
+extern trajectory_library trajectories;
+
+/**
+ * Points trajectories at /paths/auton_<page> for the auton selector's current page.  Cheap when
+ * the page hasn't changed.
+ */
+void trajectories_select();
+}  // namespace robot
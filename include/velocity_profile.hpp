@@ -0,0 +1,114 @@
+/*
+This Source Code Form is subject to the terms of the Mozilla Public
+License, v. 2.0. If a copy of the MPL was not distributed with this
+file, You can obtain one at http://mozilla.org/MPL/2.0/.
+*/
+
+#pragma once
+
+#include <algorithm>
+#include <cstddef>
+
+// Per point speed limits for pure pursuit paths.  constexpr so compile time routes get their
+// profile from the compiler, and no PROS dependencies so host tools can use it too.
+
+namespace robot {
+/**
+ * Limits the profile respects.  Distances are inches, times are seconds.
+ */
+struct profile_settings {
+  double top_speed = 51.0;       // in/s at speed 127, 300 rpm on 3.25 in wheels
+  double lateral_accel = 120.0;  // in/s^2 the robot can turn with before it slides wide
+  double accel = 100.0;          // in/s^2 speeding up, 0 skips the forward pass
+  double decel = 100.0;          // in/s^2 slowing down, 0 skips the backward pass
+  int min_speed = 30;            // never asks for less than this, so a tight corner can't stall
+};
+
+namespace profile_detail {
+constexpr double abs(double v) { return v < 0.0 ? -v : v; }
+
+constexpr double sqrt(double v) {
+  if (v <= 0.0) return 0.0;
+  double guess = v < 1.0 ? 1.0 : v;
+  for (int i = 0; i < 64; i++) {
+    double next = 0.5 * (guess + v / guess);
+    if (next == guess) break;
+    guess = next;
+  }
+  return guess;
+}
+
+constexpr double distance(double x1, double y1, double x2, double y2) { return sqrt((x2 - x1) * (x2 - x1) + (y2 - y1) * (y2 - y1)); }
+}  // namespace profile_detail
+
+/**
+ * Sets curvature and speed on every point of a path.
+ *
+ * Each point's speed starts as the most it's allowed (the speed it was given), is capped so the
+ * turn at that point stays under lateral_accel, then a backward pass slows the robot into
+ * corners early enough to make them at decel, and a forward pass keeps it from asking for more
+ * than accel can reach.  The last point keeps its speed, the PID settles the end of the motion.
+ *
+ * \param points
+ *        first point, anything with x, y, curvature and speed (0 to 127) members
+ * \param count
+ *        number of points
+ * \param settings
+ *        limits to respect
+ */
+template <typename T>
+constexpr void velocity_profile(T* points, std::size_t count, const profile_settings& settings) {
+  if (count < 2) return;
+
+  // Curvature of the circle through each point and its neighbours
+  points[0].curvature = 0.0;
+  points[count - 1].curvature = 0.0;
+  for (std::size_t i = 1; i + 1 < count; i++) {
+    const T& p = points[i - 1];
+    const T& c = points[i];
+    const T& n = points[i + 1];
+    double a = profile_detail::distance(p.x, p.y, c.x, c.y);
+    double b = profile_detail::distance(c.x, c.y, n.x, n.y);
+    double d = profile_detail::distance(p.x, p.y, n.x, n.y);
+    double cross = (c.x - p.x) * (n.y - p.y) - (c.y - p.y) * (n.x - p.x);
+    points[i].curvature = a * b * d == 0.0 ? 0.0 : 2.0 * profile_detail::abs(cross) / (a * b * d);
+  }
+
+  // Speeds in in/s from here on, converted back to 0 to 127 at the end
+  double scale = settings.top_speed / 127.0;
+  double floor = settings.min_speed * scale;
+
+  // The floor never raises a point above the speed it was given
+  for (std::size_t i = 0; i < count; i++) {
+    double commanded = points[i].speed * scale;
+    double speed = commanded;
+    if (points[i].curvature > 0.0 && settings.lateral_accel > 0.0) {
+      double corner = profile_detail::sqrt(settings.lateral_accel / points[i].curvature);
+      if (corner < speed) speed = corner;
+    }
+    speed = std::max(speed, std::min(floor, commanded));
+    points[i].speed = (int)(speed / scale);
+  }
+
+  // Backward, v^2 = v_next^2 + 2 a d
+  if (settings.decel > 0.0) {
+    for (std::size_t i = count - 1; i-- > 0;) {
+      double d = profile_detail::distance(points[i].x, points[i].y, points[i + 1].x, points[i + 1].y);
+      double next = points[i + 1].speed * scale;
+      double reachable = profile_detail::sqrt(next * next + 2.0 * settings.decel * d);
+      if (reachable < points[i].speed * scale) points[i].speed = reachable < floor ? std::min(settings.min_speed, points[i].speed) : (int)(reachable / scale);
+    }
+  }
+
+  // Forward, starting from min_speed
+  if (settings.accel > 0.0) {
+    double previous = floor;
+    for (std::size_t i = 0; i < count; i++) {
+      double d = i == 0 ? 0.0 : profile_detail::distance(points[i - 1].x, points[i - 1].y, points[i].x, points[i].y);
+      double reachable = profile_detail::sqrt(previous * previous + 2.0 * settings.accel * d);
+      if (reachable < points[i].speed * scale) points[i].speed = reachable < floor ? std::min(settings.min_speed, points[i].speed) : (int)(reachable / scale);
+      previous = points[i].speed * scale;
+    }
+  }
+}
+}  // namespace robot
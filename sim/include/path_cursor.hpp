@@ -0,0 +1,170 @@
+/*
+This Source Code Form is subject to the terms of the Mozilla Public
+License, v. 2.0. If a copy of the MPL was not distributed with this
+file, You can obtain one at http://mozilla.org/MPL/2.0/.
+*/
+
+#pragma once
+
+#include <algorithm>
+#include <array>
+#include <cmath>
+#include <cstddef>
+#include <vector>
+
+// Lookahead search for pure pursuit that costs the same every tick however long the path is.
+// Host side only: the robot follows pure pursuit paths with EZ-Template's pp_task, which ships
+// prebuilt, so nothing on the brain can use this.  lookahead_bench measures it against a full
+// search and profile_bench follows its paths with it.
+
+namespace robot {
+struct cursor_point {
+  double x = 0.0;
+  double y = 0.0;
+};
+
+/**
+ * Tracks where the robot is along a path and finds the lookahead point from there.
+ *
+ * A full search checks every segment for the closest one each tick.  The cursor only moves
+ * forward, resumes from the segment it found last tick, and looks at most WINDOW segments ahead,
+ * so a tick is O(1).  The lookahead point is found by cumulative arc length instead of a circle
+ * intersection, so it only ever walks forward too.
+ */
+class path_cursor {
+ public:
+  /**
+   * Segments past the current one checked for the closest point each tick.  At 10 ms ticks and
+   * 0.5 in spacing this covers 800 in/s, far more than the robot can move.
+   */
+  static constexpr std::size_t WINDOW = 16;
+
+  /**
+   * Starts following a new path.  Arc lengths are computed here, once.
+   *
+   * \param points
+   *        first point, anything with x and y in inches
+   * \param count
+   *        number of points
+   */
+  template <typename T>
+  void reset(const T* points, std::size_t count) {
+    path.resize(count);
+    arc.resize(count);
+    double total = 0.0;
+    for (std::size_t i = 0; i < count; i++) {
+      path[i] = {points[i].x, points[i].y};
+      if (i != 0) total += std::hypot(path[i].x - path[i - 1].x, path[i].y - path[i - 1].y);
+      arc[i] = total;
+    }
+    segment = 0;
+    ahead = 0;
+    travelled = 0.0;
+  }
+
+  /**
+   * Starts following a new path, see reset(const T*, std::size_t).
+   *
+   * \param points
+   *        points, anything with x and y in inches
+   */
+  template <typename T, std::size_t N>
+  void reset(const std::array<T, N>& points) {
+    reset(points.data(), N);
+  }
+
+  /**
+   * Moves the cursor to the robot and returns the lookahead point.
+   *
+   * \param x
+   *        robot x in inches
+   * \param y
+   *        robot y in inches
+   * \param lookahead
+   *        distance along the path ahead of the robot, in inches
+   */
+  cursor_point update(double x, double y, double lookahead) {
+    if (path.size() < 2) return path.empty() ? cursor_point{x, y} : path[0];
+
+    // Closest point on the next few segments, never behind the last one found
+    std::size_t last = std::min(segment + WINDOW, path.size() - 2);
+    double best = -1.0;
+    for (std::size_t i = segment; i <= last; i++) {
+      double t = 0.0;
+      double d = distance_to_segment(i, x, y, t);
+      if (best < 0.0 || d < best) {
+        best = d;
+        segment = i;
+        travelled = arc[i] + t * (arc[i + 1] - arc[i]);
+      }
+    }
+
+    // Lookahead by arc length, walking on from where last tick's lookahead point was
+    double s = travelled + lookahead;
+    if (s >= arc.back()) return path.back();
+    ahead = std::max(ahead, segment);
+    while (ahead + 2 < path.size() && arc[ahead + 1] < s) ahead++;
+    return interpolate(ahead, s);
+  }
+
+  /**
+   * Returns the point a distance along the path.  Only walks forward from the cursor.
+   *
+   * \param s
+   *        inches along the path from its start
+   */
+  cursor_point point_at(double s) const {
+    if (path.empty()) return {};
+    if (s >= arc.back()) return path.back();
+    std::size_t i = segment;
+    while (i + 2 < path.size() && arc[i + 1] < s) i++;
+    return interpolate(i, s);
+  }
+
+  /**
+   * Returns the segment the robot is on, segment i runs from point i to point i + 1.
+   */
+  std::size_t index() const { return segment; }
+
+  /**
+   * Returns inches along the path to the robot.
+   */
+  double progress() const { return travelled; }
+
+  /**
+   * Returns the length of the path in inches.
+   */
+  double length() const { return arc.empty() ? 0.0 : arc.back(); }
+
+  /**
+   * Returns inches left to the end of the path.
+   */
+  double remaining() const { return length() - travelled; }
+
+ private:
+  std::vector<cursor_point> path;
+  std::vector<double> arc;  // inches from the start to each point
+  std::size_t segment = 0;  // segment the robot is on
+  std::size_t ahead = 0;    // segment the lookahead point was on
+  double travelled = 0.0;
+
+  cursor_point interpolate(std::size_t i, double s) const {
+    double length = arc[i + 1] - arc[i];
+    double t = length > 0.0 ? (s - arc[i]) / length : 0.0;
+    t = t < 0.0 ? 0.0 : t > 1.0 ? 1.0
+                                : t;
+    return {path[i].x + (path[i + 1].x - path[i].x) * t, path[i].y + (path[i + 1].y - path[i].y) * t};
+  }
+
+  double distance_to_segment(std::size_t i, double x, double y, double& t) const {
+    const cursor_point& a = path[i];
+    const cursor_point& b = path[i + 1];
+    double dx = b.x - a.x, dy = b.y - a.y;
+    double length2 = dx * dx + dy * dy;
+    t = length2 > 0.0 ? ((x - a.x) * dx + (y - a.y) * dy) / length2 : 0.0;
+    t = t < 0.0 ? 0.0 : t > 1.0 ? 1.0
+                                : t;
+    return std::hypot(x - (a.x + dx * t), y - (a.y + dy * t));
+  }
+};
+}  // namespace robot
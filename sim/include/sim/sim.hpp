@@ -0,0 +1,164 @@
+/*
+This Source Code Form is subject to the terms of the Mozilla Public
+License, v. 2.0. If a copy of the MPL was not distributed with this
+file, You can obtain one at http://mozilla.org/MPL/2.0/.
+*/
+
+#pragma once
+
+#include <cstdint>
+#include <functional>
+#include <string>
+#include <vector>
+
+/**
+ * Host simulation backend for the PROS device API.
+ *
+ * Everything in here only exists in the host build (make sim).  The robot code
+ * links against these instead of libpros, so pros::delay() advances a virtual
+ * clock and the chassis motors drive a differential-drive plant.
+ */
+namespace sim {
+
+/////
+//
+// Virtual clock
+//
+/////
+
+/**
+ * Thrown into the harness task when a run goes past its time limit.
+ */
+struct time_limit_reached {
+  std::uint32_t time;
+};
+
+/**
+ * Returns the virtual time in ms.
+ */
+std::uint32_t now();
+
+/**
+ * Sets the virtual time the current run is allowed to reach, 0 disables this.
+ *
+ * When this time is reached, the task that set the deadline gets time_limit_reached
+ * thrown out of its next pros::delay().
+ *
+ * \param time
+ *        absolute virtual time in ms
+ */
+void deadline_set(std::uint32_t time);
+
+/**
+ * Returns how many context switches the virtual scheduler has done.
+ */
+std::uint64_t context_switches();
+
+/**
+ * Returns how many times operator new has been called.
+ */
+std::uint64_t allocations();
+
+/////
+//
+// Plant
+//
+/////
+
+/**
+ * Physical description of the drivetrain being simulated.
+ */
+struct drive_config {
+  std::vector<int> left_ports;
+  std::vector<int> right_ports;
+  int imu_port = 0;
+  double wheel_diameter = 3.25;  // inches
+  double cartridge_rpm = 600.0;
+  double ratio = 1.0;         // wheel gear / motor gear, same as ez::Drive
+  double track_width = 11.0;  // inches
+  double robot_size = 15.0;   // inches, keeps the robot inside the perimeter
+  double time_constant = 0.12;        // s, motor + robot inertia under power
+  double coast_time_constant = 0.45;  // s, robot rolling to a stop on coast
+  double brake_time_constant = 0.06;  // s, robot stopping on brake/hold
+  double stall_current = 2500.0;      // mA per motor
+  double battery_voltage = 12600.0;   // mV
+};
+
+/**
+ * A distance sensor mounted on the robot, looking at the field perimeter.
+ */
+struct distance_config {
+  int port = 0;
+  double x_offset = 0.0;  // inches, right of the tracking center
+  double y_offset = 0.0;  // inches, in front of the tracking center
+  double facing = 0.0;    // degrees, clockwise from the front of the robot
+};
+
+/**
+ * Field the robot is placed on.  Coordinates are inches from the bottom left corner.
+ */
+struct field_config {
+  double width = 144.0;
+  double height = 144.0;
+  double start_x = 72.0;
+  double start_y = 72.0;
+  double start_theta = 0.0;  // degrees, clockwise, 0 faces +y
+};
+
+/**
+ * Sets up the plant.  Call this before the robot code starts.
+ *
+ * \param drive
+ *        physical drivetrain
+ * \param field
+ *        field size and starting pose
+ * \param sensors
+ *        distance sensors on the robot
+ */
+void configure(drive_config drive, field_config field, std::vector<distance_config> sensors = {});
+
+/**
+ * Puts the robot back at the starting pose with every encoder, the imu and the pistons zeroed.
+ * Only the plant: the robot code's own state, EZ's PIDs, odometry and the robot:: modules, carries
+ * over into the next run.
+ */
+void reset();
+
+/**
+ * Ground truth for the simulated robot.
+ */
+struct robot_state {
+  double x;
+  double y;
+  double theta;           // degrees, clockwise
+  double left_velocity;   // in/s
+  double right_velocity;  // in/s
+};
+
+/**
+ * Returns the true pose of the robot on the field.
+ */
+robot_state robot_get();
+
+/**
+ * Sets the battery voltage the plant runs at.
+ *
+ * \param mV
+ *        battery voltage in millivolts
+ */
+void battery_set(double mV);
+
+/**
+ * Called every time a 3 wire output changes.
+ *
+ * \param callback
+ *        function taking the virtual time, the port ('A' - 'H') and the new value
+ */
+void adi_listener_set(std::function<void(std::uint32_t, char, bool)> callback);
+
+/**
+ * Advances the plant by one virtual millisecond.  Only the scheduler calls this.
+ */
+void plant_step();
+
+}  // namespace sim
@@ -0,0 +1,636 @@
+/*
+This Source Code Form is subject to the terms of the Mozilla Public
+License, v. 2.0. If a copy of the MPL was not distributed with this
+file, You can obtain one at http://mozilla.org/MPL/2.0/.
+*/
+
+// pros device classes backed by the plant.  Only the behavior the robot code can observe
+// is modeled, everything else returns the same values an idle, healthy device would.
+
+#include <algorithm>
+#include <array>
+#include <cerrno>
+#include <cmath>
+#include <cstdarg>
+#include <cstdio>
+
+#include "api.h"
+#include "plant.hpp"
+
+namespace sim {
+namespace {
+std::array<std::array<bool, 8>, 23> adi_values{};
+std::function<void(std::uint32_t, char, bool)> adi_listener;
+
+struct imu_offsets {
+  double rotation = 0.0;
+  double heading = 0.0;
+  double yaw = 0.0;
+  std::uint32_t calibrating_until = 0;
+};
+std::array<imu_offsets, 22> imus;
+
+int adi_index(std::uint8_t adi_port) {
+  if (adi_port >= 'a' && adi_port <= 'h') return adi_port - 'a';
+  if (adi_port >= 'A' && adi_port <= 'H') return adi_port - 'A';
+  return std::clamp<int>(adi_port, 1, 8) - 1;
+}
+
+void adi_write(std::uint8_t smart_port, std::uint8_t adi_port, bool value) {
+  int i = adi_index(adi_port);
+  bool& slot = adi_values[std::min<int>(smart_port, 22)][i];
+  if (slot == value) return;
+  slot = value;
+  if (adi_listener) adi_listener(now(), static_cast<char>('A' + i), value);
+}
+}  // namespace
+
+void adi_reset() {
+  for (auto& expander : adi_values) expander.fill(false);
+}
+
+void adi_listener_set(std::function<void(std::uint32_t, char, bool)> callback) { adi_listener = callback; }
+
+}  // namespace sim
+
+namespace {
+// Conversions between the physical shaft and what a pros::Motor reports
+double direction(std::int8_t port) { return port < 0 ? -1.0 : 1.0; }
+
+double units_per_degree(const sim::motor_port& m) {
+  switch (m.units) {
+    case 1:
+      return 1.0 / 360.0;
+    case 2:
+      return sim::gearset_ticks(m.gearset) / 360.0;
+    default:
+      return 1.0;
+  }
+}
+
+template <typename T>
+std::int32_t index_check(const std::vector<T>& ports, std::uint8_t index) {
+  if (index < ports.size()) return 1;
+  errno = EOVERFLOW;
+  return 0;
+}
+}  // namespace
+
+namespace pros {
+inline namespace v5 {
+/////
+//
+// Device
+//
+/////
+
+Device::Device(const std::uint8_t port) : _port(port) {}
+std::uint8_t Device::get_port(void) const { return _port; }
+bool Device::is_installed() { return true; }
+pros::DeviceType Device::get_plugged_type() const { return _deviceType; }
+pros::DeviceType Device::get_plugged_type(std::uint8_t port) {
+  return sim::motor_port_get(port).drive ? DeviceType::motor : DeviceType::none;
+}
+std::vector<Device> Device::get_all_devices(pros::DeviceType) { return {}; }
+
+/////
+//
+// Motor
+//
+/////
+
+Motor::Motor(const std::int8_t port, const pros::v5::MotorGears gearset, const pros::v5::MotorUnits encoder_units)
+    : Device(std::abs(port), DeviceType::motor), _port(port) {
+  if (gearset != MotorGears::invalid) set_gearing(gearset);
+  if (encoder_units != MotorUnits::invalid) set_encoder_units(encoder_units);
+}
+
+std::int32_t Motor::move(std::int32_t voltage) const {
+  return move_voltage(std::clamp(voltage, -127, 127) * 12000 / 127);
+}
+
+std::int32_t Motor::move_absolute(const double position, const std::int32_t velocity) const {
+  auto& m = sim::motor_port_get(_port);
+  double target = direction(_port) * position / units_per_degree(m) + m.zero;
+  m.velocity_mode = true;
+  m.position_mode = true;
+  m.target_position = target;
+  m.target_velocity = (target >= m.position ? 1.0 : -1.0) * std::abs(velocity);
+  return 1;
+}
+
+std::int32_t Motor::move_relative(const double position, const std::int32_t velocity) const {
+  return move_absolute(get_position() + position, velocity);
+}
+
+std::int32_t Motor::move_velocity(const std::int32_t velocity) const {
+  auto& m = sim::motor_port_get(_port);
+  m.velocity_mode = true;
+  m.position_mode = false;
+  m.target_velocity = direction(_port) * velocity;
+  return 1;
+}
+
+std::int32_t Motor::move_voltage(const std::int32_t voltage) const {
+  auto& m = sim::motor_port_get(_port);
+  m.velocity_mode = false;
+  m.position_mode = false;
+  m.command = direction(_port) * std::clamp(voltage, -12000, 12000);
+  return 1;
+}
+
+std::int32_t Motor::brake(void) const { return move_velocity(0); }
+
+std::int32_t Motor::modify_profiled_velocity(const std::int32_t velocity) const {
+  auto& m = sim::motor_port_get(_port);
+  if (m.velocity_mode) m.target_velocity = direction(_port) * velocity;
+  return 1;
+}
+
+double Motor::get_target_position(const std::uint8_t) const {
+  auto& m = sim::motor_port_get(_port);
+  return m.position_mode ? direction(_port) * (m.target_position - m.zero) * units_per_degree(m) : get_position();
+}
+std::int32_t Motor::get_target_velocity(const std::uint8_t) const {
+  return direction(_port) * sim::motor_port_get(_port).target_velocity;
+}
+double Motor::get_actual_velocity(const std::uint8_t) const {
+  return direction(_port) * sim::motor_port_get(_port).velocity;
+}
+std::int32_t Motor::get_current_draw(const std::uint8_t) const { return sim::motor_port_get(_port).current; }
+std::int32_t Motor::get_direction(const std::uint8_t) const { return get_actual_velocity() < 0 ? -1 : 1; }
+double Motor::get_efficiency(const std::uint8_t) const {
+  auto& m = sim::motor_port_get(_port);
+  return std::clamp(100.0 - 100.0 * m.current / std::max(m.current_limit, 1), 0.0, 100.0);
+}
+std::uint32_t Motor::get_faults(const std::uint8_t) const { return 0; }
+std::uint32_t Motor::get_flags(const std::uint8_t) const {
+  return sim::motor_port_get(_port).velocity == 0.0 ? E_MOTOR_FLAGS_ZERO_VELOCITY : E_MOTOR_FLAGS_NONE;
+}
+double Motor::get_position(const std::uint8_t) const {
+  auto& m = sim::motor_port_get(_port);
+  return direction(_port) * (m.position - m.zero) * units_per_degree(m);
+}
+double Motor::get_power(const std::uint8_t) const {
+  auto& m = sim::motor_port_get(_port);
+  return std::fabs(m.command) / 1000.0 * m.current / 1000.0;
+}
+std::int32_t Motor::get_raw_position(std::uint32_t* const timestamp, const std::uint8_t) const {
+  auto& m = sim::motor_port_get(_port);
+  if (timestamp) *timestamp = sim::now();
+  return std::lround(m.position * sim::gearset_ticks(m.gearset) / 360.0);
+}
+double Motor::get_temperature(const std::uint8_t) const { return sim::motor_port_get(_port).temperature; }
+double Motor::get_torque(const std::uint8_t) const { return sim::motor_port_get(_port).current / 2500.0 * 2.1; }
+std::int32_t Motor::get_voltage(const std::uint8_t) const {
+  return direction(_port) * sim::motor_port_get(_port).command;
+}
+std::int32_t Motor::is_over_current(const std::uint8_t) const {
+  auto& m = sim::motor_port_get(_port);
+  return m.current >= m.current_limit;
+}
+std::int32_t Motor::is_over_temp(const std::uint8_t) const { return 0; }
+MotorBrake Motor::get_brake_mode(const std::uint8_t) const {
+  return static_cast<MotorBrake>(sim::motor_port_get(_port).brake_mode);
+}
+std::int32_t Motor::get_current_limit(const std::uint8_t) const { return sim::motor_port_get(_port).current_limit; }
+MotorUnits Motor::get_encoder_units(const std::uint8_t) const {
+  return static_cast<MotorUnits>(sim::motor_port_get(_port).units);
+}
+MotorGears Motor::get_gearing(const std::uint8_t) const {
+  return static_cast<MotorGears>(sim::motor_port_get(_port).gearset);
+}
+std::int32_t Motor::get_voltage_limit(const std::uint8_t) const { return sim::motor_port_get(_port).voltage_limit; }
+std::int32_t Motor::is_reversed(const std::uint8_t) const { return _port < 0; }
+
+std::int32_t Motor::set_brake_mode(const MotorBrake mode, const std::uint8_t) const {
+  sim::motor_port_get(_port).brake_mode = static_cast<int>(mode);
+  return 1;
+}
+std::int32_t Motor::set_brake_mode(const pros::motor_brake_mode_e_t mode, const std::uint8_t) const {
+  return set_brake_mode(static_cast<MotorBrake>(mode));
+}
+std::int32_t Motor::set_current_limit(const std::int32_t limit, const std::uint8_t) const {
+  sim::motor_port_get(_port).current_limit = std::clamp(limit, 0, 2500);
+  return 1;
+}
+std::int32_t Motor::set_encoder_units(const MotorUnits units, const std::uint8_t) const {
+  sim::motor_port_get(_port).units = static_cast<int>(units);
+  return 1;
+}
+std::int32_t Motor::set_encoder_units(const pros::motor_encoder_units_e_t units, const std::uint8_t) const {
+  return set_encoder_units(static_cast<MotorUnits>(units));
+}
+std::int32_t Motor::set_gearing(const MotorGears gearset, const std::uint8_t) const {
+  sim::motor_port_get(_port).gearset = static_cast<int>(gearset);
+  return 1;
+}
+std::int32_t Motor::set_gearing(const pros::motor_gearset_e_t gearset, const std::uint8_t) const {
+  return set_gearing(static_cast<MotorGears>(gearset));
+}
+std::int32_t Motor::set_reversed(const bool reverse, const std::uint8_t) {
+  _port = reverse ? -std::abs(_port) : std::abs(_port);
+  return 1;
+}
+std::int32_t Motor::set_voltage_limit(const std::int32_t limit, const std::uint8_t) const {
+  sim::motor_port_get(_port).voltage_limit = limit;
+  return 1;
+}
+std::int32_t Motor::set_zero_position(const double position, const std::uint8_t) const {
+  auto& m = sim::motor_port_get(_port);
+  m.zero = direction(_port) * position / units_per_degree(m);
+  return 1;
+}
+std::int32_t Motor::tare_position(const std::uint8_t) const {
+  auto& m = sim::motor_port_get(_port);
+  m.zero = m.position;
+  return 1;
+}
+std::int8_t Motor::get_port(const std::uint8_t) const { return _port; }
+std::int8_t Motor::size(void) const { return 1; }
+std::vector<Motor> Motor::get_all_devices() { return {}; }
+
+std::vector<double> Motor::get_target_position_all(void) const { return {get_target_position()}; }
+std::vector<std::int32_t> Motor::get_target_velocity_all(void) const { return {get_target_velocity()}; }
+std::vector<double> Motor::get_actual_velocity_all(void) const { return {get_actual_velocity()}; }
+std::vector<std::int32_t> Motor::get_current_draw_all(void) const { return {get_current_draw()}; }
+std::vector<std::int32_t> Motor::get_direction_all(void) const { return {get_direction()}; }
+std::vector<double> Motor::get_efficiency_all(void) const { return {get_efficiency()}; }
+std::vector<std::uint32_t> Motor::get_faults_all(void) const { return {get_faults()}; }
+std::vector<std::uint32_t> Motor::get_flags_all(void) const { return {get_flags()}; }
+std::vector<double> Motor::get_position_all(void) const { return {get_position()}; }
+std::vector<double> Motor::get_power_all(void) const { return {get_power()}; }
+std::vector<std::int32_t> Motor::get_raw_position_all(std::uint32_t* const timestamp) const { return {get_raw_position(timestamp)}; }
+std::vector<double> Motor::get_temperature_all(void) const { return {get_temperature()}; }
+std::vector<double> Motor::get_torque_all(void) const { return {get_torque()}; }
+std::vector<std::int32_t> Motor::get_voltage_all(void) const { return {get_voltage()}; }
+std::vector<std::int32_t> Motor::is_over_current_all(void) const { return {is_over_current()}; }
+std::vector<std::int32_t> Motor::is_over_temp_all(void) const { return {is_over_temp()}; }
+std::vector<MotorBrake> Motor::get_brake_mode_all(void) const { return {get_brake_mode()}; }
+std::vector<std::int32_t> Motor::get_current_limit_all(void) const { return {get_current_limit()}; }
+std::vector<MotorUnits> Motor::get_encoder_units_all(void) const { return {get_encoder_units()}; }
+std::vector<MotorGears> Motor::get_gearing_all(void) const { return {get_gearing()}; }
+std::vector<std::int8_t> Motor::get_port_all(void) const { return {_port}; }
+std::vector<std::int32_t> Motor::get_voltage_limit_all(void) const { return {get_voltage_limit()}; }
+std::vector<std::int32_t> Motor::is_reversed_all(void) const { return {is_reversed()}; }
+std::int32_t Motor::set_brake_mode_all(const MotorBrake mode) const { return set_brake_mode(mode); }
+std::int32_t Motor::set_brake_mode_all(const pros::motor_brake_mode_e_t mode) const { return set_brake_mode(mode); }
+std::int32_t Motor::set_current_limit_all(const std::int32_t limit) const { return set_current_limit(limit); }
+std::int32_t Motor::set_encoder_units_all(const MotorUnits units) const { return set_encoder_units(units); }
+std::int32_t Motor::set_encoder_units_all(const pros::motor_encoder_units_e_t units) const { return set_encoder_units(units); }
+std::int32_t Motor::set_gearing_all(const MotorGears gearset) const { return set_gearing(gearset); }
+std::int32_t Motor::set_gearing_all(const pros::motor_gearset_e_t gearset) const { return set_gearing(gearset); }
+std::int32_t Motor::set_reversed_all(const bool reverse) { return set_reversed(reverse); }
+std::int32_t Motor::set_voltage_limit_all(const std::int32_t limit) const { return set_voltage_limit(limit); }
+std::int32_t Motor::set_zero_position_all(const double position) const { return set_zero_position(position); }
+std::int32_t Motor::tare_position_all(void) const { return tare_position(); }
+
+/////
+//
+// MotorGroup
+//
+/////
+
+MotorGroup::MotorGroup(const std::initializer_list<std::int8_t> ports, const pros::v5::MotorGears gearset, const pros::v5::MotorUnits encoder_units)
+    : MotorGroup(std::vector<std::int8_t>(ports), gearset, encoder_units) {}
+
+MotorGroup::MotorGroup(const std::vector<std::int8_t>& ports, const pros::v5::MotorGears gearset, const pros::v5::MotorUnits encoder_units)
+    : _ports(ports) {
+  if (gearset != MotorGears::invalid) set_gearing_all(gearset);
+  if (encoder_units != MotorUnits::invalid) set_encoder_units_all(encoder_units);
+}
+
+MotorGroup::MotorGroup(AbstractMotor& motor_group) : _ports(motor_group.get_port_all()) {}
+
+// Runs a setter on every motor and reports failure if any of them failed
+#define EACH_MOTOR(call)                     \
+  std::int32_t out = 1;                      \
+  for (auto port : _ports) {                 \
+    Motor m(port);                           \
+    if (m.call != 1) out = PROS_ERR;         \
+  }                                          \
+  return out
+
+// Reads one motor from the group by index
+#define ONE_MOTOR(call, error)                        \
+  if (!index_check(_ports, index)) return error;      \
+  return Motor(_ports[index]).call
+
+// Reads every motor in the group
+#define ALL_MOTORS(type, call)                  \
+  std::vector<type> out;                        \
+  for (auto port : _ports) out.push_back(Motor(port).call); \
+  return out
+
+std::int32_t MotorGroup::move(std::int32_t voltage) const { EACH_MOTOR(move(voltage)); }
+std::int32_t MotorGroup::move_absolute(const double position, const std::int32_t velocity) const { EACH_MOTOR(move_absolute(position, velocity)); }
+std::int32_t MotorGroup::move_relative(const double position, const std::int32_t velocity) const { EACH_MOTOR(move_relative(position, velocity)); }
+std::int32_t MotorGroup::move_velocity(const std::int32_t velocity) const { EACH_MOTOR(move_velocity(velocity)); }
+std::int32_t MotorGroup::move_voltage(const std::int32_t voltage) const { EACH_MOTOR(move_voltage(voltage)); }
+std::int32_t MotorGroup::brake(void) const { EACH_MOTOR(brake()); }
+std::int32_t MotorGroup::modify_profiled_velocity(const std::int32_t velocity) const { EACH_MOTOR(modify_profiled_velocity(velocity)); }
+
+double MotorGroup::get_target_position(const std::uint8_t index) const { ONE_MOTOR(get_target_position(), PROS_ERR_F); }
+std::int32_t MotorGroup::get_target_velocity(const std::uint8_t index) const { ONE_MOTOR(get_target_velocity(), PROS_ERR); }
+double MotorGroup::get_actual_velocity(const std::uint8_t index) const { ONE_MOTOR(get_actual_velocity(), PROS_ERR_F); }
+std::int32_t MotorGroup::get_current_draw(const std::uint8_t index) const { ONE_MOTOR(get_current_draw(), PROS_ERR); }
+std::int32_t MotorGroup::get_direction(const std::uint8_t index) const { ONE_MOTOR(get_direction(), PROS_ERR); }
+double MotorGroup::get_efficiency(const std::uint8_t index) const { ONE_MOTOR(get_efficiency(), PROS_ERR_F); }
+std::uint32_t MotorGroup::get_faults(const std::uint8_t index) const { ONE_MOTOR(get_faults(), PROS_ERR); }
+std::uint32_t MotorGroup::get_flags(const std::uint8_t index) const { ONE_MOTOR(get_flags(), PROS_ERR); }
+double MotorGroup::get_position(const std::uint8_t index) const { ONE_MOTOR(get_position(), PROS_ERR_F); }
+double MotorGroup::get_power(const std::uint8_t index) const { ONE_MOTOR(get_power(), PROS_ERR_F); }
+std::int32_t MotorGroup::get_raw_position(std::uint32_t* const timestamp, const std::uint8_t index) const { ONE_MOTOR(get_raw_position(timestamp), PROS_ERR); }
+double MotorGroup::get_temperature(const std::uint8_t index) const { ONE_MOTOR(get_temperature(), PROS_ERR_F); }
+double MotorGroup::get_torque(const std::uint8_t index) const { ONE_MOTOR(get_torque(), PROS_ERR_F); }
+std::int32_t MotorGroup::get_voltage(const std::uint8_t index) const { ONE_MOTOR(get_voltage(), PROS_ERR); }
+std::int32_t MotorGroup::is_over_current(const std::uint8_t index) const { ONE_MOTOR(is_over_current(), PROS_ERR); }
+std::int32_t MotorGroup::is_over_temp(const std::uint8_t index) const { ONE_MOTOR(is_over_temp(), PROS_ERR); }
+MotorBrake MotorGroup::get_brake_mode(const std::uint8_t index) const { ONE_MOTOR(get_brake_mode(), MotorBrake::invalid); }
+std::int32_t MotorGroup::get_current_limit(const std::uint8_t index) const { ONE_MOTOR(get_current_limit(), PROS_ERR); }
+MotorUnits MotorGroup::get_encoder_units(const std::uint8_t index) const { ONE_MOTOR(get_encoder_units(), MotorUnits::invalid); }
+MotorGears MotorGroup::get_gearing(const std::uint8_t index) const { ONE_MOTOR(get_gearing(), MotorGears::invalid); }
+std::int32_t MotorGroup::get_voltage_limit(const std::uint8_t index) const { ONE_MOTOR(get_voltage_limit(), PROS_ERR); }
+std::int32_t MotorGroup::is_reversed(const std::uint8_t index) const { ONE_MOTOR(is_reversed(), PROS_ERR); }
+std::int8_t MotorGroup::get_port(const std::uint8_t index) const { ONE_MOTOR(get_port(), PROS_ERR_BYTE); }
+
+std::vector<double> MotorGroup::get_target_position_all(void) const { ALL_MOTORS(double, get_target_position()); }
+std::vector<std::int32_t> MotorGroup::get_target_velocity_all(void) const { ALL_MOTORS(std::int32_t, get_target_velocity()); }
+std::vector<double> MotorGroup::get_actual_velocity_all(void) const { ALL_MOTORS(double, get_actual_velocity()); }
+std::vector<std::int32_t> MotorGroup::get_current_draw_all(void) const { ALL_MOTORS(std::int32_t, get_current_draw()); }
+std::vector<std::int32_t> MotorGroup::get_direction_all(void) const { ALL_MOTORS(std::int32_t, get_direction()); }
+std::vector<double> MotorGroup::get_efficiency_all(void) const { ALL_MOTORS(double, get_efficiency()); }
+std::vector<std::uint32_t> MotorGroup::get_faults_all(void) const { ALL_MOTORS(std::uint32_t, get_faults()); }
+std::vector<std::uint32_t> MotorGroup::get_flags_all(void) const { ALL_MOTORS(std::uint32_t, get_flags()); }
+std::vector<double> MotorGroup::get_position_all(void) const { ALL_MOTORS(double, get_position()); }
+std::vector<double> MotorGroup::get_power_all(void) const { ALL_MOTORS(double, get_power()); }
+std::vector<std::int32_t> MotorGroup::get_raw_position_all(std::uint32_t* const timestamp) const { ALL_MOTORS(std::int32_t, get_raw_position(timestamp)); }
+std::vector<double> MotorGroup::get_temperature_all(void) const { ALL_MOTORS(double, get_temperature()); }
+std::vector<double> MotorGroup::get_torque_all(void) const { ALL_MOTORS(double, get_torque()); }
+std::vector<std::int32_t> MotorGroup::get_voltage_all(void) const { ALL_MOTORS(std::int32_t, get_voltage()); }
+std::vector<std::int32_t> MotorGroup::is_over_current_all(void) const { ALL_MOTORS(std::int32_t, is_over_current()); }
+std::vector<std::int32_t> MotorGroup::is_over_temp_all(void) const { ALL_MOTORS(std::int32_t, is_over_temp()); }
+std::vector<MotorBrake> MotorGroup::get_brake_mode_all(void) const { ALL_MOTORS(MotorBrake, get_brake_mode()); }
+std::vector<std::int32_t> MotorGroup::get_current_limit_all(void) const { ALL_MOTORS(std::int32_t, get_current_limit()); }
+std::vector<MotorUnits> MotorGroup::get_encoder_units_all(void) const { ALL_MOTORS(MotorUnits, get_encoder_units()); }
+std::vector<MotorGears> MotorGroup::get_gearing_all(void) const { ALL_MOTORS(MotorGears, get_gearing()); }
+std::vector<std::int32_t> MotorGroup::get_voltage_limit_all(void) const { ALL_MOTORS(std::int32_t, get_voltage_limit()); }
+std::vector<std::int32_t> MotorGroup::is_reversed_all(void) const { ALL_MOTORS(std::int32_t, is_reversed()); }
+std::vector<std::int8_t> MotorGroup::get_port_all(void) const { return _ports; }
+
+std::int32_t MotorGroup::set_brake_mode(const MotorBrake mode, const std::uint8_t index) const { ONE_MOTOR(set_brake_mode(mode), PROS_ERR); }
+std::int32_t MotorGroup::set_brake_mode(const pros::motor_brake_mode_e_t mode, const std::uint8_t index) const { ONE_MOTOR(set_brake_mode(mode), PROS_ERR); }
+std::int32_t MotorGroup::set_current_limit(const std::int32_t limit, const std::uint8_t index) const { ONE_MOTOR(set_current_limit(limit), PROS_ERR); }
+std::int32_t MotorGroup::set_encoder_units(const MotorUnits units, const std::uint8_t index) const { ONE_MOTOR(set_encoder_units(units), PROS_ERR); }
+std::int32_t MotorGroup::set_encoder_units(const pros::motor_encoder_units_e_t units, const std::uint8_t index) const { ONE_MOTOR(set_encoder_units(units), PROS_ERR); }
+std::int32_t MotorGroup::set_gearing(const MotorGears gearset, const std::uint8_t index) const { ONE_MOTOR(set_gearing(gearset), PROS_ERR); }
+std::int32_t MotorGroup::set_gearing(const pros::motor_gearset_e_t gearset, const std::uint8_t index) const { ONE_MOTOR(set_gearing(gearset), PROS_ERR); }
+std::int32_t MotorGroup::set_voltage_limit(const std::int32_t limit, const std::uint8_t index) const { ONE_MOTOR(set_voltage_limit(limit), PROS_ERR); }
+std::int32_t MotorGroup::set_zero_position(const double position, const std::uint8_t index) const { ONE_MOTOR(set_zero_position(position), PROS_ERR); }
+std::int32_t MotorGroup::tare_position(const std::uint8_t index) const { ONE_MOTOR(tare_position(), PROS_ERR); }
+
+std::int32_t MotorGroup::set_gearing(std::vector<pros::motor_gearset_e_t> gearsets) const {
+  for (size_t i = 0; i < std::min(gearsets.size(), _ports.size()); i++) Motor(_ports[i]).set_gearing(gearsets[i]);
+  return 1;
+}
+std::int32_t MotorGroup::set_gearing(std::vector<MotorGears> gearsets) const {
+  for (size_t i = 0; i < std::min(gearsets.size(), _ports.size()); i++) Motor(_ports[i]).set_gearing(gearsets[i]);
+  return 1;
+}
+
+std::int32_t MotorGroup::set_reversed(const bool reverse, const std::uint8_t index) {
+  if (!index_check(_ports, index)) return PROS_ERR;
+  _ports[index] = reverse ? -std::abs(_ports[index]) : std::abs(_ports[index]);
+  return 1;
+}
+std::int32_t MotorGroup::set_reversed_all(const bool reverse) {
+  for (auto& port : _ports) port = reverse ? -std::abs(port) : std::abs(port);
+  return 1;
+}
+
+std::int32_t MotorGroup::set_brake_mode_all(const MotorBrake mode) const { EACH_MOTOR(set_brake_mode(mode)); }
+std::int32_t MotorGroup::set_brake_mode_all(const pros::motor_brake_mode_e_t mode) const { EACH_MOTOR(set_brake_mode(mode)); }
+std::int32_t MotorGroup::set_current_limit_all(const std::int32_t limit) const { EACH_MOTOR(set_current_limit(limit)); }
+std::int32_t MotorGroup::set_encoder_units_all(const MotorUnits units) const { EACH_MOTOR(set_encoder_units(units)); }
+std::int32_t MotorGroup::set_encoder_units_all(const pros::motor_encoder_units_e_t units) const { EACH_MOTOR(set_encoder_units(units)); }
+std::int32_t MotorGroup::set_gearing_all(const MotorGears gearset) const { EACH_MOTOR(set_gearing(gearset)); }
+std::int32_t MotorGroup::set_gearing_all(const pros::motor_gearset_e_t gearset) const { EACH_MOTOR(set_gearing(gearset)); }
+std::int32_t MotorGroup::set_voltage_limit_all(const std::int32_t limit) const { EACH_MOTOR(set_voltage_limit(limit)); }
+std::int32_t MotorGroup::set_zero_position_all(const double position) const { EACH_MOTOR(set_zero_position(position)); }
+std::int32_t MotorGroup::tare_position_all(void) const { EACH_MOTOR(tare_position()); }
+
+std::int8_t MotorGroup::size(void) const { return _ports.size(); }
+void MotorGroup::operator+=(AbstractMotor& other) { append(other); }
+void MotorGroup::append(AbstractMotor& other) {
+  for (auto port : other.get_port_all()) _ports.push_back(port);
+}
+void MotorGroup::erase_port(std::int8_t port) {
+  _ports.erase(std::remove_if(_ports.begin(), _ports.end(), [&](std::int8_t p) { return std::abs(p) == std::abs(port); }), _ports.end());
+}
+
+#undef EACH_MOTOR
+#undef ONE_MOTOR
+#undef ALL_MOTORS
+
+/////
+//
+// Imu
+//
+/////
+
+namespace {
+double wrap_180(double angle) {
+  angle = std::fmod(angle + 180.0, 360.0);
+  return (angle < 0 ? angle + 360.0 : angle) - 180.0;
+}
+}  // namespace
+
+std::int32_t Imu::reset(bool blocking) const {
+  sim::imus[_port].calibrating_until = sim::now() + 2000;
+  if (blocking) pros::c::delay(2000);
+  return 1;
+}
+std::int32_t Imu::set_data_rate(std::uint32_t) const { return 1; }
+Imu Imu::get_imu() { return Imu(0); }
+std::vector<Imu> Imu::get_all_devices() { return {}; }
+double Imu::get_rotation() const { return sim::imu_rotation_get() + sim::imus[_port].rotation; }
+double Imu::get_heading() const {
+  double heading = std::fmod(sim::imu_rotation_get() + sim::imus[_port].heading, 360.0);
+  return heading < 0 ? heading + 360.0 : heading;
+}
+pros::quaternion_s_t Imu::get_quaternion() const {
+  double half = -get_yaw() * M_PI / 360.0;
+  return {0.0, 0.0, std::sin(half), std::cos(half)};
+}
+pros::euler_s_t Imu::get_euler() const { return {get_pitch(), get_roll(), get_yaw()}; }
+double Imu::get_pitch() const { return 0.0; }
+double Imu::get_roll() const { return 0.0; }
+double Imu::get_yaw() const { return wrap_180(sim::imu_rotation_get() + sim::imus[_port].yaw); }
+pros::imu_gyro_s_t Imu::get_gyro_rate() const { return {0.0, 0.0, sim::imu_rate_get()}; }
+std::int32_t Imu::tare_rotation() const { return set_rotation(0.0); }
+std::int32_t Imu::tare_heading() const { return set_heading(0.0); }
+std::int32_t Imu::tare_pitch() const { return 1; }
+std::int32_t Imu::tare_yaw() const { return set_yaw(0.0); }
+std::int32_t Imu::tare_roll() const { return 1; }
+std::int32_t Imu::tare() const {
+  tare_rotation();
+  tare_heading();
+  return tare_yaw();
+}
+std::int32_t Imu::tare_euler() const { return tare_yaw(); }
+std::int32_t Imu::set_heading(const double target) const {
+  sim::imus[_port].heading = target - sim::imu_rotation_get();
+  return 1;
+}
+std::int32_t Imu::set_rotation(const double target) const {
+  sim::imus[_port].rotation = target - sim::imu_rotation_get();
+  return 1;
+}
+std::int32_t Imu::set_yaw(const double target) const {
+  sim::imus[_port].yaw = target - sim::imu_rotation_get();
+  return 1;
+}
+std::int32_t Imu::set_pitch(const double) const { return 1; }
+std::int32_t Imu::set_roll(const double) const { return 1; }
+std::int32_t Imu::set_euler(const pros::euler_s_t target) const { return set_yaw(target.yaw); }
+pros::imu_accel_s_t Imu::get_accel() const { return {0.0, sim::imu_accel_get(), 1.0}; }
+pros::ImuStatus Imu::get_status() const { return is_calibrating() ? ImuStatus::calibrating : ImuStatus::ready; }
+bool Imu::is_calibrating() const { return sim::now() < sim::imus[_port].calibrating_until; }
+imu_orientation_e_t Imu::get_physical_orientation() const { return E_IMU_Z_UP; }
+
+/////
+//
+// Distance and Rotation
+//
+/////
+
+Distance::Distance(const std::uint8_t port) : Device(port, DeviceType::distance) {}
+std::int32_t Distance::get() { return sim::distance_get(_port); }
+std::int32_t Distance::get_distance() { return get(); }
+std::vector<Distance> Distance::get_all_devices() { return {}; }
+std::int32_t Distance::get_confidence() { return get() == 9999 ? 0 : 63; }
+std::int32_t Distance::get_object_size() { return get() == 9999 ? -1 : 200; }
+double Distance::get_object_velocity() { return sim::distance_velocity_get(_port); }
+
+// There are no tracking wheels on the simulated robot
+Rotation::Rotation(const std::int8_t port) : Device(std::abs(port), DeviceType::rotation) {}
+std::int32_t Rotation::reset() { return 1; }
+std::int32_t Rotation::set_data_rate(std::uint32_t) const { return 1; }
+std::int32_t Rotation::set_position(std::uint32_t) const { return 1; }
+std::int32_t Rotation::reset_position(void) const { return 1; }
+std::vector<Rotation> Rotation::get_all_devices() { return {}; }
+std::int32_t Rotation::get_position() const { return 0; }
+std::int32_t Rotation::get_velocity() const { return 0; }
+std::int32_t Rotation::get_angle() const { return 0; }
+std::int32_t Rotation::set_reversed(bool) const { return 1; }
+std::int32_t Rotation::reverse() const { return 1; }
+std::int32_t Rotation::get_reversed() const { return 0; }
+
+/////
+//
+// Controller
+//
+/////
+
+// Nobody is holding the controller in the simulator
+Controller::Controller(controller_id_e_t id) : _id(id) {}
+std::int32_t Controller::is_connected(void) { return 1; }
+std::int32_t Controller::get_analog(controller_analog_e_t) { return 0; }
+std::int32_t Controller::get_battery_capacity(void) { return 100; }
+std::int32_t Controller::get_battery_level(void) { return 100; }
+std::int32_t Controller::get_digital(controller_digital_e_t) { return 0; }
+std::int32_t Controller::get_digital_new_press(controller_digital_e_t) { return 0; }
+std::int32_t Controller::set_text(std::uint8_t, std::uint8_t, const char*) { return 1; }
+std::int32_t Controller::set_text(std::uint8_t, std::uint8_t, const std::string&) { return 1; }
+std::int32_t Controller::clear_line(std::uint8_t) { return 1; }
+std::int32_t Controller::rumble(const char*) { return 1; }
+std::int32_t Controller::clear(void) { return 1; }
+}  // namespace v5
+
+/////
+//
+// 3 wire ports
+//
+/////
+
+namespace adi {
+Port::Port(std::uint8_t adi_port, adi_port_config_e_t) : _smart_port(INTERNAL_ADI_PORT), _adi_port(adi_port) {}
+Port::Port(ext_adi_port_pair_t port_pair, adi_port_config_e_t) : _smart_port(port_pair.first), _adi_port(port_pair.second) {}
+std::int32_t Port::get_config() const { return E_ADI_DIGITAL_OUT; }
+std::int32_t Port::get_value() const { return sim::adi_values[std::min<int>(_smart_port, 22)][sim::adi_index(_adi_port)]; }
+std::int32_t Port::set_config(adi_port_config_e_t) const { return 1; }
+std::int32_t Port::set_value(std::int32_t value) const {
+  sim::adi_write(_smart_port, _adi_port, value != 0);
+  return 1;
+}
+ext_adi_port_tuple_t Port::get_port() const { return {_smart_port, _adi_port, 0}; }
+
+DigitalOut::DigitalOut(std::uint8_t adi_port, bool init_state) : Port(adi_port, E_ADI_DIGITAL_OUT) { set_value(init_state); }
+DigitalOut::DigitalOut(ext_adi_port_pair_t port_pair, bool init_state) : Port(port_pair, E_ADI_DIGITAL_OUT) { set_value(init_state); }
+
+DigitalIn::DigitalIn(std::uint8_t adi_port) : Port(adi_port, E_ADI_DIGITAL_IN) {}
+DigitalIn::DigitalIn(ext_adi_port_pair_t port_pair) : Port(port_pair, E_ADI_DIGITAL_IN) {}
+std::int32_t DigitalIn::get_new_press() const { return 0; }
+
+Encoder::Encoder(std::uint8_t adi_port_top, std::uint8_t adi_port_bottom, bool) : Port(adi_port_top, E_ADI_LEGACY_ENCODER), _port_pair(adi_port_top, adi_port_bottom) {}
+Encoder::Encoder(ext_adi_port_tuple_t port_tuple, bool)
+    : Port(ext_adi_port_pair_t(std::get<0>(port_tuple), std::get<1>(port_tuple)), E_ADI_LEGACY_ENCODER), _port_pair(std::get<1>(port_tuple), std::get<2>(port_tuple)) {}
+std::int32_t Encoder::reset() const { return 1; }
+std::int32_t Encoder::get_value() const { return 0; }
+ext_adi_port_tuple_t Encoder::get_port() const { return {_smart_port, _port_pair.first, _port_pair.second}; }
+}  // namespace adi
+
+/////
+//
+// Brain
+//
+/////
+
+namespace battery {
+double get_capacity(void) { return 100.0; }
+std::int32_t get_current(void) { return 0; }
+double get_temperature(void) { return 30.0; }
+std::int32_t get_voltage(void) { return sim::battery_get(); }
+}  // namespace battery
+
+namespace competition {
+std::uint8_t get_status(void) { return 0; }
+std::uint8_t is_autonomous(void) { return 1; }
+std::uint8_t is_connected(void) { return 0; }
+std::uint8_t is_disabled(void) { return 0; }
+std::uint8_t is_field_control(void) { return 0; }
+std::uint8_t is_competition_switch(void) { return 0; }
+}  // namespace competition
+
+// The host has no /usd, so the robot code sees an empty slot
+namespace usd {
+std::int32_t is_installed(void) { return 0; }
+std::int32_t list_files(const char*, char*, std::int32_t) {
+  errno = ENXIO;
+  return PROS_ERR;
+}
+}  // namespace usd
+
+namespace lcd {
+namespace {
+bool lcd_on = false;
+}
+bool is_initialized(void) { return lcd_on; }
+bool initialize(void) { return lcd_on = true; }
+bool shutdown(void) { return !(lcd_on = false); }
+bool set_text(std::int16_t, std::string) { return lcd_on; }
+bool clear(void) { return lcd_on; }
+bool clear_line(std::int16_t) { return lcd_on; }
+void register_btn0_cb(lcd_btn_cb_fn_t) {}
+void register_btn1_cb(lcd_btn_cb_fn_t) {}
+void register_btn2_cb(lcd_btn_cb_fn_t) {}
+void set_text_align(Text_Align) {}
+std::uint8_t read_buttons(void) { return 0; }
+}  // namespace lcd
+
+namespace c {
+std::int32_t battery_get_voltage(void) { return sim::battery_get(); }
+std::int32_t usd_is_installed(void) { return 0; }
+std::int32_t controller_print(controller_id_e_t, std::uint8_t, std::uint8_t, const char*, ...) { return 1; }
+}  // namespace c
+}  // namespace pros
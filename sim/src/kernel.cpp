@@ -0,0 +1,411 @@
+/*
+This Source Code Form is subject to the terms of the Mozilla Public
+License, v. 2.0. If a copy of the MPL was not distributed with this
+file, You can obtain one at http://mozilla.org/MPL/2.0/.
+*/
+
+// Virtual time RTOS.
+//
+// Every pros task gets a host thread, but only one of them is ever allowed to run, the
+// same as a single core brain.  A task gives up the core when it calls delay(), and the
+// core goes to whichever task wakes up first.  When nobody is ready to run yet, the clock
+// jumps straight to the next wake time and the plant is stepped along the way, so a
+// whole auton replays as fast as the host can context switch.
+
+#include <condition_variable>
+#include <cstdio>
+#include <cstring>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "api.h"
+#include "plant.hpp"
+
+namespace sim {
+namespace {
+struct task_record {
+  std::string name;
+  std::uint32_t priority = TASK_PRIORITY_DEFAULT;
+  std::uint32_t wake = 0;
+  std::uint32_t notify_value = 0;
+  bool done = false;
+  bool suspended = false;
+  std::condition_variable cv;
+};
+
+struct mutex_record {
+  task_record* owner = nullptr;
+};
+
+std::mutex kernel_mutex;
+std::vector<task_record*> tasks;  // creation order, finished tasks are skipped
+task_record* current = nullptr;
+std::uint32_t clock_ms = 0;
+std::uint32_t deadline = 0;
+task_record* deadline_owner = nullptr;
+bool deadline_hit = false;
+std::uint64_t switches = 0;
+thread_local task_record* self = nullptr;
+
+// The thread that runs main() becomes a task the first time it touches the kernel
+task_record* self_get(std::unique_lock<std::mutex>&) {
+  if (!self) {
+    self = new task_record;
+    self->name = "main";
+    tasks.push_back(self);
+    if (!current) current = self;
+  }
+  return self;
+}
+
+// Earliest wake time wins, ties go to the higher priority, then round robin starting after the
+// current task.  A task is never preempted, it runs until it delays or blocks
+task_record* next_task() {
+  size_t start = 0;
+  for (size_t i = 0; i < tasks.size(); i++)
+    if (tasks[i] == current) start = i + 1;
+
+  task_record* best = nullptr;
+  for (size_t k = 0; k < tasks.size(); k++) {
+    task_record* t = tasks[(start + k) % tasks.size()];
+    if (t->done || t->suspended) continue;
+    if (!best || t->wake < best->wake || (t->wake == best->wake && t->priority > best->priority)) best = t;
+  }
+  return best;
+}
+
+void advance_to(std::uint32_t time) {
+  while (clock_ms < time) {
+    clock_ms++;
+    plant_step();
+    if (deadline != 0 && clock_ms >= deadline && !deadline_hit) deadline_hit = true;
+  }
+}
+
+// Hands the core to the next task and, unless this task is finished, waits to get it back
+void switch_out(std::unique_lock<std::mutex>& lock, task_record* me) {
+  task_record* next = next_task();
+  if (!next) {
+    std::fprintf(stderr, "sim: every task is blocked at %u ms\n", clock_ms);
+    std::fflush(stdout);
+    std::_Exit(3);
+  }
+  advance_to(next->wake);
+  switches++;
+  current = next;
+  if (next != me) {
+    next->cv.notify_one();
+    if (!me->done) me->cv.wait(lock, [&] { return current == me; });
+  }
+  if (me == deadline_owner && deadline_hit) {
+    deadline = 0;
+    deadline_owner = nullptr;
+    deadline_hit = false;
+    throw time_limit_reached{clock_ms};
+  }
+}
+
+void sleep_until(std::uint32_t time) {
+  std::unique_lock<std::mutex> lock(kernel_mutex);
+  task_record* me = self_get(lock);
+  me->wake = std::max(time, clock_ms);
+  switch_out(lock, me);
+}
+}  // namespace
+
+std::uint32_t now() { return clock_ms; }
+
+void deadline_set(std::uint32_t time) {
+  std::unique_lock<std::mutex> lock(kernel_mutex);
+  deadline = time;
+  deadline_owner = time == 0 ? nullptr : self_get(lock);
+  deadline_hit = false;
+}
+
+std::uint64_t context_switches() { return switches; }
+
+}  // namespace sim
+
+/////
+//
+// pros::c rtos
+//
+/////
+
+namespace pros {
+namespace c {
+using sim::kernel_mutex;
+
+std::uint32_t millis(void) { return sim::clock_ms; }
+
+std::uint64_t micros(void) { return static_cast<std::uint64_t>(sim::clock_ms) * 1000; }
+
+void delay(const std::uint32_t milliseconds) { sim::sleep_until(sim::clock_ms + milliseconds); }
+
+void task_delay(const std::uint32_t milliseconds) { delay(milliseconds); }
+
+void task_delay_until(std::uint32_t* const prev_time, const std::uint32_t delta) {
+  *prev_time += delta;
+  sim::sleep_until(*prev_time);
+}
+
+task_t task_create(task_fn_t function, void* const parameters, std::uint32_t prio, const std::uint16_t, const char* const name) {
+  std::unique_lock<std::mutex> lock(kernel_mutex);
+  auto* t = new sim::task_record;
+  t->name = name ? name : "";
+  t->priority = prio;
+  t->wake = sim::clock_ms;
+  sim::tasks.push_back(t);
+
+  std::thread([t, function, parameters] {
+    {
+      std::unique_lock<std::mutex> lock(kernel_mutex);
+      sim::self = t;
+      t->cv.wait(lock, [&] { return sim::current == t; });
+    }
+    function(parameters);
+    std::unique_lock<std::mutex> lock(kernel_mutex);
+    t->done = true;
+    sim::switch_out(lock, t);
+  }).detach();
+  return t;
+}
+
+void task_delete(task_t task) {
+  std::unique_lock<std::mutex> lock(kernel_mutex);
+  auto* t = task ? static_cast<sim::task_record*>(task) : sim::self_get(lock);
+  t->done = true;
+  if (t == sim::self) {
+    // Nothing can unwind a deleted task, so it parks forever
+    sim::switch_out(lock, t);
+    t->cv.wait(lock, [] { return false; });
+  }
+}
+
+std::uint32_t task_get_priority(task_t task) {
+  std::unique_lock<std::mutex> lock(kernel_mutex);
+  return (task ? static_cast<sim::task_record*>(task) : sim::self_get(lock))->priority;
+}
+
+void task_set_priority(task_t task, std::uint32_t prio) {
+  std::unique_lock<std::mutex> lock(kernel_mutex);
+  (task ? static_cast<sim::task_record*>(task) : sim::self_get(lock))->priority = prio;
+}
+
+task_state_e_t task_get_state(task_t task) {
+  std::unique_lock<std::mutex> lock(kernel_mutex);
+  auto* t = task ? static_cast<sim::task_record*>(task) : sim::self_get(lock);
+  if (t->done) return E_TASK_STATE_DELETED;
+  if (t->suspended) return E_TASK_STATE_SUSPENDED;
+  if (t == sim::current) return E_TASK_STATE_RUNNING;
+  return t->wake > sim::clock_ms ? E_TASK_STATE_BLOCKED : E_TASK_STATE_READY;
+}
+
+void task_suspend(task_t task) {
+  std::unique_lock<std::mutex> lock(kernel_mutex);
+  auto* t = task ? static_cast<sim::task_record*>(task) : sim::self_get(lock);
+  t->suspended = true;
+  if (t == sim::self) sim::switch_out(lock, t);
+}
+
+void task_resume(task_t task) {
+  std::unique_lock<std::mutex> lock(kernel_mutex);
+  auto* t = static_cast<sim::task_record*>(task);
+  t->suspended = false;
+  t->wake = std::max(t->wake, sim::clock_ms);
+}
+
+std::uint32_t task_get_count(void) {
+  std::unique_lock<std::mutex> lock(kernel_mutex);
+  std::uint32_t count = 0;
+  for (auto* t : sim::tasks)
+    if (!t->done) count++;
+  return count;
+}
+
+char* task_get_name(task_t task) {
+  std::unique_lock<std::mutex> lock(kernel_mutex);
+  return (task ? static_cast<sim::task_record*>(task) : sim::self_get(lock))->name.data();
+}
+
+task_t task_get_by_name(const char* name) {
+  std::unique_lock<std::mutex> lock(kernel_mutex);
+  for (auto* t : sim::tasks)
+    if (!t->done && t->name == name) return t;
+  return nullptr;
+}
+
+task_t task_get_current() {
+  std::unique_lock<std::mutex> lock(kernel_mutex);
+  return sim::self_get(lock);
+}
+
+std::uint32_t task_notify(task_t task) {
+  std::unique_lock<std::mutex> lock(kernel_mutex);
+  static_cast<sim::task_record*>(task)->notify_value++;
+  return 1;
+}
+
+std::uint32_t task_notify_ext(task_t task, std::uint32_t value, notify_action_e_t action, std::uint32_t* prev_value) {
+  std::unique_lock<std::mutex> lock(kernel_mutex);
+  auto* t = static_cast<sim::task_record*>(task);
+  if (prev_value) *prev_value = t->notify_value;
+  switch (action) {
+    case E_NOTIFY_ACTION_BITS:
+      t->notify_value |= value;
+      break;
+    case E_NOTIFY_ACTION_INCR:
+      t->notify_value++;
+      break;
+    case E_NOTIFY_ACTION_OWRITE:
+      t->notify_value = value;
+      break;
+    case E_NOTIFY_ACTION_NO_OWRITE:
+      if (t->notify_value == 0) t->notify_value = value;
+      break;
+    default:
+      break;
+  }
+  return 1;
+}
+
+std::uint32_t task_notify_take(bool clear_on_exit, std::uint32_t timeout) {
+  std::uint32_t start = sim::clock_ms;
+  while (true) {
+    {
+      std::unique_lock<std::mutex> lock(kernel_mutex);
+      auto* me = sim::self_get(lock);
+      if (me->notify_value != 0) {
+        std::uint32_t value = me->notify_value;
+        me->notify_value = clear_on_exit ? 0 : value - 1;
+        return value;
+      }
+    }
+    if (timeout != TIMEOUT_MAX && sim::clock_ms - start >= timeout) return 0;
+    delay(1);
+  }
+}
+
+bool task_notify_clear(task_t task) {
+  std::unique_lock<std::mutex> lock(kernel_mutex);
+  auto* t = task ? static_cast<sim::task_record*>(task) : sim::self_get(lock);
+  bool was_pending = t->notify_value != 0;
+  t->notify_value = 0;
+  return was_pending;
+}
+
+void task_join(task_t task) {
+  while (task_get_state(task) != E_TASK_STATE_DELETED)
+    delay(1);
+}
+
+mutex_t mutex_create(void) { return new sim::mutex_record; }
+
+// The core is never preempted, so a mutex can only be contended across a delay.  PROS mutexes
+// aren't recursive: taking one the task already holds blocks until the timeout on the robot, and
+// forever without one, so that's a deadlock here too and the harness stops on it
+bool mutex_take(mutex_t mutex, std::uint32_t timeout) {
+  auto* m = static_cast<sim::mutex_record*>(mutex);
+  std::uint32_t start = sim::clock_ms;
+  while (true) {
+    {
+      std::unique_lock<std::mutex> lock(kernel_mutex);
+      auto* me = sim::self_get(lock);
+      if (!m->owner) {
+        m->owner = me;
+        return true;
+      }
+      if (m->owner == me && timeout == TIMEOUT_MAX) {
+        std::fprintf(stderr, "sim: task %s took a mutex it already holds at %u ms\n", me->name.c_str(), sim::clock_ms);
+        std::fflush(stdout);
+        std::_Exit(3);
+      }
+    }
+    if (timeout != TIMEOUT_MAX && sim::clock_ms - start >= timeout) return false;
+    delay(1);
+  }
+}
+
+bool mutex_give(mutex_t mutex) {
+  static_cast<sim::mutex_record*>(mutex)->owner = nullptr;
+  return true;
+}
+
+void mutex_delete(mutex_t mutex) { delete static_cast<sim::mutex_record*>(mutex); }
+}  // namespace c
+
+/////
+//
+// pros rtos classes
+//
+/////
+
+inline namespace rtos {
+Task::Task(task_fn_t function, void* parameters, std::uint32_t prio, std::uint16_t stack_depth, const char* name) {
+  task = c::task_create(function, parameters, prio, stack_depth, name);
+}
+
+Task::Task(task_fn_t function, void* parameters, const char* name)
+    : Task(function, parameters, TASK_PRIORITY_DEFAULT, TASK_STACK_DEPTH_DEFAULT, name) {}
+
+Task::Task(task_t task) : task(task) {}
+
+Task& Task::operator=(task_t in) {
+  task = in;
+  return *this;
+}
+
+Task Task::current() { return Task{c::task_get_current()}; }
+
+void Task::remove() { c::task_delete(task); }
+
+std::uint32_t Task::get_priority() { return c::task_get_priority(task); }
+
+void Task::set_priority(std::uint32_t prio) { c::task_set_priority(task, prio); }
+
+std::uint32_t Task::get_state() { return c::task_get_state(task); }
+
+void Task::suspend() { c::task_suspend(task); }
+
+void Task::resume() { c::task_resume(task); }
+
+const char* Task::get_name() { return c::task_get_name(task); }
+
+std::uint32_t Task::notify() { return c::task_notify(task); }
+
+void Task::join() { c::task_join(task); }
+
+std::uint32_t Task::notify_ext(std::uint32_t value, notify_action_e_t action, std::uint32_t* prev_value) {
+  return c::task_notify_ext(task, value, action, prev_value);
+}
+
+std::uint32_t Task::notify_take(bool clear_on_exit, std::uint32_t timeout) { return c::task_notify_take(clear_on_exit, timeout); }
+
+bool Task::notify_clear() { return c::task_notify_clear(task); }
+
+void Task::delay(const std::uint32_t milliseconds) { c::delay(milliseconds); }
+
+void Task::delay_until(std::uint32_t* const prev_time, const std::uint32_t delta) { c::task_delay_until(prev_time, delta); }
+
+std::uint32_t Task::get_count() { return c::task_get_count(); }
+
+Clock::time_point Clock::now() { return time_point{duration{c::millis()}}; }
+
+Mutex::Mutex() : mutex(c::mutex_create(), c::mutex_delete) {}
+
+bool Mutex::take() { return c::mutex_take(mutex.get(), TIMEOUT_MAX); }
+
+bool Mutex::take(std::uint32_t timeout) { return c::mutex_take(mutex.get(), timeout); }
+
+bool Mutex::give() { return c::mutex_give(mutex.get()); }
+
+void Mutex::lock() { take(); }
+
+void Mutex::unlock() { give(); }
+
+bool Mutex::try_lock() { return take(0); }
+}  // namespace rtos
+}  // namespace pros
@@ -0,0 +1,138 @@
+/*
+This Source Code Form is subject to the terms of the Mozilla Public
+License, v. 2.0. If a copy of the MPL was not distributed with this
+file, You can obtain one at http://mozilla.org/MPL/2.0/.
+*/
+
+// Host harness.  Runs initialize() once, then runs an auton on the simulated robot as
+// many times as asked, each from a fresh plant, and prints where the robot ended up.
+//
+//   bin/sim [auton index | name] [--runs N] [--limit ms] [--trace file.csv]
+
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <string>
+
+#include "main.h"
+#include "sim/sim.hpp"
+
+namespace {
+struct options {
+  std::string auton = "0";
+  int runs = 1;
+  std::uint32_t limit = 60000;  // a skills run
+  std::string trace;
+};
+
+// Matches the robot in src/main.cpp
+void plant_configure() {
+  sim::drive_config drive;
+  drive.left_ports = {-8, -9, 10};
+  drive.right_ports = {18, 19, -20};
+  drive.imu_port = 17;
+  drive.wheel_diameter = 3.25;
+  drive.cartridge_rpm = 600;
+  drive.ratio = 2;
+
+  sim::field_config field;
+  field.start_x = 24.0;
+  field.start_y = 24.0;
+
+  // dist_sensor, where include/subsystems.hpp says it is
+  sim::configure(drive, field, {{DIST_SENSOR_PORT, DIST_SENSOR_MOUNT.x_offset, DIST_SENSOR_MOUNT.y_offset, DIST_SENSOR_MOUNT.facing}});
+}
+
+int auton_find(const std::string& name) {
+  auto& autons = ez::as::auton_selector.Autons;
+  char* end = nullptr;
+  long index = std::strtol(name.c_str(), &end, 10);
+  if (*end == '\0') return index >= 0 && index < (long)autons.size() ? index : -1;
+  for (size_t i = 0; i < autons.size(); i++)
+    if (autons[i].Name.find(name) != std::string::npos) return i;
+  return -1;
+}
+
+// Samples the true pose every 10 ms while an auton runs
+FILE* trace_file = nullptr;
+void trace_task() {
+  while (true) {
+    if (trace_file) {
+      auto r = sim::robot_get();
+      std::fprintf(trace_file, "%u,%.3f,%.3f,%.3f,%.3f,%.3f\n", sim::now(), r.x, r.y, r.theta, r.left_velocity, r.right_velocity);
+    }
+    pros::delay(10);
+  }
+}
+
+options options_parse(int argc, char** argv) {
+  options out;
+  for (int i = 1; i < argc; i++) {
+    std::string arg = argv[i];
+    if (arg == "--runs" && i + 1 < argc)
+      out.runs = std::max(1, std::atoi(argv[++i]));
+    else if (arg == "--limit" && i + 1 < argc)
+      out.limit = std::strtoul(argv[++i], nullptr, 10);
+    else if (arg == "--trace" && i + 1 < argc)
+      out.trace = argv[++i];
+    else
+      out.auton = arg;
+  }
+  return out;
+}
+}  // namespace
+
+int main(int argc, char** argv) {
+  options opts = options_parse(argc, argv);
+  plant_configure();
+  initialize();
+
+  int auton = auton_find(opts.auton);
+  if (auton < 0) {
+    std::printf("No auton matches \"%s\", pick one of:\n", opts.auton.c_str());
+    auto& autons = ez::as::auton_selector.Autons;
+    for (size_t i = 0; i < autons.size(); i++) std::printf("  %zu: %s\n", i, autons[i].Name.c_str());
+    std::_Exit(1);
+  }
+  ez::as::auton_selector.auton_page_current = auton;
+
+  if (!opts.trace.empty()) {
+    trace_file = std::fopen(opts.trace.c_str(), "w");
+    if (!trace_file) {
+      std::printf("Could not open %s\n", opts.trace.c_str());
+      std::_Exit(1);
+    }
+    std::fprintf(trace_file, "time,x,y,theta,left_velocity,right_velocity\n");
+    pros::Task trace(trace_task, "sim trace");
+  }
+
+  for (int run = 0; run < opts.runs; run++) {
+    sim::reset();
+    std::uint32_t start = sim::now();
+    sim::deadline_set(start + opts.limit);
+    auto wall_start = std::chrono::steady_clock::now();
+    std::uint64_t allocations_start = sim::allocations();
+
+    bool timed_out = false;
+    try {
+      autonomous();
+    } catch (const sim::time_limit_reached&) {
+      timed_out = true;
+    }
+    sim::deadline_set(0);
+
+    double wall = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - wall_start).count();
+    std::uint64_t allocations = sim::allocations() - allocations_start;
+    auto r = sim::robot_get();
+    std::printf("run %d: %s in %u ms%s, ended at (%.2f, %.2f, %.2f), %.1f ms wall time, %llu allocations\n",
+                run + 1, ez::as::auton_selector.Autons[auton].Name.c_str(), sim::now() - start,
+                timed_out ? " (time limit)" : "", r.x, r.y, r.theta, wall, (unsigned long long)allocations);
+  }
+
+  if (trace_file) std::fclose(trace_file);
+  std::fflush(stdout);
+
+  // Robot tasks never return, so skip joining them
+  std::_Exit(0);
+}
@@ -0,0 +1,238 @@
+/*
+This Source Code Form is subject to the terms of the Mozilla Public
+License, v. 2.0. If a copy of the MPL was not distributed with this
+file, You can obtain one at http://mozilla.org/MPL/2.0/.
+*/
+
+#include "plant.hpp"
+
+#include <algorithm>
+#include <array>
+#include <cmath>
+#include <cstdlib>
+
+namespace sim {
+namespace {
+constexpr double DT = 0.001;  // the plant always steps 1 ms
+constexpr double IN_PER_S2_PER_G = 386.09;
+
+std::array<motor_port, 22> motors;
+drive_config drive;
+field_config field;
+std::vector<distance_config> distances;
+
+double x = 0.0, y = 0.0, theta = 0.0;  // inches, radians clockwise
+double left_velocity = 0.0, right_velocity = 0.0;
+double imu_rotation = 0.0, imu_rate = 0.0, imu_accel = 0.0;
+double battery = 12600.0;
+
+double to_rad(double deg) { return deg * M_PI / 180.0; }
+double to_deg(double rad) { return rad * 180.0 / M_PI; }
+
+// Fraction of full power a motor is being asked for, in the physical direction of the shaft
+double command_fraction(const motor_port& m, double free_rpm) {
+  if (m.velocity_mode)
+    return std::clamp(m.target_velocity / free_rpm, -1.0, 1.0);
+  double limit = m.voltage_limit > 0 ? std::min<double>(m.voltage_limit, battery) : battery;
+  return std::clamp(m.command, -limit, limit) / 12000.0;
+}
+
+bool is_stopped(const motor_port& m) {
+  return m.velocity_mode ? m.target_velocity == 0.0 : m.command == 0.0;
+}
+
+double stop_time_constant(int brake_mode) {
+  return brake_mode == 0 ? drive.coast_time_constant : drive.brake_time_constant;
+}
+
+// Steps one side of the drive and returns its new linear velocity in in/s
+double side_step(const std::vector<int>& ports, double velocity) {
+  if (ports.empty()) return 0.0;
+
+  double free_velocity = drive.cartridge_rpm / drive.ratio * M_PI * drive.wheel_diameter / 60.0;
+  double u = 0.0;
+  bool stopped = true;
+  int brake_mode = 0;
+  int current_limit = 0;
+  for (int p : ports) {
+    motor_port& m = motor_port_get(std::abs(p));
+    u += (p < 0 ? -1.0 : 1.0) * command_fraction(m, drive.cartridge_rpm);
+    stopped = stopped && is_stopped(m);
+    brake_mode = std::max(brake_mode, m.brake_mode);
+    current_limit += m.current_limit;
+  }
+  u /= ports.size();
+
+  double current = 0.0;
+  if (stopped) {
+    velocity -= velocity / stop_time_constant(brake_mode) * DT;
+  } else {
+    // Current is proportional to torque, so the current limit caps how hard the side can accelerate
+    double slip = u - velocity / free_velocity;
+    current = drive.stall_current * ports.size() * std::fabs(slip);
+    double scale = current > current_limit ? current_limit / current : 1.0;
+    current = std::min<double>(current, current_limit);
+    velocity += (slip * free_velocity) * scale / drive.time_constant * DT;
+  }
+
+  // Spin every motor shaft on this side to match the wheels
+  double motor_rpm = velocity / (M_PI * drive.wheel_diameter) * 60.0 * drive.ratio;
+  for (int p : ports) {
+    motor_port& m = motor_port_get(std::abs(p));
+    m.velocity = (p < 0 ? -1.0 : 1.0) * motor_rpm;
+    m.position += m.velocity * 6.0 * DT;
+    m.current = current / ports.size();
+  }
+  return velocity;
+}
+
+// Unloaded motors (intakes, rollers) just chase their commanded speed
+void free_motor_step(motor_port& m) {
+  double free_rpm = gearset_rpm(m.gearset);
+  double slip = command_fraction(m, free_rpm) - m.velocity / free_rpm;
+  if (is_stopped(m))
+    m.velocity -= m.velocity / (m.brake_mode == 0 ? 0.3 : 0.03) * DT;
+  else
+    m.velocity += slip * free_rpm / 0.05 * DT;
+  double last_position = m.position;
+  m.position += m.velocity * 6.0 * DT;
+  if (m.position_mode && (m.position - m.target_position) * (last_position - m.target_position) <= 0.0) {
+    m.position_mode = false;
+    m.target_velocity = 0.0;
+  }
+  m.current = std::min<double>(drive.stall_current * std::fabs(slip) * 0.2, m.current_limit);
+}
+
+double ray_to_wall(double px, double py, double dx, double dy) {
+  double best = INFINITY;
+  auto check = [&](double t) {
+    if (t > 0.0) best = std::min(best, t);
+  };
+  if (dx != 0.0) {
+    check((0.0 - px) / dx);
+    check((field.width - px) / dx);
+  }
+  if (dy != 0.0) {
+    check((0.0 - py) / dy);
+    check((field.height - py) / dy);
+  }
+  return best;
+}
+
+double distance_raw(const distance_config& d) {
+  double s = std::sin(theta), c = std::cos(theta);
+  double px = x + d.x_offset * c + d.y_offset * s;
+  double py = y - d.x_offset * s + d.y_offset * c;
+  double facing = theta + to_rad(d.facing);
+  return ray_to_wall(px, py, std::sin(facing), std::cos(facing)) * 25.4;
+}
+}  // namespace
+
+motor_port& motor_port_get(int port) { return motors[std::clamp(std::abs(port), 0, 21)]; }
+
+double gearset_rpm(int gearset) {
+  switch (gearset) {
+    case 0:
+      return 100.0;
+    case 2:
+      return 600.0;
+    default:
+      return 200.0;
+  }
+}
+
+double gearset_ticks(int gearset) {
+  switch (gearset) {
+    case 0:
+      return 1800.0;
+    case 2:
+      return 300.0;
+    default:
+      return 900.0;
+  }
+}
+
+void configure(drive_config p_drive, field_config p_field, std::vector<distance_config> sensors) {
+  drive = p_drive;
+  field = p_field;
+  distances = sensors;
+  battery = drive.battery_voltage;
+  int gearset = drive.cartridge_rpm >= 600 ? 2 : (drive.cartridge_rpm <= 100 ? 0 : 1);
+  for (auto ports : {drive.left_ports, drive.right_ports}) {
+    for (int p : ports) {
+      motor_port_get(p).drive = true;
+      motor_port_get(p).gearset = gearset;
+    }
+  }
+  reset();
+}
+
+void reset() {
+  for (auto& m : motors) {
+    m.command = 0.0;
+    m.velocity_mode = false;
+    m.target_velocity = 0.0;
+    m.position_mode = false;
+    m.velocity = 0.0;
+    m.position = 0.0;
+    m.zero = 0.0;
+    m.current = 0.0;
+  }
+  x = field.start_x;
+  y = field.start_y;
+  theta = to_rad(field.start_theta);
+  left_velocity = right_velocity = 0.0;
+  imu_rotation = imu_rate = imu_accel = 0.0;
+  adi_reset();
+}
+
+void plant_step() {
+  double last_velocity = (left_velocity + right_velocity) / 2.0;
+  left_velocity = side_step(drive.left_ports, left_velocity);
+  right_velocity = side_step(drive.right_ports, right_velocity);
+
+  for (auto& m : motors)
+    if (!m.drive) free_motor_step(m);
+
+  // Differential drive kinematics, theta is clockwise from +y
+  double velocity = (left_velocity + right_velocity) / 2.0;
+  double omega = (left_velocity - right_velocity) / drive.track_width;
+  theta += omega * DT;
+  x += velocity * std::sin(theta) * DT;
+  y += velocity * std::cos(theta) * DT;
+  double half = drive.robot_size / 2.0;
+  x = std::clamp(x, half, field.width - half);
+  y = std::clamp(y, half, field.height - half);
+
+  imu_rotation += to_deg(omega * DT);
+  imu_rate = to_deg(omega);
+  imu_accel = (velocity - last_velocity) / DT / IN_PER_S2_PER_G;
+}
+
+robot_state robot_get() { return {x, y, to_deg(theta), left_velocity, right_velocity}; }
+
+void battery_set(double mV) { battery = mV; }
+double battery_get() { return battery; }
+
+double imu_rotation_get() { return imu_rotation; }
+double imu_rate_get() { return imu_rate; }
+double imu_accel_get() { return imu_accel; }
+
+int distance_get(int port) {
+  for (size_t i = 0; i < distances.size(); i++) {
+    if (distances[i].port != port) continue;
+    double mm = distance_raw(distances[i]);
+    return mm > 2000.0 ? 9999 : static_cast<int>(std::lround(mm));
+  }
+  return 9999;
+}
+
+double distance_velocity_get(int port) {
+  // The walls are still, so the object moves opposite to the sensor
+  double velocity = (left_velocity + right_velocity) / 2.0;
+  for (const auto& d : distances)
+    if (d.port == port) return -velocity * std::cos(to_rad(d.facing)) * 0.0254;
+  return 0.0;
+}
+
+}  // namespace sim
@@ -0,0 +1,80 @@
+/*
+This Source Code Form is subject to the terms of the Mozilla Public
+License, v. 2.0. If a copy of the MPL was not distributed with this
+file, You can obtain one at http://mozilla.org/MPL/2.0/.
+*/
+
+#pragma once
+
+#include <cstdint>
+
+#include "sim/sim.hpp"
+
+namespace sim {
+
+/**
+ * State of one smart port motor.  Everything is in the physical direction of the shaft,
+ * reversing is applied by the pros::Motor wrapper.
+ */
+struct motor_port {
+  double command = 0.0;  // mV
+  bool velocity_mode = false;
+  double target_velocity = 0.0;  // rpm
+  bool position_mode = false;    // move_absolute, stops once target_position is passed
+  double target_position = 0.0;  // degrees
+  double velocity = 0.0;         // rpm
+  double position = 0.0;         // degrees
+  double zero = 0.0;             // degrees
+  double current = 0.0;          // mA
+  double temperature = 35.0;     // C
+  int brake_mode = 0;
+  int gearset = 1;
+  int units = 0;
+  int current_limit = 2500;
+  int voltage_limit = 0;
+  bool drive = false;
+};
+
+/**
+ * Returns the motor plugged into a smart port, 1 - 21.
+ */
+motor_port& motor_port_get(int port);
+
+/**
+ * Returns the free speed of a gearset in rpm.
+ */
+double gearset_rpm(int gearset);
+
+/**
+ * Returns encoder ticks per revolution for a gearset.
+ */
+double gearset_ticks(int gearset);
+
+/**
+ * Imu readings in the physical frame, degrees clockwise and degrees/s.
+ */
+double imu_rotation_get();
+double imu_rate_get();
+double imu_accel_get();
+
+/**
+ * Returns the reading of a distance sensor in mm, or 9999 when nothing is in range.
+ */
+int distance_get(int port);
+
+/**
+ * Returns the velocity of the object a distance sensor sees in m/s.
+ */
+double distance_velocity_get(int port);
+
+/**
+ * Battery voltage in mV.
+ */
+double battery_get();
+
+/**
+ * Zeroes the 3 wire outputs.  Implemented with the devices.
+ */
+void adi_reset();
+
+}  // namespace sim
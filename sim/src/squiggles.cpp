@@ -0,0 +1,71 @@
+/*
+This Source Code Form is subject to the terms of the Mozilla Public
+License, v. 2.0. If a copy of the MPL was not distributed with this
+file, You can obtain one at http://mozilla.org/MPL/2.0/.
+*/
+
+// squiggles' SplineGenerator and TankModel for the host.  Their implementation only ships in
+// the prebuilt okapi archive, so unless SQUIGGLES_SRC points make sim at a checkout of
+// squiggles' src/, generate() is answered by robot::spline_generator instead.  The states are
+// spaced by distance rather than every dt and fast is ignored, so trajectories are close to
+// the robot's but not the same.
+
+#ifndef SIM_SQUIGGLES_SRC
+
+#include <algorithm>
+#include <cmath>
+
+#include "okapi/squiggles/squiggles.hpp"
+#include "spline_generator.hpp"
+
+namespace squiggles {
+TankModel::TankModel(double itrack_width, Constraints ilinear_constraints)
+    : track_width(itrack_width), linear_constraints(ilinear_constraints) {}
+
+Constraints TankModel::constraints(const Pose pose, double curvature, double vel) {
+  (void)pose;
+  (void)vel;
+  double faster = 1.0 + std::fabs(curvature) * track_width / 2.0;
+  Constraints out = linear_constraints;
+  out.max_vel = linear_constraints.max_vel / faster;
+  return out;
+}
+
+std::vector<double> TankModel::linear_to_wheel_vels(double lin_vel, double curvature) {
+  double turn = curvature * track_width / 2.0;
+  return {lin_vel * (1.0 - turn), lin_vel * (1.0 + turn)};
+}
+
+std::string TankModel::to_string() const {
+  return "TankModel {track_width: " + std::to_string(track_width) + ", " + linear_constraints.to_string() + "}";
+}
+
+SplineGenerator::SplineGenerator(Constraints iconstraints, std::shared_ptr<PhysicalModel> imodel, double idt)
+    : constraints(iconstraints), model(imodel), dt(idt) {}
+
+std::vector<ProfilePoint> SplineGenerator::generate(std::vector<Pose> iwaypoints, bool fast) {
+  (void)fast;
+  // The model's wheel speeds at unit speed and curvature differ by its track width
+  std::vector<double> wheels = model->linear_to_wheel_vels(1.0, 1.0);
+  robot::spline_settings settings;
+  settings.max_vel = constraints.max_vel;
+  settings.max_accel = constraints.max_accel;
+  settings.track_width = wheels.size() == 2 ? wheels[1] - wheels[0] : 0.0;
+  settings.spacing = std::max(constraints.max_vel * dt, 0.005);
+  settings.warm_start = false;
+
+  robot::profile_path<2> path;
+  robot::spline_generator generator;
+  generator.generate(iwaypoints, settings, path);
+  std::vector<ProfilePoint> out;
+  out.reserve(path.size());
+  for (const auto& p : path) out.push_back(p.squiggles_get());
+  return out;
+}
+
+std::vector<ProfilePoint> SplineGenerator::generate(std::initializer_list<Pose> iwaypoints, bool fast) {
+  return generate(std::vector<Pose>(iwaypoints), fast);
+}
+}  // namespace squiggles
+
+#endif
@@ -0,0 +1,118 @@
+/*
+This Source Code Form is subject to the terms of the Mozilla Public
+License, v. 2.0. If a copy of the MPL was not distributed with this
+file, You can obtain one at http://mozilla.org/MPL/2.0/.
+*/
+
+// Counts heap allocations for a trajectory in squiggles' layout against
+// robot::profile_path from include/profile_point.hpp.
+//
+// Generates a skills length route, then prints allocations, bytes and time for:
+//   squiggles  copying it into a std::vector<squiggles::ProfilePoint>, one allocation per state
+//   generate   a cold robot::spline_generator::generate() into an empty path
+//   regenerate the same route from a pose 2 cm away, into the same path
+//   encode     path_encode() for trajectory_follower::start()
+// and how long one pass reading every state's velocities takes in each layout.
+//
+//   bin/sim/alloc_bench [--spacing m]
+
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <new>
+#include <vector>
+
+#include "path_file.hpp"
+#include "spline_generator.hpp"
+
+using squiggles::Pose;
+
+// sim/src/alloc.cpp only links into the simulator, so this tool counts its own
+namespace {
+std::size_t allocations = 0;
+std::size_t allocated = 0;
+}  // namespace
+
+void* operator new(std::size_t size) {
+  allocations++;
+  allocated += size;
+  if (void* p = std::malloc(size ? size : 1)) return p;
+  throw std::bad_alloc();
+}
+void operator delete(void* p) noexcept { std::free(p); }
+void operator delete(void* p, std::size_t) noexcept { std::free(p); }
+
+namespace {
+struct count {
+  std::size_t allocations;
+  std::size_t bytes;
+  double us;
+};
+
+template <typename F>
+count measure(F&& fn) {
+  std::size_t a = allocations, b = allocated;
+  auto begin = std::chrono::steady_clock::now();
+  fn();
+  double us = std::chrono::duration<double, std::micro>(std::chrono::steady_clock::now() - begin).count();
+  return {allocations - a, allocated - b, us};
+}
+
+template <typename Path>
+double read_us(const Path& path) {
+  volatile double sink = 0.0;
+  auto begin = std::chrono::steady_clock::now();
+  int n = 0;
+  do {
+    double total = 0.0;
+    for (const auto& p : path) total += p.wheel_velocities[0] + p.wheel_velocities[1];
+    sink = total;
+    n++;
+  } while (std::chrono::steady_clock::now() - begin < std::chrono::milliseconds(200));
+  (void)sink;
+  return std::chrono::duration<double, std::micro>(std::chrono::steady_clock::now() - begin).count() / n;
+}
+
+void print(const char* name, const count& c, std::size_t states) {
+  std::printf("%-11s %8zu %12zu %10.1f %10.1f\n", name, c.allocations, c.bytes, c.us, c.us * 1000.0 / states);
+}
+}  // namespace
+
+int main(int argc, char** argv) {
+  robot::spline_settings settings;
+  settings.spacing = 0.005;
+  for (int i = 1; i + 1 < argc; i += 2)
+    if (!std::strcmp(argv[i], "--spacing")) settings.spacing = std::atof(argv[i + 1]);
+
+  // Out and back across the field twice
+  std::vector<Pose> route = {{-1.5, -1.5, 0.0}, {1.2, -1.2, 0.8}, {1.2, 1.2, 2.4}, {-1.2, 1.2, -2.4},
+                             {-1.2, -0.6, -0.8}, {0.6, 0.0, 0.0}, {1.5, 1.5, 1.57}};
+  robot::spline_generator generator;
+  robot::profile_path<2> path;
+
+  count generate = measure([&] { generator.generate(route, settings, path); });
+  std::size_t states = path.size();
+
+  std::vector<squiggles::ProfilePoint> layout;
+  count squiggles_copy = measure([&] {
+    layout.reserve(path.size());
+    for (const auto& p : path) layout.push_back(p.squiggles_get());
+  });
+
+  route[0].x += 0.02;
+  count regenerate = measure([&] { generator.generate(route, settings, path); });
+
+  std::vector<std::uint8_t> bytes;
+  count encode = measure([&] { bytes = robot::path_encode(path); });
+
+  std::printf("%zu states, %zu bytes each inline, %zu + %zu on the heap in squiggles' layout\n", states, sizeof(robot::profile_point<2>),
+              sizeof(squiggles::ProfilePoint), 2 * sizeof(double));
+  std::printf("%-11s %8s %12s %10s %10s\n", "", "allocs", "bytes", "us", "ns/state");
+  print("squiggles", squiggles_copy, states);
+  print("generate", generate, states);
+  print("regenerate", regenerate, states);
+  print("encode", encode, states);
+  std::printf("reading every state: squiggles %.1f us, profile_path %.1f us\n", read_us(layout), read_us(path));
+  return 0;
+}
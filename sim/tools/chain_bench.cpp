@@ -0,0 +1,219 @@
+/*
+This Source Code Form is subject to the terms of the Mozilla Public
+License, v. 2.0. If a copy of the MPL was not distributed with this
+file, You can obtain one at http://mozilla.org/MPL/2.0/.
+*/
+
+// Times a run of drives and turns two ways through robot::motion_chain:
+//   one by one   every motion planned on its own and waited on, like chassis_profile.wait()
+//                after each pid_drive_set() and pid_turn_set()
+//   queued       all of them queued and started as one with chassis_profile.queue_start(), so
+//                drive, turn, drive corners round into arcs the robot keeps its speed through
+//
+// Both follow trapezoids with feedforward from the true kS, kV and kA, EZ's drive PIDs on each
+// wheel's error from the plan and the heading PID on the planned heading.  Drives exit on
+// default_constants()'s drive exits (90 ms within 1 in, 250 ms within 3 in), turns on its turn
+// exits (90 ms within 3 deg, 250 ms within 7 deg).  The plant is motion_profile_bench's, with
+// where the robot ends up tracked so the arcs can be checked to end where the motions would have.
+//
+//   bin/sim/chain_bench [--speed 110] [--turn-speed 100] [--accel 170] [--radius 12]
+//                       [--traction 200] [motion ...]
+//
+// A motion is inches to drive, or t and degrees to turn by, eg. 21 t-75 26.25.  Defaults to
+// LEFT_SIDE_AWP's run from the preload to the goal.
+
+#include <algorithm>
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <vector>
+
+#include "feedforward.hpp"
+#include "motion_chain.hpp"
+
+using robot::chain_motion;
+using robot::feedforward_gains;
+
+namespace {
+constexpr double FREE_VELOCITY = 600.0 / 2.0 * M_PI * 3.25 / 60.0;  // in/s, the robot in src/main.cpp
+constexpr double TIME_CONSTANT = 0.12;
+constexpr double PLANT_DT = 0.001;
+constexpr double TICK = 0.01;  // ez::util::DELAY_TIME
+constexpr double WIDTH = 11.5;
+constexpr double DEG = 180.0 / M_PI;
+constexpr double FRICTION = 6.0;
+constexpr double WEAK = 0.93;
+
+// One side of motion_profile_bench's plant
+struct side {
+  double strength = 1.0;
+  double traction = 1e9;  // in/s^2
+  double velocity = 0.0;  // in/s, of the wheel
+  double position = 0.0;  // in, what the encoders read
+  double ground_velocity = 0.0;
+  bool slipping = false;
+
+  void step(double output) {
+    double effective = 0.0;
+    if (std::fabs(velocity) > 0.01) effective = output - std::copysign(FRICTION, velocity);
+    else if (std::fabs(output) > FRICTION) effective = output - std::copysign(FRICTION, output);
+    double u = std::clamp(effective / 127.0 * strength, -1.0, 1.0);
+    double accel = (u * FREE_VELOCITY - velocity) / TIME_CONSTANT;
+    if (!slipping && std::fabs(accel) > traction) slipping = true;
+    double next;
+    if (!slipping) {
+      next = velocity + accel * PLANT_DT;
+    } else {
+      next = velocity + accel * 4.0 * PLANT_DT;
+      double gap = next - ground_velocity;
+      ground_velocity += std::copysign(std::fmin(std::fabs(gap), traction * PLANT_DT), gap);
+      if (std::fabs(next - ground_velocity) < 0.5) {
+        slipping = false;
+        next = ground_velocity;
+      }
+    }
+    if (std::fabs(output) <= FRICTION && next * velocity < 0.0) next = 0.0;
+    velocity = next;
+    if (!slipping) ground_velocity = velocity;
+    position += velocity * PLANT_DT;
+  }
+};
+
+// Both sides and where the robot really is, heading clockwise from +y like EZ's odometry
+struct robot_plant {
+  side left, right;
+  double x = 0.0, y = 0.0, heading = 0.0;  // in, in, degrees
+
+  void step(double l, double r) {
+    left.step(std::clamp(l, -127.0, 127.0));
+    right.step(std::clamp(r, -127.0, 127.0));
+    double forward = (left.ground_velocity + right.ground_velocity) / 2.0 * PLANT_DT;
+    double angle = (heading + (left.ground_velocity - right.ground_velocity) / WIDTH * DEG * PLANT_DT / 2.0) / DEG;
+    x += forward * std::sin(angle);
+    y += forward * std::cos(angle);
+    heading += (left.ground_velocity - right.ground_velocity) / WIDTH * DEG * PLANT_DT;
+  }
+};
+
+// ez::PID::compute(), derivative on the measurement
+struct pid {
+  double kp, kd;
+  double previous = 0.0;
+  bool first = true;
+  double compute(double error, double current) {
+    double derivative = first ? 0.0 : previous - current;
+    first = false;
+    previous = current;
+    return kp * error + kd * derivative;
+  }
+};
+
+// ez::PID::exit_condition()'s small and big timers
+struct exit_timer {
+  double small_error, big_error;
+  int small = 0, big = 0;
+  bool update(double error) {
+    int ms = (int)std::lround(TICK * 1000.0);
+    small = std::fabs(error) < small_error ? small + ms : 0;
+    big = std::fabs(error) < big_error ? big + ms : 0;
+    return small > 90 || big > 250;
+  }
+};
+
+feedforward_gains truth(double strength) { return {FRICTION, 127.0 / (FREE_VELOCITY * strength), 127.0 * TIME_CONSTANT / (FREE_VELOCITY * strength)}; }
+
+// Follows one planned chain to its exit from the heading the last one planned, returns seconds
+// taken or -1 if it never exits
+double follow(robot_plant& plant, double& target, const chain_motion* motions, int count, const robot::chain_settings& settings) {
+  robot::motion_chain chain;
+  chain.plan(motions, count, target, settings);
+  target = chain.heading_get();
+  feedforward_gains left_gains = truth(1.0), right_gains = truth(WEAK);
+  pid left_pid{20.0, 100.0}, right_pid{20.0, 100.0}, heading_pid{11.0, 20.0};
+  exit_timer left_exit{1.0, 3.0}, right_exit{1.0, 3.0}, turn_exit{3.0, 7.0};
+  bool left_done = false, right_done = false;
+  double left_start = plant.left.position, right_start = plant.right.position;
+  for (double t = 0.0; t < chain.duration_get() + 3.0; t += TICK) {
+    robot::chain_state s = chain.sample(t);
+    double left_error = s.left - (plant.left.position - left_start), right_error = s.right - (plant.right.position - right_start);
+    if (t >= chain.duration_get()) {
+      if (chain.ends_turning()) {
+        if (turn_exit.update(s.heading - plant.heading)) return t;
+      } else {
+        left_done = left_done || left_exit.update(left_error);
+        right_done = right_done || right_exit.update(right_error);
+        if (left_done && right_done) return t;
+      }
+    }
+    double heading = heading_pid.compute(s.heading - plant.heading, plant.heading);
+    double l = robot::feedforward_output(left_gains, s.left_velocity, s.left_accel) + left_pid.compute(left_error, -left_error) + heading;
+    double r = robot::feedforward_output(right_gains, s.right_velocity, s.right_accel) + right_pid.compute(right_error, -right_error) - heading;
+    for (int i = 0; i < (int)(TICK / PLANT_DT + 0.5); i++) plant.step(l, r);
+  }
+  return -1.0;
+}
+
+void print(const char* name, double time, const robot_plant& plant, double x, double y, double heading) {
+  std::printf("  %-10s %7.2f %9.2f %10.2f\n", name, time, std::hypot(plant.x - x, plant.y - y), plant.heading - heading);
+}
+}  // namespace
+
+int main(int argc, char** argv) {
+  int speed = 110, turn_speed = 100;
+  double traction = 200.0;
+  robot::chain_settings settings;
+  settings.half_width = WIDTH / 2.0;
+  std::vector<const char*> route;
+  for (int i = 1; i < argc; i++) {
+    bool more = i + 1 < argc;
+    if (!std::strcmp(argv[i], "--speed") && more) speed = std::atoi(argv[++i]);
+    else if (!std::strcmp(argv[i], "--turn-speed") && more) turn_speed = std::atoi(argv[++i]);
+    else if (!std::strcmp(argv[i], "--accel") && more) settings.accel = std::atof(argv[++i]);
+    else if (!std::strcmp(argv[i], "--radius") && more) settings.radius = std::atof(argv[++i]);
+    else if (!std::strcmp(argv[i], "--traction") && more) traction = std::atof(argv[++i]);
+    else route.push_back(argv[i]);
+  }
+  if (route.empty()) route = {"21", "t-75", "26.25", "t-42.5", "-9"};
+  if ((int)route.size() > robot::motion_chain::MAX_MOTIONS) {
+    std::printf("at most %d motions\n", robot::motion_chain::MAX_MOTIONS);
+    return 1;
+  }
+
+  // Top speed is what the weaker side holds at the output, like chassis_profile's
+  feedforward_gains weaker = truth(WEAK);
+  double top = (speed - weaker.kS) / weaker.kV, turn_top = (turn_speed - weaker.kS) / weaker.kV;
+
+  // Where the motions end if driven as straight lines and turns in place
+  std::vector<chain_motion> motions;
+  double x = 0.0, y = 0.0, heading = 0.0;
+  for (const char* m : route) {
+    if (m[0] == 't') {
+      motions.push_back({true, true, std::atof(m + 1), turn_top});
+      heading += std::atof(m + 1);
+    } else {
+      motions.push_back({false, false, std::atof(m), top});
+      x += std::atof(m) * std::sin(heading / DEG);
+      y += std::atof(m) * std::cos(heading / DEG);
+    }
+  }
+
+  robot::motion_chain planned;
+  planned.plan(motions.data(), (int)motions.size(), 0.0, settings);
+  std::printf("accel %.0f in/s^2, radius %.1f in, traction %.0f in/s^2, %d corners rounded, %d stops\n\n", settings.accel, settings.radius, traction,
+              planned.blends_get(), planned.stops_get());
+  std::printf("             exit s  end in  heading\n");
+
+  robot_plant separate, queued;
+  separate.left.traction = separate.right.traction = queued.left.traction = queued.right.traction = traction;
+  separate.right.strength = queued.right.strength = WEAK;
+  double total = 0.0, target = 0.0;
+  for (const chain_motion& m : motions) {
+    double t = follow(separate, target, &m, 1, settings);
+    total = t < 0.0 || total < 0.0 ? -1.0 : total + t;
+  }
+  print("one by one", total, separate, x, y, heading);
+  target = 0.0;
+  print("queued", follow(queued, target, motions.data(), (int)motions.size(), settings), queued, x, y, heading);
+  return 0;
+}
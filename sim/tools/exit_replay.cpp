@@ -0,0 +1,339 @@
+/*
+This Source Code Form is subject to the terms of the Mozilla Public
+License, v. 2.0. If a copy of the MPL was not distributed with this
+file, You can obtain one at http://mozilla.org/MPL/2.0/.
+*/
+
+// Scores robot::settle_predictor from include/settle_predictor.hpp against EZ's exit timers.
+//
+//   bin/sim/exit_replay log_000.bin [--drive-error 1] [--turn-error 3]
+//       every robot::pid_wait() in the log: how long the timers took to exit, when the predictor
+//       would have, and how far the error got from the target after that
+//   bin/sim/exit_replay [--motions 40] [--seed 1] [--write synthetic.bin]
+//       makes up a skills run of turns and drives on plants with friction, delay and sensor
+//       noise, run with default_constants()'s PIDs and exits, and scores it the same way.  --write
+//       saves it as a log so the first form can be checked against a known run.
+//
+// A predicted exit is wrong when the error leaves its band again afterwards, the motion would have
+// ended on a robot still moving, or when a stop predicted short of the small band reaches it before
+// the timers would have exited, the motion would have given up early.
+
+#include <algorithm>
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <random>
+#include <vector>
+
+#include "log_record.hpp"
+#include "settle_predictor.hpp"
+
+using robot::log_record;
+
+namespace {
+constexpr int TICK = 10;  // ms, ez::util::DELAY_TIME
+constexpr std::uint8_t RUNNING = 1, SMALL_EXIT = 2, BIG_EXIT = 3, VELOCITY_EXIT = 4;  // ez::exit_output
+constexpr std::uint8_t TURN = 2, DRIVE = 4;                                           // ez::e_mode
+
+/////
+//
+// Simulated motions
+//
+/////
+
+// Second order plant: velocity lags the output through tau and a delay, static friction eats
+// kS of it
+struct plant {
+  double K;      // units/s per output at steady state
+  double tau;    // s
+  double delay;  // s
+  double kS;     // output friction takes
+  double noise;  // units of sensor noise
+};
+
+// ez::PID::compute() and exit_condition() as default_constants() sets them up
+struct pid_model {
+  double kp, ki, kd, start_i;
+  double small_error;
+  int small_time;
+  double big_error;
+  int big_time;
+  int velocity_time;
+};
+
+const pid_model DRIVE_PID = {20.0, 0.0, 100.0, 0.0, 1.0, 90, 3.0, 250, 500};
+const pid_model TURN_PID = {3.0, 0.05, 20.0, 15.0, 3.0, 90, 7.0, 250, 500};
+
+struct motion {
+  std::uint8_t mode;
+  std::vector<double> error;  // every tick, until the timers exited and 1 s past it
+  int timer_exit = -1;        // tick
+  std::uint8_t how = RUNNING;
+};
+
+// short is how far before the target a wall stops the robot, 0 for none
+motion motion_simulate(std::uint8_t mode, double target, double short_of, const plant& p, const pid_model& g, std::mt19937& rng) {
+  std::normal_distribution<double> unit(0.0, 1.0);
+  motion out;
+  out.mode = mode;
+  int lag = std::max(1, (int)std::lround(p.delay * 1000.0));
+  std::vector<double> line(lag, 0.0);
+  int head = 0;
+  double x = 0.0, v = 0.0, integral = 0.0, previous_sensor = 0.0, previous_error = target;
+  int small = 0, big = 0, still = 0, after = -1;
+  for (int t = 0; t < 5000 && (after < 0 || t < after); t += TICK) {
+    double sensor = x + p.noise * unit(rng);
+    double error = target - sensor;
+    if (g.ki != 0.0) {
+      if (std::fabs(error) < g.start_i) integral += error;
+      if ((error > 0) != (previous_error > 0)) integral = 0.0;
+    }
+    double derivative = previous_sensor - sensor;
+    double output = std::clamp(g.kp * error + g.ki * integral + g.kd * derivative, -127.0, 127.0);
+    previous_sensor = sensor;
+    previous_error = error;
+    out.error.push_back(error);
+
+    if (out.timer_exit < 0) {
+      small = std::fabs(error) < g.small_error ? small + TICK : 0;
+      big = std::fabs(error) < g.big_error ? big + TICK : 0;
+      still = std::fabs(derivative) <= 0.05 ? still + TICK : 0;
+      if (small > g.small_time) out.how = SMALL_EXIT;
+      else if (big > g.big_time) out.how = BIG_EXIT;
+      else if (still > g.velocity_time) out.how = VELOCITY_EXIT;
+      if (out.how != RUNNING) {
+        out.timer_exit = t / TICK;
+        after = t + 1000;  // keeps holding a second past the exit to check predictions against
+      }
+    }
+
+    for (int ms = 0; ms < TICK; ms++) {
+      line[head] = output;
+      head = (head + 1) % lag;
+      double u = line[head];
+      double effective = 0.0;
+      if (std::fabs(v) > 1e-3) effective = u - std::copysign(p.kS, v);
+      else if (std::fabs(u) > p.kS) effective = u - std::copysign(p.kS, u);
+      double next = v + (p.K * effective - v) / p.tau * 0.001;
+      if (std::fabs(v) > 1e-3 && next * v < 0.0) next = 0.0;  // friction stops it, never reverses it
+      v = next;
+      x += v * 0.001;
+      double wall = target - std::copysign(short_of, target);
+      if (short_of > 0.0 && (target > 0.0 ? x > wall : x < wall)) x = wall, v = 0.0;
+    }
+  }
+  return out;
+}
+
+// A made up skills run: turns of 15 to 180 degrees and drives of 4 to 48 inches, on plants that
+// vary a little from motion to motion.  Every fifth drive ends against a wall or goal 1 to 3 in
+// short of its target, the way scoring drives do.
+std::vector<motion> run_make(int motions, unsigned seed) {
+  std::mt19937 rng(seed);
+  std::uniform_real_distribution<double> uniform(0.0, 1.0);
+  std::vector<motion> out;
+  for (int i = 0; i < motions; i++) {
+    double vary = 0.9 + 0.2 * uniform(rng);
+    double sign = uniform(rng) < 0.5 ? -1.0 : 1.0;
+    if (i % 2 == 0) {
+      plant p = {4.0 * vary, 0.10, 0.02, 6.0 + 10.0 * uniform(rng), 0.03};  // ~480 deg/s flat out, IMU noise, sticky sometimes
+      out.push_back(motion_simulate(TURN, sign * (15.0 + 165.0 * uniform(rng)), 0.0, p, TURN_PID, rng));
+    } else {
+      plant p = {0.335 * vary, 0.12, 0.01, 4.0 + 8.0 * uniform(rng), 0.01};  // 42.5 in/s flat out, encoder counts
+      double wall = i % 10 == 9 ? 1.0 + 2.0 * uniform(rng) : 0.0;
+      out.push_back(motion_simulate(DRIVE, sign * (4.0 + 44.0 * uniform(rng)), wall, p, DRIVE_PID, rng));
+    }
+  }
+  return out;
+}
+
+/////
+//
+// Logs
+//
+/////
+
+bool log_read(const char* path, std::vector<log_record>& records) {
+  FILE* file = std::fopen(path, "rb");
+  if (!file) {
+    std::fprintf(stderr, "Could not open %s\n", path);
+    return false;
+  }
+  robot::log_header header;
+  bool ok = std::fread(&header, sizeof(header), 1, file) == 1 && header.magic == robot::LOG_MAGIC && header.version == robot::LOG_VERSION &&
+            header.record_size == sizeof(log_record);
+  if (!ok) std::fprintf(stderr, "%s is not a version %u robot log\n", path, robot::LOG_VERSION);
+  log_record r;
+  while (ok && std::fread(&r, sizeof(r), 1, file) == 1) records.push_back(r);
+  std::fclose(file);
+  return ok;
+}
+
+// Writes motions as robot::pid_wait() would have logged them, the right side of a drive the same as the left
+bool log_write(const char* path, const std::vector<motion>& motions) {
+  FILE* file = std::fopen(path, "wb");
+  if (!file) return false;
+  robot::log_header header;
+  header.record_size = sizeof(log_record);
+  header.period = TICK;
+  std::fwrite(&header, sizeof(header), 1, file);
+  std::uint32_t tick = 0;
+  for (const motion& m : motions) {
+    for (std::size_t i = 0; i < m.error.size(); i++) {
+      log_record r;
+      r.time = tick * TICK;
+      r.tick = tick++;
+      r.mode = m.mode;
+      r.exit = (int)i < m.timer_exit ? RUNNING : m.how;
+      r.primary.error = m.error[i];
+      if (m.mode == DRIVE) r.secondary.error = m.error[i];
+      std::fwrite(&r, sizeof(r), 1, file);
+    }
+  }
+  return std::fclose(file) == 0;
+}
+
+// Cuts a log into motions, each robot::pid_wait() is a run of records with exit RUNNING
+std::vector<motion> motions_get(const std::vector<log_record>& records, std::vector<std::vector<double>>& right) {
+  std::vector<motion> out;
+  for (std::size_t i = 0; i < records.size(); i++) {
+    if (records[i].exit != RUNNING || (i > 0 && records[i - 1].exit == RUNNING)) continue;
+    motion m;
+    m.mode = records[i].mode;
+    std::vector<double> second;
+    std::size_t j = i;
+    for (; j < records.size() && records[j].exit == RUNNING; j++) {
+      m.error.push_back(records[j].primary.error);
+      second.push_back(records[j].secondary.error);
+    }
+    if (j >= records.size()) break;  // the log ended mid motion
+    m.timer_exit = m.error.size();
+    m.how = records[j].exit;
+    // The PID keeps holding after the exit until the next motion, that's what predictions are checked against
+    for (std::size_t k = j; k < records.size() && k < j + 100 && records[k].exit != RUNNING && records[k].mode == m.mode; k++) {
+      m.error.push_back(records[k].primary.error);
+      second.push_back(records[k].secondary.error);
+    }
+    out.push_back(m);
+    right.push_back(second);
+  }
+  return out;
+}
+
+/////
+//
+// Scoring
+//
+/////
+
+struct score {
+  int predicted = -1;  // tick the predictor exits on, -1 if it never does before the timers
+  robot::settle_result how = robot::SETTLE_RUNNING;
+  double error = 0.0;  // at the predicted exit
+  double worst = 0.0;  // largest error from the predicted exit to a second past the timers
+  bool wrong = false;  // the error left its band after the predicted exit, or a stop reached the small band after all
+};
+
+// Runs the predictor over one error stream until the timers exited
+score predict(const std::vector<double>& error, int timer_exit, double small, double big) {
+  robot::settle_predictor predictor;
+  score out;
+  for (int i = 0; i < timer_exit && i < (int)error.size(); i++) {
+    out.how = predictor.update(error[i], small, big);
+    if (out.how != robot::SETTLE_RUNNING) {
+      out.predicted = i;
+      break;
+    }
+  }
+  if (out.predicted < 0) return out;
+  out.error = error[out.predicted];
+  bool reached_small = false;
+  for (int i = out.predicted; i < (int)error.size(); i++) {
+    out.worst = std::max(out.worst, std::fabs(error[i]));
+    if (i <= timer_exit && std::fabs(error[i]) < small) reached_small = true;
+  }
+  out.wrong = out.how == robot::SETTLE_SMALL ? out.worst >= small : (out.worst >= big || reached_small);
+  return out;
+}
+
+const char* how_name(std::uint8_t how) {
+  switch (how) {
+    case SMALL_EXIT: return "small";
+    case BIG_EXIT: return "big";
+    case VELOCITY_EXIT: return "velocity";
+    case 5: return "mA";
+    default: return "?";
+  }
+}
+}  // namespace
+
+int main(int argc, char** argv) {
+  const char* log = nullptr;
+  const char* write = nullptr;
+  int count = 40;
+  unsigned seed = 1;
+  double drive_error = DRIVE_PID.small_error, turn_error = TURN_PID.small_error;
+  for (int i = 1; i < argc; i++) {
+    bool more = i + 1 < argc;
+    if (!std::strcmp(argv[i], "--motions") && more) count = std::atoi(argv[++i]);
+    else if (!std::strcmp(argv[i], "--seed") && more) seed = std::atoi(argv[++i]);
+    else if (!std::strcmp(argv[i], "--write") && more) write = argv[++i];
+    else if (!std::strcmp(argv[i], "--drive-error") && more) drive_error = std::atof(argv[++i]);
+    else if (!std::strcmp(argv[i], "--turn-error") && more) turn_error = std::atof(argv[++i]);
+    else log = argv[i];
+  }
+
+  std::vector<motion> motions;
+  std::vector<std::vector<double>> right;
+  if (log) {
+    std::vector<log_record> records;
+    if (!log_read(log, records)) return 1;
+    motions = motions_get(records, right);
+  } else {
+    motions = run_make(count, seed);
+    for (const motion& m : motions) right.push_back(m.error);
+    if (write && !log_write(write, motions)) return std::fprintf(stderr, "Could not write %s\n", write), 1;
+  }
+
+  std::printf("%3s %-6s %9s %9s %10s %9s %9s %9s\n", "", "mode", "timers ms", "exit", "predicted", "saved ms", "error", "worst");
+  int total_timer = 0, total_saved = 0, early = 0, wrong = 0, considered = 0;
+  for (std::size_t i = 0; i < motions.size(); i++) {
+    const motion& m = motions[i];
+    if (m.mode != DRIVE && m.mode != TURN && m.mode != 1) continue;  // odom motions exit inside EZ-Template
+    considered++;
+    const pid_model& g = m.mode == DRIVE ? DRIVE_PID : TURN_PID;
+    double small = m.mode == DRIVE ? drive_error : turn_error;
+    // A stop short of the small band is only final without an integral to push it the rest of the way
+    double big = g.ki == 0.0 ? g.big_error * small / g.small_error : 0.0;
+    score s = predict(m.error, m.timer_exit, small, big);
+    if (m.mode == DRIVE) {
+      // Both sides have to be predicted settled, the later one decides
+      score r = predict(right[i], m.timer_exit, small, big);
+      if (s.predicted < 0 || r.predicted < 0) {
+        s.predicted = -1;
+      } else {
+        if (r.predicted > s.predicted) s.predicted = r.predicted, s.error = r.error;
+        if (r.how == robot::SETTLE_BIG) s.how = robot::SETTLE_BIG;
+        s.worst = std::max(s.worst, r.worst);
+        s.wrong = s.wrong || r.wrong;
+      }
+    }
+    int timer_ms = m.timer_exit * TICK;
+    total_timer += timer_ms;
+    std::printf("%3zu %-6s %9d %9s", i, m.mode == DRIVE ? "drive" : (m.mode == TURN ? "turn" : "swing"), timer_ms, how_name(m.how));
+    if (s.predicted < 0) {
+      std::printf(" %10s\n", "-");
+      continue;
+    }
+    int saved = timer_ms - s.predicted * TICK;
+    total_saved += saved;
+    early++;
+    if (s.wrong) wrong++;
+    std::printf(" %6d %-3s %9d %9.2f %9.2f%s\n", s.predicted * TICK, s.how == robot::SETTLE_SMALL ? "s" : "b", saved, s.error, s.worst, s.wrong ? "  wrong" : "");
+  }
+
+  std::printf("\n%d motions, %.2f s to exit on the timers, %d exited early by prediction, %.2f s saved (%.0f ms a motion), %d wrong\n", considered,
+              total_timer / 1000.0, early, total_saved / 1000.0, considered ? (double)total_saved / considered : 0.0, wrong);
+  return 0;
+}
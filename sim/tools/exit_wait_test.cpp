@@ -0,0 +1,247 @@
+/*
+This Source Code Form is subject to the terms of the Mozilla Public
+License, v. 2.0. If a copy of the MPL was not distributed with this
+file, You can obtain one at http://mozilla.org/MPL/2.0/.
+*/
+
+// Runs the wait loop behind robot::pid_wait() on the host, without EZ-Template or a chassis.
+//
+// src/exit_condition.cpp is built into this tool on its own, against stand-ins for the few
+// PROS and EZ-Template calls it makes: ez::PID::exit_condition() with EZ's small, big and
+// velocity timers, a clock that pros::Task::delay_until() steps, and a drive_telemetry the
+// test publishes each tick.  Each case checks how robot::exits_wait() ended and that it didn't
+// allocate while waiting.  Exits non-zero if any case fails.
+//
+//   bin/sim/exit_wait_test
+
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <functional>
+#include <new>
+
+#include "../../src/exit_condition.cpp"
+
+// sim/src/alloc.cpp only links into the simulator, so this tool counts its own
+namespace {
+std::size_t allocations = 0;
+}  // namespace
+
+void* operator new(std::size_t size) {
+  allocations++;
+  if (void* p = std::malloc(size ? size : 1)) return p;
+  throw std::bad_alloc();
+}
+void operator delete(void* p) noexcept { std::free(p); }
+void operator delete(void* p, std::size_t) noexcept { std::free(p); }
+
+/////
+//
+// Stand-ins
+//
+/////
+
+namespace {
+std::uint32_t clock_ms = 0;
+std::uint32_t run_start = 0;  // ms, when the current case started waiting
+std::function<void()> tick;       // steps the test's plant once per DELAY_TIME
+std::function<void()> tick_hook;  // whatever else a case does each tick
+}  // namespace
+
+std::uint32_t pros::c::millis() { return clock_ms; }
+void pros::Task::delay_until(std::uint32_t* const prev_time, const std::uint32_t delta) {
+  *prev_time += delta;
+  clock_ms = *prev_time;
+  if (tick) tick();
+  if (tick_hook) tick_hook();
+  if (clock_ms - run_start > 10000) {
+    std::printf("FAIL: never exited\n");
+    std::exit(1);
+  }
+}
+pros::Mutex::Mutex() {}
+bool pros::Mutex::take() { return true; }
+bool pros::Mutex::give() { return true; }
+std::int32_t pros::Motor::is_over_current(const std::uint8_t) const { return 0; }
+std::int32_t pros::usd::is_installed() { return 0; }
+std::uint8_t field_status = COMPETITION_AUTONOMOUS;  // what pros::competition::get_status() returns
+std::uint8_t pros::competition::get_status() { return field_status; }
+
+robot::snapshot<robot::motor_telemetry> robot::drive_telemetry;
+
+// ez::PID's timers as EZ-Template 3.2 runs them
+ez::PID::PID() {}
+ez::exit_output ez::PID::exit_condition(bool) {
+  if (exit.small_error != 0) {
+    if (std::fabs(error) < exit.small_error) {
+      j += ez::util::DELAY_TIME;
+      i = 0;
+      if (j > exit.small_exit_time) {
+        i = j = k = 0;
+        return ez::SMALL_EXIT;
+      }
+    } else {
+      j = 0;
+    }
+  }
+  if (exit.big_error != 0 && exit.big_exit_time != 0) {
+    if (std::fabs(error) < exit.big_error) {
+      i += ez::util::DELAY_TIME;
+      if (i > exit.big_exit_time) {
+        i = j = k = 0;
+        return ez::BIG_EXIT;
+      }
+    } else {
+      i = 0;
+    }
+  }
+  if (exit.velocity_exit_time != 0) {
+    if (std::fabs(derivative) <= velocity_zero_main) {
+      k += ez::util::DELAY_TIME;
+      if (k > exit.velocity_exit_time) {
+        i = j = k = 0;
+        return ez::VELOCITY_EXIT;
+      }
+    } else {
+      k = 0;
+    }
+  }
+  return ez::RUNNING;
+}
+
+/////
+//
+// Cases
+//
+/////
+
+namespace {
+int failures = 0;
+
+void check(bool ok, const char* name, const char* what) {
+  if (!ok) failures++;
+  std::printf("  %s %-34s %s\n", ok ? "ok  " : "FAIL", name, what);
+}
+
+// The chassis' three PIDs with default_constants()' drive and turn exits
+struct chassis_pids {
+  ez::PID left, right, angular;
+  chassis_pids() {
+    for (ez::PID* pid : {&left, &right})
+      pid->exit = {90, 1.0, 250, 3.0, 500, 750};
+    angular.exit = {90, 3.0, 250, 7.0, 500, 750};
+  }
+};
+
+struct motion {
+  double left_error = 24.0, right_error = 24.0, angular_error = 90.0;
+  double decay = 0.85;           // error kept per tick, 1 stalls
+  double floor = 0.0;            // error it stalls at
+  bool left_over = false, right_over = false;
+  std::int32_t current = 900;    // mA every motor reads
+  int resample = 1;              // ticks between telemetry samples, control_loop falling behind
+};
+
+// Steps every error toward its floor and publishes the telemetry for the tick
+void step(chassis_pids& p, const motion& m, double& l, double& r, double& a) {
+  auto move = [&](ez::PID& pid, double& error) {
+    double next = m.floor + (error - m.floor) * m.decay;
+    pid.derivative = error - next;
+    pid.error = error = next;
+  };
+  move(p.left, l);
+  move(p.right, r);
+  move(p.angular, a);
+  if ((clock_ms / ez::util::DELAY_TIME) % m.resample != 0) return;
+  robot::motor_telemetry t;
+  t.left_count = t.right_count = 3;
+  t.current.fill(m.current);
+  t.left_over_current = m.left_over;
+  t.right_over_current = m.right_over;
+  t.time = clock_ms;
+  robot::drive_telemetry.publish(t);
+}
+
+std::uint32_t waited = 0;  // ms the last run() waited
+
+robot::exit_wait_result run(ez::e_mode mode, ez::e_swing swing, const motion& m, std::size_t& allocated) {
+  run_start = clock_ms;
+  chassis_pids p;
+  double l = m.left_error, r = m.right_error, a = m.angular_error;
+  step(p, m, l, r, a);
+  tick = [&] { step(p, m, l, r, a); };
+  robot::pid_exit left(p.left), right(p.right), angular(p.angular);
+  std::size_t before = allocations;
+  robot::exit_wait_result out = robot::exits_wait(mode, swing, left, right, angular, false);
+  allocated = allocations - before;
+  tick = nullptr;
+  waited = clock_ms - run_start;
+  return out;
+}
+
+void cases(robot::exit_mode mode) {
+  robot::exit_mode_set(mode);
+  std::printf("%s\n", mode == robot::EXIT_PREDICTED ? "predicted exits" : "EZ's timers");
+  std::size_t allocated;
+
+  motion settle;
+  auto r = run(ez::DRIVE, ez::LEFT_SWING, settle, allocated);
+  check(r.exit == ez::SMALL_EXIT && !r.interfered, "drive settles", "small exit, not interfered");
+  check(allocated == 0, "drive allocates nothing", "while waiting");
+
+  motion stall;
+  stall.decay = 0.9;
+  stall.floor = 6.0;
+  r = run(ez::DRIVE, ez::LEFT_SWING, stall, allocated);
+  check(r.exit == ez::VELOCITY_EXIT && r.interfered, "drive stalls short", "velocity exit sets interfered");
+
+  motion pushed = stall;
+  pushed.right_over = true;
+  r = run(ez::DRIVE, ez::LEFT_SWING, pushed, allocated);
+  check(r.exit == ez::mA_EXIT && r.interfered, "drive pushed into a wall", "mA exit from the flag");
+  std::uint32_t every_tick = waited;
+
+  motion behind = pushed;
+  behind.resample = 2;
+  r = run(ez::DRIVE, ez::LEFT_SWING, behind, allocated);
+  check(r.exit != ez::mA_EXIT || waited > every_tick, "telemetry sampled every other tick", "a sample isn't counted twice");
+
+  motion hot = stall;
+  hot.current = 2500;
+  r = run(ez::DRIVE, ez::LEFT_SWING, hot, allocated);
+  check(r.exit == ez::VELOCITY_EXIT, "current at the limit, no flag", "not an mA exit");
+
+  r = run(ez::TURN, ez::LEFT_SWING, settle, allocated);
+  check(r.exit == ez::SMALL_EXIT && !r.interfered, "turn settles", "small exit, not interfered");
+  check(allocated == 0, "turn allocates nothing", "while waiting");
+
+  motion swing_stall = stall;
+  swing_stall.floor = 12.0;  // outside the turn exits' big_error
+  motion other_side = swing_stall;
+  other_side.right_over = true;
+  r = run(ez::SWING, ez::LEFT_SWING, other_side, allocated);
+  check(r.exit == ez::VELOCITY_EXIT, "left swing, right side over", "only the swinging side counts");
+
+  motion swinging_side = swing_stall;
+  swinging_side.left_over = true;
+  r = run(ez::SWING, ez::LEFT_SWING, swinging_side, allocated);
+  check(r.exit == ez::mA_EXIT && r.interfered, "left swing, left side over", "mA exit");
+  check(allocated == 0, "swing allocates nothing", "while waiting");
+
+  // The field disables the robot halfway through a stalled drive
+  tick_hook = [] {
+    if (clock_ms - run_start >= 200) field_status = COMPETITION_DISABLED;
+  };
+  r = run(ez::DRIVE, ez::LEFT_SWING, stall, allocated);
+  check(r.aborted && r.exit == ez::RUNNING && waited <= 210, "disabled while waiting", "returns within a tick");
+  field_status = COMPETITION_AUTONOMOUS;
+  tick_hook = nullptr;
+}
+}  // namespace
+
+int main() {
+  cases(robot::EXIT_TIMERS);
+  cases(robot::EXIT_PREDICTED);
+  std::printf(failures ? "\n%d failed\n" : "\nall passed\n", failures);
+  return failures ? 1 : 0;
+}
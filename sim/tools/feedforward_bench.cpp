@@ -0,0 +1,173 @@
+/*
+This Source Code Form is subject to the terms of the Mozilla Public
+License, v. 2.0. If a copy of the MPL was not distributed with this
+file, You can obtain one at http://mozilla.org/MPL/2.0/.
+*/
+
+// Characterizes a simulated drive with robot::feedforward_characterizer from
+// include/feedforward.hpp, then drives 48 inches two ways and compares them:
+//   pid          EZ's drive PID on the distance left (kp 20, kd 100) with its 3 in / 70 slew
+//   feedforward  a trapezoidal profile through the measured kS, kV, kA plus kp 5 on the
+//                distance and 2 on the velocity behind the profile
+//
+// The plant is sim/src/plant.cpp's drive side, first order with a 0.12 s time constant, plus static
+// friction and a right side weaker than the left so there's a kS and a per side difference to
+// find.
+//
+//   bin/sim/feedforward_bench [--friction 6] [--weak 0.93] [--distance 48]
+
+#include <algorithm>
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+
+#include "feedforward.hpp"
+
+using robot::feedforward_gains;
+
+namespace {
+constexpr double FREE_VELOCITY = 600.0 / 2.0 * M_PI * 3.25 / 60.0;  // in/s, the robot in src/main.cpp
+constexpr double TIME_CONSTANT = 0.12;
+constexpr double PLANT_DT = 0.001;
+constexpr double CONTROL_DT = 0.01;
+
+struct side {
+  double strength = 1.0;  // fraction of full torque this side has
+  double friction = 0.0;  // output lost to static friction
+  double velocity = 0.0;
+  double position = 0.0;
+
+  void step(double output) {
+    double effective = 0.0;
+    if (std::fabs(output) > friction) effective = output - std::copysign(friction, output);
+    else if (std::fabs(velocity) > 0.01) effective = output - std::copysign(friction, velocity);
+    double u = std::clamp(effective / 127.0 * strength, -1.0, 1.0);
+    double next = velocity + (u * FREE_VELOCITY - velocity) / TIME_CONSTANT * PLANT_DT;
+    // Friction can stop the robot but not push it backwards
+    if (std::fabs(output) <= friction && next * velocity < 0.0) next = 0.0;
+    velocity = next;
+    position += velocity * PLANT_DT;
+  }
+};
+
+struct drive {
+  side left, right;
+  void step(double l, double r) {
+    for (int i = 0; i < (int)(CONTROL_DT / PLANT_DT + 0.5); i++) {
+      left.step(l);
+      right.step(r);
+    }
+  }
+};
+
+drive drive_make(double friction, double weak) {
+  drive d;
+  d.left.friction = d.right.friction = friction;
+  d.right.strength = weak;
+  return d;
+}
+
+// What the plant really is, in feedforward terms, for one side
+feedforward_gains truth(double friction, double strength) { return {friction, 127.0 / (FREE_VELOCITY * strength), 127.0 * TIME_CONSTANT / (FREE_VELOCITY * strength)}; }
+
+struct result {
+  double settle = -1.0;  // s until within 0.5 in and under 2 in/s for good
+  double overshoot = 0.0;
+  double error_rms = 0.0;    // in, against the profile, feedforward only
+  double heading = 0.0;      // in, left minus right at the end
+};
+
+template <typename Controller>
+result run(drive d, double distance, Controller&& control) {
+  result out;
+  double settled_since = -1.0, sum = 0.0;
+  int n = 0;
+  for (double t = 0.0; t < 5.0; t += CONTROL_DT) {
+    double l, r, profile;
+    control(t, d, l, r, profile);
+    d.step(std::clamp(l, -127.0, 127.0), std::clamp(r, -127.0, 127.0));
+    double position = (d.left.position + d.right.position) / 2.0, velocity = (d.left.velocity + d.right.velocity) / 2.0;
+    out.overshoot = std::max(out.overshoot, position - distance);
+    if (profile >= 0.0) {
+      sum += (profile - position) * (profile - position);
+      n++;
+    }
+    bool inside = std::fabs(distance - position) < 0.5 && std::fabs(velocity) < 2.0;
+    if (inside && settled_since < 0.0) settled_since = t;
+    if (!inside) settled_since = -1.0;
+  }
+  out.settle = settled_since;
+  out.error_rms = n ? std::sqrt(sum / n) : 0.0;
+  out.heading = d.left.position - d.right.position;
+  return out;
+}
+}  // namespace
+
+int main(int argc, char** argv) {
+  double friction = 6.0, weak = 0.93, distance = 48.0;
+  for (int i = 1; i + 1 < argc; i += 2) {
+    if (!std::strcmp(argv[i], "--friction")) friction = std::atof(argv[i + 1]);
+    if (!std::strcmp(argv[i], "--weak")) weak = std::atof(argv[i + 1]);
+    if (!std::strcmp(argv[i], "--distance")) distance = std::atof(argv[i + 1]);
+  }
+
+  // Characterize, reading the velocities the plant had at the start of each tick like telemetry
+  drive d = drive_make(friction, weak);
+  robot::feedforward_characterizer test;
+  double time = 0.0;
+  while (!test.done()) {
+    double output = test.update(CONTROL_DT, d.left.velocity, d.right.velocity);
+    d.step(std::round(output), std::round(output));
+    time += CONTROL_DT;
+  }
+  auto l = robot::feedforward_fit_get(test.left_samples(), CONTROL_DT);
+  auto r = robot::feedforward_fit_get(test.right_samples(), CONTROL_DT);
+  feedforward_gains tl = truth(friction, 1.0), tr = truth(friction, weak);
+  std::printf("characterized in %.1f s\n", time);
+  std::printf("%-8s %8s %8s %8s %8s\n", "", "kS", "kV", "kA", "r2");
+  std::printf("%-8s %8.2f %8.3f %8.4f %8.4f\n", "left", l.gains.kS, l.gains.kV, l.gains.kA, l.r2);
+  std::printf("%-8s %8.2f %8.3f %8.4f\n", "  true", tl.kS, tl.kV, tl.kA);
+  std::printf("%-8s %8.2f %8.3f %8.4f %8.4f\n", "right", r.gains.kS, r.gains.kV, r.gains.kA, r.r2);
+  std::printf("%-8s %8.2f %8.3f %8.4f\n", "  true", tr.kS, tr.kV, tr.kA);
+
+  // EZ's drive PID: kp 20 and kd 100 on the distance left each tick, slewed from 70 for 3 in
+  double last_error = distance;
+  result pid = run(drive_make(friction, weak), distance, [&](double, const drive& d, double& lo, double& ro, double& profile) {
+    double position = (d.left.position + d.right.position) / 2.0;
+    double error = distance - position;
+    double out = 20.0 * error + 100.0 * (error - last_error);
+    last_error = error;
+    double cap = position < 3.0 ? 70.0 : 110.0;
+    lo = ro = std::clamp(out, -cap, cap);
+    profile = -1.0;
+  });
+
+  // Trapezoid at 85% of the weaker side's top speed, accelerating at what 60 output of kA buys
+  double top = 0.85 * FREE_VELOCITY * weak;
+  double accel = 60.0 / std::max(l.gains.kA, r.gains.kA);
+  result ff = run(drive_make(friction, weak), distance, [&](double t, const drive& d, double& lo, double& ro, double& profile) {
+    double ramp = top / accel, cruise = std::max(0.0, distance / top - ramp);
+    if (cruise == 0.0) ramp = std::sqrt(distance / accel);
+    double peak = accel * ramp, end = 2.0 * ramp + cruise;
+    double p, v, a;
+    if (t < ramp) {
+      a = accel, v = accel * t, p = 0.5 * accel * t * t;
+    } else if (t < ramp + cruise) {
+      a = 0.0, v = peak, p = 0.5 * peak * ramp + peak * (t - ramp);
+    } else if (t < end) {
+      double u = end - t;
+      a = -accel, v = accel * u, p = distance - 0.5 * accel * u * u;
+    } else {
+      a = 0.0, v = 0.0, p = distance;
+    }
+    lo = robot::feedforward_output(l.gains, v, a) + 5.0 * (p - d.left.position) + 2.0 * (v - d.left.velocity);
+    ro = robot::feedforward_output(r.gains, v, a) + 5.0 * (p - d.right.position) + 2.0 * (v - d.right.velocity);
+    profile = p;
+  });
+
+  std::printf("\n%.0f in drive   %10s %10s %12s %12s\n", distance, "settled s", "overshoot", "rms vs plan", "left-right");
+  std::printf("%-14s %10.2f %10.2f %12s %12.2f\n", "pid", pid.settle, pid.overshoot, "-", pid.heading);
+  std::printf("%-14s %10.2f %10.2f %12.2f %12.2f\n", "feedforward", ff.settle, ff.overshoot, ff.error_rms, ff.heading);
+  return 0;
+}
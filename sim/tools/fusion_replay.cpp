@@ -0,0 +1,295 @@
+/*
+This Source Code Form is subject to the terms of the Mozilla Public
+License, v. 2.0. If a copy of the MPL was not distributed with this
+file, You can obtain one at http://mozilla.org/MPL/2.0/.
+*/
+
+// Replays robot::pose_filter from include/pose_filter.hpp over a log.
+//
+//   bin/sim/fusion_replay log_000.bin --start x,y,theta [--mount x,y,facing] [--csv out.csv]
+//       reruns the filter on the odometry, distance and GPS inputs robot::chassis_fusion logged,
+//       from the field pose the auton passed to start_set()
+//   bin/sim/fusion_replay [--seconds 60] [--seed 1] [--no-gps] [--no-obstacles] [--write synthetic.bin]
+//                         [--csv out.csv]
+//       makes up a skills run with a known true path: wheels reading 2% long, IMU drift, two
+//       shoves odometry doesn't see, a GPS that drops out and sometimes jumps, and a distance
+//       sensor that sometimes sees a robot instead of the wall, and a goal 4 in off the +x wall.
+//       It's replayed through the same log records as a real run, then scored against the truth.
+//       --write saves it as a log, --no-gps leaves only the distance sensor, like the robot
+//       today, --no-obstacles doesn't tell the filter about the goal.
+//
+// Prints dead reckoning against the fused pose, and how many measurements the gates let through.
+
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <random>
+#include <vector>
+
+#include "log_record.hpp"
+#include "pose_filter.hpp"
+
+using robot::fusion_input;
+using robot::log_record;
+using robot::pose_filter;
+
+namespace {
+constexpr double DEG = M_PI / 180.0;
+
+struct pose {
+  double x = 0.0;
+  double y = 0.0;
+  double theta = 0.0;  // degrees, clockwise from +y
+};
+
+// Moves a pose by one tick of robot frame motion, the same way the filter predicts
+pose advance(pose p, double forward, double right, double turn) {
+  double mid = (p.theta + turn / 2.0) * DEG;
+  p.x += forward * std::sin(mid) + right * std::cos(mid);
+  p.y += forward * std::cos(mid) - right * std::sin(mid);
+  p.theta = std::remainder(p.theta + turn, 360.0);
+  return p;
+}
+
+fusion_input input_get(const log_record& r) {
+  fusion_input in;
+  in.forward = r.odom_forward;
+  in.right = r.odom_right;
+  in.turn = r.odom_turn;
+  in.distance = r.distance;
+  in.gps_x = r.gps_x;
+  in.gps_y = r.gps_y;
+  in.gps_theta = r.gps_theta;
+  in.gps_error = r.gps_error;
+  return in;
+}
+
+bool triple_parse(const char* text, double out[3]) { return std::sscanf(text, "%lf,%lf,%lf", &out[0], &out[1], &out[2]) == 3; }
+
+bool log_read(const char* path, std::vector<log_record>& records) {
+  FILE* file = std::fopen(path, "rb");
+  if (!file) {
+    std::fprintf(stderr, "Could not open %s\n", path);
+    return false;
+  }
+  robot::log_header header;
+  bool ok = std::fread(&header, sizeof(header), 1, file) == 1 && header.magic == robot::LOG_MAGIC && header.version == robot::LOG_VERSION &&
+            header.record_size == sizeof(log_record);
+  if (!ok) std::fprintf(stderr, "%s is not a version %u robot log\n", path, robot::LOG_VERSION);
+  log_record r;
+  while (ok && std::fread(&r, sizeof(r), 1, file) == 1) records.push_back(r);
+  std::fclose(file);
+  return ok;
+}
+
+bool log_write(const char* path, const std::vector<log_record>& records) {
+  FILE* file = std::fopen(path, "wb");
+  if (!file) return false;
+  robot::log_header header;
+  header.record_size = sizeof(log_record);
+  header.period = 10;
+  std::fwrite(&header, sizeof(header), 1, file);
+  std::fwrite(records.data(), sizeof(log_record), records.size(), file);
+  return std::fclose(file) == 0;
+}
+
+// A made up skills run.  Fills records with what the robot would have logged and truth with
+// where it really was every tick.
+struct synthetic {
+  std::vector<log_record> records;
+  std::vector<pose> truth;
+  int gps_outliers = 0;
+  int distance_obstructed = 0;
+  int distance_goal = 0;
+};
+
+// The synthetic run's goal, a box 4 in off the +x wall the sensor can read instead of it
+constexpr robot::field_box GOAL = {62.0, -12.0, 68.0, 12.0};
+
+synthetic synthetic_make(double seconds, unsigned seed, bool gps, const robot::filter_settings& settings, pose start) {
+  std::mt19937 rng(seed);
+  std::normal_distribution<double> unit(0.0, 1.0);
+  std::uniform_real_distribution<double> uniform(0.0, 1.0), place(-54.0, 54.0);
+
+  synthetic out;
+  pose p = start;
+  pose target = {place(rng), place(rng), 0.0};
+  int ticks = seconds * 100;
+  for (int tick = 0; tick < ticks; tick++) {
+    // Turn to face the next point at 300 deg/s, then drive to it at 50 in/s
+    double dx = target.x - p.x, dy = target.y - p.y;
+    double remaining = std::hypot(dx, dy);
+    double error = std::remainder(std::atan2(dx, dy) / DEG - p.theta, 360.0);
+    double forward = 0.0, turn = 0.0;
+    if (remaining < 1.0) {
+      target = {place(rng), place(rng), 0.0};
+    } else if (std::fabs(error) > 2.0) {
+      turn = std::copysign(std::fmin(3.0, std::fabs(error)), error);
+    } else {
+      turn = error;
+      forward = std::fmin(0.5, remaining);
+    }
+
+    // Two shoves from other robots that the wheels never see
+    double shove = (tick == ticks / 3 || tick == 2 * ticks / 3) ? 3.0 : 0.0;
+    pose next = advance(p, forward, shove, turn);
+    out.truth.push_back(next);
+
+    log_record r;
+    r.time = tick * 10;
+    r.tick = tick;
+    r.odom_forward = forward * 1.02 + 0.002 * unit(rng);
+    r.odom_right = 0.0;
+    r.odom_turn = turn * 1.003 + 0.002;
+
+    // Distance sensor on the mount the filter is told about, reading the goal when it's in the
+    // way, and a robot sometimes
+    robot::filter_settings walls = settings;
+    walls.obstacle_count = 0;
+    pose_filter wall;
+    wall.settings_set(walls);
+    wall.reset(next.x, next.y, next.theta);
+    double d = wall.distance_expected();
+    const robot::distance_mount& m = settings.distance;
+    double s = std::sin(next.theta * DEG), c = std::cos(next.theta * DEG), beam = (next.theta + m.facing) * DEG;
+    double goal = robot::filter_detail::ray_box(next.x + m.y_offset * s + m.x_offset * c, next.y + m.y_offset * c - m.x_offset * s, std::sin(beam),
+                                                std::cos(beam), GOAL, 0.0);
+    bool on_goal = d > 0.0 && goal > 0.0 && goal < d;
+    if (on_goal) d = goal;
+    if (d > 0.0 && d < settings.distance_max && tick % 2 == 0) {
+      d = d * (1.0 + 0.01 * unit(rng)) + 0.3 * unit(rng);
+      if (on_goal) {
+        out.distance_goal++;
+      } else if (uniform(rng) < 0.1) {
+        d *= 0.2 + 0.6 * uniform(rng);
+        out.distance_obstructed++;
+      }
+      r.distance = d;
+    }
+
+    // GPS fixes in the first half of every 10 s, when it can see the field strip
+    if (gps && (tick / 500) % 2 == 0 && tick % 5 == 0) {
+      r.gps_x = next.x + 0.8 * unit(rng);
+      r.gps_y = next.y + 0.8 * unit(rng);
+      r.gps_theta = next.theta + unit(rng);
+      r.gps_error = 0.8;
+      if (uniform(rng) < 0.03) {
+        r.gps_x += 15.0 + 15.0 * uniform(rng);
+        out.gps_outliers++;
+      }
+    }
+    out.records.push_back(r);
+    p = next;
+  }
+  return out;
+}
+
+struct error_stats {
+  double sum = 0.0;
+  double max = 0.0;
+  double last = 0.0;
+  int count = 0;
+  void add(double e) {
+    sum += e * e;
+    max = std::fmax(max, e);
+    last = e;
+    count++;
+  }
+  double rms() const { return count ? std::sqrt(sum / count) : 0.0; }
+};
+}  // namespace
+
+int main(int argc, char** argv) {
+  const char* log = nullptr;
+  const char* csv = nullptr;
+  const char* write = nullptr;
+  double seconds = 60.0;
+  unsigned seed = 1;
+  bool gps = true;
+  double start[3] = {-48.0, -48.0, 0.0};
+  robot::filter_settings settings;
+  settings.distance = {0.0, -6.0, 180.0};  // DIST_SENSOR_MOUNT in include/subsystems.hpp
+  bool obstacles = true;
+
+  for (int i = 1; i < argc; i++) {
+    bool more = i + 1 < argc;
+    if (!std::strcmp(argv[i], "--start") && more) {
+      if (!triple_parse(argv[++i], start)) return std::fprintf(stderr, "--start wants x,y,theta\n"), 1;
+    } else if (!std::strcmp(argv[i], "--mount") && more) {
+      double m[3];
+      if (!triple_parse(argv[++i], m)) return std::fprintf(stderr, "--mount wants x_offset,y_offset,facing\n"), 1;
+      settings.distance = {m[0], m[1], m[2]};
+    } else if (!std::strcmp(argv[i], "--csv") && more) {
+      csv = argv[++i];
+    } else if (!std::strcmp(argv[i], "--write") && more) {
+      write = argv[++i];
+    } else if (!std::strcmp(argv[i], "--seconds") && more) {
+      seconds = std::atof(argv[++i]);
+    } else if (!std::strcmp(argv[i], "--no-gps")) {
+      gps = false;
+    } else if (!std::strcmp(argv[i], "--no-obstacles")) {
+      obstacles = false;
+    } else if (!std::strcmp(argv[i], "--seed") && more) {
+      seed = std::atoi(argv[++i]);
+    } else {
+      log = argv[i];
+    }
+  }
+
+  if (!log && obstacles) settings.obstacles[settings.obstacle_count++] = GOAL;
+
+  std::vector<log_record> records;
+  synthetic made;
+  if (log) {
+    if (!log_read(log, records)) return 1;
+  } else {
+    made = synthetic_make(seconds, seed, gps, settings, {start[0], start[1], start[2]});
+    records = made.records;
+    if (write && !log_write(write, records)) return std::fprintf(stderr, "Could not write %s\n", write), 1;
+  }
+
+  pose_filter filter;
+  filter.settings_set(settings);
+  filter.reset(start[0], start[1], start[2]);
+  pose dead = {start[0], start[1], start[2]};
+  error_stats dead_error, fused_error;
+  double divergence = 0.0;
+
+  FILE* out = csv ? std::fopen(csv, "w") : nullptr;
+  if (out) std::fprintf(out, "time,odom_x,odom_y,fused_x,fused_y,fused_theta,sigma%s\n", made.truth.empty() ? "" : ",true_x,true_y");
+  for (std::size_t i = 0; i < records.size(); i++) {
+    fusion_input in = input_get(records[i]);
+    dead = advance(dead, in.forward, in.right, in.turn);
+    filter.update(in);
+    divergence = std::fmax(divergence, std::hypot(filter.x_get() - dead.x, filter.y_get() - dead.y));
+    if (!made.truth.empty()) {
+      const pose& t = made.truth[i];
+      dead_error.add(std::hypot(dead.x - t.x, dead.y - t.y));
+      fused_error.add(std::hypot(filter.x_get() - t.x, filter.y_get() - t.y));
+    }
+    if (out) {
+      std::fprintf(out, "%u,%.3f,%.3f,%.3f,%.3f,%.2f,%.3f", records[i].time, dead.x, dead.y, filter.x_get(), filter.y_get(), filter.theta_get(), filter.sigma_xy_get());
+      if (!made.truth.empty()) std::fprintf(out, ",%.3f,%.3f", made.truth[i].x, made.truth[i].y);
+      std::fprintf(out, "\n");
+    }
+  }
+  if (out) std::fclose(out);
+
+  const auto& s = filter.stats_get();
+  std::printf("%zu ticks, %.1f s%s\n", records.size(), records.size() / 100.0, log ? "" : ", synthetic");
+  if (!made.truth.empty()) {
+    std::printf("%-12s %10s %10s %10s\n", "inches", "final", "rms", "max");
+    std::printf("%-12s %10.2f %10.2f %10.2f\n", "odometry", dead_error.last, dead_error.rms(), dead_error.max);
+    std::printf("%-12s %10.2f %10.2f %10.2f\n", "fused", fused_error.last, fused_error.rms(), fused_error.max);
+  } else {
+    std::printf("odometry ends at (%.2f, %.2f, %.2f), fused at (%.2f, %.2f, %.2f), %.2f in apart at most\n", dead.x, dead.y, dead.theta, filter.x_get(),
+                filter.y_get(), filter.theta_get(), divergence);
+  }
+  std::printf("gps      %6d accepted %6d rejected", s.gps_accepted, s.gps_rejected);
+  if (!log) std::printf(" (%d outliers made)", made.gps_outliers);
+  std::printf("\ndistance %6d accepted %6d rejected", s.distance_accepted, s.distance_rejected);
+  if (!log) std::printf(" (%d obstructed, %d off the goal made)", made.distance_obstructed, made.distance_goal);
+  std::printf("\n");
+  return 0;
+}
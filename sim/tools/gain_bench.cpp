@@ -0,0 +1,173 @@
+/*
+This Source Code Form is subject to the terms of the Mozilla Public
+License, v. 2.0. If a copy of the MPL was not distributed with this
+file, You can obtain one at http://mozilla.org/MPL/2.0/.
+*/
+
+// Tunes turn gains at every point of a robot::gain_schedule and checks the schedule against one
+// set of constants tuned at 12.6 V, full speed and empty.
+//
+// The plant is the simulator's drive turning in place: outputs are millivolts clipped at the
+// battery, which sags under load through its internal resistance, and a payload makes the robot
+// slower to respond and stickier.  Each point is tuned by a grid search over kp and kd, scored on
+// the time to EZ's turn exits (90 ms within 3 deg, 250 ms within 7 deg, 500 ms stopped) over
+// 30 to 180 degree turns, with every degree of overshoot costing 100 ms and 200 ms past 1.  A
+// free degree let each point buy a few ms with overshoot the points in between then went past,
+// so slower turns overshot more than with the fixed constants.  The check runs the same turns at
+// the schedule's points and between them.
+//
+//   bin/sim/gain_bench [--resistance 0.1] [--ki 0.05] [--start-i 15]
+//
+// Prints the table to paste into initialize() and a fixed against scheduled comparison.
+
+#include <algorithm>
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+
+#include "gain_schedule.hpp"
+
+using robot::gain_schedule;
+using robot::pid_gains;
+
+namespace {
+constexpr double FREE_VELOCITY = 600.0 / 2.0 * M_PI * 3.25 / 60.0;  // in/s, the robot in src/main.cpp
+constexpr double HALF_WIDTH = 11.5 / 2.0;
+constexpr double FREE_TURN = FREE_VELOCITY / HALF_WIDTH * 180.0 / M_PI;  // deg/s
+constexpr double STALL_CURRENT = 2.5;  // A per motor, sim::drive_config
+constexpr int MOTORS = 6;
+constexpr double PLANT_DT = 0.001;
+constexpr int TICK_MS = 10;  // ez::util::DELAY_TIME
+constexpr double TURNS[] = {30.0, 60.0, 90.0, 135.0, 180.0};
+
+struct condition {
+  double speed;    // 0 to 127
+  double voltage;  // V, battery at rest
+  bool loaded;
+};
+
+struct result {
+  double time = 0.0;       // s to exit, summed over TURNS
+  double overshoot = 0.0;  // deg, worst
+  double score = 0.0;
+};
+
+double resistance = 0.1;  // ohms, battery and wiring
+
+// One turn with EZ's PID::compute() and exit_condition(), returns seconds to exit
+double turn(const condition& c, const pid_gains& g, double target, double& overshoot) {
+  double tau = c.loaded ? 0.17 : 0.12, friction = c.loaded ? 9.0 : 6.0;  // output units
+  double angle = 0.0, velocity = 0.0, integral = 0.0, previous = 0.0;
+  int small = 0, big = 0, still = 0;
+  double last = 0.0;
+  overshoot = 0.0;
+  for (int ms = 0; ms < 4000; ms += TICK_MS) {
+    double error = target - angle;
+    if (g.ki != 0.0 && (std::fabs(error) < g.start_i || g.start_i == 0.0)) integral += error;
+    if (error * (target - previous) < 0.0) integral = 0.0;  // EZ resets the integral when the error crosses 0
+    double output = g.kp * error + g.ki * integral + g.kd * (previous - angle);
+    previous = angle;
+    output = std::clamp(output, -c.speed, c.speed);
+
+    small = std::fabs(error) < 3.0 ? small + TICK_MS : 0;
+    big = std::fabs(error) < 7.0 ? big + TICK_MS : 0;
+    still = std::fabs(angle - last) < 0.05 ? still + TICK_MS : 0;
+    last = angle;
+    if (small > 90 || big > 250 || still > 500) return ms / 1000.0;
+
+    for (int i = 0; i < TICK_MS; i++) {
+      // The battery sags with the current the motors draw, and outputs past it are clipped
+      double command = output / 127.0 * 12.0;
+      double slip = std::fabs(command / 12.0 - velocity / FREE_TURN);
+      double battery = c.voltage - resistance * STALL_CURRENT * MOTORS * slip;
+      double applied = std::clamp(command, -battery, battery) / 12.0 * 127.0;
+      double effective = 0.0;
+      if (std::fabs(velocity) > 0.5) effective = applied - std::copysign(friction, velocity);
+      else if (std::fabs(applied) > friction) effective = applied - std::copysign(friction, applied);
+      double next = velocity + (effective / 127.0 * FREE_TURN - velocity) / tau * PLANT_DT;
+      if (std::fabs(applied) <= friction && next * velocity < 0.0) next = 0.0;
+      velocity = next;
+      angle += velocity * PLANT_DT;
+    }
+    overshoot = std::max(overshoot, angle - target);
+  }
+  return 4.0;
+}
+
+result run(const condition& c, const pid_gains& g) {
+  result out;
+  for (double target : TURNS) {
+    double over;
+    out.time += turn(c, g, target, over);
+    out.overshoot = std::max(out.overshoot, over);
+  }
+  out.score = out.time + 0.1 * out.overshoot + 0.1 * std::max(0.0, out.overshoot - 1.0);
+  return out;
+}
+
+pid_gains tune(const condition& c, double ki, double start_i) {
+  pid_gains best{3.0, ki, 20.0, start_i};
+  double best_score = run(c, best).score;
+  for (double kp = 1.0; kp <= 12.0; kp += 0.25) {
+    for (double kd = 0.0; kd <= 100.0; kd += 2.0) {
+      pid_gains g{kp, ki, kd, start_i};
+      double score = run(c, g).score;
+      if (score < best_score) {
+        best_score = score;
+        best = g;
+      }
+    }
+  }
+  return best;
+}
+
+void print(const result& r) { std::printf(" %8.2f %6.1f  ", r.time, r.overshoot); }
+}  // namespace
+
+int main(int argc, char** argv) {
+  double ki = 0.05, start_i = 15.0;
+  for (int i = 1; i < argc; i++) {
+    bool more = i + 1 < argc;
+    if (!std::strcmp(argv[i], "--resistance") && more) resistance = std::atof(argv[++i]);
+    else if (!std::strcmp(argv[i], "--ki") && more) ki = std::atof(argv[++i]);
+    else if (!std::strcmp(argv[i], "--start-i") && more) start_i = std::atof(argv[++i]);
+  }
+
+  const robot::schedule_axis speeds{60.0, 127.0, 2}, voltages{11.8, 12.6, 2};
+  gain_schedule schedule(speeds, voltages);
+  pid_gains fixed{};
+  std::printf("// robot::gain_schedule turn({%g, %g, %d}, {%g, %g, %d});\n", speeds.first, speeds.last, speeds.points, voltages.first, voltages.last,
+              voltages.points);
+  for (int loaded = 0; loaded < 2; loaded++) {
+    for (int v = 0; v < voltages.points; v++) {
+      for (int s = 0; s < speeds.points; s++) {
+        condition c{speeds.first + (speeds.last - speeds.first) * s / (speeds.points - 1), voltages.first + (voltages.last - voltages.first) * v / (voltages.points - 1),
+                    loaded == 1};
+        pid_gains g = tune(c, ki, start_i);
+        schedule.set(s, v, g, loaded == 1);
+        if (!loaded && s == speeds.points - 1 && v == voltages.points - 1) fixed = g;
+        std::printf("// turn.set(%d, %d, {%g, %g, %g, %g}%s);  // %.0f speed, %.1f V%s\n", s, v, g.kp, g.ki, g.kd, g.start_i, loaded ? ", true" : "", c.speed,
+                    c.voltage, loaded ? ", loaded" : "");
+      }
+    }
+  }
+
+  std::printf("\nfixed is kp %g kd %g, tuned at 127 speed, 12.6 V, empty.  Times are summed over", fixed.kp, fixed.kd);
+  for (double t : TURNS) std::printf(" %g", t);
+  std::printf(" deg turns\n\n speed  volts  payload     fixed s   over       sched s   over\n");
+  const condition checks[] = {{127, 12.6, false}, {127, 11.8, false}, {127, 12.2, false}, {90, 12.2, false}, {60, 11.8, false},
+                              {127, 12.6, true},  {127, 11.8, true},  {90, 12.2, true},   {60, 11.8, true}};
+  double totals[2] = {};
+  for (const condition& c : checks) {
+    result a = run(c, fixed), b = run(c, schedule.get(c.speed, c.voltage, c.loaded));
+    std::printf(" %5.0f  %5.1f  %7s  ", c.speed, c.voltage, c.loaded ? "yes" : "no");
+    print(a);
+    print(b);
+    std::printf("\n");
+    totals[0] += a.score;
+    totals[1] += b.score;
+  }
+  std::printf("\nscore (time plus overshoot penalty): fixed %.2f, scheduled %.2f\n", totals[0], totals[1]);
+  return 0;
+}
@@ -0,0 +1,179 @@
+/*
+This Source Code Form is subject to the terms of the Mozilla Public
+License, v. 2.0. If a copy of the MPL was not distributed with this
+file, You can obtain one at http://mozilla.org/MPL/2.0/.
+*/
+
+// Decodes the binary logs robot::recorder writes to /usd.
+//
+//   bin/sim/log_decode log_000.bin [--csv out.csv] [--columns out.col] [--tune prefix]
+//
+// --csv      one row per record, every field
+// --columns  columnar file: a header naming each column, then each column stored contiguously
+//            as little endian float32 / uint32, so one signal can be read without the rest
+// --tune     prefix_drive.csv, prefix_turn.csv and prefix_swing.csv with time,target,position,output
+//            of the primary PID, the input bin/sim/tune wants
+
+#include <cstdio>
+#include <cstring>
+#include <functional>
+#include <string>
+#include <vector>
+
+#include "log_record.hpp"
+
+using robot::log_record;
+
+namespace {
+struct column {
+  std::string name;
+  char type;  // 'f' float32, 'u' uint32
+  std::function<double(const log_record&)> get;
+};
+
+std::vector<column> columns_get() {
+  std::vector<column> out = {
+      {"time", 'u', [](const log_record& r) { return r.time; }},
+      {"tick", 'u', [](const log_record& r) { return r.tick; }},
+      {"x", 'f', [](const log_record& r) { return r.x; }},
+      {"y", 'f', [](const log_record& r) { return r.y; }},
+      {"theta", 'f', [](const log_record& r) { return r.theta; }},
+      {"velocity", 'f', [](const log_record& r) { return r.velocity; }},
+  };
+
+  // Both PIDs have the same six float terms, in this order
+  const char* terms[] = {"target", "current", "error", "output", "integral", "derivative"};
+  for (int which = 0; which < 2; which++) {
+    for (int term = 0; term < 6; term++) {
+      out.push_back({std::string(which == 0 ? "primary_" : "secondary_") + terms[term], 'f', [which, term](const log_record& r) {
+                       const float* t = &(which == 0 ? r.primary : r.secondary).target;
+                       return (double)t[term];
+                     }});
+    }
+  }
+  for (int i = 0; i < 6; i++) out.push_back({"current_" + std::to_string(i), 'f', [i](const log_record& r) { return r.current[i]; }});
+  out.push_back({"mode", 'u', [](const log_record& r) { return r.mode; }});
+  out.push_back({"exit", 'u', [](const log_record& r) { return r.exit; }});
+  out.push_back({"dropped", 'u', [](const log_record& r) { return r.dropped; }});
+  out.push_back({"odom_forward", 'f', [](const log_record& r) { return r.odom_forward; }});
+  out.push_back({"odom_right", 'f', [](const log_record& r) { return r.odom_right; }});
+  out.push_back({"odom_turn", 'f', [](const log_record& r) { return r.odom_turn; }});
+  out.push_back({"distance", 'f', [](const log_record& r) { return r.distance; }});
+  out.push_back({"gps_x", 'f', [](const log_record& r) { return r.gps_x; }});
+  out.push_back({"gps_y", 'f', [](const log_record& r) { return r.gps_y; }});
+  out.push_back({"gps_theta", 'f', [](const log_record& r) { return r.gps_theta; }});
+  out.push_back({"gps_error", 'f', [](const log_record& r) { return r.gps_error; }});
+  return out;
+}
+
+bool log_read(const char* path, robot::log_header& header, std::vector<log_record>& records) {
+  FILE* file = std::fopen(path, "rb");
+  if (!file) {
+    std::fprintf(stderr, "Could not open %s\n", path);
+    return false;
+  }
+  bool ok = std::fread(&header, sizeof(header), 1, file) == 1 && header.magic == robot::LOG_MAGIC;
+  if (!ok) {
+    std::fprintf(stderr, "%s is not a robot log\n", path);
+  } else if (header.version != robot::LOG_VERSION || header.record_size != sizeof(log_record)) {
+    std::fprintf(stderr, "%s is log version %u with %u byte records, this decoder reads version %u with %zu byte records\n", path,
+                 header.version, header.record_size, robot::LOG_VERSION, sizeof(log_record));
+    ok = false;
+  } else {
+    log_record r;
+    while (std::fread(&r, sizeof(r), 1, file) == 1) records.push_back(r);
+  }
+  std::fclose(file);
+  return ok;
+}
+
+void csv_write(const char* path, const std::vector<log_record>& records) {
+  FILE* out = std::fopen(path, "w");
+  auto columns = columns_get();
+  for (size_t i = 0; i < columns.size(); i++) std::fprintf(out, "%s%s", i ? "," : "", columns[i].name.c_str());
+  std::fprintf(out, "\n");
+  for (const auto& r : records) {
+    for (size_t i = 0; i < columns.size(); i++) std::fprintf(out, columns[i].type == 'u' ? "%s%.0f" : "%s%.6g", i ? "," : "", columns[i].get(r));
+    std::fprintf(out, "\n");
+  }
+  std::fclose(out);
+}
+
+// "COLS", column count, row count, then per column: name length, name, type, and the data
+// of every column back to back in the same order
+void columns_write(const char* path, const std::vector<log_record>& records) {
+  FILE* out = std::fopen(path, "wb");
+  auto columns = columns_get();
+  std::uint32_t count = columns.size(), rows = records.size();
+  std::fwrite("COLS", 1, 4, out);
+  std::fwrite(&count, sizeof(count), 1, out);
+  std::fwrite(&rows, sizeof(rows), 1, out);
+  for (size_t i = 0; i < columns.size(); i++) {
+    std::uint8_t length = columns[i].name.size();
+    std::fwrite(&length, 1, 1, out);
+    std::fwrite(columns[i].name.data(), 1, length, out);
+    std::fwrite(&columns[i].type, 1, 1, out);
+  }
+  for (const auto& c : columns) {
+    for (const auto& r : records) {
+      if (c.type == 'u') {
+        std::uint32_t value = c.get(r);
+        std::fwrite(&value, sizeof(value), 1, out);
+      } else {
+        float value = c.get(r);
+        std::fwrite(&value, sizeof(value), 1, out);
+      }
+    }
+  }
+  std::fclose(out);
+}
+
+// One file per motion type, modes are ez::e_mode
+void tune_write(const std::string& prefix, const std::vector<log_record>& records) {
+  const std::pair<const char*, int> modes[] = {{"drive", 4}, {"turn", 2}, {"swing", 1}};
+  for (auto [name, mode] : modes) {
+    std::string path = prefix + "_" + name + ".csv";
+    FILE* out = nullptr;
+    for (const auto& r : records) {
+      if (r.mode != mode) continue;
+      if (!out) {
+        out = std::fopen(path.c_str(), "w");
+        std::fprintf(out, "time,target,position,output\n");
+      }
+      std::fprintf(out, "%u,%.6g,%.6g,%.6g\n", r.time, r.primary.target, r.primary.current, r.primary.output);
+    }
+    if (out) {
+      std::fclose(out);
+      std::printf("wrote %s\n", path.c_str());
+    }
+  }
+}
+}  // namespace
+
+int main(int argc, char** argv) {
+  if (argc < 2) {
+    std::fprintf(stderr, "usage: log_decode log.bin [--csv out.csv] [--columns out.col] [--tune prefix]\n");
+    return 1;
+  }
+
+  robot::log_header header;
+  std::vector<log_record> records;
+  if (!log_read(argv[1], header, records)) return 1;
+
+  std::uint32_t dropped = 0;
+  for (const auto& r : records) dropped += r.dropped;
+  double seconds = records.empty() ? 0.0 : (records.back().time - records.front().time) / 1000.0;
+  std::printf("%zu records over %.2f s (%u ms period), %u dropped\n", records.size(), seconds, header.period, dropped);
+
+  for (int i = 2; i + 1 < argc; i += 2) {
+    if (!std::strcmp(argv[i], "--csv"))
+      csv_write(argv[i + 1], records);
+    else if (!std::strcmp(argv[i], "--columns"))
+      columns_write(argv[i + 1], records);
+    else if (!std::strcmp(argv[i], "--tune"))
+      tune_write(argv[i + 1], records);
+    else
+      std::fprintf(stderr, "Unknown argument %s\n", argv[i]);
+  }
+  return 0;
+}
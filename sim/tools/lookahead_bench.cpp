@@ -0,0 +1,131 @@
+/*
+This Source Code Form is subject to the terms of the Mozilla Public
+License, v. 2.0. If a copy of the MPL was not distributed with this
+file, You can obtain one at http://mozilla.org/MPL/2.0/.
+*/
+
+// Benchmarks the pure pursuit lookahead search.
+//
+// Drives a point along 50, 500 and 5000 point paths at 0.5 in spacing, 60 in/s and 10 ms ticks,
+// finding the lookahead point every tick two ways: a full search over every segment followed by
+// a circle intersection (what a plain pure pursuit does), and robot::path_cursor.
+//
+//   bin/sim/lookahead_bench [--repeat N]
+
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <vector>
+
+#include "path_cursor.hpp"
+
+using robot::cursor_point;
+
+namespace {
+constexpr double SPACING = 0.5;
+constexpr double LOOKAHEAD = 12.0;
+constexpr double STEP = 0.6;  // inches per 10 ms tick at 60 in/s
+
+// A long S curve, so the closest segment is never trivially the last one
+std::vector<cursor_point> path_make(int count) {
+  std::vector<cursor_point> path;
+  double x = 0.0, y = 0.0, heading = 0.0;
+  for (int i = 0; i < count; i++) {
+    path.push_back({x, y});
+    heading = 0.8 * std::sin(i * SPACING / 40.0);
+    x += SPACING * std::sin(heading);
+    y += SPACING * std::cos(heading);
+  }
+  return path;
+}
+
+// Closest segment over the whole path, then the first circle intersection past it
+cursor_point full_search(const std::vector<cursor_point>& path, double x, double y) {
+  std::size_t closest = 0;
+  double best = 1e18;
+  for (std::size_t i = 0; i + 1 < path.size(); i++) {
+    double dx = path[i + 1].x - path[i].x, dy = path[i + 1].y - path[i].y;
+    double t = ((x - path[i].x) * dx + (y - path[i].y) * dy) / (dx * dx + dy * dy);
+    t = t < 0.0 ? 0.0 : t > 1.0 ? 1.0
+                                : t;
+    double d = std::hypot(x - (path[i].x + dx * t), y - (path[i].y + dy * t));
+    if (d < best) {
+      best = d;
+      closest = i;
+    }
+  }
+  for (std::size_t i = closest; i + 1 < path.size(); i++) {
+    double dx = path[i + 1].x - path[i].x, dy = path[i + 1].y - path[i].y;
+    double fx = path[i].x - x, fy = path[i].y - y;
+    double a = dx * dx + dy * dy, b = 2.0 * (fx * dx + fy * dy), c = fx * fx + fy * fy - LOOKAHEAD * LOOKAHEAD;
+    double disc = b * b - 4.0 * a * c;
+    if (disc < 0.0) continue;
+    double t = (-b + std::sqrt(disc)) / (2.0 * a);
+    if (t >= 0.0 && t <= 1.0) return {path[i].x + dx * t, path[i].y + dy * t};
+  }
+  return path.back();
+}
+
+// Robot positions along the path, 0.3 in to one side
+std::vector<cursor_point> positions_make(const std::vector<cursor_point>& path) {
+  robot::path_cursor walk;
+  walk.reset(path.data(), path.size());
+  std::vector<cursor_point> out;
+  for (double s = 0.0; s < walk.length(); s += STEP) {
+    cursor_point p = walk.point_at(s);
+    out.push_back({p.x + 0.3, p.y});
+  }
+  return out;
+}
+
+volatile double sink;  // keeps the optimiser from dropping the search
+
+// Average ns per tick over a whole run, start() runs untimed before each one
+template <typename S, typename F>
+double run(const std::vector<cursor_point>& positions, int repeat, S&& start, F&& search) {
+  using clock = std::chrono::steady_clock;
+  double total = 0.0;
+  for (int k = 0; k < repeat; k++) {
+    start();
+    double sum = 0.0;
+    auto begin = clock::now();
+    for (const auto& p : positions) {
+      cursor_point target = search(p);
+      sum += target.x + target.y;
+    }
+    total += std::chrono::duration<double, std::nano>(clock::now() - begin).count();
+    sink = sum;
+  }
+  return total / (repeat * positions.size());
+}
+}  // namespace
+
+int main(int argc, char** argv) {
+  int repeat = 20;
+  for (int i = 1; i + 1 < argc; i += 2)
+    if (!std::strcmp(argv[i], "--repeat")) repeat = std::atoi(argv[i + 1]);
+
+  std::printf("%8s %8s %16s %16s %9s %14s\n", "points", "ticks", "full ns/tick", "cursor ns/tick", "speedup", "max gap (in)");
+  for (int count : {50, 500, 5000}) {
+    std::vector<cursor_point> path = path_make(count);
+    std::vector<cursor_point> positions = positions_make(path);
+    robot::path_cursor cursor;
+
+    double full = run(positions, repeat, [] {}, [&](cursor_point p) { return full_search(path, p.x, p.y); });
+    double fast = run(positions, repeat, [&] { cursor.reset(path.data(), path.size()); }, [&](cursor_point p) { return cursor.update(p.x, p.y, LOOKAHEAD); });
+
+    // How far apart the two lookahead points get, arc length and circle intersection differ on curves
+    double gap = 0.0;
+    cursor.reset(path.data(), path.size());
+    for (const auto& p : positions) {
+      cursor_point a = full_search(path, p.x, p.y), b = cursor.update(p.x, p.y, LOOKAHEAD);
+      gap = std::max(gap, std::hypot(a.x - b.x, a.y - b.y));
+    }
+
+    std::printf("%8d %8zu %16.1f %16.1f %8.1fx %14.2f\n", count, positions.size(), full, fast, full / fast, gap);
+  }
+  return 0;
+}
@@ -0,0 +1,260 @@
+/*
+This Source Code Form is subject to the terms of the Mozilla Public
+License, v. 2.0. If a copy of the MPL was not distributed with this
+file, You can obtain one at http://mozilla.org/MPL/2.0/.
+*/
+
+// Times straight drives to their exit conditions three ways:
+//   slew + pid   chassis.pid_drive_set(), EZ's drive PID per side (kp 20, kd 100) against the step
+//                target, speed slewed up from 70 over the first 3 in, plus the heading PID
+//   trapezoid    robot::chassis_profile.pid_drive_set() with PROFILE_TRAPEZOID, feedforward on
+//                the profile from include/motion_profile.hpp, the same PIDs on the error from it
+//   s-curve      the same with PROFILE_S_CURVE
+//
+// Every run uses default_constants()'s drive exit conditions (90 ms within 1 in, 250 ms within
+// 3 in, 500 ms stopped) and is timed from the motion starting to both sides exiting.  The plant is
+// feedforward_bench's, first order with static friction and a right side weaker than the left,
+// and the feedforward is its true kS, kV and kA, what the Characterize auton measures to ~1%.
+// The tires grip up to --traction, past that the wheels slip and the encoders the PIDs read run
+// ahead of the robot, so errors are where the robot really ended up.
+//
+//   bin/sim/motion_profile_bench [--speed 110] [--accel 170] [--jerk 8000] [--traction 200]
+//                                [--friction 6] [--weak 0.93] [distance ...]
+//
+// Distances default to the drives in LEFT_SIDE_AWP.
+
+#include <algorithm>
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <vector>
+
+#include "feedforward.hpp"
+#include "motion_profile.hpp"
+
+using robot::feedforward_gains;
+
+namespace {
+constexpr double FREE_VELOCITY = 600.0 / 2.0 * M_PI * 3.25 / 60.0;  // in/s, the robot in src/main.cpp
+constexpr double TIME_CONSTANT = 0.12;
+constexpr double PLANT_DT = 0.001;
+constexpr double TICK = 0.01;  // ez::util::DELAY_TIME
+constexpr double WIDTH = 11.5;
+constexpr double DEG = 180.0 / M_PI;
+
+// One side of feedforward_bench's plant, plus traction.  While the motors ask for more acceleration
+// than the tires can give, the wheels spin (or lock) against the carpet: the chassis only changes
+// speed at the traction limit and the encoders, which EZ's PIDs read, run ahead of it.
+struct side {
+  double strength = 1.0;
+  double friction = 0.0;
+  double traction = 1e9;  // in/s^2
+  double velocity = 0.0;  // in/s, of the wheel
+  double position = 0.0;  // in, what the encoders read
+  double ground_velocity = 0.0;
+  double ground = 0.0;    // in, where this side really is
+  bool slipping = false;
+
+  void step(double output) {
+    // Friction opposes the motion, or holds the robot still until the output beats it
+    double effective = 0.0;
+    if (std::fabs(velocity) > 0.01) effective = output - std::copysign(friction, velocity);
+    else if (std::fabs(output) > friction) effective = output - std::copysign(friction, output);
+    double u = std::clamp(effective / 127.0 * strength, -1.0, 1.0);
+    double accel = (u * FREE_VELOCITY - velocity) / TIME_CONSTANT;
+    if (!slipping && std::fabs(accel) > traction) slipping = true;
+    double next;
+    if (!slipping) {
+      next = velocity + accel * PLANT_DT;
+    } else {
+      // Unloaded, the wheel reaches the motor's speed much quicker, the chassis follows at the limit
+      next = velocity + accel * 4.0 * PLANT_DT;
+      double gap = next - ground_velocity;
+      ground_velocity += std::copysign(std::fmin(std::fabs(gap), traction * PLANT_DT), gap);
+      if (std::fabs(next - ground_velocity) < 0.5) {
+        slipping = false;
+        next = ground_velocity;
+      }
+    }
+    if (std::fabs(output) <= friction && next * velocity < 0.0) next = 0.0;
+    velocity = next;
+    if (!slipping) ground_velocity = velocity;
+    position += velocity * PLANT_DT;
+    ground += ground_velocity * PLANT_DT;
+  }
+};
+
+struct drive {
+  side left, right;
+  double heading() const { return (left.ground - right.ground) / WIDTH * DEG; }  // degrees clockwise, the IMU sees the real turn
+};
+
+// ez::PID::compute(), derivative on the measurement so a moving target doesn't kick it
+struct pid {
+  double kp, kd;
+  double previous = 0.0;
+  bool first = true;
+  double compute(double error, double current) {
+    double derivative = first ? 0.0 : previous - current;
+    first = false;
+    previous = current;
+    return kp * error + kd * derivative;
+  }
+};
+
+// ez::PID::exit_condition() with default_constants()'s drive exits
+struct exit_timer {
+  int small = 0, big = 0, still = 0;
+  double last = 0.0;
+  bool update(double error, double position) {
+    int ms = (int)std::lround(TICK * 1000.0);
+    small = std::fabs(error) < 1.0 ? small + ms : 0;
+    big = std::fabs(error) < 3.0 ? big + ms : 0;
+    still = std::fabs(position - last) <= 0.05 ? still + ms : 0;
+    last = position;
+    return small > 90 || big > 250 || still > 500;
+  }
+};
+
+struct result {
+  double exit = -1.0;      // s from the start to both sides exiting
+  double error = 0.0;      // in the robot really is from the target at the exit
+  double overshoot = 0.0;  // in past the target at most
+  double slip = 0.0;       // in the encoders ran ahead of the robot by the exit
+  double heading = 0.0;    // degrees off at the exit
+  double plan = 0.0;       // s the profile lasts
+};
+
+// Runs one drive.  control(t, d, l, r) sets outputs every tick and returns true while its own
+// setpoint is still moving
+template <typename Controller>
+result run(double friction, double weak, double traction, double distance, Controller&& control) {
+  drive d;
+  d.left.friction = d.right.friction = friction;
+  d.left.traction = d.right.traction = traction;
+  d.right.strength = weak;
+  exit_timer left_exit, right_exit;
+  bool left_done = false, right_done = false;
+  result out;
+  for (double t = 0.0; t < 6.0; t += TICK) {
+    double l = 0.0, r = 0.0;
+    bool moving = control(t, d, l, r);
+    if (!moving) {
+      left_done = left_done || left_exit.update(distance - d.left.position, d.left.position);
+      right_done = right_done || right_exit.update(distance - d.right.position, d.right.position);
+      if (left_done && right_done) {
+        out.exit = t;
+        break;
+      }
+    }
+    for (int i = 0; i < (int)(TICK / PLANT_DT + 0.5); i++) {
+      d.left.step(std::clamp(l, -127.0, 127.0));
+      d.right.step(std::clamp(r, -127.0, 127.0));
+    }
+    double ground = (d.left.ground + d.right.ground) / 2.0;
+    out.overshoot = std::max(out.overshoot, distance > 0.0 ? ground - distance : distance - ground);
+  }
+  out.error = distance - (d.left.ground + d.right.ground) / 2.0;
+  out.slip = std::fabs((d.left.position + d.right.position - d.left.ground - d.right.ground) / 2.0);
+  out.heading = d.heading();
+  return out;
+}
+
+feedforward_gains truth(double friction, double strength) { return {friction, 127.0 / (FREE_VELOCITY * strength), 127.0 * TIME_CONSTANT / (FREE_VELOCITY * strength)}; }
+
+void print(const char* name, const result& r) {
+  if (r.exit < 0.0) std::printf("  %-12s %8s", name, "no exit");
+  else std::printf("  %-12s %8.2f", name, r.exit);
+  if (r.plan > 0.0) std::printf(" %8.2f", r.plan);
+  else std::printf(" %8s", "-");
+  std::printf(" %9.2f %10.2f %8.2f %8.2f\n", r.error, r.overshoot, r.slip, r.heading);
+}
+
+// The whole of text as a number, false for anything else, eg. a flag
+bool number_parse(const char* text, double& out) {
+  char* stop;
+  out = std::strtod(text, &stop);
+  return stop != text && *stop == '\0' && std::isfinite(out);
+}
+
+int usage() {
+  std::fprintf(stderr,
+               "usage: motion_profile_bench [--speed 110] [--accel 170] [--jerk 8000] [--traction 200]\n"
+               "                            [--friction 6] [--weak 0.93] [distance ...]\n");
+  return 1;
+}
+}  // namespace
+
+int main(int argc, char** argv) {
+  double speed = 110.0, accel = 170.0, jerk = 8000.0, traction = 200.0, friction = 6.0, weak = 0.93;
+  std::vector<double> distances;
+  const struct {
+    const char* flag;
+    double* value;
+  } options[] = {{"--speed", &speed}, {"--accel", &accel}, {"--jerk", &jerk}, {"--traction", &traction}, {"--friction", &friction}, {"--weak", &weak}};
+  for (int i = 1; i < argc; i++) {
+    if (!std::strcmp(argv[i], "--help") || !std::strcmp(argv[i], "-h")) return usage(), 0;
+    double* value = nullptr;
+    for (const auto& option : options) {
+      if (!std::strcmp(argv[i], option.flag)) value = option.value;
+    }
+    double number;
+    if (value) {
+      if (i + 1 >= argc || !number_parse(argv[i + 1], *value)) return std::fprintf(stderr, "%s wants a number\n", argv[i]), usage();
+      i++;
+    } else if (number_parse(argv[i], number)) {
+      distances.push_back(number);
+    } else {
+      return std::fprintf(stderr, "unknown argument %s\n", argv[i]), usage();
+    }
+  }
+  if (distances.empty()) distances = {10.0, 21.0, 26.25, -9.0, 28.5, -14.0, -48.5, 14.0, 43.0};
+
+  feedforward_gains left_gains = truth(friction, 1.0), right_gains = truth(friction, weak);
+  // Top speed is what the weaker side holds at output `speed`, like EZ capping the output there
+  double top = std::min((speed - left_gains.kS) / left_gains.kV, (speed - right_gains.kS) / right_gains.kV);
+
+  std::printf("speed %.0f (%.1f in/s), accel %.0f in/s^2, jerk %.0f in/s^3, traction %.0f in/s^2\n", speed, top, accel, jerk, traction);
+  double totals[3] = {};
+  for (double distance : distances) {
+    // chassis.pid_drive_set(distance, speed) with slew_drive_constants_set(3_in, 70) and the heading PID
+    pid left_pid{20.0, 100.0}, right_pid{20.0, 100.0}, heading_pid{11.0, 20.0};
+    result slewed = run(friction, weak, traction, distance, [&](double, const drive& d, double& l, double& r) {
+      double travelled = std::fabs((d.left.position + d.right.position) / 2.0);
+      double cap = std::fabs(distance) > 3.0 && travelled < 3.0 ? 70.0 + (speed - 70.0) * travelled / 3.0 : speed;
+      double lo = std::clamp(left_pid.compute(distance - d.left.position, d.left.position), -cap, cap);
+      double ro = std::clamp(right_pid.compute(distance - d.right.position, d.right.position), -cap, cap);
+      double heading = heading_pid.compute(-d.heading(), d.heading());
+      l = lo + heading;
+      r = ro - heading;
+      return false;
+    });
+
+    result profiled[2];
+    for (int shape = 0; shape < 2; shape++) {
+      robot::motion_profile profile;
+      profile.generate(distance, {top, accel, jerk}, (robot::profile_shape)shape);
+      pid lp{20.0, 100.0}, rp{20.0, 100.0}, hp{11.0, 20.0};
+      profiled[shape] = run(friction, weak, traction, distance, [&](double t, const drive& d, double& l, double& r) {
+        robot::motion_state s = profile.sample(t);
+        // The PIDs work on the error from the setpoint, so their derivative damps only the velocity error
+        double heading = hp.compute(-d.heading(), d.heading());
+        l = robot::feedforward_output(left_gains, s.velocity, s.acceleration) + lp.compute(s.position - d.left.position, d.left.position - s.position) + heading;
+        r = robot::feedforward_output(right_gains, s.velocity, s.acceleration) + rp.compute(s.position - d.right.position, d.right.position - s.position) - heading;
+        return t < profile.duration_get();
+      });
+      profiled[shape].plan = profile.duration_get();
+    }
+
+    std::printf("\n%5.1f in         exit s   plan s  error in  overshoot  slip in  heading\n", distance);
+    print("slew + pid", slewed);
+    print("trapezoid", profiled[0]);
+    print("s-curve", profiled[1]);
+    totals[0] += slewed.exit;
+    totals[1] += profiled[0].exit;
+    totals[2] += profiled[1].exit;
+  }
+  std::printf("\ntotal exit s: slew + pid %.2f, trapezoid %.2f, s-curve %.2f\n", totals[0], totals[1], totals[2]);
+  return 0;
+}
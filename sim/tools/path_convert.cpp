@@ -0,0 +1,164 @@
+/*
+This Source Code Form is subject to the terms of the Mozilla Public
+License, v. 2.0. If a copy of the MPL was not distributed with this
+file, You can obtain one at http://mozilla.org/MPL/2.0/.
+*/
+
+// Converts trajectories to the binary path files in include/path_file.hpp.
+//
+//   bin/sim/path_convert --csv skills.csv skills.path
+//       a squiggles csv (serialize_path(), AsyncMotionProfileController::storePath()):
+//       x,y,yaw,vel,accel,jerk,curvature,time[,left,right]
+//   bin/sim/path_convert --pathfinder left.csv right.csv skills.path
+//       Pathfinder's per wheel csvs: dt,x,y,position,velocity,acceleration,jerk,heading
+//   bin/sim/path_convert --dump skills.path > skills.csv
+//       back to a squiggles csv
+//
+// Converting prints the sizes and how long each format takes to load.
+
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <string>
+#include <vector>
+
+#include "path_file.hpp"
+
+using squiggles::ProfilePoint;
+
+namespace {
+std::string file_read(const char* file) {
+  std::string out;
+  FILE* f = std::fopen(file, "rb");
+  if (!f) return out;
+  char buffer[65536];
+  std::size_t n;
+  while ((n = std::fread(buffer, 1, sizeof(buffer), f)) > 0) out.append(buffer, n);
+  std::fclose(f);
+  return out;
+}
+
+// Numeric rows of a csv, skipping a header line or anything else that doesn't start with a number
+std::vector<std::vector<double>> csv_rows(const std::string& text) {
+  std::vector<std::vector<double>> rows;
+  const char* p = text.c_str();
+  while (*p) {
+    const char* end = std::strchr(p, '\n');
+    if (!end) end = p + std::strlen(p);
+    std::vector<double> row;
+    const char* field = p;
+    while (field < end) {
+      char* stop;
+      double value = std::strtod(field, &stop);
+      if (stop == field) break;
+      row.push_back(value);
+      field = stop;
+      while (field < end && (*field == ',' || *field == ' ' || *field == '\r')) field++;
+    }
+    if (!row.empty()) rows.push_back(row);
+    p = *end ? end + 1 : end;
+  }
+  return rows;
+}
+
+std::vector<ProfilePoint> squiggles_csv(const std::string& text) {
+  std::vector<ProfilePoint> out;
+  for (const auto& r : csv_rows(text)) {
+    if (r.size() < 8) continue;
+    std::vector<double> wheels(r.begin() + 8, r.end());
+    out.emplace_back(squiggles::ControlVector(squiggles::Pose(r[0], r[1], r[2]), r[3], r[4], r[5]), wheels, r[6], r[7]);
+  }
+  return out;
+}
+
+// Pathfinder writes one csv per side, the robot's state is halfway between them
+std::vector<ProfilePoint> pathfinder_csv(const std::string& left_text, const std::string& right_text) {
+  std::vector<ProfilePoint> out;
+  auto left = csv_rows(left_text), right = csv_rows(right_text);
+  double time = 0.0;
+  for (std::size_t i = 0; i < left.size() && i < right.size(); i++) {
+    const auto& l = left[i];
+    const auto& r = right[i];
+    if (l.size() < 8 || r.size() < 8) continue;
+    double track = std::hypot(l[1] - r[1], l[2] - r[2]);
+    double vel = (l[4] + r[4]) / 2.0;
+    double curvature = track > 0.0 && std::fabs(vel) > 1e-9 ? (r[4] - l[4]) / (track * vel) : 0.0;
+    out.emplace_back(squiggles::ControlVector(squiggles::Pose((l[1] + r[1]) / 2.0, (l[2] + r[2]) / 2.0, l[7]), vel, (l[5] + r[5]) / 2.0, (l[6] + r[6]) / 2.0),
+                     std::vector<double>{l[4], r[4]}, curvature, time);
+    time += l[0];
+  }
+  return out;
+}
+
+template <typename F>
+double time_us(F&& load) {
+  auto begin = std::chrono::steady_clock::now();
+  int n = 0;
+  do {
+    load();
+    n++;
+  } while (std::chrono::steady_clock::now() - begin < std::chrono::milliseconds(200));
+  return std::chrono::duration<double, std::micro>(std::chrono::steady_clock::now() - begin).count() / n;
+}
+
+int usage() {
+  std::fprintf(stderr,
+               "usage: path_convert --csv in.csv out.path\n"
+               "       path_convert --pathfinder left.csv right.csv out.path\n"
+               "       path_convert --dump in.path\n");
+  return 1;
+}
+}  // namespace
+
+int main(int argc, char** argv) {
+  if (argc == 3 && !std::strcmp(argv[1], "--dump")) {
+    std::vector<float> bytes = robot::path_read(argv[2]);
+    robot::path_view path;
+    if (!path.open(bytes.data(), bytes.size() * sizeof(float))) {
+      std::fprintf(stderr, "%s isn't a version %d path file, or it's damaged\n", argv[2], robot::PATH_VERSION);
+      return 1;
+    }
+    std::printf("x,y,yaw,vel,accel,jerk,curvature,time,left,right\n");
+    for (std::size_t i = 0; i < path.size(); i++) std::printf("%s\n", path.point(i).squiggles_get().to_csv().c_str());
+    return 0;
+  }
+
+  std::vector<ProfilePoint> points;
+  std::string text, right;
+  const char* out;
+  if (argc == 4 && !std::strcmp(argv[1], "--csv")) {
+    text = file_read(argv[2]);
+    points = squiggles_csv(text);
+    out = argv[3];
+  } else if (argc == 5 && !std::strcmp(argv[1], "--pathfinder")) {
+    text = file_read(argv[2]);
+    right = file_read(argv[3]);
+    points = pathfinder_csv(text, right);
+    out = argv[4];
+  } else {
+    return usage();
+  }
+  if (points.empty()) {
+    std::fprintf(stderr, "no points read\n");
+    return 1;
+  }
+  if (!robot::path_write(out, points)) {
+    std::fprintf(stderr, "couldn't write %s\n", out);
+    return 1;
+  }
+
+  // Load both the way the brain would, already in memory so only parsing is timed
+  std::vector<float> bytes = robot::path_read(out);
+  robot::path_view view;
+  volatile std::size_t sink = 0;
+  double csv_us = time_us([&] { sink = right.empty() ? squiggles_csv(text).size() : pathfinder_csv(text, right).size(); });
+  double binary_us = time_us([&] { sink = view.open(bytes.data(), bytes.size() * sizeof(float)) ? view.size() : 0; });
+  (void)sink;
+
+  std::printf("%zu points\n", points.size());
+  std::printf("csv     %9zu bytes %10.1f us to load\n", text.size() + right.size(), csv_us);
+  std::printf("binary  %9zu bytes %10.1f us to load\n", bytes.size() * sizeof(float), binary_us);
+  return 0;
+}
@@ -0,0 +1,124 @@
+/*
+This Source Code Form is subject to the terms of the Mozilla Public
+License, v. 2.0. If a copy of the MPL was not distributed with this
+file, You can obtain one at http://mozilla.org/MPL/2.0/.
+*/
+
+// Compares a velocity profiled pure pursuit path against the same path at one speed.
+//
+// A skills style route is compiled with route_compile() and followed with pure pursuit by a
+// simple robot model: speed changes at most ACCEL, and a turn tighter than LATERAL allows at the
+// current speed slides wide.  The profile is compiled with the same limits.  The profiled run is timed, then every constant speed is tried and
+// the fastest one that tracks the path as well as the profiled run is reported next to it.
+//
+//   bin/sim/profile_bench [--csv file]
+
+#include <algorithm>
+#include <cmath>
+#include <cstdio>
+#include <cstring>
+#include <vector>
+
+#include "path_cursor.hpp"
+#include "route.hpp"
+
+using robot::route_point;
+using robot::route_sample;
+
+namespace {
+constexpr double DT = 0.01;
+constexpr double LOOKAHEAD = 7.0;
+constexpr double TOP_SPEED = 51.0;  // in/s at speed 127
+constexpr double ACCEL = 150.0;     // in/s^2 speeding up or slowing down
+constexpr double LATERAL = 150.0;   // in/s^2 before the wheels slide
+
+// Out along the wall, round the matchloader, back across the field and into the goal
+constexpr std::array<route_point, 7> SKILLS = {{{0, 0}, {0, 30, 127}, {-24, 36, 127}, {-30, 60, 127}, {0, 72, 127}, {30, 60, 127}, {24, 24, 127}}};
+constexpr robot::route_settings SETTINGS = {.profile = {.top_speed = TOP_SPEED, .lateral_accel = LATERAL, .accel = ACCEL, .decel = ACCEL}};
+constexpr auto SKILLS_PATH = robot::route_compile<SKILLS, SETTINGS>();
+
+struct result {
+  double time = 0.0;   // seconds until the robot is within 1 in of the end
+  double error = 0.0;  // furthest the robot got from the path, inches
+  bool finished = false;
+};
+
+result follow(const std::vector<route_sample>& path, FILE* csv) {
+  robot::path_cursor cursor;
+  cursor.reset(path.data(), path.size());
+  double x = path[0].x, y = path[0].y;
+  double heading = std::atan2(path[1].x - path[0].x, path[1].y - path[0].y);  // 0 is +y, like odom
+  double v = 0.0;
+  result out;
+
+  for (int tick = 0; tick < 3000; tick++) {
+    robot::cursor_point target = cursor.update(x, y, LOOKAHEAD);
+    std::size_t index = std::min(cursor.index() + 1, path.size() - 1);
+    double command = path[index].speed * TOP_SPEED / 127.0;
+
+    // Pure pursuit curvature to the lookahead point
+    double dx = target.x - x, dy = target.y - y;
+    double alpha = std::atan2(dx, dy) - heading;
+    alpha = std::atan2(std::sin(alpha), std::cos(alpha));
+    double curvature = 2.0 * std::sin(alpha) / std::max(std::hypot(dx, dy), 1e-6);
+
+    // Speed can only change so fast, and a turn can only be so tight at speed
+    v += std::clamp(command - v, -ACCEL * DT, ACCEL * DT);
+    if (v > 0.0) curvature = std::clamp(curvature, -LATERAL / (v * v), LATERAL / (v * v));
+
+    heading += v * curvature * DT;
+    x += v * std::sin(heading) * DT;
+    y += v * std::cos(heading) * DT;
+
+    // Tracking error against the whole path, not just the cursor's window
+    double best = 1e18;
+    for (std::size_t i = 0; i + 1 < path.size(); i++) {
+      double sx = path[i + 1].x - path[i].x, sy = path[i + 1].y - path[i].y;
+      double t = std::clamp(((x - path[i].x) * sx + (y - path[i].y) * sy) / (sx * sx + sy * sy), 0.0, 1.0);
+      best = std::min(best, std::hypot(x - (path[i].x + sx * t), y - (path[i].y + sy * t)));
+    }
+    out.error = std::max(out.error, best);
+    if (csv) std::fprintf(csv, "%.2f,%.3f,%.3f,%.2f,%.3f\n", tick * DT, x, y, v, best);
+
+    if (std::hypot(x - path.back().x, y - path.back().y) < 1.0) {
+      out.time = (tick + 1) * DT;
+      out.finished = true;
+      return out;
+    }
+  }
+  return out;
+}
+}  // namespace
+
+int main(int argc, char** argv) {
+  FILE* csv = nullptr;
+  for (int i = 1; i + 1 < argc; i += 2)
+    if (!std::strcmp(argv[i], "--csv")) csv = std::fopen(argv[i + 1], "w");
+  if (csv) std::fprintf(csv, "time,x,y,speed,error\n");
+
+  std::vector<route_sample> profiled(SKILLS_PATH.begin(), SKILLS_PATH.end());
+  result fast = follow(profiled, csv);
+  if (csv) std::fclose(csv);
+
+  // Fastest single speed that stays as close to the path
+  result flat;
+  int flat_speed = 0;
+  for (int speed = 127; speed >= 20; speed--) {
+    std::vector<route_sample> constant = profiled;
+    for (auto& p : constant) p.speed = speed;
+    flat = follow(constant, nullptr);
+    if (flat.finished && flat.error <= fast.error) {
+      flat_speed = speed;
+      break;
+    }
+  }
+
+  std::printf("%zu points, %.0f in/s^2 accel, %.0f in/s^2 before sliding\n", profiled.size(), ACCEL, LATERAL);
+  std::printf("%-22s %10s %12s\n", "", "time (s)", "max error");
+  std::printf("%-22s %10.2f %12.2f\n", "velocity profile", fast.time, fast.error);
+  if (flat_speed)
+    std::printf("constant speed %-7d %10.2f %12.2f\n", flat_speed, flat.time, flat.error);
+  else
+    std::printf("no constant speed tracks as well as the profile\n");
+  return 0;
+}
@@ -0,0 +1,79 @@
+/*
+This Source Code Form is subject to the terms of the Mozilla Public
+License, v. 2.0. If a copy of the MPL was not distributed with this
+file, You can obtain one at http://mozilla.org/MPL/2.0/.
+*/
+
+// Compile time checks for the route compiler in include/route.hpp.  Building this tool is the
+// test, every static_assert runs in the compiler.  Running it prints a compiled route as csv.
+//
+//   bin/sim/route_check > route.csv
+
+#include <cstdio>
+
+#include "route.hpp"
+
+using robot::route_point;
+
+namespace {
+constexpr double near(double a, double b) { return a - b < 1e-6 && b - a < 1e-6; }
+
+// Straight line, 24 in at 1 in spacing
+constexpr std::array<route_point, 2> STRAIGHT = {{{0, 0}, {0, 24, 100}}};
+constexpr auto STRAIGHT_PATH = robot::route_compile<STRAIGHT>();
+static_assert(STRAIGHT_PATH.size() == 25);
+static_assert(near(STRAIGHT_PATH[10].x, 0.0) && near(STRAIGHT_PATH[10].y, 10.0));
+static_assert(STRAIGHT_PATH[12].curvature == 0.0);
+static_assert(STRAIGHT_PATH[12].speed == 100);
+static_assert(STRAIGHT_PATH.front().speed == 30, "starts from min_speed and accelerates");
+static_assert(STRAIGHT_PATH[3].speed < STRAIGHT_PATH[6].speed);
+
+// Slower than min_speed, the floor doesn't speed it up
+constexpr std::array<route_point, 2> CREEP = {{{0, 0}, {0, 24, 20}}};
+constexpr auto CREEP_PATH = robot::route_compile<CREEP>();
+static_assert(CREEP_PATH.front().speed == 20 && CREEP_PATH[12].speed == 20);
+
+// Square corner, smoothed into an arc
+constexpr std::array<route_point, 3> CORNER = {{{0, 0}, {0, 24}, {24, 24, 90, true}}};
+constexpr auto CORNER_PATH = robot::route_compile<CORNER>();
+static_assert(CORNER_PATH.size() == 49);
+static_assert(near(CORNER_PATH.front().x, 0.0) && near(CORNER_PATH.front().y, 0.0));
+static_assert(near(CORNER_PATH.back().x, 24.0) && near(CORNER_PATH.back().y, 24.0));
+static_assert(CORNER_PATH[24].x > 0.0 && CORNER_PATH[24].y < 24.0, "the corner is rounded off");
+static_assert(CORNER_PATH[24].curvature > CORNER_PATH[5].curvature);
+static_assert(CORNER_PATH[24].speed < 110, "the corner is slowed down for");
+static_assert(CORNER_PATH[5].speed > CORNER_PATH[20].speed, "and slowed into before it arrives");
+static_assert(CORNER_PATH.back().reverse && !CORNER_PATH.front().reverse);
+
+// Mirrored for the other side of the field
+constexpr auto CORNER_MIRRORED = robot::route_compile<CORNER, robot::route_settings{.mirror = true}>();
+static_assert(near(CORNER_MIRRORED.back().x, -24.0) && CORNER_MIRRORED[24].speed == CORNER_PATH[24].speed);
+
+// Coarser spacing, fewer points
+constexpr auto CORNER_COARSE = robot::route_compile<CORNER, robot::route_settings{.spacing = 2.0}>();
+static_assert(CORNER_COARSE.size() == 25);
+
+// Tables of the wrong size, as at run time.  A short one is cut and still ends on the last
+// waypoint, a long one repeats its last point.
+template <std::size_t N>
+struct sized {
+  std::size_t used = 0;
+  std::array<robot::route_sample, N> table{};
+};
+template <std::size_t N>
+constexpr sized<N> compile_into() {
+  sized<N> out;
+  out.used = robot::route_compile(STRAIGHT, out.table);
+  return out;
+}
+constexpr auto SHORT = compile_into<10>();
+static_assert(SHORT.used == 10 && near(SHORT.table.back().y, 24.0) && near(SHORT.table.front().y, 0.0));
+constexpr auto LONG = compile_into<30>();
+static_assert(LONG.used == 25 && near(LONG.table[24].y, 24.0) && near(LONG.table.back().y, 24.0));
+}  // namespace
+
+int main() {
+  std::printf("x,y,curvature,speed,reverse\n");
+  for (const auto& p : CORNER_PATH) std::printf("%.3f,%.3f,%.4f,%d,%d\n", p.x, p.y, p.curvature, p.speed, p.reverse);
+  return 0;
+}
@@ -0,0 +1,175 @@
+/*
+This Source Code Form is subject to the terms of the Mozilla Public
+License, v. 2.0. If a copy of the MPL was not distributed with this
+file, You can obtain one at http://mozilla.org/MPL/2.0/.
+*/
+
+// Benchmarks robot::spline_generator from include/spline_generator.hpp.
+//
+// Generates random 6 and 32 waypoint routes across the field four ways:
+//   numeric   every segment from a cold start with central difference gradients, the way
+//             squiggles' gradient descent works
+//   analytic  the analytic gradient, warm starting each segment from the one before
+//   warm      regenerating a route after the start pose moved 2 cm, warm from the last solution
+//   threads   the analytic gradient with segments split between threads
+// and prints shapes/second (the splines alone), paths/second and states/second (timed
+// trajectories at 2 cm spacing), cost evaluations and the median bending energy reached, which
+// should match between the rows.  Then checks that routes with a waypoint repeated, or
+// repeated with a new heading like a turn in place, still give finite states every way.
+//
+//   bin/sim/spline_bench [--routes N] [--threads N]
+
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <random>
+#include <vector>
+
+#include "spline_generator.hpp"
+
+using robot::spline_generator;
+using robot::spline_settings;
+using squiggles::Pose;
+
+namespace {
+// Random poses inside a 3.6 m field, each at least 0.4 m from the last
+std::vector<Pose> route_make(std::mt19937& rng, int count) {
+  std::uniform_real_distribution<double> place(-1.6, 1.6), turn(-M_PI, M_PI);
+  std::vector<Pose> out;
+  while ((int)out.size() < count) {
+    Pose p(place(rng), place(rng), turn(rng));
+    if (!out.empty() && p.dist(out.back()) < 0.4) continue;
+    out.push_back(p);
+  }
+  return out;
+}
+
+// Bending energy of a route, from its states
+double energy(const robot::profile_path<2>& states) {
+  double total = 0.0;
+  for (std::size_t i = 1; i < states.size(); i++) total += states[i].curvature * states[i].curvature * states[i].vector.pose.dist(states[i - 1].vector.pose);
+  return total;
+}
+
+// True if every state of the path is a number
+bool finite(const robot::profile_path<2>& states) {
+  for (const auto& p : states) {
+    double values[] = {p.vector.pose.x, p.vector.pose.y, p.vector.pose.yaw, p.vector.vel, p.vector.accel, p.curvature, p.time, p.wheel_velocities[0], p.wheel_velocities[1]};
+    for (double v : values) {
+      if (!std::isfinite(v)) return false;
+    }
+  }
+  return true;
+}
+
+double median(std::vector<double> values) {
+  std::nth_element(values.begin(), values.begin() + values.size() / 2, values.end());
+  return values[values.size() / 2];
+}
+
+struct row {
+  double seconds = 0.0;
+  long states = 0;
+  long evaluations = 0;
+  std::vector<double> energy;
+  int paths = 0;
+};
+
+enum mode { NUMERIC,
+            ANALYTIC,
+            WARM,
+            THREADS };
+
+// Generates every route one way.  WARM generates each route once untimed, then times it again
+// with the start pose moved.
+row measure(const std::vector<std::vector<Pose>>& routes, spline_settings settings, mode how, int threads) {
+  using clock = std::chrono::steady_clock;
+  if (how == NUMERIC) {
+    settings.warm_start = false;
+    settings.analytic = false;
+  }
+  row out;
+  robot::profile_path<2> states;
+  for (const auto& route : routes) {
+    spline_generator generator;
+    std::vector<Pose> input = route;
+    if (how == WARM) {
+      generator.generate(route, settings, states);
+      input[0].x += 0.02;
+    }
+    auto begin = clock::now();
+    generator.generate(input, settings, states, how == THREADS ? threads : 1);
+    out.seconds += std::chrono::duration<double>(clock::now() - begin).count();
+    out.paths++;
+    out.states += states.size();
+    out.evaluations += generator.evaluations();
+    out.energy.push_back(energy(states));
+  }
+  return out;
+}
+}  // namespace
+
+int main(int argc, char** argv) {
+  int routes = 2000, threads = 4;
+  for (int i = 1; i + 1 < argc; i += 2) {
+    if (!std::strcmp(argv[i], "--routes")) routes = std::atoi(argv[i + 1]);
+    if (!std::strcmp(argv[i], "--threads")) threads = std::atoi(argv[i + 1]);
+  }
+  std::mt19937 rng(7);
+  std::vector<std::vector<Pose>> short_routes, long_routes;
+  for (int i = 0; i < routes; i++) short_routes.push_back(route_make(rng, 6));
+  for (int i = 0; i < routes / 20 + 1; i++) long_routes.push_back(route_make(rng, 32));
+
+  // Shapes alone with states so far apart each segment only gets two, then full trajectories
+  spline_settings full, shape;
+  shape.spacing = 1e6;
+  const char* names[] = {"numeric", "analytic", "warm", "threads"};
+
+  std::printf("%-10s %10s %10s %14s %12s %10s\n", "", "shapes/s", "paths/s", "states/s", "evals/path", "energy");
+  for (const auto* set : {&short_routes, &long_routes}) {
+    std::printf("%zu waypoints\n", set->front().size());
+    for (mode how : {NUMERIC, ANALYTIC, WARM, THREADS}) {
+      row s = measure(*set, shape, how, threads);
+      row f = measure(*set, full, how, threads);
+      std::printf("%-10s %10.0f %10.0f %14.0f %12.1f %10.2f\n", names[how], s.paths / s.seconds, f.paths / f.seconds, f.states / f.seconds, (double)f.evaluations / f.paths, median(f.energy));
+    }
+  }
+
+  // The same short routes with one waypoint repeated, as is or turned, then with every
+  // waypoint on top of the start
+  std::vector<std::vector<Pose>> repeated;
+  for (const auto& route : short_routes) {
+    std::vector<Pose> input = route;
+    std::size_t at = rng() % input.size();
+    Pose copy = input[at];
+    if (rng() % 2) copy.yaw += M_PI / 2.0;
+    input.insert(input.begin() + at + 1, copy);
+    repeated.push_back(input);
+  }
+  repeated.push_back(std::vector<Pose>(4, short_routes.front().front()));
+  int failed = 0;
+  for (mode how : {NUMERIC, ANALYTIC, WARM, THREADS}) {
+    spline_settings settings = full;
+    if (how == NUMERIC) {
+      settings.warm_start = false;
+      settings.analytic = false;
+    }
+    spline_generator generator;
+    robot::profile_path<2> states;
+    for (const auto& route : repeated) {
+      std::vector<Pose> input = route;
+      if (how == WARM) {
+        generator.generate(route, settings, states);
+        input[0].x += 0.02;
+      }
+      generator.generate(input, settings, states, how == THREADS ? threads : 1);
+      if (!finite(states)) failed++;
+    }
+  }
+  std::printf("repeated waypoints: %s\n", failed ? "FAIL" : "ok");
+  if (failed) std::printf("%i paths had states that are not numbers\n", failed);
+  return failed ? 1 : 0;
+}
@@ -0,0 +1,589 @@
+/*
+This Source Code Form is subject to the terms of the Mozilla Public
+License, v. 2.0. If a copy of the MPL was not distributed with this
+file, You can obtain one at http://mozilla.org/MPL/2.0/.
+*/
+
+// Offline PID tuner.
+//
+// Reads logged step responses, fits a plant model to each of drive / turn / swing, searches
+// kp, ki, kd, start_i and the small/big exit times against that model on every core, then
+// prints a default_constants() ready to paste into src/autons.cpp and a convergence report.
+//
+//   bin/sim/tune [--drive log.csv] [--turn log.csv] [--swing log.csv]
+//                [--plant drive:K,tau_ms,delay_ms] [--overshoot drive:0.5]
+//                [--constants src/autons.cpp] [--threads N] [--rounds N] [--seed N]
+//
+// Logs are csv with a header containing time (ms), target, position and output (-127 to 127),
+// one row per control tick.  Every time the target jumps a new step starts.
+
+#include <algorithm>
+#include <array>
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <fstream>
+#include <map>
+#include <random>
+#include <sstream>
+#include <string>
+#include <thread>
+#include <vector>
+
+namespace {
+/////
+//
+// Logs and plant identification
+//
+/////
+
+struct sample {
+  double time, target, position, output;
+};
+
+// First order velocity response with dead time: tau * v' = K * u(t - delay) - v
+struct plant_model {
+  double K = 0.0;        // units/s per unit of output
+  double tau = 0.1;      // s
+  double delay = 0.0;    // s
+  double rms = 0.0;      // velocity fit error, units/s
+  double r2 = 0.0;
+  bool fitted = false;
+};
+
+std::vector<sample> log_read(const std::string& path) {
+  std::ifstream file(path);
+  if (!file) {
+    std::fprintf(stderr, "Could not open %s\n", path.c_str());
+    std::exit(1);
+  }
+
+  std::string line;
+  std::getline(file, line);
+  std::map<std::string, int> columns;
+  {
+    std::stringstream header(line);
+    std::string name;
+    for (int i = 0; std::getline(header, name, ','); i++) {
+      name.erase(std::remove_if(name.begin(), name.end(), ::isspace), name.end());
+      columns[name] = i;
+    }
+  }
+  for (auto name : {"time", "target", "position", "output"}) {
+    if (!columns.count(name)) {
+      std::fprintf(stderr, "%s has no %s column\n", path.c_str(), name);
+      std::exit(1);
+    }
+  }
+
+  std::vector<sample> out;
+  while (std::getline(file, line)) {
+    std::vector<double> values;
+    std::stringstream row(line);
+    std::string cell;
+    while (std::getline(row, cell, ',')) values.push_back(std::atof(cell.c_str()));
+    if ((int)values.size() < (int)columns.size()) continue;
+    out.push_back({values[columns["time"]], values[columns["target"]], values[columns["position"]], values[columns["output"]]});
+  }
+  return out;
+}
+
+// Splits a log wherever the target jumps and returns the step sizes
+std::vector<double> steps_find(const std::vector<sample>& log) {
+  std::vector<double> out;
+  for (size_t i = 0; i < log.size(); i++) {
+    if (i == 0 || std::fabs(log[i].target - log[i - 1].target) > 1e-6) {
+      double size = log[i].target - log[i].position;
+      if (std::fabs(size) > 1e-3) out.push_back(size);
+    }
+  }
+  return out;
+}
+
+// Least squares fit of v[k+1] = a v[k] + b u[k - d] for each dead time d, keeping the best
+plant_model plant_identify(const std::vector<sample>& log) {
+  plant_model best;
+  if (log.size() < 10) return best;
+
+  std::vector<double> dts;
+  for (size_t i = 1; i < log.size(); i++) dts.push_back(log[i].time - log[i - 1].time);
+  std::nth_element(dts.begin(), dts.begin() + dts.size() / 2, dts.end());
+  double dt = std::max(dts[dts.size() / 2], 1.0) / 1000.0;
+
+  std::vector<double> v(log.size(), 0.0);
+  for (size_t i = 1; i + 1 < log.size(); i++) v[i] = (log[i + 1].position - log[i - 1].position) / (2.0 * dt);
+
+  for (int d = 0; d <= 8; d++) {
+    double svv = 0, svu = 0, suu = 0, svy = 0, suy = 0;
+    int n = 0;
+    for (size_t k = 1 + d; k + 2 < log.size(); k++) {
+      double vk = v[k], uk = log[k - d].output, y = v[k + 1];
+      svv += vk * vk, svu += vk * uk, suu += uk * uk, svy += vk * y, suy += uk * y;
+      n++;
+    }
+    double det = svv * suu - svu * svu;
+    if (n < 5 || std::fabs(det) < 1e-12) continue;
+    double a = (svy * suu - suy * svu) / det;
+    double b = (suy * svv - svy * svu) / det;
+    if (a <= 0.0 || a >= 1.0 || b == 0.0) continue;
+
+    double sse = 0, sst = 0, mean = 0;
+    for (size_t k = 1 + d; k + 2 < log.size(); k++) mean += v[k + 1];
+    mean /= n;
+    for (size_t k = 1 + d; k + 2 < log.size(); k++) {
+      double e = v[k + 1] - (a * v[k] + b * log[k - d].output);
+      sse += e * e;
+      sst += (v[k + 1] - mean) * (v[k + 1] - mean);
+    }
+
+    plant_model m;
+    m.tau = -dt / std::log(a);
+    m.K = b / (1.0 - a);
+    m.delay = d * dt;
+    m.rms = std::sqrt(sse / n);
+    m.r2 = sst > 0 ? 1.0 - sse / sst : 0.0;
+    m.fitted = true;
+    if (!best.fitted || m.rms < best.rms) best = m;
+  }
+  return best;
+}
+
+/////
+//
+// Closed loop model of ez::PID
+//
+/////
+
+struct gains {
+  double kp = 0, ki = 0, kd = 0, start_i = 0;
+};
+
+struct exit_settings {
+  double small_error = 1.0;
+  int small_exit_time = 90;
+  double big_error = 3.0;
+  int big_exit_time = 250;
+  int velocity_exit_time = 500;
+  int mA_timeout = 500;
+};
+
+struct step_result {
+  bool settled = false;
+  double overshoot = 0.0;     // past the target, in units
+  int final_entry = 0;        // ms, when the error entered the small band for the last time
+  int longest_early = 0;      // ms, longest stay in the small band that was later left
+  int big_before_small = 0;   // ms spent inside the big band before the small band was entered for good
+};
+
+constexpr int TICK = 10;    // ms, ez::util::DELAY_TIME
+constexpr int WINDOW = 4000;
+
+// Runs one step against the plant the same way ez::PID::compute() does every tick
+step_result step_simulate(const plant_model& plant, const gains& g, double step, double max_speed, const exit_settings& exit) {
+  step_result out;
+  int delay_ms = std::max(0, (int)std::lround(plant.delay * 1000.0));
+  std::vector<double> delay_line(delay_ms + 1, 0.0);
+  int delay_head = 0;
+
+  double x = 0, v = 0, integral = 0, prev_error = step, prev_x = 0;
+  double direction = step > 0 ? 1.0 : -1.0;
+  int in_small_since = -1, in_big_since = -1;
+  bool left_small = true;
+
+  for (int t = 0; t <= WINDOW; t += TICK) {
+    double error = step - x;
+
+    if (g.ki != 0.0) {
+      if (std::fabs(error) < g.start_i) integral += error;
+      if ((error > 0) != (prev_error > 0)) integral = 0;
+    }
+    double derivative = prev_x - x;
+    double output = std::clamp(g.kp * error + g.ki * integral + g.kd * derivative, -max_speed, max_speed);
+    prev_error = error;
+    prev_x = x;
+
+    // Exit bookkeeping on the same tick the PID runs
+    out.overshoot = std::max(out.overshoot, -direction * error);
+    if (std::fabs(error) < exit.small_error) {
+      if (in_small_since < 0) in_small_since = t;
+    } else {
+      if (in_small_since >= 0) out.longest_early = std::max(out.longest_early, t - in_small_since);
+      in_small_since = -1;
+    }
+    if (std::fabs(error) < exit.big_error) {
+      if (in_big_since < 0) in_big_since = t;
+    } else {
+      in_big_since = -1;
+    }
+    left_small = in_small_since < 0;
+    if (!left_small) {
+      out.final_entry = in_small_since;
+      out.big_before_small = in_big_since >= 0 ? in_small_since - in_big_since : 0;
+    }
+
+    for (int ms = 0; ms < TICK; ms++) {
+      delay_line[delay_head] = output;
+      delay_head = (delay_head + 1) % delay_line.size();
+      double u = delay_line[delay_head];
+      v += (plant.K * u - v) / plant.tau * 0.001;
+      x += v * 0.001;
+    }
+  }
+
+  // Settled means it was still in the band for the last half second of the window
+  out.settled = !left_small && out.final_entry <= WINDOW - 500;
+  return out;
+}
+
+/////
+//
+// Search
+//
+/////
+
+struct bounds {
+  double kp_min, kp_max, ki_max, kd_max, start_i_max;
+};
+
+struct candidate {
+  gains g;
+  exit_settings exit;
+  double cost = INFINITY;
+  double settle = 0;     // ms, average time to exit on the nominal plant
+  double overshoot = 0;  // worst overshoot over every plant variant
+};
+
+struct problem {
+  std::string name;
+  plant_model plant;
+  std::vector<double> steps;
+  double max_speed = 127;
+  double overshoot_limit = 1.0;
+  exit_settings exit;
+  bounds limits;
+};
+
+// The plant is never exactly what was logged, so every candidate has to hold up on these too
+std::vector<plant_model> plant_variants(const plant_model& p) {
+  std::vector<plant_model> out = {p, p, p, p};
+  out[1].K *= 0.9, out[1].tau *= 1.2;
+  out[2].K *= 1.1, out[2].tau *= 0.8;
+  out[3].delay += 0.01;
+  return out;
+}
+
+void candidate_evaluate(const problem& prob, const std::vector<plant_model>& variants, candidate& c) {
+  double penalty = 0, settle = 0, overshoot = 0;
+  int required_small = 0, required_big = 0;
+
+  for (size_t vi = 0; vi < variants.size(); vi++) {
+    for (double step : prob.steps) {
+      step_result r = step_simulate(variants[vi], c.g, step, prob.max_speed, c.exit);
+      overshoot = std::max(overshoot, r.overshoot);
+      if (!r.settled) {
+        penalty += 10000;
+        continue;
+      }
+      if (r.overshoot > prob.overshoot_limit) penalty += 2000 * (r.overshoot - prob.overshoot_limit) / prob.overshoot_limit + 500;
+
+      // The small exit has to outlast any early visit to the band, or it would exit while still moving
+      required_small = std::max(required_small, r.longest_early + TICK);
+      required_big = std::max(required_big, r.big_before_small);
+      if (vi == 0) settle += r.final_entry;
+    }
+  }
+
+  c.exit.small_exit_time = std::max(((required_small + TICK - 1) / TICK) * TICK, 3 * TICK);
+  c.exit.big_exit_time = std::max(((required_big + c.exit.small_exit_time + 2 * TICK + TICK - 1) / TICK) * TICK, c.exit.small_exit_time + 5 * TICK);
+  c.settle = settle / prob.steps.size() + c.exit.small_exit_time;
+  c.overshoot = overshoot;
+  c.cost = c.settle + penalty;
+}
+
+void batch_evaluate(const problem& prob, std::vector<candidate>& batch, int threads) {
+  auto variants = plant_variants(prob.plant);
+  std::vector<std::thread> pool;
+  for (int t = 0; t < threads; t++) {
+    pool.emplace_back([&, t]() {
+      for (size_t i = t; i < batch.size(); i += threads) candidate_evaluate(prob, variants, batch[i]);
+    });
+  }
+  for (auto& th : pool) th.join();
+}
+
+struct round_report {
+  int round;
+  double best, elite_median, sigma;
+};
+
+candidate search(const problem& prob, int threads, int rounds, unsigned seed, std::vector<round_report>& report) {
+  std::mt19937 rng(seed);
+  std::uniform_real_distribution<double> unit(0.0, 1.0);
+  auto log_uniform = [&](double lo, double hi) { return std::exp(std::log(lo) + unit(rng) * (std::log(hi) - std::log(lo))); };
+
+  const bounds& b = prob.limits;
+  auto clamp_gains = [&](gains g) {
+    g.kp = std::clamp(g.kp, b.kp_min, b.kp_max);
+    g.ki = std::clamp(g.ki, 0.0, b.ki_max);
+    g.kd = std::clamp(g.kd, 0.0, b.kd_max);
+    g.start_i = std::clamp(g.start_i, 0.0, b.start_i_max);
+    if (g.ki == 0.0) g.start_i = 0.0;
+    return g;
+  };
+
+  // Round 0 spreads over the whole space, half the samples without an integral term
+  std::vector<candidate> population(2048);
+  for (auto& c : population) {
+    c.exit = prob.exit;
+    c.g.kp = log_uniform(b.kp_min, b.kp_max);
+    c.g.kd = unit(rng) < 0.1 ? 0.0 : log_uniform(b.kd_max / 1000.0, b.kd_max);
+    if (unit(rng) < 0.5) {
+      c.g.ki = log_uniform(b.ki_max / 1000.0, b.ki_max);
+      c.g.start_i = unit(rng) * b.start_i_max;
+    }
+  }
+  batch_evaluate(prob, population, threads);
+
+  constexpr int ELITES = 16;
+  constexpr int CHILDREN = 64;
+  double sigma = 0.35;
+  for (int round = 0; round <= rounds; round++) {
+    std::sort(population.begin(), population.end(), [](const candidate& a, const candidate& b) { return a.cost < b.cost; });
+    population.resize(std::min<size_t>(population.size(), ELITES));
+    report.push_back({round, population[0].cost, population[population.size() / 2].cost, sigma});
+    if (round == rounds) break;
+
+    // Each elite spawns children with multiplicative noise that shrinks every round
+    std::normal_distribution<double> noise(0.0, sigma);
+    std::vector<candidate> children;
+    for (const auto& parent : population) {
+      for (int i = 0; i < CHILDREN; i++) {
+        candidate c;
+        c.exit = prob.exit;
+        c.g = parent.g;
+        c.g.kp *= std::exp(noise(rng));
+        c.g.kd = c.g.kd == 0.0 ? (unit(rng) < 0.2 ? b.kd_max * 0.01 : 0.0) : c.g.kd * std::exp(noise(rng));
+        if (c.g.ki != 0.0) {
+          c.g.ki *= std::exp(noise(rng));
+          c.g.start_i *= std::exp(noise(rng));
+          if (unit(rng) < 0.05) c.g.ki = 0.0;
+        }
+        c.g = clamp_gains(c.g);
+        children.push_back(c);
+      }
+    }
+    batch_evaluate(prob, children, threads);
+    population.insert(population.end(), children.begin(), children.end());
+    sigma *= 0.8;
+  }
+  return population[0];
+}
+
+/////
+//
+// Output
+//
+/////
+
+std::string number(double value) {
+  char buffer[32];
+  std::snprintf(buffer, sizeof(buffer), "%.3f", value);
+  std::string out = buffer;
+  while (out.back() == '0' && out[out.size() - 2] != '.') out.pop_back();
+  return out;
+}
+
+std::string unit_of(const std::string& mode) { return mode == "drive" ? "_in" : "_deg"; }
+
+std::string constants_line(const std::string& mode, const gains& g) {
+  return "  chassis.pid_" + mode + "_constants_set(" + number(g.kp) + ", " + number(g.ki) + ", " + number(g.kd) +
+         (g.start_i != 0.0 ? ", " + number(g.start_i) : "") + ");";
+}
+
+std::string exit_line(const std::string& mode, const exit_settings& e) {
+  std::string u = unit_of(mode);
+  return "  chassis.pid_" + mode + "_exit_condition_set(" + std::to_string(e.small_exit_time) + "_ms, " + number(e.small_error) + u + ", " +
+         std::to_string(e.big_exit_time) + "_ms, " + number(e.big_error) + u + ", " + std::to_string(e.velocity_exit_time) + "_ms, " +
+         std::to_string(e.mA_timeout) + "_ms);";
+}
+
+// Pulls default_constants() out of a source file so untuned lines are kept as they are
+std::vector<std::string> constants_read(const std::string& path) {
+  std::ifstream file(path);
+  std::vector<std::string> out;
+  std::string line;
+  bool inside = false;
+  int depth = 0;
+  while (std::getline(file, line)) {
+    if (!inside && line.find("void default_constants()") != std::string::npos && line.find(';') == std::string::npos) inside = true;
+    if (!inside) continue;
+    out.push_back(line);
+    depth += std::count(line.begin(), line.end(), '{') - std::count(line.begin(), line.end(), '}');
+    if (depth == 0 && line.find('}') != std::string::npos) break;
+  }
+  return out;
+}
+
+// Reads "chassis.pid_<mode>_exit_condition_set(90_ms, 3_deg, 250_ms, 7_deg, 500_ms, 500_ms);"
+bool exit_parse(const std::vector<std::string>& lines, const std::string& mode, exit_settings& out) {
+  std::string key = "chassis.pid_" + mode + "_exit_condition_set(";
+  for (const auto& line : lines) {
+    auto at = line.find(key);
+    if (at == std::string::npos) continue;
+    std::vector<double> values;
+    std::stringstream args(line.substr(at + key.size()));
+    std::string arg;
+    while (std::getline(args, arg, ',')) values.push_back(std::atof(arg.c_str()));
+    if (values.size() < 6) return false;
+    out = {values[1], (int)values[0], values[3], (int)values[2], (int)values[4], (int)values[5]};
+    return true;
+  }
+  return false;
+}
+
+struct options {
+  std::map<std::string, std::string> logs;
+  std::map<std::string, plant_model> plants;
+  std::map<std::string, double> overshoot;
+  std::map<std::string, double> speed = {{"drive", 110}, {"turn", 100}, {"swing", 90}};
+  std::string constants = "src/autons.cpp";
+  int threads = std::max(1u, std::thread::hardware_concurrency());
+  int rounds = 12;
+  unsigned seed = 1;
+};
+
+// "drive:0.5" or "drive:K,tau_ms,delay_ms"
+std::pair<std::string, std::vector<double>> keyed_parse(const std::string& arg) {
+  auto colon = arg.find(':');
+  std::pair<std::string, std::vector<double>> out;
+  out.first = arg.substr(0, colon);
+  std::stringstream values(colon == std::string::npos ? "" : arg.substr(colon + 1));
+  std::string value;
+  while (std::getline(values, value, ',')) out.second.push_back(std::atof(value.c_str()));
+  return out;
+}
+
+options options_parse(int argc, char** argv) {
+  options out;
+  for (int i = 1; i < argc; i++) {
+    std::string arg = argv[i];
+    std::string next = i + 1 < argc ? argv[i + 1] : "";
+    if (arg == "--drive" || arg == "--turn" || arg == "--swing") {
+      out.logs[arg.substr(2)] = next, i++;
+    } else if (arg == "--plant") {
+      auto [mode, v] = keyed_parse(next);
+      if (v.size() < 3) {
+        std::fprintf(stderr, "--plant wants mode:K,tau_ms,delay_ms\n");
+        std::exit(1);
+      }
+      plant_model p;
+      p.K = v[0], p.tau = v[1] / 1000.0, p.delay = v[2] / 1000.0, p.fitted = true;
+      out.plants[mode] = p, i++;
+    } else if (arg == "--overshoot" || arg == "--speed") {
+      auto [mode, v] = keyed_parse(next);
+      if (!v.empty()) (arg == "--overshoot" ? out.overshoot : out.speed)[mode] = v[0];
+      i++;
+    } else if (arg == "--constants") {
+      out.constants = next, i++;
+    } else if (arg == "--threads") {
+      out.threads = std::max(1, std::atoi(next.c_str())), i++;
+    } else if (arg == "--rounds") {
+      out.rounds = std::max(1, std::atoi(next.c_str())), i++;
+    } else if (arg == "--seed") {
+      out.seed = std::strtoul(next.c_str(), nullptr, 10), i++;
+    } else {
+      std::fprintf(stderr, "Unknown argument %s\n", arg.c_str());
+      std::exit(1);
+    }
+  }
+  return out;
+}
+}  // namespace
+
+int main(int argc, char** argv) {
+  options opts = options_parse(argc, argv);
+  std::vector<std::string> constants = constants_read(opts.constants);
+
+  const std::map<std::string, bounds> limits = {
+      {"drive", {1.0, 60.0, 0.5, 400.0, 10.0}},
+      {"turn", {0.5, 15.0, 0.2, 100.0, 30.0}},
+      {"swing", {1.0, 20.0, 0.2, 150.0, 30.0}},
+  };
+  const std::map<std::string, std::vector<double>> default_steps = {
+      {"drive", {6, 12, 24, 48}},
+      {"turn", {15, 45, 90, 180}},
+      {"swing", {30, 45, 90}},
+  };
+
+  std::map<std::string, candidate> tuned;
+  for (std::string mode : {"drive", "turn", "swing"}) {
+    problem prob;
+    prob.name = mode;
+    prob.limits = limits.at(mode);
+    prob.max_speed = opts.speed[mode];
+    if (!exit_parse(constants, mode, prob.exit)) prob.exit = mode == "drive" ? exit_settings{1, 90, 3, 250, 500, 500} : exit_settings{3, 90, 7, 250, 500, 500};
+    prob.overshoot_limit = opts.overshoot.count(mode) ? opts.overshoot[mode] : prob.exit.small_error;
+
+    if (opts.logs.count(mode)) {
+      auto log = log_read(opts.logs[mode]);
+      prob.plant = plant_identify(log);
+      for (double s : steps_find(log)) prob.steps.push_back(s);
+      if (!prob.plant.fitted) {
+        std::fprintf(stderr, "Could not fit a plant to %s\n", opts.logs[mode].c_str());
+        return 1;
+      }
+    } else if (opts.plants.count(mode)) {
+      prob.plant = opts.plants[mode];
+    } else {
+      continue;
+    }
+    if (prob.steps.empty()) prob.steps = default_steps.at(mode);
+
+    std::printf("== %s\n", mode.c_str());
+    std::printf("plant: K %.3f units/s per output, tau %.0f ms, delay %.0f ms", prob.plant.K, prob.plant.tau * 1000, prob.plant.delay * 1000);
+    if (opts.logs.count(mode)) std::printf(", fit rms %.3f units/s, r2 %.3f", prob.plant.rms, prob.plant.r2);
+    std::printf("\nsteps:");
+    for (double s : prob.steps) std::printf(" %s", number(s).c_str());
+    std::printf("\n\nround        best    elite median   sigma\n");
+
+    std::vector<round_report> report;
+    candidate best = search(prob, opts.threads, opts.rounds, opts.seed, report);
+    for (auto& r : report) std::printf("%5d  %10.1f  %14.1f  %6.3f\n", r.round, r.best, r.elite_median, r.sigma);
+
+    std::printf("\nkp %s  ki %s  kd %s  start_i %s\n", number(best.g.kp).c_str(), number(best.g.ki).c_str(), number(best.g.kd).c_str(), number(best.g.start_i).c_str());
+    std::printf("small exit %d ms, big exit %d ms, worst overshoot %s (limit %s)\n", best.exit.small_exit_time, best.exit.big_exit_time,
+                number(best.overshoot).c_str(), number(prob.overshoot_limit).c_str());
+    for (double s : prob.steps) {
+      step_result r = step_simulate(prob.plant, best.g, s, prob.max_speed, best.exit);
+      std::printf("  step %8s: settles in %4d ms, overshoot %s\n", number(s).c_str(), r.settled ? r.final_entry + best.exit.small_exit_time : -1,
+                  number(r.overshoot).c_str());
+    }
+    if (best.cost > best.settle) std::printf("warning: no candidate met every constraint, loosen --overshoot or check the log\n");
+    std::printf("\n");
+    tuned[mode] = best;
+  }
+
+  if (tuned.empty()) {
+    std::fprintf(stderr, "Nothing to tune, pass --drive/--turn/--swing logs or --plant\n");
+    return 1;
+  }
+
+  // Swap the tuned lines into the existing default_constants(), or write a fresh one
+  if (constants.empty()) {
+    constants.push_back("void default_constants() {");
+    for (auto& [mode, c] : tuned) constants.push_back(constants_line(mode, c.g));
+    for (auto& [mode, c] : tuned) constants.push_back(exit_line(mode, c.exit));
+    constants.push_back("}");
+  } else {
+    for (auto& line : constants) {
+      for (auto& [mode, c] : tuned) {
+        if (line.find("chassis.pid_" + mode + "_constants_set(") != std::string::npos) line = constants_line(mode, c.g);
+        if (line.find("chassis.pid_" + mode + "_exit_condition_set(") != std::string::npos) line = exit_line(mode, c.exit);
+      }
+    }
+  }
+  std::printf("// Tuned default_constants(), paste over the one in src/autons.cpp\n");
+  for (auto& line : constants) std::printf("%s\n", line.c_str());
+  return 0;
+}
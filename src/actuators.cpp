@@ -0,0 +1,170 @@
+/*
+This Source Code Form is subject to the terms of the Mozilla Public
+License, v. 2.0. If a copy of the MPL was not distributed with this
+file, You can obtain one at http://mozilla.org/MPL/2.0/.
+*/
+
+#include "actuators.hpp"
+
+#include "main.h"
+
+using namespace robot;
+
+actuators::actuators(std::array<pros::adi::DigitalOut*, PISTON_COUNT> pistons, pros::Motor& intake, pros::Motor& hood)
+    : devices(pistons), motors{&intake, &hood} {}
+
+// Callers hold the mutex
+void actuators::piston_target_set(piston_id piston, bool extended) {
+  target[piston] = extended;
+  if (!extended) return;
+  for (const auto& lock : INTERLOCKS) {
+    if (lock.a == piston) target[lock.b] = false;
+    if (lock.b == piston) target[lock.a] = false;
+  }
+}
+
+void actuators::piston_set(piston_id piston, bool extended) {
+  mutex.take();
+  piston_target_set(piston, extended);
+  mutex.give();
+}
+
+bool actuators::piston_get(piston_id piston) { return target[piston]; }
+bool actuators::piston_output_get(piston_id piston) { return output[piston]; }
+
+void actuators::roller_set(roller_id roller, int speed) {
+  mutex.take();
+  roller_target[roller] = speed;
+  mutex.give();
+}
+
+int actuators::roller_get(roller_id roller) {
+  mutex.take();
+  int out = roller_target[roller];
+  mutex.give();
+  return out;
+}
+
+bool actuators::bottom_intake_get() { return bottom_intake; }
+
+bool actuators::busy() {
+  return target != output || roller_target != roller_output;
+}
+
+void actuators::update() {
+  mutex.take();
+  std::uint32_t now = pros::millis();
+
+  // Retract first so anything waiting on a gap starts timing this tick
+  for (int i = 0; i < PISTON_COUNT; i++) {
+    if (!target[i] && output[i]) {
+      devices[i]->set_value(false);
+      output[i] = false;
+      retracted[i] = true;
+      retracted_at[i] = now;
+    }
+  }
+
+  for (int i = 0; i < PISTON_COUNT; i++) {
+    if (!target[i] || output[i]) continue;
+    bool clear = true;
+    for (const auto& lock : INTERLOCKS) {
+      int other = lock.a == i ? lock.b : lock.b == i ? lock.a
+                                                     : -1;
+      if (other < 0) continue;
+      // A piston that hasn't been out since boot has nothing to clear
+      if (output[other] || (retracted[other] && now - retracted_at[other] < lock.gap)) clear = false;
+    }
+    if (clear) {
+      devices[i]->set_value(true);
+      output[i] = true;
+    }
+  }
+
+  for (int i = 0; i < ROLLER_COUNT; i++) {
+    if (roller_target[i] == roller_output[i]) continue;
+    motors[i]->move(roller_target[i]);
+    roller_output[i] = roller_target[i];
+  }
+  mutex.give();
+}
+
+void actuators::matchload_toggle() {
+  mutex.take();
+  if (!target[PISTON_MATCHLOAD]) {
+    // Aligner retracts through the interlock, matchload follows once it's clear
+    piston_target_set(PISTON_MATCHLOAD, true);
+    piston_target_set(PISTON_MIDDLE_GOAL, false);
+    piston_target_set(PISTON_HOOD, false);
+    bottom_intake = true;
+    roller_target[ROLLER_INTAKE] = -127;
+    roller_target[ROLLER_HOOD] = 0;
+  } else {
+    piston_target_set(PISTON_ALIGNER, true);
+  }
+  mutex.give();
+}
+
+void actuators::aligner_toggle() {
+  mutex.take();
+  piston_target_set(PISTON_ALIGNER, !target[PISTON_ALIGNER]);
+  mutex.give();
+}
+
+void actuators::right_descore_toggle() {
+  mutex.take();
+  if (!target[PISTON_RIGHT_DESCORE]) {
+    piston_target_set(PISTON_RIGHT_DESCORE, true);
+    roller_target[ROLLER_HOOD] = 0;
+  } else {
+    piston_target_set(PISTON_RIGHT_DESCORE, false);
+  }
+  mutex.give();
+}
+
+void actuators::middle_goal_toggle() {
+  mutex.take();
+  if (!target[PISTON_MIDDLE_GOAL]) {
+    piston_target_set(PISTON_MIDDLE_GOAL, true);
+    roller_target[ROLLER_HOOD] = -127;
+    roller_target[ROLLER_INTAKE] = -127;
+    bottom_intake = false;
+  } else {
+    piston_target_set(PISTON_MIDDLE_GOAL, false);
+  }
+  mutex.give();
+}
+
+void actuators::bottom_intake_toggle() {
+  mutex.take();
+  bottom_intake = !bottom_intake;
+  roller_target[ROLLER_INTAKE] = bottom_intake ? -127 : 127;
+  mutex.give();
+}
+
+void actuators::top_score_toggle() {
+  mutex.take();
+  if (!target[PISTON_HOOD]) {
+    // Middle goal and descore retract through the interlocks.  Matchload has none with the hood,
+    // auton_button_6 crosses the field with both extended
+    piston_target_set(PISTON_HOOD, true);
+    piston_target_set(PISTON_MATCHLOAD, false);
+    piston_target_set(PISTON_ALIGNER, true);
+    roller_target[ROLLER_HOOD] = -127;
+    roller_target[ROLLER_INTAKE] = -127;
+    bottom_intake = true;
+  } else {
+    piston_target_set(PISTON_HOOD, false);
+    roller_target[ROLLER_HOOD] = 0;
+  }
+  mutex.give();
+}
+
+void actuators::rollers_stop() {
+  mutex.take();
+  piston_target_set(PISTON_HOOD, false);
+  roller_target[ROLLER_INTAKE] = 0;
+  roller_target[ROLLER_HOOD] = 0;
+  bottom_intake = false;
+  mutex.give();
+}
@@ -4,12 +4,6 @@
 // EXTERN DECLARATIONS
 /////
 extern pros::Motor intake;
-extern pros::Motor hood_motor;
-extern pros::ADIDigitalOut matchload_piston;
-extern pros::ADIDigitalOut right_descore_piston;
-extern pros::ADIDigitalOut middle_goal_piston;
-extern pros::ADIDigitalOut hood_piston;
-extern pros::ADIDigitalOut aligner_piston;
 
 // DISTANCE SENSOR (Port 10 in main.cpp)
 extern pros::Distance dist_sensor; 
@@ -68,44 +62,47 @@ void jiggle(int time_ms) {
   chassis.drive_brake_set(pros::E_MOTOR_BRAKE_BRAKE);
 }
 
-void set_intake(int speed) { intake.move(speed); }
-void set_hood_motor(int speed) { hood_motor.move(speed); }
+// Mechanisms go through the actuators sequencer, so these only set targets and return.  The
+// actuators stage applies them on the next tick and keeps the interlocks.
+void set_intake(int speed) { mechanisms.roller_set(robot::ROLLER_INTAKE, speed); }
+void set_hood_motor(int speed) { mechanisms.roller_set(robot::ROLLER_HOOD, speed); }
 
 void bottom_intake() {
   set_intake(-127);
   intake.set_brake_mode(pros::E_MOTOR_BRAKE_COAST);
 }
 
+void matchload_down() { mechanisms.piston_set(robot::PISTON_MATCHLOAD, true); }
+void matchload_up() { mechanisms.piston_set(robot::PISTON_MATCHLOAD, false); }
+
 void top_outtake() {
   set_hood_motor(-127);
-  hood_piston.set_value(true);
-  matchload_piston.set_value(false);
-  middle_goal_piston.set_value(false);
+  mechanisms.piston_set(robot::PISTON_HOOD, true);  // retracts middle goal
+  matchload_up();
   set_intake(-127); 
 }
 
 void stop_intake() {
   set_intake(0);
   set_hood_motor(0);
-  hood_piston.set_value(false);
+  mechanisms.piston_set(robot::PISTON_HOOD, false);
 }
 void alignerDown() {
-  aligner_piston.set_value(true);
+  mechanisms.piston_set(robot::PISTON_ALIGNER, true);
 }
 void alignerUp() {
-  aligner_piston.set_value(false);
+  mechanisms.piston_set(robot::PISTON_ALIGNER, false);
 }
 
 void top_intake() {
   set_hood_motor(0);
-  hood_piston.set_value(false);
+  mechanisms.piston_set(robot::PISTON_HOOD, false);
 }
 
 void bottom_outtake() { set_intake(127); }
 
 void middle_goal_action() {
-  middle_goal_piston.set_value(true);
-  hood_piston.set_value(false);
+  mechanisms.piston_set(robot::PISTON_MIDDLE_GOAL, true);  // lowers the hood
   set_hood_motor(-127);
   set_intake(-127);
 }
@@ -172,7 +169,7 @@ void LEFT_SIDE_AWP() {
   top_outtake();
   pros::delay(1250); 
 
-  matchload_piston.set_value(true);
+  matchload_down();
   bottom_intake();
   top_intake();
   chassis.pid_turn_relative_set(-6_deg, TURN_SPEED);
@@ -184,7 +181,7 @@ void LEFT_SIDE_AWP() {
   chassis.pid_drive_set(-14_in, 110);
   chassis.pid_wait();
 
-  matchload_piston.set_value(false);
+  matchload_up();
 
   chassis.pid_turn_relative_set(49.5_deg, TURN_SPEED);
   chassis.pid_wait();
@@ -194,7 +191,7 @@ void LEFT_SIDE_AWP() {
 
   middle_goal_action();
   pros::delay(1000);
-  middle_goal_piston.set_value(false);
+  mechanisms.piston_set(robot::PISTON_MIDDLE_GOAL, false);
   top_intake();
   chassis.pid_drive_set(14_in, 110);
   chassis.pid_wait();
@@ -250,7 +247,7 @@ top_outtake();
 pros::delay(1250); 
 chassis.pid_turn_relative_set(-4_deg, TURN_SPEED); // Nudge turn to align with goal
 chassis.pid_wait_quick_chain();
-matchload_piston.set_value(true);
+matchload_down();
 bottom_intake();
 top_intake();
 alignerUp(); // Retract aligner
@@ -265,7 +262,7 @@ jiggle(500); // Unstuck/Grab balls
 
 chassis.pid_drive_set(-7.5_in, 110);
 chassis.pid_wait();
-matchload_piston.set_value(false);
+matchload_up();
 
 // Inverted: 50 -> -50
 chassis.pid_turn_relative_set(135.5_deg, TURN_SPEED);
@@ -282,41 +279,39 @@ bottom_outtake();
 void auton_skills() {
   chassis.odom_xyt_set(0_in, 0_in, 0_deg);
   bottom_intake();
-  chassis.pid_odom_set({{-4.5_in, 40_in, 0_deg}, fwd, 110});
-  chassis.pid_wait_until({-3_in,29_in});
-  matchload_piston.set_value(true);   
-  chassis.pid_wait();
+  robot::chassis_events.pid_odom_set({{-4.5_in, 40_in, 0_deg}, fwd, 110});
+  robot::chassis_events.past_point(-3, 29, matchload_down);
+  robot::pid_wait();
   chassis.pid_turn_set(-124_deg, TURN_SPEED);
   chassis.pid_wait_quick_chain();
   //got balls
   chassis.pid_odom_set({{4.25_in,48.6_in}, rev, 100});
-  chassis.pid_wait();
+  robot::pid_wait();
   middle_goal_action();
   pros::delay(1400);
   //middle goal scored
-  middle_goal_piston.set_value(false);
+  mechanisms.piston_set(robot::PISTON_MIDDLE_GOAL, false);
   top_intake();
   chassis.pid_odom_set({{-31_in,1_in, 180_deg}, fwd, 100});
   chassis.pid_wait_quick_chain();
   pros::delay(150);
-  chassis.pid_odom_set({{-31_in,25_in}, rev, 100});
-  chassis.pid_wait_until({-30_in, 15_in});
-  alignerDown();
-  chassis.pid_wait_quick_chain();
+  robot::chassis_events.pid_odom_set({{-31_in,25_in}, rev, 100});
+  robot::chassis_events.past_point(-30, 15, alignerDown);
+  robot::pid_wait_quick_chain();
   top_outtake();
   pros::delay(1000);
   top_intake();
   chassis.pid_odom_set({{-31_in,10_in}, fwd, 100});
   chassis.pid_wait_quick_chain();
   alignerUp();
-  right_descore_piston.set_value(true);
+  mechanisms.piston_set(robot::PISTON_RIGHT_DESCORE, true);
   chassis.pid_odom_set({{-20.5_in,30_in, 184_deg}, rev, 100});
   chassis.pid_wait_quick_chain();
-  right_descore_piston.set_value(false);
+  mechanisms.piston_set(robot::PISTON_RIGHT_DESCORE, false);
   pros::delay(100);
   chassis.drive_brake_set(pros::E_MOTOR_BRAKE_HOLD);
   chassis.pid_odom_set({{-20.5_in,54.2_in}, rev, 70});
-  chassis.pid_wait();
+  robot::pid_wait();
   /*chassis.pid_odom_set({{0_in, 12_in}, fwd, 100});
   chassis.pid_wait_quick_chain();
     pros::delay(1000);
@@ -364,7 +359,7 @@ void LEFT_SIDE_NO_AWP() {
   top_outtake();
   pros::delay(1250); 
 
-  matchload_piston.set_value(true);
+  matchload_down();
   bottom_intake();
   top_intake();
   alignerUp();
@@ -377,7 +372,7 @@ void LEFT_SIDE_NO_AWP() {
 
   chassis.pid_drive_set(-13_in, 110);
   chassis.pid_wait();
-  matchload_piston.set_value(false);
+  matchload_up();
 
 
   chassis.pid_turn_relative_set(52_deg, TURN_SPEED);
@@ -405,14 +400,14 @@ void LEFT_SIDE_NO_AWP() {
 void auton_button_5() {
   chassis.pid_drive_set(-9.25_in,100);
   chassis.pid_wait();
-  matchload_piston.set_value(true);
+  matchload_down();
   bottom_intake();
   chassis.pid_drive_set(10_in,75);
   chassis.pid_wait();
   chassis.pid_drive_set(25_in,127);
   chassis.pid_wait();
   pros::delay(4000);
-  matchload_piston.set_value(false);
+  matchload_up();
   chassis.pid_drive_set(6_in,85);
   chassis.pid_wait();
 }
@@ -429,7 +424,7 @@ void auton_button_6() {
   chassis.pid_turn_relative_set(-90_deg, TURN_SPEED);
   chassis.pid_wait_quick_chain();
 
-  matchload_piston.set_value(true);
+  matchload_down();
   bottom_intake();
   pros::delay(300);
 
@@ -452,7 +447,7 @@ void auton_button_6() {
   alignerUp();
   chassis.pid_turn_relative_set(-45_deg, TURN_SPEED);
   chassis.pid_wait_quick_chain();
-  matchload_piston.set_value(true);
+  matchload_down();
   
   //cross field 1
   chassis.pid_odom_set(55_in, 100);
@@ -462,7 +457,7 @@ void auton_button_6() {
   chassis.pid_wait_quick_chain();
   chassis.pid_odom_set(26.5_in,100);
   chassis.pid_wait();
-  matchload_piston.set_value(false);
+  matchload_up();
   chassis.pid_turn_relative_set(40_deg, TURN_SPEED);
   chassis.pid_wait_quick_chain();
 
@@ -478,7 +473,7 @@ void auton_button_6() {
   //matchload 2
   alignerUp();
   pros::delay(250);
-  matchload_piston.set_value(true);
+  matchload_down();
   top_intake();
   chassis.pid_odom_set(29_in, 85);
   chassis.pid_wait();
@@ -490,7 +485,7 @@ void auton_button_6() {
   top_outtake();
   bottom_intake();
   pros::delay(2500);
-  hood_piston.set_value(false);
+  mechanisms.piston_set(robot::PISTON_HOOD, false);
   pros::delay(700);
 
  //prepare to cross field
@@ -500,7 +495,7 @@ void auton_button_6() {
   chassis.pid_wait();
   chassis.pid_turn_relative_set(90_deg, TURN_SPEED);
   chassis.pid_wait_quick_chain();
-  matchload_piston.set_value(true);
+  matchload_down();
   //cross field 2
   chassis.pid_odom_set(96_in, 100);
   chassis.pid_wait();
@@ -523,7 +518,7 @@ void auton_button_6() {
   alignerUp();
   chassis.pid_turn_relative_set(-45_deg, TURN_SPEED);
   chassis.pid_wait_quick_chain();
-  matchload_piston.set_value(true);
+  matchload_down();
   
   //cross field 3
   pros::delay(100);
@@ -535,7 +530,7 @@ void auton_button_6() {
   chassis.pid_wait_quick_chain();
   chassis.pid_odom_set(33.5_in,100);
   chassis.pid_wait();
-  matchload_piston.set_value(false);
+  matchload_up();
   chassis.pid_turn_relative_set(40_deg, TURN_SPEED);
   chassis.pid_wait_quick_chain();
 
@@ -551,7 +546,7 @@ void auton_button_6() {
   //matchload 4
   alignerUp();
   pros::delay(250);
-  matchload_piston.set_value(true);
+  matchload_down();
   top_intake();
   chassis.pid_odom_set(29_in, 85);
   chassis.pid_wait();
@@ -563,7 +558,7 @@ void auton_button_6() {
   top_outtake();
   bottom_intake();
   pros::delay(2500);
-  hood_piston.set_value(false);
+  mechanisms.piston_set(robot::PISTON_HOOD, false);
 
   //prepare to park
   chassis.pid_odom_set(15_in, 80);
@@ -624,4 +619,12 @@ void auton_button_8() {
   bottom_intake();
   chassis.CURRENT_BRAKE = pros::E_MOTOR_BRAKE_HOLD;
   chassis.drive_brake_set(pros::E_MOTOR_BRAKE_HOLD);
-}
\ No newline at end of file
+}
+
+// Measures the drive's feedforward, needs 4 feet clear in front and behind.  Paste the gains it
+// prints into initialize().  Runs in the simulator too, once it's built with
+// make sim EZ_TEMPLATE_SRC=<path to EZ-Template/src>: bin/sim/sim Characterize
+void drive_characterize() {
+  chassis.drive_brake_set(pros::E_MOTOR_BRAKE_COAST);
+  robot::chassis_velocity.characterize();
+}
@@ -0,0 +1,88 @@
+/*
+This Source Code Form is subject to the terms of the Mozilla Public
+License, v. 2.0. If a copy of the MPL was not distributed with this
+file, You can obtain one at http://mozilla.org/MPL/2.0/.
+*/
+
+#include "drive_velocity.hpp"
+
+#include <algorithm>
+#include <cmath>
+
+#include "main.h"
+
+using namespace robot;
+
+drive_velocity robot::chassis_velocity;
+
+namespace {
+constexpr double MIN_R2 = 0.9;  // a worse fit means the test went wrong, eg. the robot hit something
+constexpr double FREE_TICKS = 3000.0;  // encoder ticks a second at full speed, any cartridge
+}  // namespace
+
+void drive_velocity::gains_set(feedforward_gains left_gains, feedforward_gains right_gains) {
+  mutex.take();
+  left = left_gains;
+  right = right_gains;
+  measured = true;
+  mutex.give();
+}
+
+feedforward_gains drive_velocity::fallback_get() { return {0.0, 127.0 / top_speed_get(), 0.0}; }
+
+feedforward_gains drive_velocity::left_gains_get() {
+  mutex.take();
+  bool set = measured;
+  feedforward_gains out = left;
+  mutex.give();
+  return set ? out : fallback_get();
+}
+
+feedforward_gains drive_velocity::right_gains_get() {
+  mutex.take();
+  bool set = measured;
+  feedforward_gains out = right;
+  mutex.give();
+  return set ? out : fallback_get();
+}
+
+double drive_velocity::top_speed_get() { return FREE_TICKS / chassis.drive_tick_per_inch(); }
+
+// drive_rpm_get() is the cartridge's, the motors' free speed
+double drive_velocity::wheel_velocity_get(double rpm) { return rpm / chassis.drive_rpm_get() * top_speed_get(); }
+
+void drive_velocity::set(double left_velocity, double right_velocity, double left_accel, double right_accel, double left_feedback, double right_feedback) {
+  double l = feedforward_output(left_gains_get(), left_velocity, left_accel) + left_feedback;
+  double r = feedforward_output(right_gains_get(), right_velocity, right_accel) + right_feedback;
+  chassis.drive_set(std::clamp((int)std::lround(l), -127, 127), std::clamp((int)std::lround(r), -127, 127));
+}
+
+bool drive_velocity::characterize(characterize_settings settings) {
+  chassis.drive_mode_set(ez::DISABLE);
+  feedforward_characterizer test(settings);
+  std::uint32_t period = control_loop.period_get();
+  double dt = period / 1000.0;
+
+  // drive_telemetry is sampled every control_loop tick, so this reads a fresh one each loop
+  std::uint32_t loop_time = pros::millis();
+  while (!test.done()) {
+    motor_telemetry t = drive_telemetry.get();
+    double output = test.update(dt, wheel_velocity_get(t.left_velocity()), wheel_velocity_get(t.right_velocity()));
+    int command = std::clamp((int)std::lround(output), -127, 127);
+    chassis.drive_set(command, command);
+    pros::Task::delay_until(&loop_time, period);
+  }
+  chassis.drive_set(0, 0);
+
+  feedforward_fit l = feedforward_fit_get(test.left_samples(), dt);
+  feedforward_fit r = feedforward_fit_get(test.right_samples(), dt);
+  printf("\nfeedforward  left kS %.2f kV %.3f kA %.4f r2 %.3f (%i samples)\n", l.gains.kS, l.gains.kV, l.gains.kA, l.r2, l.samples);
+  printf("            right kS %.2f kV %.3f kA %.4f r2 %.3f (%i samples)\n", r.gains.kS, r.gains.kV, r.gains.kA, r.r2, r.samples);
+  if (l.r2 < MIN_R2 || r.r2 < MIN_R2) {
+    printf("feedforward: fit is poor, gains not changed.  Give it room and try again\n");
+    return false;
+  }
+  gains_set(l.gains, r.gains);
+  printf("robot::chassis_velocity.gains_set({%.2f, %.3f, %.4f}, {%.2f, %.3f, %.4f});\n", l.gains.kS, l.gains.kV, l.gains.kA, r.gains.kS, r.gains.kV, r.gains.kA);
+  return true;
+}
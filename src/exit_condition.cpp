@@ -0,0 +1,180 @@
+/*
+This Source Code Form is subject to the terms of the Mozilla Public
+License, v. 2.0. If a copy of the MPL was not distributed with this
+file, You can obtain one at http://mozilla.org/MPL/2.0/.
+*/
+
+#include "exit_condition.hpp"
+
+#include <algorithm>
+#include <atomic>
+#include <cmath>
+#include <cstdio>
+
+using namespace robot;
+
+namespace {
+std::atomic<int> mode_current{EXIT_TIMERS};
+pros::Mutex stats_mutex;
+exit_stats stats;
+}  // namespace
+
+void robot::exit_mode_set(exit_mode mode) { mode_current = mode; }
+
+exit_mode robot::exit_mode_get() { return (exit_mode)mode_current.load(); }
+
+void robot::exit_stats_add(std::uint32_t saved) {
+  stats_mutex.take();
+  stats.motions++;
+  if (saved > 0) stats.predicted++;
+  stats.saved += saved;
+  stats.last_saved = saved;
+  stats_mutex.give();
+}
+
+exit_stats robot::exit_stats_get() {
+  stats_mutex.take();
+  exit_stats out = stats;
+  stats_mutex.give();
+  return out;
+}
+
+void robot::exit_stats_reset() {
+  stats_mutex.take();
+  stats = {};
+  stats_mutex.give();
+}
+
+void robot::exit_stats_print() {
+  exit_stats s = exit_stats_get();
+  printf("exit: %i motions, %i ended by prediction, %.2f s saved\n", s.motions, s.predicted, s.saved / 1000.0);
+}
+
+pid_exit::pid_exit(ez::PID& pid) : pid(&pid), mode(exit_mode_get()) {}
+
+void pid_exit::reset() {
+  mA_time = 0;
+  sampled = false;
+  mode = exit_mode_get();
+  predictor.reset();
+  small_time = big_time = velocity_time = 0;
+  saved = 0;
+}
+
+int pid_exit::saved_get() { return saved; }
+
+// Runs when the timers haven't exited yet.  Keeps its own copy of how long each has been
+// running, to know how much later it would have exited than the prediction.
+ez::exit_output pid_exit::predict(bool print) {
+  if (mode != EXIT_PREDICTED) return ez::RUNNING;
+  const auto& exit = pid->exit;
+  double error = std::fabs(pid->error);
+  small_time = error < exit.small_error ? small_time + ez::util::DELAY_TIME : 0;
+  big_time = error < exit.big_error ? big_time + ez::util::DELAY_TIME : 0;
+  velocity_time = std::fabs(pid->derivative) <= 0.05 ? velocity_time + ez::util::DELAY_TIME : 0;
+
+  double big = pid->constants.ki == 0.0 ? exit.big_error : 0.0;
+  settle_result result = predictor.update(pid->error, exit.small_error, big);
+  if (result == SETTLE_SMALL) {
+    saved = std::max(0, exit.small_exit_time + ez::util::DELAY_TIME - small_time);
+    if (print) printf("  Predicted Small Exit, %i ms early.\n", saved);
+    return ez::SMALL_EXIT;
+  }
+  if (result == SETTLE_BIG) {
+    // Whichever of the big and velocity timers would have gone first
+    int big_left = exit.big_exit_time != 0 ? exit.big_exit_time + ez::util::DELAY_TIME - big_time : INT32_MAX;
+    int velocity_left = exit.velocity_exit_time != 0 ? exit.velocity_exit_time + ez::util::DELAY_TIME - velocity_time : INT32_MAX;
+    saved = std::max(0, std::min(big_left, velocity_left));
+    if (saved == INT32_MAX) saved = 0;
+    if (print) printf("  Predicted Big Exit, %i ms early.\n", saved);
+    return ez::BIG_EXIT;
+  }
+  return ez::RUNNING;
+}
+
+// Same timeout EZ-Template uses, the motors have to be over current for mA_timeout in a row.
+// count is false when there's no new reading, the timeout then holds where it was
+ez::exit_output pid_exit::mA_check(bool over_current, bool count, bool print) {
+  if (pid->exit.mA_timeout != 0 && count) {
+    if (over_current) {
+      mA_time += ez::util::DELAY_TIME;
+      if (mA_time > pid->exit.mA_timeout) {
+        if (print) printf("  mA Exit.\n");
+        return ez::mA_EXIT;
+      }
+    } else {
+      mA_time = 0;
+    }
+  }
+  ez::exit_output out = pid->exit_condition(print);
+  return out == ez::RUNNING ? predict(print) : out;
+}
+
+ez::exit_output pid_exit::exit_condition(bool over_current, bool print) { return mA_check(over_current, true, print); }
+
+ez::exit_output pid_exit::exit_condition(std::span<const pros::Motor> motors, bool print) {
+  bool over_current = false;
+  if (pid->exit.mA_timeout != 0) {
+    for (const auto& motor : motors) {
+      if (motor.is_over_current()) {
+        over_current = true;
+        break;
+      }
+    }
+  }
+  return mA_check(over_current, true, print);
+}
+
+ez::exit_output pid_exit::exit_condition(const motor_telemetry& telemetry, bool left, bool right, bool print) {
+  bool fresh = !sampled || telemetry.time != sample_time;
+  sampled = true;
+  sample_time = telemetry.time;
+  return mA_check((left && telemetry.left_over_current) || (right && telemetry.right_over_current), fresh, print);
+}
+
+exit_wait_result robot::exits_wait(ez::e_mode mode, ez::e_swing swing, pid_exit& left, pid_exit& right, pid_exit& angular, bool print) {
+  ez::exit_output left_exit = ez::RUNNING, right_exit = ez::RUNNING, angular_exit = ez::RUNNING;
+  bool swing_left = swing == ez::LEFT_SWING;
+  exit_wait_result out;
+  std::uint32_t loop_time = pros::millis();
+  std::uint8_t status = pros::competition::get_status();
+  while (true) {
+    // The field disabling the robot, or moving on to driver control, ends the wait, EZ's own
+    // wait would sit out its timers while autonomous() is about to be killed
+    std::uint8_t now = pros::competition::get_status();
+    if ((now & COMPETITION_DISABLED) || (now & COMPETITION_AUTONOMOUS) != (status & COMPETITION_AUTONOMOUS)) {
+      out.aborted = true;
+      break;
+    }
+
+    const motor_telemetry telemetry = drive_telemetry.get();
+    if (mode == ez::DRIVE) {
+      bool left_running = left_exit == ez::RUNNING, right_running = right_exit == ez::RUNNING;
+      if (left_running) left_exit = left.exit_condition(telemetry, true, false, print);
+      if (right_running) right_exit = right.exit_condition(telemetry, false, true, print);
+      if (left_exit != ez::RUNNING && right_exit != ez::RUNNING) {
+        // The side that exited last decides, the motion can't have ended sooner on its timers
+        out.saved = std::max(left_running ? left.saved_get() : 0, right_running ? right.saved_get() : 0);
+        break;
+      }
+    } else {
+      bool turn = mode == ez::TURN;
+      angular_exit = angular.exit_condition(telemetry, turn || swing_left, turn || !swing_left, print);
+      if (angular_exit != ez::RUNNING) {
+        out.saved = angular.saved_get();
+        break;
+      }
+    }
+    // EZ-Template's exit timers count DELAY_TIME per call, so this has to run at that rate
+    pros::Task::delay_until(&loop_time, ez::util::DELAY_TIME);
+  }
+
+  if (out.aborted) return out;
+  auto interfered = [](ez::exit_output e) { return e == ez::mA_EXIT || e == ez::VELOCITY_EXIT; };
+  out.interfered = interfered(left_exit) || interfered(right_exit) || interfered(angular_exit);
+  if (left_exit == ez::mA_EXIT || right_exit == ez::mA_EXIT || angular_exit == ez::mA_EXIT)
+    out.exit = ez::mA_EXIT;
+  else
+    out.exit = mode == ez::DRIVE ? std::max(left_exit, right_exit) : angular_exit;
+  return out;
+}
@@ -6,6 +6,9 @@
 
 pros::Controller master(pros::E_CONTROLLER_MASTER);
 
+// Every periodic stage (sensors, odometry, control, output) runs in order on this 10 ms tick
+robot::scheduler control_loop(ez::util::DELAY_TIME);
+
 // Announce Autons
 void LEFT_SIDE_AWP();
 void RIGHT_SIDE_ROUTE(); // Make sure this name matches autons.cpp
@@ -14,6 +17,7 @@ void LEFT_SIDE_NO_AWP();
 void auton_button_5();
 void auton_button_6();
 void auton_button_8();
+void drive_characterize();
 void default_constants(); 
 
 // ----------------------------------------------------------------------------
@@ -34,7 +38,7 @@ pros::Motor intake(-15, pros::v5::MotorGears::blue, pros::v5::MotorUnits::degree
 pros::Motor hood_motor(6, pros::v5::MotorGears::blue, pros::v5::MotorUnits::degrees); 
 
 // DISTANCE SENSOR (Added based on previous context)
-pros::Distance dist_sensor(14); 
+pros::Distance dist_sensor(DIST_SENSOR_PORT);
 
 // PNEUMATICS
 pros::ADIDigitalOut matchload_piston('A');
@@ -43,13 +47,10 @@ pros::ADIDigitalOut middle_goal_piston('C');
 pros::ADIDigitalOut hood_piston('D');
 pros::ADIDigitalOut aligner_piston('E'); // NEW ALIGNER
 
-// TOGGLE FLAGS
-bool matchloadOn = false;
-bool rightDescoreOn = false;
-bool middleGoalOn = false;
-bool topOutakeOn = false;
-bool bottomIntakeOn = false;
-bool alignerOn = false; // NEW FLAG
+// Pistons and rollers, sequenced every control_loop tick so button presses never block the drive
+robot::actuators mechanisms(
+    {&matchload_piston, &right_descore_piston, &middle_goal_piston, &hood_piston, &aligner_piston},  // robot::piston_id order
+    intake, hood_motor);
 
 // ----------------------------------------------------------------------------
 // INITIALIZATION
@@ -64,6 +65,19 @@ void initialize() {
   // PID TUNING
   default_constants(); 
 
+  // PURE PURSUIT PATHS
+  // Smoothed pure pursuit routes compiled here start driving immediately in autonomous, start them
+  // with robot::pp_paths.pid_odom_smooth_pp_set() using the same start and points, eg.
+  // robot::pp_paths.compile({0, 0}, std::vector<ez::united_odom>{{{24_in, 24_in}, fwd, 110}, {{48_in, 0_in}, fwd, 110}});
+  // Set the speed limits through curves first with robot::pp_paths.profile_set().  Routes that
+  // never change can be compiled by the compiler instead, see include/route.hpp, and driven with
+  // robot::route_start().
+
+  // TRAJECTORIES
+  // Spline trajectories timed to the drive's limits take a while to generate, so generate them
+  // here, keep the result, and follow it with robot::chassis_trajectory.start(), eg.
+  // static auto curve = robot::chassis_trajectory.generate({{0_in, 0_in, 0_deg}, {24_in, 36_in, 90_deg}});
+
   // AUTONOMOUS SELECTOR
   ez::as::auton_selector.autons_add({
       {"Button 1\n\n(L1) Left Side Route AWP", LEFT_SIDE_AWP},
@@ -73,14 +87,86 @@ void initialize() {
       {"Button 5\n\nSKILLS JUST PARK", auton_button_5},
       {"Button 6\n\nTurn 360 Degrees", auton_button_6},
       {"Button 8\n\nEmpty slot", auton_button_8},
+      {"Characterize\n\nDrive feedforward kS kV kA", drive_characterize},
   });
 
   chassis.initialize();
   ez::as::initialize();
+
+  // TRAJECTORY LIBRARY
+  // Path files from bin/sim/path_convert in /usd/paths/auton_<selector page>/ load in the
+  // background from here, and again whenever the page changes.  Follow one in an auton with
+  // robot::trajectories.start(robot::path_id_get("skills_1")), which waits for it if needed
+  robot::trajectories_select();
+
+  // DRIVE FEEDFORWARD
+  // Run the Characterize auton once, then paste the robot::chassis_velocity.gains_set() it prints
+  // here.  Trajectories drive through it.
+
+  // PROFILED MOTIONS (only built with make PROFILED_MOTION=1, they don't beat EZ's slew yet)
+  // robot::chassis_profile.pid_drive_set(48_in, 110) and robot::chassis_profile.wait() drive a
+  // trapezoidal or S-curve plan through the feedforward, using the PID constants above.  Keep
+  // accel under what the tires grip, bin/sim/motion_profile_bench shows what slipping costs, eg.
+  // robot::chassis_profile.settings_set({robot::PROFILE_S_CURVE, 170.0, 8000.0});
+  // Motions queued with pid_drive_queue() and pid_turn_relative_queue() run as one from
+  // queue_start(), rounding drive, turn, drive corners off at blend_radius without stopping.
+
+  // EXIT CONDITIONS
+  // robot::pid_wait() and profiled motions exit as soon as the error is predicted to have settled
+  // instead of waiting out the small and big exit timers.  Check it on a log with
+  // bin/sim/exit_replay first, then turn it on here:
+  // robot::exit_mode_set(robot::EXIT_PREDICTED);
+
+  // GAIN SCHEDULES
+  // Constants tuned on a full battery overshoot or stall on a drained one.  Tune a few speeds and
+  // voltages with bin/sim/gain_bench or on the robot and schedule them, the rest are blended, eg.
+  // robot::gain_schedule turn({0, 127, 3}, {11.8, 12.6, 2});
+  // turn.fill({3, 0.05, 20, 15});
+  // turn.set(2, 0, {3.6, 0.05, 24, 15});
+  // robot::chassis_gains.table_set(robot::SCHEDULE_TURN, turn);
+  // and robot::chassis_gains.payload_set(true) in an auton once the robot is carrying blocks.
+
+  // POSE FUSION
+  // Corrects odometry drift with dist_sensor reading the perimeter.  Off until an auton says
+  // where the robot is on the field, eg. after chassis.odom_xyt_set() in auton_skills():
+  // robot::chassis_fusion.start_set(-48, -48, 0);  // inches from the field center, like the GPS
+  // No auton does yet: DIST_SENSOR_MOUNT is a guess until it's measured, and correct_to_goal()
+  // aims dist_sensor at goals, so their footprints have to be in the filter first or their faces
+  // pass for the wall, eg.
+  // robot::filter_settings fusion = robot::chassis_fusion.settings_get();
+  // fusion.obstacles[fusion.obstacle_count++] = {x_min, y_min, x_max, y_max};  // one per goal, inches
+  // robot::chassis_fusion.settings_set(fusion);
+  robot::chassis_fusion.distance_set(&dist_sensor, DIST_SENSOR_MOUNT);
+
+  // CONTROL LOOP STAGES (run in this order every tick)
+  control_loop.stage_add("gains", robot::chassis_gains_update);
+  control_loop.stage_add("telemetry", robot::drive_telemetry_sample);
+  control_loop.stage_add("fusion", robot::chassis_pose_fuse);
+  control_loop.stage_add("pose", robot::chassis_pose_publish);
+  control_loop.stage_add("events", robot::chassis_events_check);
+  control_loop.stage_add("trajectory", robot::chassis_trajectory_update);
+#ifdef ROBOT_PROFILED_MOTION
+  control_loop.stage_add("profile", robot::chassis_profile_update);
+#endif
+  control_loop.stage_add("actuators", []() { mechanisms.update(); });
+  control_loop.stage_add("recorder", robot::chassis_record);
+  control_loop.start();
+  robot::chassis_recorder.open();  // logs autonomous to /usd when a card is in
 }
 
-void disabled() {}
-void competition_initialize() {}
+// The selector's page can change until autonomous starts, so keep the trajectory library on it
+void disabled() {
+  while (true) {
+    robot::trajectories_select();
+    pros::delay(100);
+  }
+}
+void competition_initialize() {
+  while (true) {
+    robot::trajectories_select();
+    pros::delay(100);
+  }
+}
 
 // ----------------------------------------------------------------------------
 // AUTONOMOUS RUNNER
@@ -89,136 +175,12 @@ void autonomous() {
   chassis.pid_targets_reset();       
   chassis.drive_sensor_reset();      
   chassis.drive_brake_set(pros::E_MOTOR_BRAKE_HOLD); 
+  robot::chassis_recorder.start();  // the file is already open, see initialize()
+  robot::exit_stats_reset();
+  robot::trajectories_select();  // in case the page changed without a field control switch
   ez::as::auton_selector.selected_auton_call(); 
-}
-
-// ----------------------------------------------------------------------------
-// BUTTON LOGIC
-// ----------------------------------------------------------------------------
-
-void rightDescoreD() {
-    if (!rightDescoreOn) {
-        right_descore_piston.set_value(true);
-        rightDescoreOn = true;
-        hood_motor.move(0);   
-        hood_piston.set_value(false);
-        topOutakeOn = false;
-    } else {
-        right_descore_piston.set_value(false);
-        rightDescoreOn = false;
-    }
-}
-
-void middleGoalD() {
-    if (!middleGoalOn) {
-        middle_goal_piston.set_value(true);
-        hood_piston.set_value(false);
-        hood_motor.move(-127); 
-        intake.move(-127);     
-        middleGoalOn = true;
-        
-        // Reset Conflicts
-        topOutakeOn = false;
-        bottomIntakeOn = false;
-        // Don't necessarily need to reset matchload/aligner here unless they physically collide
-    } else {
-        middle_goal_piston.set_value(false);
-        middleGoalOn = false;
-    }
-}
-
-// --- NEW ALIGNER LOGIC ---
-// Mapped to Button Y
-void alignerD() {
-    if (!alignerOn) {
-        matchload_piston.set_value(false);
-        matchloadOn = false;
-        pros::delay(250);
-        aligner_piston.set_value(true);
-        alignerOn = true;
-
-        // FORCE MATCHLOAD OFF (Mutual Exclusion)
-        
-    } else {
-        aligner_piston.set_value(false);
-        alignerOn = false;
-    }
-}
-
-// --- UPDATED MATCHLOAD LOGIC ---
-void matchloadD() {
-    if (!matchloadOn) {
-        // FORCE ALIGNER OFF (Mutual Exclusion)
-        aligner_piston.set_value(false);
-        alignerOn = false;
-        pros::delay(250);
-        matchload_piston.set_value(true);
-        matchloadOn = true;
-
-        
-
-        // Turn off other stuff
-        middle_goal_piston.set_value(false);
-        middleGoalOn = false;
-        topOutakeOn = false;
-        bottomIntakeOn = true;
-        
-        intake.move(-127);    
-        hood_piston.set_value(false);
-        hood_motor.move(0);   
-    } else {
-        matchload_piston.set_value(false);
-        matchloadOn = false;
-        pros::delay(250);
-        aligner_piston.set_value(true);
-        alignerOn = true;
-    }
-}
-
-void bottomIntakeD() {
-    if (!bottomIntakeOn) {
-        intake.move(-127);    
-        bottomIntakeOn = true;
-    } else {
-        intake.move(127);    
-        bottomIntakeOn = false;
-    }
-}
-
-void topOutakeD() {
-    if (!topOutakeOn) {
-        hood_motor.move(-127); 
-        hood_piston.set_value(true);
-        middle_goal_piston.set_value(false);
-        matchload_piston.set_value(false);
-        aligner_piston.set_value(true); // Safety: retract aligner when shooting
-        alignerOn = true;
-        right_descore_piston.set_value(false);
-        rightDescoreOn = false;
-
-        intake.move(-127);    
-        topOutakeOn = true;
-        
-        middleGoalOn = false;
-        matchloadOn = false;
-        bottomIntakeOn = true;
-    } else {
-        hood_motor.move(0);   
-        hood_piston.set_value(false);
-        topOutakeOn = false;
-    }
-}
-
-void stopIntake() {
-    intake.move(0);
-    hood_motor.move(0);
-    hood_piston.set_value(false);
-    bottomIntakeOn = false;
-    topOutakeOn = false;
-    
-    // Optional: Reset pistons to safe state?
-    // matchload_piston.set_value(false);
-    // aligner_piston.set_value(false);
+  robot::chassis_recorder.stop();
+  robot::exit_stats_print();
 }
 
 // ----------------------------------------------------------------------------
@@ -226,27 +188,36 @@ void stopIntake() {
 // ----------------------------------------------------------------------------
 void opcontrol() {
   chassis.drive_brake_set(pros::E_MOTOR_BRAKE_COAST); 
-
+  robot::chassis_recorder.stop();  // field control ends auton without returning
+  robot::chassis_events.clear();
+  robot::chassis_trajectory.stop();
+#ifdef ROBOT_PROFILED_MOTION
+  robot::chassis_profile.stop();
+#endif
+
+  // delay_until keeps the loop on a fixed period instead of drifting by however long the body took
+  std::uint32_t loop_time = pros::millis();
   while (true) {
     chassis.opcontrol_arcade_standard(ez::SPLIT); 
 
     // TRIGGER AUTON (B + DOWN)
     if (master.get_digital(pros::E_CONTROLLER_DIGITAL_B) && master.get_digital(pros::E_CONTROLLER_DIGITAL_DOWN)) {
         autonomous();
+        loop_time = pros::millis();
     }
 
-    // BUTTONS
-    if (master.get_digital_new_press(pros::E_CONTROLLER_DIGITAL_L1)) rightDescoreD();
-    if (master.get_digital_new_press(pros::E_CONTROLLER_DIGITAL_Y)) middleGoalD();
-    if (master.get_digital_new_press(pros::E_CONTROLLER_DIGITAL_A)) matchloadD();
+    // BUTTONS (these only set targets, the actuators stage moves the hardware and enforces the interlocks)
+    if (master.get_digital_new_press(pros::E_CONTROLLER_DIGITAL_L1)) mechanisms.right_descore_toggle();
+    if (master.get_digital_new_press(pros::E_CONTROLLER_DIGITAL_Y)) mechanisms.middle_goal_toggle();
+    if (master.get_digital_new_press(pros::E_CONTROLLER_DIGITAL_A)) mechanisms.matchload_toggle();
     
     // Mapped Aligner to 'L2'
-    if (master.get_digital_new_press(pros::E_CONTROLLER_DIGITAL_L2)) alignerD();
+    if (master.get_digital_new_press(pros::E_CONTROLLER_DIGITAL_L2)) mechanisms.aligner_toggle();
 
-    if (master.get_digital_new_press(pros::E_CONTROLLER_DIGITAL_R2)) bottomIntakeD();
-    if (master.get_digital_new_press(pros::E_CONTROLLER_DIGITAL_R1)) topOutakeD();
-    if (master.get_digital_new_press(pros::E_CONTROLLER_DIGITAL_UP)) stopIntake();
+    if (master.get_digital_new_press(pros::E_CONTROLLER_DIGITAL_R2)) mechanisms.bottom_intake_toggle();
+    if (master.get_digital_new_press(pros::E_CONTROLLER_DIGITAL_R1)) mechanisms.top_score_toggle();
+    if (master.get_digital_new_press(pros::E_CONTROLLER_DIGITAL_UP)) mechanisms.rollers_stop();
 
-    pros::delay(ez::util::DELAY_TIME);
+    pros::Task::delay_until(&loop_time, control_loop.period_get());
   }
 }
\ No newline at end of file
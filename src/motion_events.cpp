@@ -0,0 +1,175 @@
+/*
+This Source Code Form is subject to the terms of the Mozilla Public
+License, v. 2.0. If a copy of the MPL was not distributed with this
+file, You can obtain one at http://mozilla.org/MPL/2.0/.
+*/
+
+#include "motion_events.hpp"
+
+#include <cmath>
+
+#include "main.h"
+
+using namespace robot;
+
+motion_events robot::chassis_events;
+
+int motion_events::add(event e) {
+  mutex.take();
+  int id = -1;
+  for (auto& slot : events) {
+    if (slot.id != -1) continue;
+    e.id = id = next_id++;
+    if (next_id < 0) next_id = 0;
+    slot = e;
+    break;
+  }
+  mutex.give();
+  if (id == -1) printf("motion_events: queue full, event dropped\n");
+  return id;
+}
+
+int motion_events::at_pose(double x, double y, double radius, callback fn) {
+  event e;
+  e.type = POSE;
+  e.x = x;
+  e.y = y;
+  e.radius = radius;
+  e.fn = fn;
+  return add(e);
+}
+
+int motion_events::past_point(double x, double y, callback fn) {
+  ez::pose now = chassis_pose.pose_get();
+  event e;
+  e.type = PAST;
+  e.x = x;
+  e.y = y;
+  e.dx = x - now.x;
+  e.dy = y - now.y;
+  e.fn = fn;
+  return add(e);
+}
+
+int motion_events::at_distance(double distance, callback fn) {
+  event e;
+  e.type = DISTANCE;
+  e.x = travelled_get() + std::fabs(distance);
+  e.fn = fn;
+  return add(e);
+}
+
+int motion_events::at_index(int index, callback fn) {
+  if (index < 0 || index >= path_size - 1) {
+    printf("motion_events: path has no point %i\n", index);
+    return -1;
+  }
+  event e;
+  e.type = INDEX;
+  e.index = index;
+  e.fn = fn;
+  return add(e);
+}
+
+void motion_events::path_set(ez::pose start, const std::vector<ez::odom>& input) {
+  mutex.take();
+  for (auto& e : events) e.id = -1;
+  path[0] = start;
+  path_size = 1;
+  for (const auto& point : input) {
+    if (path_size == (int)path.size()) break;
+    path[path_size++] = point.target;
+  }
+  path_passed = 0;
+  mutex.give();
+}
+
+void motion_events::pid_odom_set(std::vector<ez::united_odom> input) {
+  std::vector<ez::odom> points;
+  points.reserve(input.size());
+  for (const auto& point : input)
+    points.push_back({{point.target.x.convert(okapi::inch), point.target.y.convert(okapi::inch)}, point.drive_direction, point.max_xy_speed});
+  path_set(chassis_pose.pose_get(), points);
+
+  chassis.pid_odom_set(input);
+}
+
+void motion_events::pid_odom_set(ez::united_odom target) { pid_odom_set(std::vector<ez::united_odom>{target}); }
+
+bool motion_events::pending(int id) {
+  if (id < 0) return false;
+  for (const auto& e : events)
+    if (e.id == id) return true;
+  return false;
+}
+
+void motion_events::motion_end() {
+  mutex.take();
+  int dropped = 0;
+  for (auto& e : events) {
+    if (e.id != -1) dropped++;
+    e.id = -1;
+  }
+  path_size = 0;
+  path_passed = 0;
+  mutex.give();
+  if (dropped) printf("motion_events: motion ended with %i events not fired\n", dropped);
+}
+
+void motion_events::clear() {
+  mutex.take();
+  for (auto& e : events) e.id = -1;
+  mutex.give();
+}
+
+double motion_events::travelled_get() { return travelled; }
+
+void motion_events::check() {
+  ez::pose now = chassis_pose.pose_get();
+  std::array<callback, MAX_EVENTS> due;
+  int due_count = 0;
+
+  mutex.take();
+  if (have_last) travelled += std::hypot(now.x - last.x, now.y - last.y);
+  last = now;
+  have_last = true;
+
+  // A point is passed once the robot is past the line through it, square to the segment leading in
+  while (path_passed < path_size - 1) {
+    const ez::pose& a = path[path_passed];
+    const ez::pose& b = path[path_passed + 1];
+    double dx = b.x - a.x, dy = b.y - a.y;
+    if ((now.x - b.x) * dx + (now.y - b.y) * dy < 0.0) break;
+    path_passed++;
+  }
+
+  for (auto& e : events) {
+    if (e.id == -1) continue;
+    bool fire = false;
+    switch (e.type) {
+      case POSE:
+        fire = std::hypot(now.x - e.x, now.y - e.y) <= e.radius;
+        break;
+      case PAST:
+        // The same line test as a path point
+        fire = (now.x - e.x) * e.dx + (now.y - e.y) * e.dy >= 0.0;
+        break;
+      case DISTANCE:
+        fire = travelled >= e.x;
+        break;
+      case INDEX:
+        fire = path_passed > e.index;
+        break;
+    }
+    if (!fire) continue;
+    due[due_count++] = e.fn;
+    e.id = -1;
+  }
+  mutex.give();
+
+  // Callbacks may add events, so they run with nothing held
+  for (int i = 0; i < due_count; i++)
+    if (due[i]) due[i]();
+}
+
+void robot::chassis_events_check() { chassis_events.check(); }
@@ -0,0 +1,185 @@
+/*
+This Source Code Form is subject to the terms of the Mozilla Public
+License, v. 2.0. If a copy of the MPL was not distributed with this
+file, You can obtain one at http://mozilla.org/MPL/2.0/.
+*/
+
+#include "path_cache.hpp"
+
+#include <algorithm>
+#include <cmath>
+
+#include "main.h"
+
+using namespace robot;
+
+path_cache robot::pp_paths;
+
+namespace {
+// FNV-1a, hashing each field so struct padding never leaks into the key
+struct hasher {
+  std::uint64_t value = 14695981039346656037ull;
+  void add(const void* data, std::size_t size) {
+    const auto* bytes = static_cast<const unsigned char*>(data);
+    for (std::size_t i = 0; i < size; i++) {
+      value ^= bytes[i];
+      value *= 1099511628211ull;
+    }
+  }
+  void add(double d) { add(&d, sizeof(d)); }
+  void add(int i) { add(&i, sizeof(i)); }
+};
+
+std::vector<ez::odom> odom_get(const std::vector<ez::united_odom>& movements) {
+  std::vector<ez::odom> out;
+  out.reserve(movements.size());
+  for (const auto& m : movements)
+    out.push_back({{m.target.x.convert(okapi::inch), m.target.y.convert(okapi::inch), m.target.theta.convert(okapi::degree)},
+                   m.drive_direction,
+                   m.max_xy_speed,
+                   m.turn_behavior});
+  return out;
+}
+
+// What velocity_profile() works on, the speeds are copied back into max_xy_speed
+struct speed_point {
+  double x = 0.0;
+  double y = 0.0;
+  double curvature = 0.0;
+  int speed = 0;
+};
+}  // namespace
+
+std::uint64_t robot::path_key(ez::pose start, const std::vector<ez::odom>& movements, const path_settings& settings) {
+  hasher h;
+  h.add(start.x);
+  h.add(start.y);
+  for (const auto& m : movements) {
+    h.add(m.target.x);
+    h.add(m.target.y);
+    h.add(m.target.theta);
+    h.add((int)m.drive_direction);
+    h.add(m.max_xy_speed);
+    h.add((int)m.turn_behavior);
+  }
+  h.add(settings.spacing);
+  h.add(settings.weight_smooth);
+  h.add(settings.weight_data);
+  h.add(settings.tolerance);
+  h.add(settings.profile.top_speed);
+  h.add(settings.profile.lateral_accel);
+  h.add(settings.profile.accel);
+  h.add(settings.profile.decel);
+  h.add(settings.profile.min_speed);
+  return h.value;
+}
+
+compiled_path robot::path_compile(ez::pose start, const std::vector<ez::odom>& movements, const path_settings& settings) {
+  compiled_path out;
+  out.key = path_key(start, movements, settings);
+  if (movements.empty()) return out;
+
+  // Inject points every spacing inches along each segment, each one heading to the segment's end
+  ez::pose from = start;
+  std::vector<bool> fixed;
+  for (size_t k = 0; k < movements.size(); k++) {
+    const ez::odom& m = movements[k];
+    if (k != 0) out.input_index.push_back(out.points.size());
+    double dx = m.target.x - from.x, dy = m.target.y - from.y;
+    double length = std::hypot(dx, dy);
+    int fit = path_inject_count(length, settings.spacing);
+    for (int j = 0; j < fit; j++) {
+      double t = (j * settings.spacing) / length;
+      out.points.push_back({{from.x + dx * t, from.y + dy * t, ez::ANGLE_NOT_SET}, m.drive_direction, m.max_xy_speed, m.turn_behavior});
+      fixed.push_back(false);
+    }
+    // A segment after an input point starts on it, so a boomerang point keeps its angle and position
+    if (k != 0 && fit != 0 && from.theta != ez::ANGLE_NOT_SET) {
+      out.points[out.points.size() - fit].target.theta = from.theta;
+      fixed[fixed.size() - fit] = true;
+    }
+    from = m.target;
+  }
+  out.points.push_back(movements.back());
+  fixed.push_back(true);
+  out.input_index.push_back(out.points.size() - 1);
+  for (auto& index : out.input_index) index = std::min<int>(index, out.points.size() - 1);
+
+  // Smoothing and the velocity profile work on x, y and speed, which are copied back.  The ends
+  // and boomerang points stay where they are, and keep their speed since the robot settles there.
+  std::vector<speed_point> profile(out.points.size());
+  for (size_t i = 0; i < out.points.size(); i++)
+    profile[i] = {out.points[i].target.x, out.points[i].target.y, 0.0, out.points[i].max_xy_speed};
+  std::vector<speed_point> original = profile;
+  path_smooth(profile.data(), original.data(), profile.size(), [&](std::size_t i) { return (bool)fixed[i]; }, settings.weight_smooth, settings.weight_data,
+              settings.tolerance);
+  velocity_profile(profile.data(), profile.size(), settings.profile);
+  for (size_t i = 0; i < out.points.size(); i++) {
+    out.points[i].target.x = profile[i].x;
+    out.points[i].target.y = profile[i].y;
+    if (!fixed[i]) out.points[i].max_xy_speed = profile[i].speed;
+  }
+  return out;
+}
+
+path_settings path_cache::settings_get() {
+  std::vector<double> smooth = chassis.odom_path_smooth_constants_get();
+  path_settings settings;
+  settings.spacing = chassis.odom_path_spacing_get();
+  if (smooth.size() >= 3) {
+    settings.weight_smooth = smooth[0];
+    settings.weight_data = smooth[1];
+    settings.tolerance = smooth[2];
+  }
+  settings.profile = profile;
+  return settings;
+}
+
+const compiled_path& path_cache::compile(ez::pose start, const std::vector<ez::odom>& movements) {
+  path_settings settings = settings_get();
+  std::uint64_t key = path_key(start, movements, settings);
+  auto found = paths.find(key);
+  if (found != paths.end()) return found->second;
+  return paths.emplace(key, path_compile(start, movements, settings)).first->second;
+}
+
+const compiled_path& path_cache::compile(ez::pose start, const std::vector<ez::united_odom>& movements) {
+  return compile(start, odom_get(movements));
+}
+
+void path_cache::pid_odom_smooth_pp_set(ez::pose start, const std::vector<ez::odom>& movements, bool slew_on) {
+  if (!find(path_key(start, movements, settings_get()))) {
+    miss_count++;
+    printf("path_cache: path wasn't compiled in initialize(), compiling it now\n");
+  }
+  const compiled_path& path = compile(start, movements);
+  chassis_events.path_set(start, movements);
+  chassis.pid_odom_pp_set(path.points, slew_on);
+}
+
+void path_cache::pid_odom_smooth_pp_set(ez::pose start, const std::vector<ez::united_odom>& movements, bool slew_on) {
+  pid_odom_smooth_pp_set(start, odom_get(movements), slew_on);
+}
+
+void path_cache::profile_set(const profile_settings& input) { profile = input; }
+profile_settings path_cache::profile_get() const { return profile; }
+
+const compiled_path* path_cache::find(std::uint64_t key) const {
+  auto found = paths.find(key);
+  return found == paths.end() ? nullptr : &found->second;
+}
+
+int path_cache::size() const { return paths.size(); }
+int path_cache::misses() const { return miss_count; }
+
+void robot::route_start(const route_sample* route, std::size_t size, bool slew_on) {
+  // EZ takes a vector by value, so keep the one built here and only let EZ's copy allocate
+  static std::vector<ez::odom> points;
+  points.clear();
+  points.reserve(size);
+  for (std::size_t i = 1; i < size; i++) {
+    if (route[i].x == route[i - 1].x && route[i].y == route[i - 1].y) continue;  // padding from route_compile()
+    points.push_back({{route[i].x, route[i].y, ez::ANGLE_NOT_SET}, route[i].reverse ? ez::rev : ez::fwd, route[i].speed});
+  }
+  chassis.pid_odom_pp_set(points, slew_on);
+}
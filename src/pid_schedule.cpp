@@ -0,0 +1,130 @@
+/*
+This Source Code Form is subject to the terms of the Mozilla Public
+License, v. 2.0. If a copy of the MPL was not distributed with this
+file, You can obtain one at http://mozilla.org/MPL/2.0/.
+*/
+
+#include "pid_schedule.hpp"
+
+#include "main.h"
+
+using namespace robot;
+
+pid_scheduler robot::chassis_gains;
+
+namespace {
+// Battery filter per tick, ~0.5 s time constant at 10 ms.  Slow enough to ride out the sag while
+// accelerating, quick enough to follow the battery draining over a match
+constexpr double VOLTAGE_FILTER = 0.02;
+// Ticks new gains wait for EZ's task to be between compute()s.  Both tasks tick every 10 ms, and
+// if they wake on the same ms this one runs first every time, so they would wait forever
+constexpr int DEFER_LIMIT = 5;
+}  // namespace
+
+void robot::chassis_gains_update() { chassis_gains.update(); }
+
+void pid_scheduler::table_set(schedule_pid pid, const gain_schedule& table) {
+  if (pid < 0 || pid >= SCHEDULE_COUNT) return;
+  mutex.take();
+  tables[pid] = table;
+  scheduled[pid] = true;
+  stale = true;
+  mutex.give();
+}
+
+void pid_scheduler::table_clear(schedule_pid pid) {
+  if (pid < 0 || pid >= SCHEDULE_COUNT) return;
+  mutex.take();
+  scheduled[pid] = false;
+  stale = true;
+  mutex.give();
+}
+
+void pid_scheduler::payload_set(bool input) {
+  mutex.take();
+  loaded = input;
+  mutex.give();
+}
+
+bool pid_scheduler::payload_get() {
+  mutex.take();
+  bool out = loaded;
+  mutex.give();
+  return out;
+}
+
+double pid_scheduler::voltage_get() {
+  mutex.take();
+  double out = voltage;
+  mutex.give();
+  return out;
+}
+
+pid_gains pid_scheduler::gains_get(schedule_pid pid, double speed, pid_gains fallback) {
+  if (pid < 0 || pid >= SCHEDULE_COUNT) return fallback;
+  mutex.take();
+  pid_gains out = scheduled[pid] ? tables[pid].get(speed, voltage, loaded) : fallback;
+  mutex.give();
+  return out;
+}
+
+void pid_scheduler::write(ez::PID& pid, schedule_pid which, double speed) {
+  if (!scheduled[which]) return;
+  pid_gains g = tables[which].get(speed, voltage, loaded);
+  written[writes] = &pid;
+  replaced[writes] = pid.constants;
+  gains[writes++] = g;
+  pid.constants_set(g.kp, g.ki, g.kd, g.start_i);
+}
+
+// headingPID, turnPID and swingPID hold default_constants() themselves.  EZ copies new drive
+// constants into leftPID and rightPID at every drive, those are left alone
+void pid_scheduler::restore() {
+  for (int i = writes - 1; i >= 0; i--) {
+    const ez::PID::Constants& now = written[i]->constants;
+    const pid_gains& g = gains[i];
+    bool ours = now.kp == g.kp && now.ki == g.ki && now.kd == g.kd && now.start_i == g.start_i;
+    if (ours) written[i]->constants_set(replaced[i].kp, replaced[i].ki, replaced[i].kd, replaced[i].start_i);
+  }
+  writes = 0;
+}
+
+void pid_scheduler::update() {
+  double reading = pros::battery::get_voltage() / 1000.0;
+  motion now = {chassis.drive_mode_get(), 0.0, (double)chassis.pid_speed_max_get()};
+  if (now.mode == ez::DRIVE) now.target = chassis.leftPID.target_get();
+  if (now.mode == ez::TURN) now.target = chassis.turnPID.target_get();
+  if (now.mode == ez::SWING) now.target = chassis.swingPID.target_get();
+  // Waiting for its next tick EZ's task is between compute()s, and it can't run again before
+  // this task blocks
+  bool writable = chassis.ez_auto.get_state() == pros::E_TASK_STATE_BLOCKED;
+
+  mutex.take();
+  if (reading > 0.0) voltage = voltage <= 0.0 ? reading : voltage + (reading - voltage) * VOLTAGE_FILTER;
+  if (!(now == running)) stale = true;
+  if (stale && !writable && ++deferred >= DEFER_LIMIT) {
+    // Most likely EZ's task woke this ms and hasn't run yet, which is between compute()s too.
+    // Said once, if the tasks are in step it happens every motion
+    if (forced++ == 0) printf("pid_schedule: EZ's task didn't wait between ticks for %i ticks, writing gains anyway\n", deferred);
+    writable = true;
+  }
+  if (stale && writable) {
+    restore();
+    if (now.mode == ez::DRIVE) {
+      // Which of EZ's drive constants pid_drive_set() picked
+      bool backward = chassis.leftPID.target_get() + chassis.rightPID.target_get() < chassis.drive_sensor_left() + chassis.drive_sensor_right();
+      schedule_pid drive = backward ? SCHEDULE_DRIVE_BACKWARD : SCHEDULE_DRIVE;
+      write(chassis.leftPID, drive, now.speed);
+      write(chassis.rightPID, drive, now.speed);
+      write(chassis.headingPID, SCHEDULE_HEADING, now.speed);
+    } else if (now.mode == ez::TURN) {
+      write(chassis.turnPID, SCHEDULE_TURN, now.speed);
+    } else if (now.mode == ez::SWING) {
+      write(chassis.swingPID, SCHEDULE_SWING, now.speed);
+    }
+    running = now;
+    stale = false;
+    deferred = 0;
+  }
+  mutex.give();
+}
@@ -0,0 +1,39 @@
+/*
+This Source Code Form is subject to the terms of the Mozilla Public
+License, v. 2.0. If a copy of the MPL was not distributed with this
+file, You can obtain one at http://mozilla.org/MPL/2.0/.
+*/
+
+#include "main.h"
+
+// robot::pid_wait() is the chassis side of exit_condition.cpp, which stays free of the chassis
+// so its wait loop builds on the host without EZ-Template, see sim/tools/exit_wait_test.cpp
+
+void robot::pid_wait() {
+  ez::e_mode mode = chassis.drive_mode_get();
+  chassis_recorder.exit_set(ez::RUNNING);
+  if (mode != ez::DRIVE && mode != ez::TURN && mode != ez::SWING) {
+    chassis.pid_wait();
+    chassis_recorder.exit_set((ez::exit_output)0);  // EZ-Template doesn't say how it exited
+    chassis_events.motion_end();
+    return;
+  }
+
+  // Let the PID run at least one iteration, like chassis.pid_wait()
+  pros::delay(ez::util::DELAY_TIME);
+
+  pid_exit left(chassis.leftPID), right(chassis.rightPID);
+  pid_exit angular(mode == ez::TURN ? chassis.turnPID : chassis.swingPID);
+  exit_wait_result result = exits_wait(mode, chassis.current_swing, left, right, angular, chassis.pid_print_toggle_get());
+
+  if (result.aborted) printf("exit: wait ended, the robot was disabled or the mode changed\n");
+  if (result.interfered) chassis.interfered = true;
+  chassis_recorder.exit_set(result.exit);
+  exit_stats_add(result.saved);
+  chassis_events.motion_end();
+}
+
+void robot::pid_wait_quick_chain() {
+  chassis.pid_wait_quick_chain();
+  chassis_events.motion_end();
+}
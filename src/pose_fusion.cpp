@@ -0,0 +1,218 @@
+/*
+This Source Code Form is subject to the terms of the Mozilla Public
+License, v. 2.0. If a copy of the MPL was not distributed with this
+file, You can obtain one at http://mozilla.org/MPL/2.0/.
+*/
+
+#include "pose_fusion.hpp"
+
+#include <cmath>
+
+#include "main.h"
+
+using namespace robot;
+
+pose_fusion robot::chassis_fusion;
+
+namespace {
+constexpr double METERS = 0.0254;      // per inch, the GPS reports meters
+constexpr double RESET_DISTANCE = 6.0;  // inches in one tick, more means odom_xyt_set() moved the pose
+constexpr double RESET_TURN = 45.0;     // degrees in one tick
+constexpr double GPS_MAX_ERROR = 0.15;  // meters, the GPS is lost past this
+// Ticks a correction waits for EZ's task to be between updates.  Both tasks tick every 10 ms,
+// and if they wake on the same ms this one runs first every time, so it would wait forever
+constexpr int DEFER_LIMIT = 5;
+
+double wrap_deg(double angle) { return std::remainder(angle, 360.0); }
+
+// Rotates a vector clockwise by angle degrees, EZ's direction for positive headings
+void rotate(double& x, double& y, double angle) {
+  double s = std::sin(ez::util::to_rad(angle)), c = std::cos(ez::util::to_rad(angle));
+  double rx = x * c + y * s, ry = -x * s + y * c;
+  x = rx;
+  y = ry;
+}
+}  // namespace
+
+void robot::chassis_pose_fuse() { chassis_fusion.update(); }
+
+void pose_fusion::settings_set(const filter_settings& input) {
+  mutex.take();
+  filter.settings_set(input);
+  mutex.give();
+}
+
+filter_settings pose_fusion::settings_get() {
+  mutex.take();
+  filter_settings out = filter.settings_get();
+  mutex.give();
+  return out;
+}
+
+void pose_fusion::distance_set(pros::Distance* sensor, distance_mount mount) {
+  mutex.take();
+  distance = sensor;
+  filter_settings s = filter.settings_get();
+  s.distance = mount;
+  filter.settings_set(s);
+  mutex.give();
+}
+
+void pose_fusion::gps_set(pros::Gps* sensor) {
+  mutex.take();
+  gps = sensor;
+  mutex.give();
+}
+
+ez::pose pose_fusion::field_from_odom(ez::pose p) {
+  rotate(p.x, p.y, origin.theta);
+  return {p.x + origin.x, p.y + origin.y, wrap_deg(p.theta + origin.theta)};
+}
+
+ez::pose pose_fusion::odom_from_field(ez::pose p) {
+  double x = p.x - origin.x, y = p.y - origin.y;
+  rotate(x, y, -origin.theta);
+  return {x, y, wrap_deg(p.theta - origin.theta)};
+}
+
+void pose_fusion::start_set(double x, double y, double theta) {
+  ez::pose odom = chassis.odom_pose_get();
+  mutex.take();
+  // The origin that puts the robot's current odom pose at this field pose
+  origin.theta = wrap_deg(theta - odom.theta);
+  double ox = odom.x, oy = odom.y;
+  rotate(ox, oy, origin.theta);
+  origin.x = x - ox;
+  origin.y = y - oy;
+  filter.reset(x, y, theta);
+  filter.stats_reset();
+  last = odom;
+  input = {};
+  pending = false;
+  deferred = forced = 0;
+  active = true;
+  mutex.give();
+}
+
+void pose_fusion::stop() {
+  mutex.take();
+  active = false;
+  mutex.give();
+}
+
+bool pose_fusion::running() {
+  mutex.take();
+  bool out = active;
+  mutex.give();
+  return out;
+}
+
+void pose_fusion::correct_set(bool input) {
+  mutex.take();
+  correcting = input;
+  mutex.give();
+}
+
+ez::pose pose_fusion::field_pose_get() {
+  mutex.take();
+  ez::pose out = {filter.x_get(), filter.y_get(), filter.theta_get()};
+  mutex.give();
+  return out;
+}
+
+fusion_input pose_fusion::input_get() {
+  mutex.take();
+  fusion_input out = input;
+  mutex.give();
+  return out;
+}
+
+filter_stats pose_fusion::stats_get() {
+  mutex.take();
+  filter_stats out = filter.stats_get();
+  mutex.give();
+  return out;
+}
+
+void pose_fusion::update() {
+  mutex.take();
+  if (!active) {
+    mutex.give();
+    return;
+  }
+  ez::pose now = chassis.odom_pose_get();
+
+  // Odometry moved since the last tick, in the robot's frame so it doesn't care about the origin
+  double dx = now.x - last.x, dy = now.y - last.y;
+  double turn = wrap_deg(now.theta - last.theta);
+  double mid = ez::util::to_rad(last.theta + turn / 2.0);
+  fusion_input in;
+  in.forward = dx * std::sin(mid) + dy * std::cos(mid);
+  in.right = dx * std::cos(mid) - dy * std::sin(mid);
+  in.turn = turn;
+
+  // A jump no robot can drive in a tick is the auton setting the pose, start over from it
+  if (std::hypot(dx, dy) > RESET_DISTANCE || std::fabs(turn) > RESET_TURN) {
+    ez::pose field = field_from_odom(now);
+    filter.reset(field.x, field.y, field.theta);
+    last = now;
+    input = {};
+    mutex.give();
+    return;
+  }
+
+  if (distance) {
+    std::int32_t mm = distance->get();
+    if (mm > 0 && mm < 9999) in.distance = mm / 25.4;
+  }
+  if (gps) {
+    double error = gps->get_error();
+    if (error != PROS_ERR_F && error >= 0.0 && error < GPS_MAX_ERROR) {
+      pros::gps_position_s_t p = gps->get_position();
+      in.gps_x = p.x / METERS;
+      in.gps_y = p.y / METERS;
+      in.gps_theta = gps->get_heading();
+      in.gps_error = error / METERS;
+    }
+  }
+
+  filter_stats before = filter.stats_get();
+  filter.update(in);
+  filter_stats after = filter.stats_get();
+  input = in;
+  last = now;
+
+  // Only touch EZ's odometry when a measurement moved the estimate, so dead reckoning alone
+  // never fights it.  One that can't be written this tick is written on a later one, the
+  // filter keeps it
+  bool corrected = after.gps_accepted != before.gps_accepted || after.distance_accepted != before.distance_accepted;
+  pending = pending || corrected;
+  bool writable = false;
+  if (correcting && pending) {
+    writable = odom_writable();
+    if (!writable && ++deferred >= DEFER_LIMIT) {
+      // Most likely EZ's task woke this ms and hasn't run yet, which is between updates too.
+      // Said once, if the tasks are in step it happens every correction
+      if (forced++ == 0) printf("pose_fusion: EZ's task didn't wait between updates for %i ticks, correcting anyway\n", deferred);
+      writable = true;
+    }
+  }
+  if (writable) {
+    ez::pose odom = chassis.odom_pose_get();
+    ez::pose target = odom_from_field({filter.x_get(), filter.y_get(), filter.theta_get()});
+    // Whatever EZ integrated since now was read stays on top of the correction
+    double cx = target.x - now.x, cy = target.y - now.y;
+    chassis.odom_xy_set(odom.x + cx, odom.y + cy);
+    last.x += cx;
+    last.y += cy;
+    pending = false;
+    deferred = 0;
+  }
+  mutex.give();
+}
+
+bool pose_fusion::odom_writable() {
+  // EZ's task integrates odometry.  Waiting for its next tick, it's between updates, and this
+  // task outranks it so it can't run again before the write
+  return chassis.ez_auto.get_state() == pros::E_TASK_STATE_BLOCKED;
+}
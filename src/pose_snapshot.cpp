@@ -0,0 +1,50 @@
+/*
+This Source Code Form is subject to the terms of the Mozilla Public
+License, v. 2.0. If a copy of the MPL was not distributed with this
+file, You can obtain one at http://mozilla.org/MPL/2.0/.
+*/
+
+#include "pose_snapshot.hpp"
+
+#include <cmath>
+
+#include "main.h"
+
+using namespace robot;
+
+pose_snapshot robot::chassis_pose;
+
+void pose_snapshot::publish(double x, double y, double theta, double velocity, std::uint32_t time) {
+  buffer.publish({x, y, theta, velocity, buffer.sequence_get() + 1, time});
+}
+
+pose_sample pose_snapshot::get() const { return buffer.get(); }
+
+ez::pose pose_snapshot::pose_get() const {
+  pose_sample p = get();
+  return {p.x, p.y, p.theta};
+}
+
+std::uint32_t pose_snapshot::tick_get() const { return buffer.sequence_get(); }
+
+void robot::chassis_pose_publish() {
+  static ez::pose last = chassis.odom_pose_get();
+  static std::uint32_t last_time = pros::millis();
+
+  ez::pose current = chassis.odom_pose_get();
+  std::uint32_t now = pros::millis();
+
+  // Velocity is the distance moved this tick, signed by whether it went along the heading
+  double velocity = 0.0;
+  if (now != last_time) {
+    double dx = current.x - last.x;
+    double dy = current.y - last.y;
+    double heading = ez::util::to_rad(current.theta);
+    double forward = dx * std::sin(heading) + dy * std::cos(heading);
+    velocity = std::copysign(std::hypot(dx, dy), forward) / ((now - last_time) / 1000.0);
+  }
+
+  chassis_pose.publish(current.x, current.y, current.theta, velocity, now);
+  last = current;
+  last_time = now;
+}
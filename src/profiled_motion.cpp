@@ -0,0 +1,310 @@
+/*
+This Source Code Form is subject to the terms of the Mozilla Public
+License, v. 2.0. If a copy of the MPL was not distributed with this
+file, You can obtain one at http://mozilla.org/MPL/2.0/.
+*/
+
+#include "profiled_motion.hpp"
+
+#include <algorithm>
+#include <cmath>
+
+#include "main.h"
+
+// Only built with make PROFILED_MOTION=1, see the Makefile
+#ifdef ROBOT_PROFILED_MOTION
+
+using namespace robot;
+
+profiled_motion robot::chassis_profile;
+
+namespace {
+constexpr double RADIANS = M_PI / 180.0;
+
+// Gives a PID the scheduled gains for this motion, or the constants from default_constants()
+// if it has no schedule.  Once per motion like pid_scheduler does for EZ's motions, so a profiled
+// and an EZ motion started at the same voltage run on the same gains
+void constants_load(ez::PID& pid, const ez::PID::Constants& from, schedule_pid which, int speed) {
+  pid_gains gains = chassis_gains.gains_get(which, speed, {from.kp, from.ki, from.kd, from.start_i});
+  pid.constants_set(gains.kp, gains.ki, gains.kd, gains.start_i);
+}
+}  // namespace
+
+void robot::chassis_profile_update() { chassis_profile.update(); }
+
+void profiled_motion::settings_set(profiled_settings input) {
+  mutex.take();
+  settings = input;
+  mutex.give();
+}
+
+profiled_settings profiled_motion::settings_get() {
+  mutex.take();
+  profiled_settings out = settings;
+  mutex.give();
+  return out;
+}
+
+// Fastest the weaker side cruises at `speed`, so the cap means what it does for chassis.pid_drive_set()
+double profiled_motion::top_speed_get(int speed) {
+  double output = std::clamp(std::abs(speed), 0, 127);
+  feedforward_gains left = chassis_velocity.left_gains_get(), right = chassis_velocity.right_gains_get();
+  if (left.kV <= 0.0 || right.kV <= 0.0) return 0.0;
+  return std::max(0.0, std::min((output - left.kS) / left.kV, (output - right.kS) / right.kV));
+}
+
+double profiled_motion::half_width_get(const profiled_settings& now) {
+  double inches = chassis.drive_width_get();
+  return (inches > 0.0 ? inches : now.track_width) / 2.0;
+}
+
+void profiled_motion::pid_drive_set(okapi::QLength target, int speed) {
+  profiled_settings now = settings_get();
+  double top = top_speed_get(speed);
+  chassis.drive_mode_set(ez::DISABLE);
+  mutex.take();
+  profile.generate(target.convert(okapi::inch), {top, now.accel, now.jerk}, now.shape);
+  speed_max = speed;
+  begin(MOTION_DRIVE);
+  mutex.give();
+}
+
+void profiled_motion::pid_turn_set(okapi::QAngle target, int speed) {
+  profiled_settings now = settings_get();
+  double half = half_width_get(now);
+  // Turns share the wheels' limits, an angle is its arc at the wheels over the half width
+  double scale = 1.0 / (half * RADIANS);
+  motion_limits limits = {top_speed_get(speed) * scale, now.accel * scale, now.jerk * scale};
+  double start = chassis.drive_imu_get();
+  chassis.drive_mode_set(ez::DISABLE);
+  mutex.take();
+  half_width = half;
+  angle_start = start;
+  profile.generate(target.convert(okapi::degree) - start, limits, now.shape);
+  speed_max = speed;
+  begin(MOTION_TURN);
+  mutex.give();
+}
+
+void profiled_motion::pid_turn_relative_set(okapi::QAngle target, int speed) {
+  pid_turn_set(chassis.headingPID.target_get() * okapi::degree + target, speed);
+}
+
+void profiled_motion::pid_drive_queue(okapi::QLength target, int speed) { queue_add({false, false, target.convert(okapi::inch), top_speed_get(speed)}, speed); }
+
+void profiled_motion::pid_turn_queue(okapi::QAngle target, int speed) { queue_add({true, false, target.convert(okapi::degree), top_speed_get(speed)}, speed); }
+
+void profiled_motion::pid_turn_relative_queue(okapi::QAngle target, int speed) { queue_add({true, true, target.convert(okapi::degree), top_speed_get(speed)}, speed); }
+
+void profiled_motion::queue_add(chain_motion motion, int speed) {
+  if (queued >= motion_chain::MAX_MOTIONS) {
+    printf("profile: queue is full, %i motions\n", queued);
+    return;
+  }
+  queue_speed = queued == 0 ? speed : std::max(queue_speed, speed);
+  queue[queued++] = motion;
+}
+
+void profiled_motion::queue_clear() { queued = 0; }
+
+void profiled_motion::queue_start() {
+  if (queued == 0) return;
+  profiled_settings now = settings_get();
+  chain_settings limits = {now.accel, now.blend_radius, now.lateral_accel, half_width_get(now)};
+  double heading = chassis.headingPID.target_get();
+  chassis.drive_mode_set(ez::DISABLE);
+  mutex.take();
+  chain.plan(queue, queued, heading, limits);
+  speed_max = queue_speed;
+  begin(MOTION_CHAIN);
+  mutex.give();
+  if (chassis.pid_print_toggle_get())
+    printf("profile: %i motions, %i corners rounded, %i stops, %.2f s\n", queued, chain.blends_get(), chain.stops_get(), chain.duration_get());
+  queued = 0;
+}
+
+void profiled_motion::begin(motion_type motion) {
+  type = motion;
+
+  // The PIDs run on the error from the plan, target 0, so their derivative is the velocity error
+  for (ez::PID* pid : {&left_pid, &right_pid, &angular_pid}) {
+    pid->variables_reset();
+    pid->timers_reset();
+    pid->target_set(0.0);
+  }
+  constants_load(left_pid, chassis.pid_drive_constants_get(), SCHEDULE_DRIVE, speed_max);
+  constants_load(right_pid, chassis.pid_drive_constants_get(), SCHEDULE_DRIVE, speed_max);
+  left_pid.exit = chassis.leftPID.exit;
+  right_pid.exit = chassis.rightPID.exit;
+  if (type == MOTION_DRIVE) {
+    constants_load(angular_pid, chassis.pid_heading_constants_get(), SCHEDULE_HEADING, speed_max);
+    angular_pid.target_set(chassis.headingPID.target_get());
+  } else if (type == MOTION_CHAIN) {
+    // The heading PID follows the planned heading, and a chain ending on a turn exits like one.
+    // Its constants are swapped for the turn's through turns in place, see update()
+    chain_turning = chain.sample(0.0).turning;
+    angular_load();
+    angular_pid.target_set(chain.sample(0.0).heading);
+    if (chain.ends_turning()) angular_pid.exit = chassis.turnPID.exit;
+  } else {
+    constants_load(angular_pid, chassis.pid_turn_constants_get(), SCHEDULE_TURN, speed_max);
+    angular_pid.exit = chassis.turnPID.exit;
+  }
+  left_exit.reset();
+  right_exit.reset();
+  angular_exit.reset();
+  left_done = right_done = ez::RUNNING;
+
+  left_start = chassis.drive_sensor_left();
+  right_start = chassis.drive_sensor_right();
+  start_time = pros::millis();
+  exit_time = 0;
+  exit = ez::RUNNING;
+  active = true;
+}
+
+void profiled_motion::angular_load() {
+  if (chain_turning) {
+    constants_load(angular_pid, chassis.pid_turn_constants_get(), SCHEDULE_TURN, speed_max);
+  } else {
+    constants_load(angular_pid, chassis.pid_heading_constants_get(), SCHEDULE_HEADING, speed_max);
+  }
+}
+
+double profiled_motion::duration_get() const { return type == MOTION_CHAIN ? chain.duration_get() : profile.duration_get(); }
+
+void profiled_motion::drive_exit_check(const motor_telemetry& telemetry, bool print) {
+  bool left_running = left_done == ez::RUNNING, right_running = right_done == ez::RUNNING;
+  if (left_running) left_done = left_exit.exit_condition(telemetry, true, false, print);
+  if (right_running) right_done = right_exit.exit_condition(telemetry, false, true, print);
+  if (left_done != ez::RUNNING && right_done != ez::RUNNING) {
+    int saved = std::max(left_running ? left_exit.saved_get() : 0, right_running ? right_exit.saved_get() : 0);
+    finish(left_done == ez::mA_EXIT || right_done == ez::mA_EXIT ? ez::mA_EXIT : std::max(left_done, right_done), saved);
+  }
+}
+
+void profiled_motion::finish(ez::exit_output how, int saved) {
+  exit_stats_add(saved);
+  exit = how;
+  exit_time = pros::millis() - start_time;
+  active = false;
+  // EZ's next drive holds the heading this turn ended on
+  if (type == MOTION_TURN) chassis.headingPID.target_set(angle_start + profile.distance_get());
+  if (type == MOTION_CHAIN) chassis.headingPID.target_set(chain.heading_get());
+}
+
+void profiled_motion::wait() {
+  chassis_recorder.exit_set(ez::RUNNING);
+  while (running()) pros::delay(ez::util::DELAY_TIME);
+  ez::exit_output how = exit_get();
+  if (how == ez::mA_EXIT) chassis.interfered = true;
+  chassis_recorder.exit_set(how);
+}
+
+bool profiled_motion::running() {
+  mutex.take();
+  bool out = active;
+  mutex.give();
+  return out;
+}
+
+void profiled_motion::stop() {
+  mutex.take();
+  bool was_active = active;
+  active = false;
+  mutex.give();
+  if (was_active) chassis.drive_set(0, 0);
+}
+
+ez::exit_output profiled_motion::exit_get() {
+  mutex.take();
+  ez::exit_output out = exit;
+  mutex.give();
+  return out;
+}
+
+std::uint32_t profiled_motion::plan_time_get() {
+  mutex.take();
+  std::uint32_t out = std::lround(duration_get() * 1000.0);
+  mutex.give();
+  return out;
+}
+
+std::uint32_t profiled_motion::exit_time_get() {
+  mutex.take();
+  std::uint32_t out = exit_time;
+  mutex.give();
+  return out;
+}
+
+void profiled_motion::update() {
+  mutex.take();
+  if (!active) {
+    mutex.give();
+    return;
+  }
+
+  double t = (pros::millis() - start_time) / 1000.0;
+  motion_state plan = profile.sample(t);
+  bool planning = t < duration_get();
+  bool print = chassis.pid_print_toggle_get();
+  const motor_telemetry telemetry = drive_telemetry.get();
+
+  double left_velocity, right_velocity, left_accel, right_accel, left_feedback, right_feedback;
+  if (type == MOTION_DRIVE) {
+    left_velocity = right_velocity = plan.velocity;
+    left_accel = right_accel = plan.acceleration;
+    double heading = angular_pid.compute(chassis.drive_imu_get());
+    left_feedback = left_pid.compute(chassis.drive_sensor_left() - left_start - plan.position) + heading;
+    right_feedback = right_pid.compute(chassis.drive_sensor_right() - right_start - plan.position) - heading;
+
+    // Exits only once the plan is over, until then the error is from a setpoint still moving
+    if (!planning) drive_exit_check(telemetry, print);
+  } else if (type == MOTION_CHAIN) {
+    chain_state state = chain.sample(t);
+    left_velocity = state.left_velocity;
+    right_velocity = state.right_velocity;
+    left_accel = state.left_accel;
+    right_accel = state.right_accel;
+    angular_pid.target_set(state.heading);
+    // A turn in place is held by the turn constants like pid_turn_set(), the rest by the heading's
+    if (state.turning != chain_turning) {
+      chain_turning = state.turning;
+      angular_load();
+    }
+    double heading = angular_pid.compute(chassis.drive_imu_get());
+    left_feedback = left_pid.compute(chassis.drive_sensor_left() - left_start - state.left) + heading;
+    right_feedback = right_pid.compute(chassis.drive_sensor_right() - right_start - state.right) - heading;
+
+    if (!planning && chain.ends_turning()) {
+      ez::exit_output how = angular_exit.exit_condition(telemetry, true, true, print);
+      if (how != ez::RUNNING) finish(how, angular_exit.saved_get());
+    } else if (!planning) {
+      drive_exit_check(telemetry, print);
+    }
+  } else {
+    // Clockwise is the left side forward
+    double wheel = half_width * RADIANS;
+    left_velocity = plan.velocity * wheel;
+    right_velocity = -left_velocity;
+    left_accel = plan.acceleration * wheel;
+    right_accel = -left_accel;
+    left_feedback = angular_pid.compute(chassis.drive_imu_get() - angle_start - plan.position);
+    right_feedback = -left_feedback;
+
+    if (!planning) {
+      ez::exit_output how = angular_exit.exit_condition(telemetry, true, true, print);
+      if (how != ez::RUNNING) finish(how, angular_exit.saved_get());
+    }
+  }
+
+  bool done = !active;
+  mutex.give();
+  if (done) {
+    chassis.drive_set(0, 0);
+    return;
+  }
+  chassis_velocity.set(left_velocity, right_velocity, left_accel, right_accel, left_feedback, right_feedback);
+}
+
+#endif
@@ -0,0 +1,190 @@
+/*
+This Source Code Form is subject to the terms of the Mozilla Public
+License, v. 2.0. If a copy of the MPL was not distributed with this
+file, You can obtain one at http://mozilla.org/MPL/2.0/.
+*/
+
+#include "recorder.hpp"
+
+#include <algorithm>
+#include <cmath>
+
+#include "main.h"
+
+using namespace robot;
+
+recorder robot::chassis_recorder;
+
+namespace {
+constexpr int MAX_NAMES = 1000;  // _000 to _999
+
+pid_terms terms_get(const ez::PID& pid) {
+  return {(float)pid.target, (float)pid.cur, (float)pid.error, (float)pid.output, (float)pid.integral, (float)pid.derivative};
+}
+}  // namespace
+
+bool recorder::open(const char* input) {
+  if (task) return true;
+  if (!pros::usd::is_installed()) return false;
+  prefix = input;
+  // Lowest useful priority, the card can block for tens of ms and nothing should wait on it
+  task = new pros::Task([this]() { task_fn(); }, TASK_PRIORITY_MIN + 1, TASK_STACK_DEPTH_DEFAULT, "recorder");
+  return true;
+}
+
+bool recorder::start() {
+  if (enabled) return true;
+  if (!ready) return false;
+  dropped_since_push = 0;
+  start_time = pros::millis();
+  enabled = true;
+  return true;
+}
+
+void recorder::stop() {
+  if (!enabled) return;
+  enabled = false;
+  stopping = true;
+  for (int i = 0; i < 100 && stopping; i++) pros::delay(10);
+}
+
+// Opens the first free file name so old logs are never overwritten, on the recorder's task
+bool recorder::file_open() {
+  char path[64];
+  for (; next_name < MAX_NAMES; next_name++) {
+    snprintf(path, sizeof(path), "%s_%03d.bin", prefix, next_name);
+    FILE* existing = fopen(path, "rb");
+    if (!existing) break;
+    fclose(existing);
+  }
+  if (next_name >= MAX_NAMES) {
+    printf("recorder: %s_000.bin to _%03d.bin all exist, not recording\n", prefix, MAX_NAMES - 1);
+    return false;
+  }
+  file = fopen(path, "wb");
+  if (!file) {
+    printf("recorder: couldn't open %s, not recording\n", path);
+    return false;
+  }
+  next_name++;
+  block_count = 0;
+  header_written = false;
+  ready = true;
+  return true;
+}
+
+bool recorder::recording() { return enabled; }
+
+void recorder::push(const log_record& record) {
+  if (!enabled) return;
+  log_record out = record;
+  out.dropped = dropped_since_push;
+  if (ring.push(out)) {
+    dropped_since_push = 0;
+  } else {
+    dropped++;
+    if (dropped_since_push != UINT16_MAX) dropped_since_push++;
+  }
+}
+
+void recorder::exit_set(ez::exit_output input) { exit = input; }
+ez::exit_output recorder::exit_get() { return (ez::exit_output)exit.load(); }
+std::uint32_t recorder::dropped_get() { return dropped; }
+std::uint32_t recorder::written_get() { return written; }
+
+void recorder::drain(bool everything) {
+  while (ring.pop(block[block_count])) {
+    block_count++;
+    if (block_count == BLOCK_RECORDS) {
+      fwrite(block, sizeof(log_record), block_count, file);
+      fflush(file);
+      written += block_count;
+      block_count = 0;
+    }
+  }
+  if (everything && block_count != 0) {
+    fwrite(block, sizeof(log_record), block_count, file);
+    written += block_count;
+    block_count = 0;
+  }
+}
+
+void recorder::task_fn() {
+  bool failed = false;
+  while (true) {
+    if (!file && !failed) failed = !file_open();
+    if (file && (enabled || stopping) && !header_written) {
+      log_header header;
+      header.record_size = sizeof(log_record);
+      header.start_time = start_time;
+      header.period = control_loop.period_get();
+      fwrite(&header, sizeof(header), 1, file);
+      header_written = true;
+    }
+    if (file && header_written) {
+      drain(false);
+      if (stopping) {
+        drain(true);
+        fclose(file);
+        file = nullptr;
+        ready = false;
+        stopping = false;
+      }
+    }
+    pros::delay(100);
+  }
+}
+
+void robot::chassis_record() {
+  if (!chassis_recorder.recording()) return;
+
+  pose_sample pose = chassis_pose.get();
+  motor_telemetry telemetry = drive_telemetry.get();
+
+  log_record r;
+  r.time = pros::millis();
+  r.tick = control_loop.tick_count();
+  r.x = pose.x;
+  r.y = pose.y;
+  r.theta = pose.theta;
+  r.velocity = pose.velocity;
+
+  ez::e_mode mode = chassis.drive_mode_get();
+  switch (mode) {
+    case ez::DRIVE:
+      r.primary = terms_get(chassis.leftPID);
+      r.secondary = terms_get(chassis.rightPID);
+      break;
+    case ez::TURN:
+    case ez::TURN_TO_POINT:
+      r.primary = terms_get(chassis.turnPID);
+      break;
+    case ez::SWING:
+      r.primary = terms_get(chassis.swingPID);
+      break;
+    case ez::POINT_TO_POINT:
+    case ez::PURE_PURSUIT:
+      r.primary = terms_get(chassis.xyPID);
+      r.secondary = terms_get(chassis.current_a_odomPID);
+      break;
+    default:
+      break;
+  }
+
+  for (int i = 0; i < std::min(telemetry.size(), 6); i++)
+    r.current[i] = std::clamp<std::int32_t>(telemetry.current[i], INT16_MIN, INT16_MAX);
+  r.mode = mode;
+  r.exit = chassis_recorder.exit_get();
+
+  // What the fusion stage fed its filter this tick, so sim/tools/fusion_replay can rerun it
+  fusion_input in = chassis_fusion.input_get();
+  r.odom_forward = in.forward;
+  r.odom_right = in.right;
+  r.odom_turn = in.turn;
+  r.distance = in.distance;
+  r.gps_x = in.gps_x;
+  r.gps_y = in.gps_y;
+  r.gps_theta = in.gps_theta;
+  r.gps_error = in.gps_error;
+  chassis_recorder.push(r);
+}
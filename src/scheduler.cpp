@@ -0,0 +1,102 @@
+/*
+This Source Code Form is subject to the terms of the Mozilla Public
+License, v. 2.0. If a copy of the MPL was not distributed with this
+file, You can obtain one at http://mozilla.org/MPL/2.0/.
+*/
+
+#include "scheduler.hpp"
+
+#include <algorithm>
+#include <cstdio>
+
+using namespace robot;
+
+scheduler::scheduler(std::uint32_t period) : period(std::max<std::uint32_t>(period, 1)) {}
+
+int scheduler::stage_add(const char* name, std::function<void()> run, std::uint32_t budget) {
+  stages_mutex.take();
+  stage s;
+  s.run = run;
+  s.stats.name = name;
+  s.stats.budget = budget;
+  stages.push_back(s);
+  int index = stages.size() - 1;
+  stages_mutex.give();
+  return index;
+}
+
+void scheduler::start() {
+  enabled = true;
+  // Runs above the default priority so user tasks can't delay a tick
+  if (!task) task = new pros::Task([this]() { task_fn(); }, TASK_PRIORITY_DEFAULT + 1, TASK_STACK_DEPTH_DEFAULT, "scheduler");
+}
+
+void scheduler::stop() { enabled = false; }
+bool scheduler::running() { return enabled; }
+
+void scheduler::tick() {
+  std::uint64_t tick_start = pros::micros();
+  stages_mutex.take();
+  for (auto& s : stages) {
+    std::uint64_t start = pros::micros();
+    s.run();
+    std::uint32_t took = pros::micros() - start;
+
+    s.stats.last = took;
+    s.stats.max = std::max(s.stats.max, took);
+    s.stats.total += took;
+    s.stats.runs++;
+    if (s.stats.budget != 0 && took > s.stats.budget) s.stats.overruns++;
+  }
+  stages_mutex.give();
+
+  std::uint32_t took = pros::micros() - tick_start;
+  longest_tick = std::max(longest_tick, took);
+  if (took > period * 1000) tick_overruns++;
+  ticks++;
+}
+
+void scheduler::task_fn() {
+  std::uint32_t next = pros::millis();
+  while (true) {
+    if (enabled) tick();
+
+    // A whole missed period means something blocked us, so drop the missed ticks instead of running them back to back
+    std::uint32_t now = pros::millis();
+    if (now >= next + 2 * period) {
+      if (enabled) tick_overruns++;
+      next = now - period;
+    }
+    pros::Task::delay_until(&next, period);
+  }
+}
+
+void scheduler::period_set(std::uint32_t input) { period = std::max<std::uint32_t>(input, 1); }
+std::uint32_t scheduler::period_get() { return period; }
+std::uint32_t scheduler::tick_count() { return ticks; }
+std::uint32_t scheduler::overruns() { return tick_overruns; }
+std::uint32_t scheduler::tick_max() { return longest_tick; }
+int scheduler::stage_count() { return stages.size(); }
+
+scheduler::stage_stats scheduler::stage_stats_get(int index) {
+  if (index < 0 || index >= stage_count()) return {};
+  return stages[index].stats;
+}
+
+void scheduler::stats_reset() {
+  stages_mutex.take();
+  for (auto& s : stages) {
+    s.stats.last = s.stats.max = s.stats.runs = s.stats.overruns = 0;
+    s.stats.total = 0;
+  }
+  ticks = tick_overruns = longest_tick = 0;
+  stages_mutex.give();
+}
+
+void scheduler::stats_print() {
+  printf("\n%u ticks at %u ms, %u overruns, longest tick %u us\n", ticks, period, tick_overruns, longest_tick);
+  for (auto& s : stages) {
+    std::uint32_t average = s.stats.runs == 0 ? 0 : s.stats.total / s.stats.runs;
+    printf("  %-12s avg %5u us  max %5u us  overruns %u\n", s.stats.name, average, s.stats.max, s.stats.overruns);
+  }
+}
@@ -0,0 +1,57 @@
+/*
+This Source Code Form is subject to the terms of the Mozilla Public
+License, v. 2.0. If a copy of the MPL was not distributed with this
+file, You can obtain one at http://mozilla.org/MPL/2.0/.
+*/
+
+#include "telemetry.hpp"
+
+#include "main.h"
+
+using namespace robot;
+
+snapshot<motor_telemetry> robot::drive_telemetry;
+
+namespace {
+double average(const std::array<double, TELEMETRY_MOTORS>& values, int begin, int count) {
+  if (count == 0) return 0.0;
+  double sum = 0.0;
+  for (int i = begin; i < begin + count; i++) sum += values[i];
+  return sum / count;
+}
+
+std::int32_t sum(const std::array<std::int32_t, TELEMETRY_MOTORS>& values, int begin, int count) {
+  std::int32_t out = 0;
+  for (int i = begin; i < begin + count; i++) out += values[i];
+  return out;
+}
+
+// Reads each quantity once per motor, straight into the next buffer
+void motors_read(const std::vector<pros::Motor>& motors, motor_telemetry& out, int& index) {
+  for (const auto& motor : motors) {
+    if (index >= TELEMETRY_MOTORS) return;
+    out.velocity[index] = motor.get_actual_velocity();
+    out.current[index] = motor.get_current_draw();
+    index++;
+  }
+}
+}  // namespace
+
+double motor_telemetry::left_velocity() const { return average(velocity, left_begin(), left_count); }
+double motor_telemetry::right_velocity() const { return average(velocity, right_begin(), right_count); }
+std::int32_t motor_telemetry::left_current() const { return sum(current, left_begin(), left_count); }
+std::int32_t motor_telemetry::right_current() const { return sum(current, right_begin(), right_count); }
+
+void robot::drive_telemetry_sample() {
+  motor_telemetry out;
+  int index = 0;
+  motors_read(chassis.left_motors, out, index);
+  out.left_count = index;
+  motors_read(chassis.right_motors, out, index);
+  out.right_count = index - out.left_count;
+  if (!chassis.left_motors.empty()) out.left_over_current = chassis.left_motors[0].is_over_current();
+  if (!chassis.right_motors.empty()) out.right_over_current = chassis.right_motors[0].is_over_current();
+  out.tick = drive_telemetry.sequence_get() + 1;
+  out.time = pros::millis();
+  drive_telemetry.publish(out);
+}
@@ -0,0 +1,206 @@
+/*
+This Source Code Form is subject to the terms of the Mozilla Public
+License, v. 2.0. If a copy of the MPL was not distributed with this
+file, You can obtain one at http://mozilla.org/MPL/2.0/.
+*/
+
+#include "trajectory.hpp"
+
+#include <algorithm>
+#include <cmath>
+
+#include "main.h"
+
+using namespace robot;
+
+trajectory_follower robot::chassis_trajectory;
+
+namespace {
+constexpr double METERS = 0.0254;  // per inch, squiggles works in meters and radians
+
+// EZ headings are degrees clockwise from +y, squiggles yaw is radians counterclockwise from +x
+double yaw_get(double theta) { return M_PI / 2.0 - theta * M_PI / 180.0; }
+
+double wrap(double angle) { return std::atan2(std::sin(angle), std::cos(angle)); }
+
+std::vector<squiggles::Pose> poses_get(const std::vector<ez::united_pose>& waypoints) {
+  std::vector<ez::pose> poses;
+  for (const auto& w : waypoints) poses.push_back(ez::util::united_pose_to_pose(w));
+
+  // A pose without an angle faces along the path
+  std::vector<squiggles::Pose> points;
+  for (std::size_t i = 0; i < poses.size(); i++) {
+    double yaw;
+    if (poses[i].theta != ez::ANGLE_NOT_SET) {
+      yaw = yaw_get(poses[i].theta);
+    } else {
+      const ez::pose& a = i + 1 < poses.size() ? poses[i] : poses[i - 1];
+      const ez::pose& b = i + 1 < poses.size() ? poses[i + 1] : poses[i];
+      yaw = std::atan2(b.y - a.y, b.x - a.x);
+    }
+    points.emplace_back(poses[i].x * METERS, poses[i].y * METERS, yaw);
+  }
+  return points;
+}
+}  // namespace
+
+void robot::chassis_trajectory_update() { chassis_trajectory.update(); }
+
+void trajectory_follower::settings_set(trajectory_settings input) {
+  mutex.take();
+  settings = input;
+  mutex.give();
+}
+
+trajectory_settings trajectory_follower::settings_get() {
+  mutex.take();
+  trajectory_settings out = settings;
+  mutex.give();
+  return out;
+}
+
+double trajectory_follower::width_get(const trajectory_settings& now) {
+  double inches = chassis.drive_width_get();
+  return (inches > 0.0 ? inches : now.track_width) * METERS;
+}
+
+spline_settings trajectory_follower::limits_get(const trajectory_settings& now) {
+  spline_settings limits;
+  limits.max_vel = chassis_velocity.top_speed_get() * METERS;
+  limits.max_accel = now.max_accel * METERS;
+  limits.track_width = width_get(now);
+  limits.spacing = now.spacing * METERS;
+  return limits;
+}
+
+std::vector<squiggles::ProfilePoint> trajectory_follower::generate(const std::vector<ez::united_pose>& waypoints, bool fast) {
+  if (waypoints.size() < 2) return {};
+  trajectory_settings now = settings_get();
+  squiggles::Constraints constraints(chassis_velocity.top_speed_get() * METERS, now.max_accel * METERS, now.max_jerk * METERS);
+  squiggles::SplineGenerator generator(constraints, std::make_shared<squiggles::TankModel>(width_get(now), constraints), now.dt);
+  std::vector<squiggles::ProfilePoint> out = generator.generate(poses_get(waypoints), fast);
+  if (out.empty()) printf("trajectory: no trajectory fits those poses\n");
+  return out;
+}
+
+void trajectory_follower::generate_live(const std::vector<ez::united_pose>& waypoints, profile_path<2>& out) {
+  live.generate(poses_get(waypoints), limits_get(settings_get()), out);
+}
+
+void trajectory_follower::start(const std::vector<squiggles::ProfilePoint>& path) { start_encoded(path_encode(path)); }
+
+void trajectory_follower::start(const profile_path<2>& path) { start_encoded(path_encode(path)); }
+
+void trajectory_follower::start_encoded(std::vector<std::uint8_t> bytes) {
+  path_view view;
+  view.open(bytes.data(), bytes.size());
+  trajectory_settings now = settings_get();
+  chassis.drive_mode_set(ez::DISABLE);
+  mutex.take();
+  owned.swap(bytes);  // the view moves with the buffer, the old path is freed once nothing points at it
+  std::shared_ptr<const void> owner;
+  held.swap(owner);
+  begin(view, now);
+  mutex.give();
+}
+
+void trajectory_follower::start(const path_view& path, std::shared_ptr<const void> owner) {
+  trajectory_settings now = settings_get();
+  chassis.drive_mode_set(ez::DISABLE);
+  mutex.take();
+  held.swap(owner);  // the last motion's owner is let go of once the mutex is given
+  begin(path, now);
+  mutex.give();
+}
+
+void trajectory_follower::begin(const path_view& path, const trajectory_settings& now) {
+  states = path;
+  state = 0;
+  start_time = pros::millis();
+  width = width_get(now);
+  active = !states.empty();
+}
+
+void trajectory_follower::pid_trajectory_set(const std::vector<ez::united_pose>& waypoints) {
+  start(generate(waypoints));
+}
+
+void trajectory_follower::wait() {
+  while (running()) pros::delay(ez::util::DELAY_TIME);
+}
+
+bool trajectory_follower::running() {
+  mutex.take();
+  bool out = active;
+  mutex.give();
+  return out;
+}
+
+void trajectory_follower::stop() {
+  mutex.take();
+  bool was_active = active;
+  active = false;
+  std::shared_ptr<const void> owner = std::move(held);
+  mutex.give();
+  if (was_active) chassis.drive_set(0, 0);
+}
+
+double trajectory_follower::end_error_get() {
+  mutex.take();
+  double out = end_error;
+  mutex.give();
+  return out;
+}
+
+void trajectory_follower::update() {
+  mutex.take();
+  if (!active) {
+    mutex.give();
+    return;
+  }
+
+  // State for the current time, only walking forward from the last one
+  const float* time = states.column(PATH_TIME);
+  double t = (pros::millis() - start_time) / 1000.0;
+  while (state + 1 < states.size() && time[state + 1] <= t) state++;
+  bool done = state + 1 >= states.size();
+  double xd = states.get(PATH_X, state), yd = states.get(PATH_Y, state), yawd = states.get(PATH_YAW, state);
+
+  ez::pose now = chassis_pose.pose_get();
+  double x = now.x * METERS, y = now.y * METERS, yaw = yaw_get(now.theta);
+
+  if (done) {
+    end_error = std::hypot(xd - x, yd - y) / METERS;
+    active = false;
+    std::shared_ptr<const void> owner = std::move(held);
+    mutex.give();
+    chassis.drive_set(0, 0);
+    return;
+  }
+
+  // RAMSETE, the error in the robot's frame corrects the state's velocities
+  double dx = xd - x, dy = yd - y;
+  double ex = std::cos(yaw) * dx + std::sin(yaw) * dy;
+  double ey = -std::sin(yaw) * dx + std::cos(yaw) * dy;
+  double etheta = wrap(yawd - yaw);
+  double vd = states.get(PATH_VEL, state);
+  // Turn rate from the next state's heading, so it doesn't depend on squiggles' curvature sign
+  double span = time[state + 1] - time[state];
+  double wd = span > 0.0 ? wrap(states.get(PATH_YAW, state + 1) - yawd) / span : 0.0;
+  double k = 2.0 * settings.zeta * std::sqrt(wd * wd + settings.b * vd * vd);
+  double sinc = std::fabs(etheta) < 1e-6 ? 1.0 : std::sin(etheta) / etheta;
+  double v = vd * std::cos(etheta) + k * ex;
+  double w = wd + k * etheta + settings.b * vd * sinc * ey;
+
+  // Wheel speeds in in/s, with the path's wheel accelerations for the feedforward's kA
+  double left = (v - w * width / 2.0) / METERS;
+  double right = (v + w * width / 2.0) / METERS;
+  double left_accel = 0.0, right_accel = 0.0;
+  if (span > 0.0) {
+    left_accel = (states.get(PATH_LEFT, state + 1) - states.get(PATH_LEFT, state)) / span / METERS;
+    right_accel = (states.get(PATH_RIGHT, state + 1) - states.get(PATH_RIGHT, state)) / span / METERS;
+  }
+  mutex.give();
+
+  chassis_velocity.set(left, right, left_accel, right_accel);
+}
@@ -0,0 +1,200 @@
+/*
+This Source Code Form is subject to the terms of the Mozilla Public
+License, v. 2.0. If a copy of the MPL was not distributed with this
+file, You can obtain one at http://mozilla.org/MPL/2.0/.
+*/
+
+#include "trajectory_library.hpp"
+
+#include <cstring>
+
+#include "main.h"
+
+using namespace robot;
+
+trajectory_library robot::trajectories;
+
+namespace {
+constexpr int LIST_SIZE = 4096;  // bytes of file names list_files() can return
+constexpr char EXTENSION[] = ".path";
+
+// Heap used by one loaded path, the file plus the map node, the shared entry and name
+std::size_t entry_bytes(std::size_t file_bytes, std::size_t name_size) { return file_bytes + name_size + 96; }
+}  // namespace
+
+bool trajectory_library::load(const char* directory) {
+  if (!pros::usd::is_installed()) return false;
+  mutex.take();
+  pending = directory;
+  requests++;
+  bool idle = !busy;
+  busy = true;
+  mutex.give();
+  // Below the control loop and the recorder's writes, nothing should wait on a read
+  if (!task) task = new pros::Task([this]() { task_fn(); }, TASK_PRIORITY_MIN + 1, TASK_STACK_DEPTH_DEFAULT, "trajectories");
+  if (idle) task->notify();  // a running load picks pending up when it finishes
+  return true;
+}
+
+void trajectory_library::directory_set(const char* directory) {
+  mutex.take();
+  bool same = selected == directory;
+  if (!same) {
+    selected = directory;
+    selections++;
+    paths.clear();
+    footprint = 0;
+  }
+  mutex.give();
+  if (!same) load(directory);
+}
+
+bool trajectory_library::loading() { return busy; }
+
+std::shared_ptr<const path_view> trajectory_library::find(path_id id) {
+  mutex.take();
+  auto it = paths.find(id);
+  // Shares the entry's count, so the file stays while the view is held
+  std::shared_ptr<const path_view> out;
+  if (it != paths.end()) out = std::shared_ptr<const path_view>(it->second, &it->second->view);
+  mutex.give();
+  return out;
+}
+
+std::shared_ptr<const path_view> trajectory_library::wait(path_id id, int timeout) {
+  std::uint32_t start = pros::millis();
+  while (true) {
+    // Check busy first, a path can only have loaded before the task says it's done
+    bool still_loading = busy;
+    if (auto out = find(id)) return out;
+    if (!still_loading || (int)(pros::millis() - start) >= timeout) return nullptr;
+    pros::delay(ez::util::DELAY_TIME);
+  }
+}
+
+bool trajectory_library::start(path_id id) {
+  std::shared_ptr<const path_view> path = wait(id);
+  if (!path) {
+    printf("trajectories: path %u isn't loaded\n", (unsigned)id);
+    return false;
+  }
+  chassis_trajectory.start(*path, path);
+  return true;
+}
+
+void trajectory_library::clear() {
+  mutex.take();
+  paths.clear();
+  footprint = 0;
+  mutex.give();
+}
+
+void trajectory_library::budget_set(std::size_t bytes) {
+  mutex.take();
+  budget = bytes;
+  mutex.give();
+}
+
+int trajectory_library::size() {
+  mutex.take();
+  int out = paths.size();
+  mutex.give();
+  return out;
+}
+
+std::size_t trajectory_library::bytes_get() {
+  mutex.take();
+  std::size_t out = footprint;
+  mutex.give();
+  return out;
+}
+
+std::uint32_t trajectory_library::load_time_get() { return load_time; }
+
+void trajectory_library::stats_print() {
+  mutex.take();
+  printf("\n%u paths, %u of %u bytes, loaded in %u ms\n", (unsigned)paths.size(), (unsigned)footprint, (unsigned)budget, (unsigned)load_time.load());
+  for (const auto& [id, e] : paths)
+    printf("  %-20s %10u  %6u points %7u bytes %6u us\n", e->name.c_str(), (unsigned)id, (unsigned)e->view.size(), (unsigned)(e->bytes.size() * sizeof(float)), (unsigned)e->load_time);
+  mutex.give();
+}
+
+void trajectory_library::directory_read(const std::string& directory, std::uint32_t selection) {
+  std::vector<char> list(LIST_SIZE, '\0');
+  if (pros::usd::list_files(directory.c_str(), list.data(), LIST_SIZE) == PROS_ERR) {
+    printf("trajectories: can't list /usd%s\n", directory.c_str());
+    return;
+  }
+  list.back() = '\0';
+
+  // One name per line
+  char* save = nullptr;
+  for (char* name = strtok_r(list.data(), "\n", &save); name; name = strtok_r(nullptr, "\n", &save)) {
+    std::size_t length = std::strlen(name);
+    if (length <= sizeof(EXTENSION) - 1 || std::strcmp(name + length - (sizeof(EXTENSION) - 1), EXTENSION) != 0) continue;
+    std::string stem(name, length - (sizeof(EXTENSION) - 1));
+    path_id id = path_id_get(stem);
+
+    mutex.take();
+    bool stale = selections != selection;
+    bool skip = paths.count(id) != 0;
+    mutex.give();
+    if (stale) return;
+    if (skip) continue;
+
+    std::string file = "/usd" + directory + "/" + name;
+    std::uint32_t begin = pros::micros();
+    auto e = std::make_shared<entry>();
+    e->name = stem;
+    e->bytes = path_read(file.c_str());
+    if (!e->view.open(e->bytes.data(), e->bytes.size() * sizeof(float))) {
+      printf("trajectories: %s isn't a version %d path file, or it's damaged\n", file.c_str(), PATH_VERSION);
+      continue;
+    }
+    e->load_time = pros::micros() - begin;
+
+    std::size_t cost = entry_bytes(e->bytes.size() * sizeof(float), stem.size());
+    mutex.take();
+    if (selections != selection) {
+      mutex.give();
+      return;
+    }
+    if (footprint + cost > budget) {
+      mutex.give();
+      printf("trajectories: %s would go over the %u byte budget, skipped\n", file.c_str(), (unsigned)budget);
+      continue;
+    }
+    paths.emplace(id, std::move(e));
+    footprint += cost;
+    mutex.give();
+  }
+}
+
+void trajectory_library::task_fn() {
+  while (true) {
+    pros::Task::notify_take(true, TIMEOUT_MAX);
+    bool again = true;
+    while (again) {
+      mutex.take();
+      std::string directory = pending;
+      std::uint32_t request = requests, selection = selections;
+      mutex.give();
+
+      std::uint32_t begin = pros::millis();
+      directory_read(directory, selection);
+      load_time = pros::millis() - begin;
+
+      // Loads asked for while this one ran are read next, only the latest
+      mutex.take();
+      again = requests != request;
+      if (!again) busy = false;
+      mutex.give();
+    }
+  }
+}
+
+void robot::trajectories_select() {
+  char directory[32];
+  snprintf(directory, sizeof(directory), "/paths/auton_%d", ez::as::auton_selector.auton_page_current);
+  trajectories.directory_set(directory);
+}